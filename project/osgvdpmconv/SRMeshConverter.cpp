@@ -1,12 +1,11 @@
 #include <fstream>
 #include "osg/Geode"
 #include "osg/Geometry"
-#include "vdpm/Allocator.h"
 #include "SRMeshConverter.h"
 
 using namespace osg;
 
-typedef MxDynBlock<MxVdpmPairContraction> QSlimLog;
+typedef MxVdpmHistory QSlimLog;
 static MxVdpmSlim* slim;
 static QSlimLog* history;
 static ostream *debug_stream;
@@ -28,9 +27,11 @@ static bool mxmsg_debug_handler(MxMsgInfo *info)
     return true;
 }
 
-SRMeshConverter::SRMeshConverter(unsigned int faceTarget, std::string& fileName) : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN)
+SRMeshConverter::SRMeshConverter(unsigned int faceTarget, std::string& fileName, unsigned int hausdorffFreq, unsigned int partitionBlocks) : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN)
 {
     this->faceTarget = faceTarget;
+    this->hausdorffFreq = hausdorffFreq;
+    this->partitionBlocks = partitionBlocks;
 
 #if (SAFETY > 0)
     if (!debug_stream)
@@ -103,9 +104,10 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
     MxFaceID   next_face = 0;
 
     // Update refine informations
+    slim->update_deviations(*history);
     for (i = 0; i<(uint)history->length(); i++)
     {
-        MxVdpmPairContraction& conx = (*history)[i];
+        MxVdpmRecord& conx = (*history)[i];
         conx.update_radius(*history, slim->vertex_radiuses, m);
         conx.update_cone(*history, *slim);
     }
@@ -163,15 +165,10 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
             vertex.parent = UINT_MAX;
             vertex.i = UINT_MAX;
 
-            for (j = history->length() - 1; j <= (uint)history->length(); j--)
-            {
-                MxVdpmPairContraction& conx = (*history)[j];
-                if (m->vertex_is_valid(conx.v1) && i == conx.v1)
-                {
-                    conx.v_i = index;
-                    break;
-                }
-            }
+            // the latest contraction that kept a base vertex splits it first
+            j = slim->vertex_contractions(i);
+            if (j != UINT_MAX)
+                (*history)[j].v_i = index;
         }
     }
 
@@ -278,7 +275,7 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
     j = 0;
     for (i = history->length() - 1; i <= (uint)history->length(); i--)
     {
-        const MxVdpmPairContraction& conx = (*history)[i];
+        const MxVdpmRecord& conx = (*history)[i];
         SanityCheck(m->vertex_is_valid(conx.v1));
         SanityCheck(!m->vertex_is_valid(conx.v2));
         Vsplit& vsplit = vsplits(j);
@@ -389,13 +386,13 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
 
         if (conx.child_v1 != UINT_MAX)
         {
-            MxVdpmPairContraction& conx_v1 = (*history)[conx.child_v1];
+            MxVdpmRecord& conx_v1 = (*history)[conx.child_v1];
             conx_v1.v_i = vsplit.vt_i;
         }
 
         if (conx.child_v2 != UINT_MAX)
         {
-            MxVdpmPairContraction& conx_v2 = (*history)[conx.child_v2];
+            MxVdpmRecord& conx_v2 = (*history)[conx.child_v2];
             conx_v2.v_i = vsplit.vu_i;
         }
 
@@ -426,9 +423,10 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
         vsplit.dir_error = conx.dir_error;
 
         // Remap delta faces
-        for (k = 0; k<(uint)conx.delta_faces.length(); k++)
+        const MxFaceID *delta_faces = history->delta_faces(conx);
+        for (k = 0; k<conx.delta_count; k++)
         {
-            FID fk = conx.delta_faces(k);
+            FID fk = delta_faces[k];
             assert(m->face_is_valid(fk));
             m->face(fk).remap_vertex(conx.v1, conx.v2);
         }
@@ -474,6 +472,11 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
     if (!this->vertices)
         goto error;
 
+#ifdef VDPM_INDEX_TOPOLOGY
+    if (this->createTopologyPools(this->vcount, this->baseFCount + this->vsplitCount * 2))
+        goto error;
+#endif
+
     // Output vertices
     for (i = 0; i < this->vcount; ++i)
     {
@@ -481,7 +484,7 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
 
         this->vertices[i].avertex = NULL;
         index = v.parent;
-        this->vertices[i].parent = (index == UINT_MAX) ? NULL : &this->vertices[index];
+        this->vertices[i].parent = this->ref((index == UINT_MAX) ? NULL : &this->vertices[index]);
         this->vertices[i].i = v.i;
 
     #if (SAFETY >= 2)
@@ -500,7 +503,7 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
         VGeom& g = vgeoms(i);
         vdpm::VGeom* vgeom = this->geometry.getVGeom(i);
 
-        avertex = vdpm::Allocator::getInstance().allocAVertex();
+        avertex = this->allocAVertex();
 
         for (j = 0; j < 3; j++)
             vgeom->point[j] = g.point[j];
@@ -522,8 +525,8 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
         }
 
         avertex->i = i;
-        this->vertices[i].avertex = avertex;
-        avertex->vertex = &this->vertices[i];
+        this->vertices[i].avertex = this->ref(avertex);
+        avertex->vertex = this->ref(&this->vertices[i]);
         avertex->vmorph = NULL;
         this->addAVertex(avertex);
 
@@ -607,7 +610,7 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
     for (i = 0; i < this->baseFCount; ++i)
     {
         Face& f = faces(i);
-        aface = vdpm::Allocator::getInstance().allocAFace();
+        aface = this->allocAFace();
 
         index = f.vertices[0];
         aface->v0 = this->vertices[index].avertex;
@@ -616,7 +619,7 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
         index = f.vertices[2];
         aface->v2 = this->vertices[index].avertex;
 
-        this->faces[i].aface = aface;
+        this->faces[i].aface = this->ref(aface);
         aface->tstrip = NULL;
         this->addAFace(aface);
 
@@ -631,11 +634,11 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
         Face& f = faces(i);
 
         index = f.neighbors[0];
-        this->faces[i].aface->n0 = (index == UINT_MAX) ? NULL : this->faces[index].aface;
+        this->getAFace(this->faces[i].aface)->n0 = (index == UINT_MAX) ? NULL : this->faces[index].aface;
         index = f.neighbors[1];
-        this->faces[i].aface->n1 = (index == UINT_MAX) ? NULL : this->faces[index].aface;
+        this->getAFace(this->faces[i].aface)->n1 = (index == UINT_MAX) ? NULL : this->faces[index].aface;
         index = f.neighbors[2];
-        this->faces[i].aface->n2 = (index == UINT_MAX) ? NULL : this->faces[index].aface;
+        this->getAFace(this->faces[i].aface)->n2 = (index == UINT_MAX) ? NULL : this->faces[index].aface;
 
     #if (SAFETY >= 2)
         mxmsg_signalf(MXMSG_DEBUG, "nf[%u] {%d %d %d}", i, f.neighbors[0], f.neighbors[1], f.neighbors[2]);
@@ -658,13 +661,13 @@ void SRMeshConv::write(MxVdpmSlim* slim, MxStdModel* m)
         this->vsplits[i].vu_i = vu_i;
 
         index = s.fn[0];
-        this->vsplits[i].fn0 = (index == UINT_MAX) ? NULL : &this->faces[index];
+        this->vsplits[i].fn0 = this->ref((index == UINT_MAX) ? NULL : &this->faces[index]);
         index = s.fn[1];
-        this->vsplits[i].fn1 = (index == UINT_MAX) ? NULL : &this->faces[index];
+        this->vsplits[i].fn1 = this->ref((index == UINT_MAX) ? NULL : &this->faces[index]);
         index = s.fn[2];
-        this->vsplits[i].fn2 = (index == UINT_MAX) ? NULL : &this->faces[index];
+        this->vsplits[i].fn2 = this->ref((index == UINT_MAX) ? NULL : &this->faces[index]);
         index = s.fn[3];
-        this->vsplits[i].fn3 = (index == UINT_MAX) ? NULL : &this->faces[index];
+        this->vsplits[i].fn3 = this->ref((index == UINT_MAX) ? NULL : &this->faces[index]);
 
         this->vsplits[i].radius = s.radius;
         this->vsplits[i].sin2alpha = s.sin2alpha;
@@ -688,33 +691,12 @@ error:
 
 static void slim_history_callback(const MxPairContraction& conx, float cost)
 {
-    uint i;
     MxVdpmPairContraction* pconx = (MxVdpmPairContraction*)&conx;
 
-    pconx->index = history->length();
-    pconx->child_v1 = UINT_MAX;
-    pconx->child_v2 = UINT_MAX;
-
-    for (i = history->length() - 1; i <= history->length(); i--)
-    {
-        MxVdpmPairContraction& child_conx = (*history)[i];
-
-        if (pconx->child_v1 == UINT_MAX && child_conx.v1 == conx.v1)
-        {
-            pconx->child_v1 = child_conx.index;
-            child_conx.parent = pconx->index;
-        }
-        else if (pconx->child_v2 == UINT_MAX && child_conx.v1 == conx.v2)
-        {
-            pconx->child_v2 = child_conx.index;
-            child_conx.parent = pconx->index;
-        }
-        if (pconx->child_v1 != UINT_MAX && pconx->child_v2 != UINT_MAX)
-            break;
-    }
-    pconx->update_deviation(*history, *slim);
+    slim->link_contraction(*history, *pconx);
+    pconx->capture_deviation(*slim);
 
-    history->add((MxVdpmPairContraction&)conx);
+    history->add(*pconx);
 }
 
 void SRMeshConverter::apply(osg::Geode & geode)
@@ -729,12 +711,13 @@ void SRMeshConverter::apply(osg::Geode & geode)
             read(*m, *geometry);
 
             slim = new MxVdpmSlim(m);
+            slim->hausdorff_freq = hausdorffFreq;
             slim->initialize();
 
             history = new QSlimLog(100);
             slim->contraction_callback = slim_history_callback;
 
-            slim->decimate(faceTarget);
+            slim->decimate_partitioned(faceTarget, partitionBlocks);
 
             osgVdpm::SRMeshDrawable* srmeshdrawable = new osgVdpm::SRMeshDrawable;
 
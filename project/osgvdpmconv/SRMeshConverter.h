@@ -10,7 +10,7 @@
 class SRMeshConverter : public osg::NodeVisitor
 {
 public:
-    SRMeshConverter(unsigned int faceTarget, std::string& fileName);
+    SRMeshConverter(unsigned int faceTarget, std::string& fileName, unsigned int hausdorffFreq = 0, unsigned int partitionBlocks = 1);
     ~SRMeshConverter();
 
     virtual void apply( osg::Geode & geode );
@@ -24,5 +24,7 @@ private:
     void write(osgVdpm::SRMeshDrawable& srmeshdrawable, MxVdpmSlim& slim);
 
     unsigned int faceTarget;
+    unsigned int hausdorffFreq;
+    unsigned int partitionBlocks;
 };
 #endif
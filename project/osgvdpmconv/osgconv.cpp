@@ -811,6 +811,12 @@ int main( int argc, char **argv )
         do_srmesh_conv = true;
     }
 
+    unsigned int hausdorffFreq = 0;
+    while (arguments.read("--vdpm-hausdorff", hausdorffFreq)) {}
+
+    unsigned int partitionBlocks = 1;
+    while (arguments.read("--vdpm-blocks", partitionBlocks)) {}
+
     // any option left unread are converted into errors to write out later.
     arguments.reportRemainingOptionsAsUnrecognized();
 
@@ -923,7 +929,7 @@ int main( int argc, char **argv )
 
         if (do_srmesh_conv)
         {
-            SRMeshConverter conv(faceTarget, fileNameOut);
+            SRMeshConverter conv(faceTarget, fileNameOut, hausdorffFreq, partitionBlocks);
             root->accept(conv);
         }
 
@@ -0,0 +1,204 @@
+/* vdpmbake - Static LOD extraction from .vdpm files
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <climits>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "vdpm/LODBaker.h"
+#include "vdpm/Log.h"
+#include "vdpm/Serializer.h"
+#include "vdpm/SRMesh.h"
+
+using namespace std;
+using namespace vdpm;
+
+#define MAX_LEVELS 32
+
+static void println(const char format[], ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+}
+
+static int writeObj(const char filePath[], SRMesh* srmesh, const BakedLOD& lod)
+{
+    FILE* fp;
+    unsigned int i, vertexCount = lod.getVertexCount();
+    const uint8_t* vgeom;
+    const float* attr;
+    bool hasColor = srmesh->hasColor(), hasTexCoord = srmesh->hasTexCoord();
+
+    fp = fopen(filePath, "w");
+    if (!fp)
+        return -1;
+
+    fprintf(fp, "# vdpmbake: %u vertices, %u faces, %u vsplits, error %g\n", vertexCount, lod.getFaceCount(), lod.vsplitCount, lod.error);
+    if (srmesh->getTextureName())
+        fprintf(fp, "# texture %s\n", srmesh->getTextureName());
+
+    for (i = 0, vgeom = &lod.vgeoms[0]; i < vertexCount; ++i, vgeom += lod.vgeomSize)
+    {
+        const VGeom* v = (const VGeom*)vgeom;
+
+        // vertex colors follow the position, as most OBJ readers accept
+        if (hasColor)
+        {
+            attr = (const float*)(vgeom + srmesh->getColorOffset());
+            fprintf(fp, "v %g %g %g %g %g %g\n", v->point.x, v->point.y, v->point.z, attr[0], attr[1], attr[2]);
+        }
+        else
+        {
+            fprintf(fp, "v %g %g %g\n", v->point.x, v->point.y, v->point.z);
+        }
+    }
+
+    for (i = 0, vgeom = &lod.vgeoms[0]; i < vertexCount; ++i, vgeom += lod.vgeomSize)
+    {
+        const VGeom* v = (const VGeom*)vgeom;
+        fprintf(fp, "vn %g %g %g\n", v->normal.x, v->normal.y, v->normal.z);
+    }
+
+    if (hasTexCoord)
+    {
+        for (i = 0, vgeom = &lod.vgeoms[0]; i < vertexCount; ++i, vgeom += lod.vgeomSize)
+        {
+            attr = (const float*)(vgeom + srmesh->getTexCoordOffset());
+            fprintf(fp, "vt %g %g\n", attr[0], attr[1]);
+        }
+    }
+
+    for (i = 0; i < lod.indices.size(); i += 3)
+    {
+        unsigned int a = lod.indices[i] + 1, b = lod.indices[i + 1] + 1, c = lod.indices[i + 2] + 1;
+
+        if (hasTexCoord)
+            fprintf(fp, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+        else
+            fprintf(fp, "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+static string getLevelPath(const char output[], unsigned int level)
+{
+    string path(output);
+    string::size_type dot = path.rfind('.');
+    char suffix[16];
+
+    if (dot == string::npos || path.find_first_of("/\\", dot) != string::npos)
+        dot = path.size();
+
+    sprintf(suffix, "_%u", level);
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+static void usage()
+{
+    printf("usage: vdpmbake [-f faces] [-e error] [-n levels] input.vdpm output.obj\n");
+    printf("  -f  maximum number of faces (default: the full mesh)\n");
+    printf("  -e  stop once every remaining vsplit has a smaller uniform error (a distance)\n");
+    printf("  -n  write levels LODs from the base mesh up to the limits as output_0.obj...\n");
+}
+
+int main(int argc, char* argv[])
+{
+    SRMesh* srmesh;
+    LODBaker* baker;
+    BakedLOD lod;
+    const char* input = NULL;
+    const char* output = NULL;
+    unsigned int faceCount = UINT_MAX, levels = 1, level, baseFaceCount, maxFaceCount;
+    float error = 0.0f;
+    int i, ret = 1;
+
+    Log::println = println;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            faceCount = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+            error = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            levels = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (argv[i][0] != '-' && !input)
+            input = argv[i];
+        else if (argv[i][0] != '-' && !output)
+            output = argv[i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!input || !output || levels == 0 || levels > MAX_LEVELS)
+    {
+        usage();
+        return 1;
+    }
+
+    srmesh = Serializer::getInstance().loadSRMesh(input);
+    if (!srmesh)
+    {
+        printf("cannot load %s\n", input);
+        return 1;
+    }
+
+    baker = new LODBaker(srmesh);
+    baseFaceCount = srmesh->getAFaceCount();
+    maxFaceCount = faceCount < srmesh->getFaceCount() ? faceCount : srmesh->getFaceCount();
+
+    // levels are spaced evenly in log face count; each one continues from the previous
+    for (level = 0; level < levels; ++level)
+    {
+        string path = levels > 1 ? getLevelPath(output, level) : string(output);
+        unsigned int count = maxFaceCount;
+
+        if (levels > 1 && maxFaceCount > baseFaceCount)
+            count = (unsigned int)(baseFaceCount * pow((double)maxFaceCount / baseFaceCount, (double)level / (levels - 1)) + 0.5);
+
+        if (baker->bake(count, error, lod))
+        {
+            printf("cannot bake %s\n", input);
+            goto end;
+        }
+
+        if (writeObj(path.c_str(), srmesh, lod))
+        {
+            printf("cannot write %s\n", path.c_str());
+            goto end;
+        }
+
+        printf("%s: %u vertices, %u faces, %u vsplits, error %g\n", path.c_str(), lod.getVertexCount(), lod.getFaceCount(), lod.vsplitCount, lod.error);
+    }
+    ret = 0;
+
+end:
+    delete baker;
+    delete srmesh;
+    return ret;
+}
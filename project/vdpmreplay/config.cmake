@@ -0,0 +1 @@
+set(CFG_USE_VDPM y)
\ No newline at end of file
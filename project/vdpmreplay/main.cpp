@@ -0,0 +1,141 @@
+/* vdpmreplay - Renderer trace replay tool
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "vdpm/Log.h"
+#include "vdpm/RecordingRenderer.h"
+
+using namespace vdpm;
+
+// CPU backend: buffers live in system memory, draw calls are ignored.
+class CpuRenderer : public Renderer
+{
+public:
+    void updateViewport(Viewport* viewport) {}
+    void draw(SRMesh* srmesh) {}
+};
+
+struct ReplayTotals
+{
+    bool verbose;
+    unsigned int frames, calls;
+    uint64_t uploadBytes, writtenBytes, recordedTime, replayTime;
+    uint64_t maxUploadBytes, maxRecordedTime;
+    unsigned int maxUploadFrame, maxRecordedFrame;
+};
+
+static void println(const char format[], ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+}
+
+static void frameCallback(const RendererTraceFrame& frame, void* param)
+{
+    ReplayTotals* totals = (ReplayTotals*)param;
+
+    if (totals->verbose)
+    {
+        printf("frame %u: calls %u upload %llu written %llu recorded %.3f ms replay %.3f ms\n",
+            frame.index, frame.calls, (unsigned long long)frame.uploadBytes, (unsigned long long)frame.writtenBytes,
+            frame.recordedTime / 1e6, frame.replayTime / 1e6);
+    }
+
+    if (frame.uploadBytes > totals->maxUploadBytes)
+    {
+        totals->maxUploadBytes = frame.uploadBytes;
+        totals->maxUploadFrame = frame.index;
+    }
+
+    if (frame.recordedTime > totals->maxRecordedTime)
+    {
+        totals->maxRecordedTime = frame.recordedTime;
+        totals->maxRecordedFrame = frame.index;
+    }
+
+    ++totals->frames;
+    totals->calls += frame.calls;
+    totals->uploadBytes += frame.uploadBytes;
+    totals->writtenBytes += frame.writtenBytes;
+    totals->recordedTime += frame.recordedTime;
+    totals->replayTime += frame.replayTime;
+}
+
+static void usage()
+{
+    printf("usage: vdpmreplay [-v] [-o output.trace] input.trace\n");
+    printf("  -v  print statistics of every frame\n");
+    printf("  -o  record the replay to another trace\n");
+}
+
+int main(int argc, char* argv[])
+{
+    ReplayTotals totals;
+    CpuRenderer cpu;
+    RecordingRenderer* recorder = NULL;
+    const char* input = NULL;
+    const char* output = NULL;
+    int i, ret;
+
+    ::memset(&totals, 0, sizeof(totals));
+    Log::println = println;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+            totals.verbose = true;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (argv[i][0] != '-' && !input)
+            input = argv[i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!input)
+    {
+        usage();
+        return 1;
+    }
+
+    if (output)
+        recorder = new RecordingRenderer(&cpu, output);
+
+    ret = RecordingRenderer::replay(input, recorder ? (Renderer*)recorder : &cpu, frameCallback, &totals);
+    delete recorder;
+
+    if (ret)
+        return 1;
+
+    printf("frames %u, calls %u\n", totals.frames, totals.calls);
+    printf("upload %llu bytes (%.1f per frame), written %llu bytes (%.1f per frame)\n",
+        (unsigned long long)totals.uploadBytes, totals.frames ? (double)totals.uploadBytes / totals.frames : 0.0,
+        (unsigned long long)totals.writtenBytes, totals.frames ? (double)totals.writtenBytes / totals.frames : 0.0);
+    printf("recorded %.3f ms, replay %.3f ms\n", totals.recordedTime / 1e6, totals.replayTime / 1e6);
+    printf("max upload %llu bytes at frame %u, max recorded time %.3f ms at frame %u\n",
+        (unsigned long long)totals.maxUploadBytes, totals.maxUploadFrame, totals.maxRecordedTime / 1e6, totals.maxRecordedFrame);
+    return 0;
+}
@@ -19,7 +19,7 @@
 
 #include "qslim.h"
 
-static char *options = "O:B:W:t:Fo:m:c:rjI:M:qh";
+static char *options = "O:B:W:t:Fo:m:c:rjI:M:H:P:G:S:qh";
 
 static char *usage_string =
 "-O <n>         Optimal placement policy:\n"
@@ -35,6 +35,17 @@ static char *usage_string =
 "-r             Enable history recording.\n"
 "-M <format>    Select output format:\n"
 "                       {smf, iv, vrml, pm, mmf, log}\n"
+"-H <n>         Measure vsplit deviations exactly against the original faces,\n"
+"                       sampling faces on a lattice of n+1 points per edge.\n"
+"-P <n>         Decimate n*n*n spatial blocks in parallel first, then\n"
+"                       merge them level by level.\n"
+"-G <n>         Lossy preprocessing: stream the input out of core and cluster\n"
+"                       it onto a grid of n cells along its longest side;\n"
+"                       the hierarchy starts from the clustered mesh.\n"
+"                       The history is spilled as with -S, to the\n"
+"                       temporary directory unless -S is given.\n"
+"-S <dir>       Keep the contraction history in memory-mapped temporary\n"
+"                       files in the given directory.\n"
 "-q		Be quiet.\n"
 "-j             Join only; do not remove any faces.\n"
 "-h             Print help.\n"
@@ -98,6 +109,10 @@ void process_cmdline(int argc, char **argv)
 	case 'c':  compactness_ratio = atof(optarg); break;
 	case 'r':  will_record_history = true; break;
 	case 'j':  will_join_only = true; break;
+	case 'H':  hausdorff_freq = atoi(optarg); break;
+	case 'P':  partition_blocks = atoi(optarg); break;
+	case 'G':  stream_grid = atoi(optarg); break;
+	case 'S':  history_spill_dir = optarg; break;
 	case 'q':  be_quiet = true; break;
 	case 'h':  print_usage(); exit(0); break;
 
@@ -22,6 +22,10 @@ bool will_record_history = true;
 double compactness_ratio = 0.0;
 double meshing_penalty = 1.0;
 bool will_join_only = false;
+unsigned int hausdorff_freq = 0;
+unsigned int partition_blocks = 1;
+unsigned int stream_grid = 0;
+char *history_spill_dir = NULL;
 bool be_quiet = false;
 OutputFormat output_format = VDPM;
 char *output_filename = NULL;
@@ -73,6 +77,21 @@ void slim_print_banner(ostream& out)
 	<< slim_copyright_notice << endl;
 }
 
+// Streamed input is meant for models too large for memory, so its
+// history goes to disk even without -S
+static const char *spill_directory()
+{
+    const char *dir = history_spill_dir;
+
+    if( !dir && stream_grid > 0 )
+    {
+	if( !(dir = getenv("TMPDIR")) && !(dir = getenv("TEMP")) && !(dir = getenv("TMP")) )
+	    dir = ".";
+    }
+
+    return dir;
+}
+
 void slim_init()
 {
     if( !slim )
@@ -86,12 +105,17 @@ void slim_init()
     slim->compactness_ratio = compactness_ratio;
     slim->meshing_penalty = meshing_penalty;
     slim->will_join_only = will_join_only;
+    slim->hausdorff_freq = hausdorff_freq;
 
 	slim->initialize();
 
     if( will_record_history )
     {
 	    history = new QSlimLog(100);
+	    const char *dir = spill_directory();
+
+	    if( dir && !history->spill_to(dir) )
+		mxmsg_signal(MXMSG_WARN, "Failed to create the history spill files.");
 	    slim->contraction_callback = slim_history_callback;
     }
 }
@@ -213,15 +237,33 @@ void output_final_model()
 
 void input_file(const char *filename)
 {
+    if (stream_grid > 0)
+    {
+        MxStreamCluster cluster(stream_grid);
+
+        if (streq(filename, "-") || !cluster.read(filename))
+            mxmsg_signal(MXMSG_FATAL, "Failed to stream input file", filename);
+        if (!be_quiet)
+            cerr << "+ Streamed input   (" << cluster.input_verts << "v/" << cluster.input_faces << "f)" << endl;
+
+        cluster.emit(*m);
+        return;
+    }
+
     char * pch = strrchr((char*)filename, '.');
-    if (pch && stricmp(pch, ".obj") == 0)
+    if (pch && stricmp(pch, ".ply") == 0)
+    {
+        if (streq(filename, "-") || !mx_read_ply(filename, *m))
+            mxmsg_signal(MXMSG_FATAL, "Failed to read PLY input file", filename);
+    }
+    else if (pch && stricmp(pch, ".obj") == 0)
     {
         obj = new MxOBJReader;
         obj->unparsed_hook = unparsed_hook;
 
         if (streq(filename, "-"))
             obj->read(cin, m);
-        else
+        else if (!mx_read_mapped(filename, *m))
         {
             ifstream in(filename);
             if (!in.good())
@@ -237,7 +279,7 @@ void input_file(const char *filename)
 
         if (streq(filename, "-"))
             smf->read(cin, m);
-        else
+        else if (!mx_read_mapped(filename, *m))
         {
             ifstream in(filename);
             if (!in.good())
@@ -264,35 +306,14 @@ void include_deferred_files()
 
 void slim_history_callback(const MxPairContraction& conx, float cost)
 {
-	uint i;
 	MxVdpmPairContraction* pconx = (MxVdpmPairContraction*)&conx;
 
-	pconx->index = history->length();
-    pconx->child_v1 = UINT_MAX;
-    pconx->child_v2 = UINT_MAX;
-
-	for(i=history->length()-1; i<=history->length(); i--)
-	{	
-		MxVdpmPairContraction& child_conx = (*history)[i];
-
-        if (pconx->child_v1 == UINT_MAX && child_conx.v1 == conx.v1)
-		{
-			pconx->child_v1 = child_conx.index;
-			child_conx.parent = pconx->index;
-		}
-        else if (pconx->child_v2 == UINT_MAX && child_conx.v1 == conx.v2)
-		{
-			pconx->child_v2 = child_conx.index;
-			child_conx.parent = pconx->index;
-		}
-		if (pconx->child_v1 != UINT_MAX && pconx->child_v2 != UINT_MAX)
-			break;
-	}
-	pconx->update_deviation(*history, *slim);
+	slim->link_contraction(*history, *pconx);
+	pconx->capture_deviation(*slim);
 
 #if (SAFETY >= 2)
     mxmsg_signalf(MXMSG_DEBUG, "c[%u] v:{%u %u} child:{%d %d}", pconx->index, conx.v1, conx.v2, pconx->child_v1, pconx->child_v2);
 #endif
 
-    history->add((MxVdpmPairContraction&)conx);
+    history->add(*pconx);
 }
@@ -59,7 +59,8 @@ void output_regressive_mmf(ostream& out)
 
     for(uint i=0; i<history->length(); i++)
     {
-        MxPairContraction& conx = (*history)[i];
+        const MxVdpmRecord& conx = (*history)[i];
+        const MxFaceID *dead_faces = history->dead_faces(conx);
 
 	// Output the basic contraction record
         out << "v% " << conx.v1+1 << " " << conx.v2+1 << " "
@@ -67,8 +68,8 @@ void output_regressive_mmf(ostream& out)
             << endl;
 
         // Output the faces that are being removed
-        for(uint j=0; j<conx.dead_faces.length(); j++)
-            out << "f- " << conx.dead_faces(j)+1 << endl;
+        for(uint j=0; j<conx.dead_count; j++)
+            out << "f- " << dead_faces[j]+1 << endl;
     }
 }
 
@@ -78,20 +79,22 @@ void output_regressive_log(ostream& out)
 
     for(uint i=0; i<history->length(); i++)
     {
-        MxPairContraction& conx = (*history)[i];
+        const MxVdpmRecord& conx = (*history)[i];
+        const MxFaceID *dead_faces = history->dead_faces(conx);
 
 	// Output the basic contraction record
         out << "v% " << conx.v1+1 << " " << conx.v2+1 << " "
             << conx.dv1[X] << " " << conx.dv1[Y] << " " << conx.dv1[Z];
 
         // Output the faces that are being removed
-        for(uint j=0; j<conx.dead_faces.length(); j++)
-            out << " " << conx.dead_faces(j)+1;
+        for(uint j=0; j<conx.dead_count; j++)
+            out << " " << dead_faces[j]+1;
 
         // Output the faces that are being reshaped
         out << " &";
-        for(uint k=0; k<conx.delta_faces.length(); k++)
-            out << " " << conx.delta_faces(k)+1;
+        const MxFaceID *delta_faces = history->delta_faces(conx);
+        for(uint k=0; k<conx.delta_count; k++)
+            out << " " << delta_faces[k]+1;
 
         out << endl;
     }
@@ -136,7 +139,9 @@ void output_progressive_pm(ostream& out)
     //
     for(i=history->length()-1; i<=history->length(); i--)
     {
-	const MxPairContraction& conx = (*history)[i];
+	const MxVdpmRecord& conx = (*history)[i];
+	const MxFaceID *dead_faces = history->dead_faces(conx);
+	const MxFaceID *delta_faces = history->delta_faces(conx);
 	SanityCheck( m->vertex_is_valid(conx.v1) );
 	SanityCheck( !m->vertex_is_valid(conx.v2) );
 
@@ -146,9 +151,9 @@ void output_progressive_pm(ostream& out)
 	out << " ";
 
 	// Output new faces
-	for(k=0; k<conx.dead_faces.length(); k++)
+	for(k=0; k<conx.dead_count; k++)
 	{
-	    FID fk = conx.dead_faces(k);
+	    FID fk = dead_faces[k];
 	    VID vk = m->face(fk).opposite_vertex(conx.v1, conx.v2);
  	    SanityCheck( m->vertex_is_valid(vk) );
 
@@ -156,16 +161,16 @@ void output_progressive_pm(ostream& out)
 	    if( !m->face(fk).is_inorder(vk, conx.v1) ) out << "-";
  	    out << vmap(vk)+1;
 
-	    fmap(conx.dead_faces(k)) = next_face++;
-	    m->face_mark_valid(conx.dead_faces(k));
+	    fmap(dead_faces[k]) = next_face++;
+	    m->face_mark_valid(dead_faces[k]);
 	}
 
 	// Output delta faces
 	out << " &";
-	for(k=0; k<conx.delta_faces.length(); k++)
+	for(k=0; k<conx.delta_count; k++)
 	{
 	    out << " ";
-	    FID fk = conx.delta_faces(k);
+	    FID fk = delta_faces[k];
 	    assert(m->face_is_valid(fk));
 	    out << " " << fmap(fk)+1;
 	}
@@ -237,9 +242,10 @@ void output_progressive_vdpm(ostream& out)
     MxFaceID   next_face = 0;
 
 	// Update refine informations
+	slim->update_deviations(*history);
 	for (i = 0; i<(uint)history->length(); i++)
     {
-		MxVdpmPairContraction& conx = (*history)[i];
+		MxVdpmRecord& conx = (*history)[i];
 		conx.update_radius(*history, slim->vertex_radiuses, m);
 		conx.update_cone(*history, *slim);
 	}
@@ -297,15 +303,10 @@ void output_progressive_vdpm(ostream& out)
             vertex.parent = UINT_MAX;
             vertex.i = UINT_MAX;
 
-            for (j = history->length() - 1; j <= (uint)history->length(); j--)
-            {
-                MxVdpmPairContraction& conx = (*history)[j];
-                if (m->vertex_is_valid(conx.v1) && i == conx.v1)
-                {
-                    conx.v_i = index;
-                    break;
-                }
-            }
+            // the latest contraction that kept a base vertex splits it first
+            j = slim->vertex_contractions(i);
+            if (j != UINT_MAX)
+                (*history)[j].v_i = index;
 	    }
     }
 
@@ -412,7 +413,7 @@ void output_progressive_vdpm(ostream& out)
 	j = 0;
 	for (i = history->length() - 1; i <= (uint)history->length(); i--)
     {
-		const MxVdpmPairContraction& conx = (*history)[i];
+		const MxVdpmRecord& conx = (*history)[i];
 		SanityCheck( m->vertex_is_valid(conx.v1) );
 		SanityCheck( !m->vertex_is_valid(conx.v2) );
 		Vsplit& vsplit = vsplits(j);
@@ -523,13 +524,13 @@ void output_progressive_vdpm(ostream& out)
 
         if (conx.child_v1 != UINT_MAX)
         {
-            MxVdpmPairContraction& conx_v1 = (*history)[conx.child_v1];
+            MxVdpmRecord& conx_v1 = (*history)[conx.child_v1];
             conx_v1.v_i = vsplit.vt_i;
         }
 
         if (conx.child_v2 != UINT_MAX)
         {
-            MxVdpmPairContraction& conx_v2 = (*history)[conx.child_v2];
+            MxVdpmRecord& conx_v2 = (*history)[conx.child_v2];
             conx_v2.v_i = vsplit.vu_i;
         }
 
@@ -560,9 +561,10 @@ void output_progressive_vdpm(ostream& out)
 		vsplit.dir_error = conx.dir_error;
 
 		// Remap delta faces
-		for(k=0; k<(uint)conx.delta_faces.length(); k++)
+		const MxFaceID *delta_faces = history->delta_faces(conx);
+		for(k=0; k<conx.delta_count; k++)
 		{
-			FID fk = conx.delta_faces(k);
+			FID fk = delta_faces[k];
 			assert(m->face_is_valid(fk));
 			m->face(fk).remap_vertex(conx.v1, conx.v2);
 		}
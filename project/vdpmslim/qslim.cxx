@@ -79,13 +79,14 @@ int main(int argc, char **argv)
 
     // Decimate model until target is reached
     //
-    TIMING(slim_time, result = slim->decimate(face_target));
+    TIMING(slim_time, result = slim->decimate_partitioned(face_target, partition_blocks));
     if (!result)
     {
         while (history->length() > 0)
         {
-            MxPairContraction& conx = history->drop();
+            MxVdpmPairContraction conx;
 
+            history->drop(conx);
             slim->apply_expansion(conx);
 
             if (slim->check_model())
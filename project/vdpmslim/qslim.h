@@ -17,11 +17,13 @@
 #include <MxVdpmSlim.h>
 #include <MxSMF.h>
 #include "MxOBJ.h"
+#include "MxStreamCluster.h"
+#include "MxMappedReader.h"
 
 #define QSLIM_VERSION 2100
 #define QSLIM_VERSION_STRING "2.1"
 
-typedef MxDynBlock<MxVdpmPairContraction> QSlimLog;
+typedef MxVdpmHistory QSlimLog;
 
 enum OutputFormat { SMF, PM, MMF, LOG, IV, VRML, VDPM };
 
@@ -38,6 +40,10 @@ extern bool will_record_history;
 extern double compactness_ratio;
 extern double meshing_penalty;
 extern bool will_join_only;
+extern unsigned int hausdorff_freq;
+extern unsigned int partition_blocks;
+extern unsigned int stream_grid;
+extern char *history_spill_dir;
 extern bool be_quiet;
 extern OutputFormat output_format;
 extern char *output_filename;
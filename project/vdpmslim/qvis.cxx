@@ -56,8 +56,9 @@ void decimate_callback(const MxPairContraction& conx, float cost)
 
 void slim_undo()
 {
-    MxPairContraction& conx = history->drop();
+    MxVdpmPairContraction conx;
 
+    history->drop(conx);
     slim->apply_expansion(conx);
 }
 
@@ -115,7 +116,7 @@ static void cb_colorize()
 	// Propagate colors as per current model state
 	for(i=history->length(); i>0; i--)
 	{
-	    MxPairContraction& conx = (*history)[i-1];
+	    MxVdpmRecord& conx = (*history)[i-1];
 	    m_orig->color(conx.v2) = m_orig->color(conx.v1);
 	}
 
@@ -0,0 +1,269 @@
+/* vdpmstream - Progressive view-dependent mesh streaming over TCP
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "vdpm/Log.h"
+#include "vdpm/Renderer.h"
+#include "vdpm/Serializer.h"
+#include "vdpm/SRMesh.h"
+#include "vdpm/StreamClient.h"
+#include "vdpm/StreamServer.h"
+#include "vdpm/Viewport.h"
+
+using namespace std;
+using namespace vdpm;
+
+#define DEFAULT_PORT        5566
+#define DEFAULT_THREADS     4
+#define DEFAULT_FRAMES      300
+#define DEFAULT_RECORDS     4096
+#define DEFAULT_TAU         0.001f
+#define VIEW_ANGLE          0.7854f     // 45 degrees
+
+// CPU backend: buffers live in system memory, draw calls are ignored.
+class CpuRenderer : public Renderer
+{
+public:
+    // the mesh frees its vertices once they are in the vertex buffer, so keep a copy
+    void* createBuffer(RendererBuffer target, unsigned int size, const void* data)
+    {
+        void* buf = ::malloc(size);
+
+        if (buf && data)
+            ::memcpy(buf, data, size);
+
+        return buf;
+    }
+
+    void updateViewport(Viewport* viewport) {}
+    void draw(SRMesh* srmesh) {}
+};
+
+static void println(const char format[], ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+}
+
+static double getElapsed(const chrono::steady_clock::time_point& start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static void serveClients(StreamServer* server, atomic<int>* remaining)
+{
+    while (remaining->fetch_sub(1) > 0)
+    {
+        if (server->serve())
+            printf("client disconnected\n");
+        else
+            printf("client served\n");
+    }
+}
+
+static int runServer(const char input[], unsigned short port, unsigned int threadCount, int clients)
+{
+    StreamServer* server;
+    SRMesh* srmesh;
+    vector<thread> threads;
+    atomic<int> remaining(clients > 0 ? clients : INT_MAX);
+    unsigned int i;
+    int ret = 1;
+
+    srmesh = Serializer::getInstance().loadSRMesh(input);
+    if (!srmesh)
+    {
+        printf("cannot load %s\n", input);
+        return 1;
+    }
+
+    server = new StreamServer(srmesh);
+    if (server->listen(port))
+        goto end;
+
+    printf("serving %s on port %u\n", input, server->getPort());
+    fflush(stdout);
+
+    for (i = 0; i < threadCount; ++i)
+        threads.push_back(thread(serveClients, server, &remaining));
+
+    for (i = 0; i < threadCount; ++i)
+        threads[i].join();
+
+    ret = 0;
+
+end:
+    delete server;
+    delete srmesh;
+    return ret;
+}
+
+static void lookAtFront(Viewport* viewport, SRMesh* srmesh)
+{
+    const Vector& min = srmesh->getBoundMin();
+    const Vector& max = srmesh->getBoundMax();
+    Point center = (min + max) * 0.5f, eye;
+    float radius = magnitude(max - min) * 0.5f;
+    float c = cosf(VIEW_ANGLE * 0.5f), s = sinf(VIEW_ANGLE * 0.5f);
+    Vector normals[4] = { Vector(c, 0.0f, -s), Vector(-c, 0.0f, -s), Vector(0.0f, c, -s), Vector(0.0f, -c, -s) };
+    int p;
+
+    // looking down -z from far enough to see the whole mesh
+    eye = center + Vector(0.0f, 0.0f, radius / s);
+
+    for (p = 0; p < 4; ++p)
+        viewport->setViewClipPlane(p, normals[p].x, normals[p].y, normals[p].z, -dotProduct(normals[p], eye));
+
+    viewport->setViewClipPlane(4, 0.0f, 0.0f, -1.0f, eye.z - radius * 0.01f);
+    viewport->setViewClipPlane(5, 0.0f, 0.0f, 1.0f, radius * 4.0f - eye.z);
+    viewport->setViewPosition(eye.x, eye.y, eye.z);
+}
+
+static int runClient(const char host[], unsigned short port, float tau, unsigned int frames, unsigned int records)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    StreamClient client;
+    CpuRenderer renderer;
+    Viewport viewport;
+    SRMesh* srmesh;
+    unsigned int frame, received = 0;
+    int count, ret = 1;
+
+    srmesh = client.connect(host, port);
+    if (!srmesh)
+        return 1;
+
+    printf("base mesh: %u faces after %.3f ms\n", srmesh->getAFaceCount(), getElapsed(start));
+
+    if (srmesh->realize(&renderer))
+    {
+        printf("cannot realize the mesh\n");
+        goto end;
+    }
+
+    lookAtFront(&viewport, srmesh);
+    srmesh->setViewport(&viewport);
+    srmesh->setViewAngle(VIEW_ANGLE);
+    srmesh->setTau(tau);
+
+    if (client.sendView(&viewport))
+        goto end;
+
+    for (frame = 0; frame < frames; ++frame)
+    {
+        count = client.update(records);
+        if (count < 0)
+        {
+            printf("stream failed at frame %u\n", frame);
+            goto end;
+        }
+        received += count;
+
+    #ifdef VDPM_GEOMORPHS
+        srmesh->updateVMorphs();
+    #endif
+        srmesh->adaptRefine();
+        srmesh->updateScene();
+
+        if (count > 0)
+        {
+            printf("frame %u: %u of %u records, %u faces, %.3f ms\n",
+                frame, received, srmesh->getVSplitCount(), srmesh->getAFaceCount(), getElapsed(start));
+        }
+    }
+
+    printf("%s after %u frames: %u of %u records, %u faces, %.3f ms\n", client.isComplete() ? "complete" : "incomplete",
+        frames, received, srmesh->getVSplitCount(), srmesh->getAFaceCount(), getElapsed(start));
+
+    ret = client.isComplete() ? 0 : 1;
+
+end:
+    client.close();
+    delete srmesh;
+    return ret;
+}
+
+static void usage()
+{
+    printf("usage: vdpmstream [-p port] [-j threads] [-n clients] input.vdpm\n");
+    printf("       vdpmstream -c host [-p port] [-t tau] [-f frames] [-r records]\n");
+    printf("  -p  TCP port (default %u, 0 picks a free port for the server)\n", DEFAULT_PORT);
+    printf("  -j  clients served at the same time (default %u)\n", DEFAULT_THREADS);
+    printf("  -n  exit after serving this many clients (default: never)\n");
+    printf("  -c  connect to a server and refine a front view without drawing\n");
+    printf("  -t  screen-space error tolerance of the client (default %g)\n", DEFAULT_TAU);
+    printf("  -f  frames to run the client (default %u)\n", DEFAULT_FRAMES);
+    printf("  -r  maximum records the client adds per frame (default %u)\n", DEFAULT_RECORDS);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* input = NULL;
+    const char* host = NULL;
+    unsigned short port = DEFAULT_PORT;
+    unsigned int threadCount = DEFAULT_THREADS, frames = DEFAULT_FRAMES, records = DEFAULT_RECORDS;
+    float tau = DEFAULT_TAU;
+    int clients = 0, i;
+
+    Log::println = println;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            port = (unsigned short)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threadCount = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            clients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            host = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            tau = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            frames = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            records = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (argv[i][0] != '-' && !input)
+            input = argv[i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (host && !input)
+        return runClient(host, port, tau, frames, records);
+
+    if (!host && input && threadCount > 0)
+        return runServer(input, port, threadCount, clients);
+
+    usage();
+    return 1;
+}
@@ -25,6 +25,7 @@
 #include "cameraSimple.h"   // 3D mesh of camera
 #include "Log.h"
 #include "vdpm/Log.h"
+#include "vdpm/OpenGL4Renderer.h"
 #include "vdpm/OpenGLRenderer.h"
 #include "vdpm/Serializer.h"
 #include "vdpm/SRMesh.h"
@@ -366,7 +367,11 @@ void ModelGL::draw()
             return;
 
         srmesh = meshes[meshCount];
+    #ifdef VDPM_RENDERER_OPENGL4
+        srmesh->realize(&OpenGL4Renderer::getInstance());
+    #else
         srmesh->realize(&OpenGLRenderer::getInstance());
+    #endif
 
         viewChanged = paramChanged = initialized = true;
         ++meshCount;
@@ -336,9 +336,9 @@ static void calc_normals_as_oriented_model(struct model *m,
 /* Returns the integer sample frequency for a triangle of area t_area, so that
  * the sample density (number of samples per unit area) is s_density
  * (statistically speaking). The returned sample frequency is the number of
- * samples to take on each side. A random variable is used so that the
- * resulting sampling density is s_density in average. */
-static int get_sampling_freq(double t_area, double s_density)
+ * samples to take on each side. A random variable r, as returned by rand(),
+ * is used so that the resulting sampling density is s_density in average. */
+static int get_sampling_freq(double t_area, double s_density, int r)
 {
   double rv,p,n_samples;
   int n;
@@ -350,7 +350,7 @@ static int get_sampling_freq(double t_area, double s_density)
    * gives no more than n_samples. The we choose n with probability p, or n+1
    * with probability 1-p, so that p*n*(n+1)/2+(1-p)*(n+1)*(n+2)/2=n_samples,
    * that is the expected value is n_samples. */
-  rv = rand()/(RAND_MAX+1.0); /* rand var. in [0,1) interval */
+  rv = r/(RAND_MAX+1.0); /* rand var. in [0,1) interval */
   n_samples = t_area*s_density;
   n = (int)floor(sqrt(0.25+2*n_samples)-0.5);
   p = (n+2)*0.5-n_samples/(n+1);
@@ -1348,6 +1348,23 @@ static double dist_pt_surf(dvertex_t p, const struct triangle_list *tl,
  *                          External functions                               *
  * --------------------------------------------------------------------------*/
 
+/* See compute_error.h */
+int sampled_face_count(const struct model *m)
+{
+  dvertex_t v1,v2,v3;
+  int k,n;
+
+  /* Same degenerate test as dist_surf_surf() */
+  for (k=0, n=0; k<m->num_faces; k++) {
+    vertex_f2d_dv(&(m->vertices[m->faces[k].f0]),&v1);
+    vertex_f2d_dv(&(m->vertices[m->faces[k].f1]),&v2);
+    vertex_f2d_dv(&(m->vertices[m->faces[k].f2]),&v3);
+    if (tri_area_dv(&v1,&v2,&v3) < DMARGIN*DBL_MIN) continue;
+    n++;
+  }
+  return n;
+}
+
 /* See compute_error.h */
 void dist_surf_surf(struct model_error *me1, struct model *m2, 
 		    double sampling_density, int min_sample_freq,
@@ -1373,12 +1390,14 @@ void dist_surf_surf(struct model_error *me1, struct model *m2,
   double prev_d;              /* distance for previous point */
   dvertex_t v1,v2,v3;         /* double version of triangle vertices */
   struct misc_stats m_stats;  /* temporary structure for temp stats */
+  const int *rand_values;     /* given random values, NULL to use rand() */
 #ifdef DO_DIST_PT_SURF_STATS
   struct dist_pt_surf_stats dps_stats; /* Statistics */
 #endif
 
   /* Initialize */
   m1 = me1->mesh;
+  rand_values = me1->rand_values;
   memset(&ts,0,sizeof(ts));
   memset(&tse,0,sizeof(tse));
   report_step = (int) (m1->num_faces/(100.0/2)); /* report every 2 % */
@@ -1435,7 +1454,8 @@ void dist_surf_surf(struct model_error *me1, struct model *m2,
     vertex_f2d_dv(&(m1->vertices[m1->faces[k].f2]),&v3);
     me1->fe[k].face_area = tri_area_dv(&v1,&v2,&v3);
     if (me1->fe[k].face_area < DMARGIN*DBL_MIN) continue; /* degenerate */
-    n = get_sampling_freq(me1->fe[k].face_area,sampling_density);
+    n = get_sampling_freq(me1->fe[k].face_area,sampling_density,
+                          (rand_values != NULL) ? *(rand_values++) : rand());
     if (n < min_sample_freq) n = min_sample_freq;
     realloc_triag_sample_error(&tse,n);
     sample_triangle(&v1,&v2,&v3,n,&ts);
@@ -120,6 +120,9 @@ struct model_error {
   float *verror;          /* The per vertex error array. NULL if not
                            * present. */
   struct model_info *info;/* The model information. NULL if not present. */
+  const int *rand_values; /* If not NULL, the values used in turn instead of
+                           * rand() to choose the sampling frequency of each
+                           * sampled triangle. See sampled_face_count(). */
 };
 
 /* Statistics from the dist_surf_surf function */
@@ -166,6 +169,10 @@ void dist_surf_surf(struct model_error *me1, struct model *m2,
                     struct prog_reporter *prog);
 
 
+/* Returns the number of triangles of m that dist_surf_surf() samples when m
+ * is model 1, which is the number of random values it draws. */
+int sampled_face_count(const struct model *m);
+
 /* Frees the memory allocated by dist_surf_surf() for the per face error
  * metrics. */
 void free_face_error(struct face_error *fe);
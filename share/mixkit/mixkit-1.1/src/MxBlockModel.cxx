@@ -52,6 +52,12 @@ MxBlockModel *MxBlockModel::clone(MxBlockModel *m)
     return m;
 }
 
+void MxBlockModel::reserve(uint nvert, uint nface)
+{
+    if( vertices.total_space() < (int)nvert )  vertices.resize(nvert);
+    if( faces.total_space() < (int)nface )  faces.resize(nface);
+}
+
 MxFaceID MxBlockModel::alloc_face(MxVertexID v1, MxVertexID v2, MxVertexID v3)
 {
     faces.add(MxFace(v1,v2,v3));
@@ -80,6 +80,9 @@ public:
 
     MxBlockModel *clone(MxBlockModel *into=NULL);
 
+    // Makes room for nvert vertices and nface faces in one step
+    virtual void reserve(uint nvert, uint nface);
+
     unsigned int vert_count() const { return vertices.length(); }
     unsigned int face_count() const { return faces.length(); }
     unsigned int color_count() const { return (colors?colors->length():0); }
@@ -0,0 +1,337 @@
+#include "stdmix.h"
+#include "MxHausdorff.h"
+
+#include <float.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define MX_HAUSDORFF_SSE
+#include <xmmintrin.h>
+#endif
+
+// Fields of a block, each 4 floats wide (one per triangle)
+enum
+{
+    AX, AY, AZ, BX, BY, BZ, CX, CY, CZ,
+    E0X, E0Y, E0Z, E1X, E1Y, E1Z, E2X, E2Y, E2Z,    // b - a, c - b, a - c
+    IL0, IL1, IL2,                                  // 1 / squared edge lengths, 0 if degenerate
+    NX, NY, NZ, INN,                                // unnormalized normal, 1 / its squared length or 0
+    M0X, M0Y, M0Z, M1X, M1Y, M1Z, M2X, M2Y, M2Z,    // inward normals of the edge planes
+    C0, C1, C2,                                     // edge plane offsets
+    FIELD_COUNT
+};
+
+#define BLOCK_SIZE (FIELD_COUNT * 4)
+
+static inline float inverse_or_zero(float v)
+{
+    return (v > 0.0f) ? 1.0f / v : 0.0f;
+}
+
+MxHausdorff::MxHausdorff(const float *points, const uint *faces, uint face_count)
+    : block_count((face_count + 3) / 4), blocks(((face_count + 3) / 4) * BLOCK_SIZE)
+{
+    uint i, k;
+
+    for (i = 0; i < block_count * 4; i++)
+    {
+        // Pad the last block with copies of the last triangle
+        const uint *f = &faces[((i < face_count) ? i : face_count - 1) * 3];
+        float *t = &blocks[(i / 4) * BLOCK_SIZE + (i % 4)];
+        float v[3][3], e[3][3], n[3];
+
+        for (k = 0; k < 3; k++)
+        {
+            v[k][0] = points[f[k] * 3];
+            v[k][1] = points[f[k] * 3 + 1];
+            v[k][2] = points[f[k] * 3 + 2];
+        }
+        for (k = 0; k < 3; k++)
+        {
+            e[k][0] = v[(k + 1) % 3][0] - v[k][0];
+            e[k][1] = v[(k + 1) % 3][1] - v[k][1];
+            e[k][2] = v[(k + 1) % 3][2] - v[k][2];
+        }
+
+        // n = (b - a) x (c - a) = e0 x -e2
+        n[0] = e[2][1] * e[0][2] - e[2][2] * e[0][1];
+        n[1] = e[2][2] * e[0][0] - e[2][0] * e[0][2];
+        n[2] = e[2][0] * e[0][1] - e[2][1] * e[0][0];
+
+        for (k = 0; k < 3; k++)
+        {
+            t[(AX + k * 3) * 4] = v[k][0];
+            t[(AY + k * 3) * 4] = v[k][1];
+            t[(AZ + k * 3) * 4] = v[k][2];
+
+            t[(E0X + k * 3) * 4] = e[k][0];
+            t[(E0Y + k * 3) * 4] = e[k][1];
+            t[(E0Z + k * 3) * 4] = e[k][2];
+
+            t[(IL0 + k) * 4] = inverse_or_zero(e[k][0] * e[k][0] + e[k][1] * e[k][1] + e[k][2] * e[k][2]);
+
+            // n x e points from the edge toward the triangle interior
+            float mx = n[1] * e[k][2] - n[2] * e[k][1];
+            float my = n[2] * e[k][0] - n[0] * e[k][2];
+            float mz = n[0] * e[k][1] - n[1] * e[k][0];
+
+            t[(M0X + k * 3) * 4] = mx;
+            t[(M0Y + k * 3) * 4] = my;
+            t[(M0Z + k * 3) * 4] = mz;
+            t[(C0 + k) * 4] = mx * v[k][0] + my * v[k][1] + mz * v[k][2];
+        }
+
+        t[NX * 4] = n[0];
+        t[NY * 4] = n[1];
+        t[NZ * 4] = n[2];
+        t[INN * 4] = inverse_or_zero(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    }
+}
+
+#ifdef MX_HAUSDORFF_SSE
+
+static inline __m128 dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+// mask ? a : b
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+float MxHausdorff::dist2(const float p[3], float vec[3]) const
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 px = _mm_set1_ps(p[0]);
+    const __m128 py = _mm_set1_ps(p[1]);
+    const __m128 pz = _mm_set1_ps(p[2]);
+    __m128 best = _mm_set1_ps(FLT_MAX);
+    __m128 bx = zero, by = zero, bz = zero;
+    float d[4], x[4], y[4], z[4];
+    uint i, k;
+
+    if (block_count == 0)
+    {
+        vec[0] = vec[1] = vec[2] = 0.0f;
+        return 0.0f;
+    }
+
+    for (i = 0; i < block_count; i++)
+    {
+        const float *t = &blocks[i * BLOCK_SIZE];
+        __m128 dist = _mm_set1_ps(FLT_MAX);
+        __m128 rx = zero, ry = zero, rz = zero;
+
+        // Closest point on each edge
+        for (k = 0; k < 3; k++)
+        {
+            __m128 ex = _mm_loadu_ps(t + (E0X + k * 3) * 4);
+            __m128 ey = _mm_loadu_ps(t + (E0Y + k * 3) * 4);
+            __m128 ez = _mm_loadu_ps(t + (E0Z + k * 3) * 4);
+            __m128 wx = _mm_sub_ps(px, _mm_loadu_ps(t + (AX + k * 3) * 4));
+            __m128 wy = _mm_sub_ps(py, _mm_loadu_ps(t + (AY + k * 3) * 4));
+            __m128 wz = _mm_sub_ps(pz, _mm_loadu_ps(t + (AZ + k * 3) * 4));
+            __m128 s = _mm_mul_ps(dot3(wx, wy, wz, ex, ey, ez), _mm_loadu_ps(t + (IL0 + k) * 4));
+
+            s = _mm_min_ps(_mm_max_ps(s, zero), one);
+            wx = _mm_sub_ps(wx, _mm_mul_ps(s, ex));
+            wy = _mm_sub_ps(wy, _mm_mul_ps(s, ey));
+            wz = _mm_sub_ps(wz, _mm_mul_ps(s, ez));
+
+            __m128 dk = dot3(wx, wy, wz, wx, wy, wz);
+            __m128 closer = _mm_cmplt_ps(dk, dist);
+
+            dist = select(closer, dk, dist);
+            rx = select(closer, wx, rx);
+            ry = select(closer, wy, ry);
+            rz = select(closer, wz, rz);
+        }
+
+        // Projection to the plane if it is inside all three edge planes
+        __m128 nx = _mm_loadu_ps(t + NX * 4);
+        __m128 ny = _mm_loadu_ps(t + NY * 4);
+        __m128 nz = _mm_loadu_ps(t + NZ * 4);
+        __m128 inn = _mm_loadu_ps(t + INN * 4);
+        __m128 inside = _mm_cmpgt_ps(inn, zero);
+
+        for (k = 0; k < 3; k++)
+        {
+            __m128 s = dot3(px, py, pz,
+                _mm_loadu_ps(t + (M0X + k * 3) * 4),
+                _mm_loadu_ps(t + (M0Y + k * 3) * 4),
+                _mm_loadu_ps(t + (M0Z + k * 3) * 4));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(s, _mm_loadu_ps(t + (C0 + k) * 4)));
+        }
+
+        __m128 dpp = dot3(_mm_sub_ps(px, _mm_loadu_ps(t + AX * 4)),
+            _mm_sub_ps(py, _mm_loadu_ps(t + AY * 4)),
+            _mm_sub_ps(pz, _mm_loadu_ps(t + AZ * 4)), nx, ny, nz);
+        __m128 scale = _mm_mul_ps(dpp, inn);
+
+        dist = select(inside, _mm_mul_ps(dpp, scale), dist);
+        rx = select(inside, _mm_mul_ps(nx, scale), rx);
+        ry = select(inside, _mm_mul_ps(ny, scale), ry);
+        rz = select(inside, _mm_mul_ps(nz, scale), rz);
+
+        __m128 closer = _mm_cmplt_ps(dist, best);
+
+        best = select(closer, dist, best);
+        bx = select(closer, rx, bx);
+        by = select(closer, ry, by);
+        bz = select(closer, rz, bz);
+    }
+
+    _mm_storeu_ps(d, best);
+    _mm_storeu_ps(x, bx);
+    _mm_storeu_ps(y, by);
+    _mm_storeu_ps(z, bz);
+
+    for (i = 1, k = 0; i < 4; i++)
+    {
+        if (d[i] < d[k])
+            k = i;
+    }
+    vec[0] = x[k];
+    vec[1] = y[k];
+    vec[2] = z[k];
+    return d[k];
+}
+
+#else
+
+float MxHausdorff::dist2(const float p[3], float vec[3]) const
+{
+    float best = FLT_MAX;
+    uint i, j, k;
+
+    vec[0] = vec[1] = vec[2] = 0.0f;
+
+    if (block_count == 0)
+        return 0.0f;
+
+    for (i = 0; i < block_count; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            const float *t = &blocks[i * BLOCK_SIZE + j];
+            float dist = FLT_MAX;
+            float r[3];
+
+            // Closest point on each edge
+            for (k = 0; k < 3; k++)
+            {
+                float ex = t[(E0X + k * 3) * 4], ey = t[(E0Y + k * 3) * 4], ez = t[(E0Z + k * 3) * 4];
+                float wx = p[0] - t[(AX + k * 3) * 4];
+                float wy = p[1] - t[(AY + k * 3) * 4];
+                float wz = p[2] - t[(AZ + k * 3) * 4];
+                float s = (wx * ex + wy * ey + wz * ez) * t[(IL0 + k) * 4];
+
+                s = MIN(MAX(s, 0.0f), 1.0f);
+                wx -= s * ex;
+                wy -= s * ey;
+                wz -= s * ez;
+
+                float dk = wx * wx + wy * wy + wz * wz;
+                if (dk < dist)
+                {
+                    dist = dk;
+                    r[0] = wx;
+                    r[1] = wy;
+                    r[2] = wz;
+                }
+            }
+
+            // Projection to the plane if it is inside all three edge planes
+            bool inside = t[INN * 4] > 0.0f;
+
+            for (k = 0; k < 3; k++)
+            {
+                float s = p[0] * t[(M0X + k * 3) * 4] + p[1] * t[(M0Y + k * 3) * 4] + p[2] * t[(M0Z + k * 3) * 4];
+                inside = inside && s >= t[(C0 + k) * 4];
+            }
+
+            if (inside)
+            {
+                float dpp = (p[0] - t[AX * 4]) * t[NX * 4] + (p[1] - t[AY * 4]) * t[NY * 4] + (p[2] - t[AZ * 4]) * t[NZ * 4];
+                float scale = dpp * t[INN * 4];
+
+                dist = dpp * scale;
+                r[0] = t[NX * 4] * scale;
+                r[1] = t[NY * 4] * scale;
+                r[2] = t[NZ * 4] * scale;
+            }
+
+            if (dist < best)
+            {
+                best = dist;
+                vec[0] = r[0];
+                vec[1] = r[1];
+                vec[2] = r[2];
+            }
+        }
+    }
+    return best;
+}
+
+#endif // MX_HAUSDORFF_SSE
+
+float MxHausdorff::max_dist2(const float *points, uint point_count, const uint *faces, uint face_count,
+    uint freq, float vec[3]) const
+{
+    float best = 0.0f;
+    float r[3], dist;
+    uint i, j, k;
+
+    vec[0] = vec[1] = vec[2] = 0.0f;
+
+    for (i = 0; i < point_count; i++)
+    {
+        dist = dist2(&points[i * 3], r);
+        if (dist > best)
+        {
+            best = dist;
+            vec[0] = r[0];
+            vec[1] = r[1];
+            vec[2] = r[2];
+        }
+    }
+
+    if (freq < 2)
+        return best;
+
+    for (i = 0; i < face_count; i++)
+    {
+        const float *a = &points[faces[i * 3] * 3];
+        const float *b = &points[faces[i * 3 + 1] * 3];
+        const float *c = &points[faces[i * 3 + 2] * 3];
+
+        for (j = 0; j <= freq; j++)
+        {
+            for (k = 0; j + k <= freq; k++)
+            {
+                float u = (float)j / freq, v = (float)k / freq;
+                float p[3];
+
+                if ((j == 0 || j == freq) && (k == 0 || k == freq))
+                    continue;   // a corner
+
+                p[0] = a[0] + u * (b[0] - a[0]) + v * (c[0] - a[0]);
+                p[1] = a[1] + u * (b[1] - a[1]) + v * (c[1] - a[1]);
+                p[2] = a[2] + u * (b[2] - a[2]) + v * (c[2] - a[2]);
+
+                dist = dist2(p, r);
+                if (dist > best)
+                {
+                    best = dist;
+                    vec[0] = r[0];
+                    vec[1] = r[1];
+                    vec[2] = r[2];
+                }
+            }
+        }
+    }
+    return best;
+}
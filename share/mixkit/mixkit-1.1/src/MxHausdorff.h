@@ -0,0 +1,35 @@
+#ifndef MXHAUSDORFF_INCLUDED // -*- C++ -*-
+#define MXHAUSDORFF_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+#include "MxBlock.h"
+
+// One-sided Hausdorff distance from sample points to a small triangle set,
+// using exact point-triangle distances against every triangle. Meant for local
+// neighborhoods of a few dozen triangles, where a spatial grid costs more than
+// it saves. The triangles are stored four to a block in structure-of-arrays
+// layout so the distances are computed four triangles at a time.
+class MxHausdorff
+{
+private:
+    uint block_count;
+    MxBlock<float> blocks;
+
+public:
+    // points are xyz triples, faces are index triples into points
+    MxHausdorff(const float *points, const uint *faces, uint face_count);
+
+    // Squared distance from p to the triangles, and p minus its closest point.
+    float dist2(const float p[3], float vec[3]) const;
+
+    // Largest squared distance over a lattice of freq+1 samples along each edge
+    // of the given triangles, and the vector of dist2() where it occurs. Every
+    // point is a sample, so the corners of the lattices are measured only once.
+    float max_dist2(const float *points, uint point_count, const uint *faces, uint face_count,
+        uint freq, float vec[3]) const;
+};
+
+// MXHAUSDORFF_INCLUDED
+#endif
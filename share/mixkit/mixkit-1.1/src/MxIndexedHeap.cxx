@@ -0,0 +1,130 @@
+/************************************************************************
+
+  Indexed 4-ary heap
+
+ ************************************************************************/
+
+#include "stdmix.h"
+#include "MxIndexedHeap.h"
+
+void MxIndexedHeap::upheap(uint i)
+{
+    entry moving = entries(i);
+
+    while (i > 0 && moving.key > entries(parent(i)).key)
+    {
+        place(entries(parent(i)), i);
+        i = parent(i);
+    }
+    place(moving, i);
+}
+
+void MxIndexedHeap::downheap(uint i)
+{
+    entry moving = entries(i);
+    uint n = entries.length();
+
+    for (;;)
+    {
+        uint c = child(i), end = MIN(c + 4, n), largest = c;
+
+        if (c >= n)
+            break;
+
+        for (c++; c < end; c++)
+            if (entries(c).key > entries(largest).key)
+                largest = c;
+
+        if (!(moving.key < entries(largest).key))
+            break;
+
+        place(entries(largest), i);
+        i = largest;
+    }
+    place(moving, i);
+}
+
+void MxIndexedHeap::insert(uint id, float key)
+{
+    while (id >= (uint)positions.length())
+        positions.add(UINT_MAX);
+    SanityCheck(positions(id) == UINT_MAX);
+
+    entry& x = entries.add();
+    x.key = key;
+    x.id = id;
+    upheap(entries.last_id());
+}
+
+void MxIndexedHeap::update(uint id, float key)
+{
+    SanityCheck(contains(id));
+    uint i = positions(id);
+    float old = entries(i).key;
+
+    entries(i).key = key;
+    if (key > old)
+        upheap(i);
+    else
+        downheap(i);
+}
+
+bool MxIndexedHeap::remove(uint id)
+{
+    if (!contains(id)) return false;
+
+    uint i = positions(id);
+    float key = entries(i).key;
+    entry last = entries.drop();
+
+    positions(id) = UINT_MAX;
+    if (i < (uint)entries.length())
+    {
+        place(last, i);
+        if (last.key < key)
+            downheap(i);
+        else
+            upheap(i);
+    }
+    return true;
+}
+
+void MxIndexedHeap::build(const float *keys, uint count)
+{
+    uint i;
+
+    reset();
+    if (count < 1) return;
+
+    entries.room_for(count);
+    while ((uint)positions.length() < count)
+        positions.add(UINT_MAX);
+
+    for (i = 0; i < count; i++)
+    {
+        entries(i).key = keys[i];
+        entries(i).id = i;
+        positions(i) = i;
+    }
+
+    for (i = parent(count - 1) + 1; i-- > 0;)
+        downheap(i);
+}
+
+bool MxIndexedHeap::extract(uint *id, float *key)
+{
+    if (entries.length() < 1) return false;
+
+    *id = entries(0).id;
+    if (key) *key = entries(0).key;
+
+    remove(*id);
+    return true;
+}
+
+void MxIndexedHeap::reset()
+{
+    for (uint i = 0; i < (uint)entries.length(); i++)
+        positions(entries(i).id) = UINT_MAX;
+    entries.reset();
+}
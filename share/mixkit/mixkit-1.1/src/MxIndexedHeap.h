@@ -0,0 +1,56 @@
+#ifndef MXINDEXEDHEAP_INCLUDED // -*- C++ -*-
+#define MXINDEXEDHEAP_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+/************************************************************************
+
+  Indexed 4-ary heap
+
+  Holds (key, id) pairs by value, with the largest key on top like
+  MxHeap. The position of each id is kept in a table, so update() and
+  remove() need no search. Four children per node halve the depth of
+  the tree, and the children share a cache line.
+
+ ************************************************************************/
+
+#include "MxDynBlock.h"
+
+class MxIndexedHeap
+{
+private:
+    struct entry { float key; uint id; };
+
+    MxDynBlock<entry> entries;
+    MxDynBlock<uint> positions;     // 1 per id, UINT_MAX when not in heap
+
+    static uint parent(uint i) { return (i - 1) / 4; }
+    static uint child(uint i) { return 4 * i + 1; }
+
+    void place(const entry& x, uint i) { entries(i) = x; positions(x.id) = i; }
+    void upheap(uint i);
+    void downheap(uint i);
+
+public:
+    MxIndexedHeap(uint n = 64) : entries(n), positions(n) { }
+
+    uint size() const { return entries.length(); }
+    bool contains(uint id) const { return id < (uint)positions.length() && positions(id) != UINT_MAX; }
+    float key(uint id) const { return entries(positions(id)).key; }
+
+    void insert(uint id, float key);
+    void update(uint id, float key);
+    bool remove(uint id);
+
+    // Replaces the contents with ids [0, count) and sifts them down
+    // bottom-up, in O(count) rather than count inserts
+    void build(const float *keys, uint count);
+
+    // Removes the top entry; returns false if the heap is empty
+    bool extract(uint *id, float *key = NULL);
+    void reset();
+};
+
+// MXINDEXEDHEAP_INCLUDED
+#endif
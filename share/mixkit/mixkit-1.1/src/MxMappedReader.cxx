@@ -0,0 +1,861 @@
+/************************************************************************
+
+  Memory-mapped model readers
+
+ ************************************************************************/
+
+#include "stdmix.h"
+#include "MxMappedReader.h"
+#include "MxParallel.h"
+#include "MxMat4.h"
+#include "MxVector.h"
+
+#include <limits.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+// Chunks per thread, so that uneven chunks still balance
+#define MAPPED_CHUNKS 4
+
+// Chunks are at least this long
+#define MAPPED_MIN_CHUNK 65536
+
+////////////////////////////////////////////////////////////////////////
+//
+// Mapped files
+//
+
+MxMappedFile::MxMappedFile(const char *filename)
+{
+    data = NULL;
+    data_size = 0;
+
+#if defined(_WIN32)
+    LARGE_INTEGER len;
+
+    mapping = NULL;
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &len) || len.QuadPart == 0)
+        return;
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping)
+        return;
+
+    data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data)
+        data_size = (size_t)len.QuadPart;
+#else
+    struct stat st;
+    void *p;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0)
+        return;
+
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+        return;
+
+    madvise(p, (size_t)st.st_size, MADV_WILLNEED);
+    data = (const char *)p;
+    data_size = (size_t)st.st_size;
+#endif
+}
+
+MxMappedFile::~MxMappedFile()
+{
+#if defined(_WIN32)
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+#else
+    if (data)
+        munmap((void *)data, data_size);
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Tokens
+//
+
+// isspace() in the C locale, which MxCmdParser splits on
+static inline bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static const char *skip_space(const char *p, const char *end)
+{
+    while (p < end && is_space(*p))
+        p++;
+    return p;
+}
+
+static const char *skip_token(const char *p, const char *end)
+{
+    while (p < end && !is_space(*p))
+        p++;
+    return p;
+}
+
+static double parse_real_slow(const char *p, const char *end)
+{
+    char buf[64];
+    size_t n = end - p;
+
+    if (n >= sizeof(buf))
+        return strtod(std::string(p, end).c_str(), NULL);
+
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    return strtod(buf, NULL);
+}
+
+static const double exact_powers[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parses the token [p, end) as atof() would. Up to 2^53 significant and
+// 10^22 in scale, both factors are exact doubles and one multiply or
+// divide rounds correctly (Clinger's fast path). Other tokens go to
+// strtod().
+static double parse_real(const char *p, const char *end)
+{
+    const char *s = p;
+    unsigned long long mantissa = 0;
+    int digits = 0, significant = 0, exponent = 0, e = 0;
+    bool negative = false, e_negative = false;
+
+    if (s < end && (*s == '-' || *s == '+'))
+        negative = (*s++ == '-');
+
+    for (; s < end && is_digit(*s); s++, digits++)
+    {
+        mantissa = mantissa * 10 + (*s - '0');
+        if (mantissa)
+            significant++;
+    }
+    if (s < end && *s == '.')
+        for (s++; s < end && is_digit(*s); s++, digits++, exponent--)
+        {
+            mantissa = mantissa * 10 + (*s - '0');
+            if (mantissa)
+                significant++;
+        }
+
+    if (digits == 0 || significant > 19)
+        return parse_real_slow(p, end);
+
+    if (s < end && (*s == 'e' || *s == 'E'))
+    {
+        const char *t;
+
+        if (++s < end && (*s == '-' || *s == '+'))
+            e_negative = (*s++ == '-');
+        for (t = s; s < end && is_digit(*s) && e < 1000; s++)
+            e = e * 10 + (*s - '0');
+        if (s == t)
+            return parse_real_slow(p, end);
+        exponent += e_negative ? -e : e;
+    }
+
+    if (s != end || mantissa > (1ULL << 53) || exponent < -22 || exponent > 22)
+        return parse_real_slow(p, end);
+
+    double v = (double)mantissa;
+
+    v = exponent < 0 ? v / exact_powers[-exponent] : v * exact_powers[exponent];
+    return negative ? -v : v;
+}
+
+// Reads the leading integer of a face token like atoi() and sscanf("%u")
+// do for "12", "-3" and "12/5/7".
+static bool parse_index(const char *p, const char *end, int& id)
+{
+    long long v = 0;
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+    if (p == end || !is_digit(*p))
+        return false;
+
+    for (; p < end && is_digit(*p); p++)
+        if ((v = v * 10 + (*p - '0')) > INT_MAX)
+            return false;
+
+    id = (int)(negative ? -v : v);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// SMF and OBJ
+//
+
+enum
+{
+    MAPPED_VERTEX, MAPPED_FACE, MAPPED_COLOR, MAPPED_NORMAL,
+    MAPPED_BIND_COLOR, MAPPED_BIND_NORMAL, MAPPED_BEGIN, MAPPED_END,
+    MAPPED_KINDS
+};
+
+struct mapped_chunk
+{
+    const char *begin, *end;
+    uint count[MAPPED_KINDS];   // lines of each kind, from the first pass
+    uint base[MAPPED_KINDS];    // lines of each kind in earlier chunks
+    bool ok;
+};
+
+static void split_chunks(const MxMappedFile& file, MxDynBlock<mapped_chunk>& chunks)
+{
+    size_t n = MIN((size_t)mx_thread_count() * MAPPED_CHUNKS, file.size() / MAPPED_MIN_CHUNK + 1);
+    size_t step = file.size() / n;
+    const char *p = file.begin(), *end = file.end();
+
+    for (size_t i = 1; p < end; i++)
+    {
+        const char *q = i < n ? MAX(p, file.begin() + i * step) : end;
+
+        if (q < end && (q = (const char *)memchr(q, '\n', end - q)) != NULL)
+            q++;
+        else
+            q = end;
+
+        mapped_chunk& c = chunks.add();
+        c.begin = p;
+        c.end = q;
+        memset(c.count, 0, sizeof(c.count));
+        c.ok = true;
+        p = q;
+    }
+}
+
+static bool is_op(const char *op, size_t len, const char *name)
+{
+    return len == strlen(name) && !strncmp(op, name, len);
+}
+
+// Calls line(kind, args, args_end) for every command of the chunk, in
+// order. Returns false on a command the plain readers do not cover, or
+// when line() does.
+template<class F>
+static bool scan_chunk(const mapped_chunk& c, bool obj, const F& line)
+{
+    const char *args[4], *args_end[4];
+    const char *p, *start, *eol, *op;
+    size_t len;
+    uint n;
+    int kind;
+
+    for (start = c.begin; start < c.end; start = eol < c.end ? eol + 1 : c.end)
+    {
+        if (!(eol = (const char *)memchr(start, '\n', c.end - start)))
+            eol = c.end;
+
+        p = skip_space(start, eol);
+        if (p == eol || *p == '#')
+            continue;
+        if (memchr(p, ';', eol - p))
+            return false;       // phrase separator
+
+        op = p;
+        p = skip_token(p, eol);
+        len = p - op;
+
+        for (n = 0; (p = skip_space(p, eol)) < eol; n++)
+        {
+            if (n < 4)
+                args[n] = p;
+            p = skip_token(p, eol);
+            if (n < 4)
+                args_end[n] = p;
+        }
+
+        if (is_op(op, len, "v") && n >= 3)
+            kind = MAPPED_VERTEX;
+        else if ((is_op(op, len, "f") || (!obj && is_op(op, len, "t"))) && n == 3)
+            kind = MAPPED_FACE;
+        else if (obj)
+        {
+            if (is_op(op, len, "vn") && n >= 3)
+                kind = MAPPED_NORMAL;
+            else if (is_op(op, len, "g") || is_op(op, len, "o") || is_op(op, len, "s") ||
+                     is_op(op, len, "usemtl") || is_op(op, len, "mtllib"))
+                continue;
+            else
+                return false;
+        }
+        else if (is_op(op, len, "c") && n >= 3)
+            kind = MAPPED_COLOR;
+        else if (is_op(op, len, "n") && n >= 3)
+            kind = MAPPED_NORMAL;
+        else if (is_op(op, len, "bind") && n == 2 && is_op(args[1], args_end[1] - args[1], "vertex") &&
+                 (args[0][0] == 'c' || args[0][0] == 'n'))
+            kind = args[0][0] == 'c' ? MAPPED_BIND_COLOR : MAPPED_BIND_NORMAL;
+        else if (is_op(op, len, "begin") && n == 0)
+            kind = MAPPED_BEGIN;
+        else if (is_op(op, len, "end") && n == 0)
+            kind = MAPPED_END;
+        else
+            return false;
+
+        if (!line(kind, args, args_end))
+            return false;
+    }
+
+    return true;
+}
+
+bool mx_read_mapped(const char *filename, MxStdModel& m)
+{
+    const char *ext = strrchr(filename, '.');
+    bool obj = ext && !stricmp(ext, ".obj");
+    uint total[MAPPED_KINDS] = { 0 }, i, k;
+
+    if (m.vert_count() || m.face_count())
+        return false;
+
+    MxMappedFile file(filename);
+    if (!file.is_open())
+        return false;
+
+    MxDynBlock<mapped_chunk> chunks(64);
+    split_chunks(file, chunks);
+
+    uint nchunks = chunks.length();
+
+    mx_parallel_for(nchunks, [&](uint ci)
+    {
+        mapped_chunk& c = chunks(ci);
+
+        c.ok = scan_chunk(c, obj, [&](int kind, const char **, const char **)
+        {
+            c.count[kind]++;
+            return true;
+        });
+    });
+
+    for (i = 0; i < nchunks; i++)
+    {
+        if (!chunks(i).ok)
+            return false;
+
+        for (k = 0; k < MAPPED_KINDS; k++)
+        {
+            chunks(i).base[k] = total[k];
+            total[k] += chunks(i).count[k];
+        }
+    }
+
+    // Properties need a binding before them, and blocks may not offset the
+    // vertex numbering
+    uint nverts = total[MAPPED_VERTEX], nfaces = total[MAPPED_FACE];
+    uint ncolors = total[MAPPED_COLOR], nnormals = total[MAPPED_NORMAL];
+
+    if (total[MAPPED_BIND_COLOR] > 1 || total[MAPPED_BIND_NORMAL] > 1 ||
+        (ncolors && !total[MAPPED_BIND_COLOR]) ||
+        (nnormals && !obj && !total[MAPPED_BIND_NORMAL]) ||
+        total[MAPPED_BEGIN] != total[MAPPED_END])
+        return false;
+
+    MxBlock<float> positions(MAX(3 * nverts, 1u));
+    MxBlock<uint> corners(MAX(3 * nfaces, 1u));
+    MxBlock<float> colors(MAX(3 * ncolors, 1u)), normals(MAX(3 * nnormals, 1u));
+    const Mat4 I = Mat4::I();
+
+    mx_parallel_for(nchunks, [&](uint ci)
+    {
+        mapped_chunk& c = chunks(ci);
+        uint next[MAPPED_KINDS];
+
+        memcpy(next, c.base, sizeof(next));
+        c.ok = scan_chunk(c, obj, [&](int kind, const char **args, const char **args_end)
+        {
+            uint j = next[kind]++, a;
+            int id;
+
+            switch (kind)
+            {
+            case MAPPED_VERTEX:
+            {
+                // The same identity transform as MxSMFReader::v_xform(),
+                // which also turns -0 into 0
+                Vec4 p = I * Vec4(parse_real(args[0], args_end[0]),
+                                  parse_real(args[1], args_end[1]),
+                                  parse_real(args[2], args_end[2]), 1);
+
+                positions[3 * j + X] = (float)(p[X] / p[W]);
+                positions[3 * j + Y] = (float)(p[Y] / p[W]);
+                positions[3 * j + Z] = (float)(p[Z] / p[W]);
+                break;
+            }
+
+            case MAPPED_FACE:
+                for (a = 0; a < 3; a++)
+                {
+                    if (!parse_index(args[a], args_end[a], id))
+                        return false;
+                    if (id < 0)
+                        id += next[MAPPED_VERTEX] + 1;  // relative to the next vertex
+                    if (id < 1 || (uint)id > nverts)
+                        return false;
+                    corners[3 * j + a] = id - 1;
+                }
+                break;
+
+            case MAPPED_COLOR:
+                for (a = 0; a < 3; a++)
+                    colors[3 * j + a] = (float)parse_real(args[a], args_end[a]);
+                break;
+
+            case MAPPED_NORMAL:
+            {
+                Vec3 n(parse_real(args[0], args_end[0]),
+                       parse_real(args[1], args_end[1]),
+                       parse_real(args[2], args_end[2]));
+
+                unitize(n);
+                for (a = 0; a < 3; a++)
+                    normals[3 * j + a] = (float)n[a];
+                break;
+            }
+
+            case MAPPED_BIND_COLOR:
+                return next[MAPPED_COLOR] == 0;
+
+            case MAPPED_BIND_NORMAL:
+                return next[MAPPED_NORMAL] == 0;
+
+            case MAPPED_BEGIN:
+                return next[MAPPED_VERTEX] == 0;
+            }
+
+            return true;
+        });
+    });
+
+    for (i = 0; i < nchunks; i++)
+        if (!chunks(i).ok)
+            return false;
+
+    m.reserve(nverts, nfaces);
+    for (i = 0; i < nverts; i++)
+        m.add_vertex(&positions[3 * i]);
+    for (i = 0; i < nfaces; i++)
+        m.add_face(&corners[3 * i]);
+
+    if (total[MAPPED_BIND_COLOR])
+    {
+        m.color_binding(MX_PERVERTEX);
+        for (i = 0; i < ncolors; i++)
+            m.add_color(colors[3 * i + 0], colors[3 * i + 1], colors[3 * i + 2]);
+    }
+
+    if (total[MAPPED_BIND_NORMAL] || nnormals)
+    {
+        m.normal_binding(MX_PERVERTEX);
+        for (i = 0; i < nnormals; i++)
+            m.add_normal(normals[3 * i + X], normals[3 * i + Y], normals[3 * i + Z]);
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// PLY
+//
+
+enum { PLY_ASCII, PLY_BINARY_LE, PLY_BINARY_BE };
+
+enum
+{
+    PLY_NONE, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16,
+    PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+};
+
+static const char *ply_type_names[][2] =
+{
+    { "", "" }, { "char", "int8" }, { "uchar", "uint8" },
+    { "short", "int16" }, { "ushort", "uint16" }, { "int", "int32" },
+    { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" }
+};
+
+static const uint ply_type_sizes[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+struct ply_property
+{
+    std::string name;
+    int type;
+    int count_type;             // PLY_NONE unless this is a list
+};
+
+struct ply_element
+{
+    std::string name;
+    uint count;
+    std::vector<ply_property> props;
+};
+
+struct ply_cursor
+{
+    const char *p, *end;
+    int format;
+    bool swap;                  // file and host byte order differ
+};
+
+static int ply_parse_type(const std::string& name)
+{
+    for (int t = PLY_INT8; t <= PLY_FLOAT64; t++)
+        if (name == ply_type_names[t][0] || name == ply_type_names[t][1])
+            return t;
+    return PLY_NONE;
+}
+
+static double ply_decode(const char *p, int type, bool swap)
+{
+    unsigned char b[8];
+    uint n = ply_type_sizes[type], i;
+
+    for (i = 0; i < n; i++)
+        b[i] = p[swap ? n - 1 - i : i];
+
+    switch (type)
+    {
+    case PLY_INT8:    { signed char v;     memcpy(&v, b, 1); return v; }
+    case PLY_UINT8:   { unsigned char v;   memcpy(&v, b, 1); return v; }
+    case PLY_INT16:   { short v;           memcpy(&v, b, 2); return v; }
+    case PLY_UINT16:  { unsigned short v;  memcpy(&v, b, 2); return v; }
+    case PLY_INT32:   { int v;             memcpy(&v, b, 4); return v; }
+    case PLY_UINT32:  { unsigned int v;    memcpy(&v, b, 4); return v; }
+    case PLY_FLOAT32: { float v;           memcpy(&v, b, 4); return v; }
+    default:          { double v;          memcpy(&v, b, 8); return v; }
+    }
+}
+
+static bool ply_read(ply_cursor& c, int type, double& v)
+{
+    if (c.format == PLY_ASCII)
+    {
+        const char *s = skip_space(c.p, c.end);
+
+        c.p = skip_token(s, c.end);
+        if (s == c.p)
+            return false;
+        v = parse_real(s, c.p);
+        return true;
+    }
+
+    if ((size_t)(c.end - c.p) < ply_type_sizes[type])
+        return false;
+    v = ply_decode(c.p, type, c.swap);
+    c.p += ply_type_sizes[type];
+    return true;
+}
+
+// Reads one property; the items of a list land in items when it is given
+static bool ply_read_property(ply_cursor& c, const ply_property& prop, double& v,
+                              MxDynBlock<uint> *items = NULL)
+{
+    if (prop.count_type == PLY_NONE)
+        return ply_read(c, prop.type, v);
+
+    double count, item;
+
+    if (!ply_read(c, prop.count_type, count) || count < 0)
+        return false;
+    for (uint i = 0; i < (uint)count; i++)
+    {
+        if (!ply_read(c, prop.type, item))
+            return false;
+        if (items)
+            items->add(item < 0 ? UINT_MAX : (uint)item);
+    }
+    v = count;
+    return true;
+}
+
+static bool ply_read_header(const MxMappedFile& file, ply_cursor& c, std::vector<ply_element>& elements)
+{
+    const char *line = file.begin(), *end = file.end(), *eol;
+    bool first = true, host_le;
+    int format = -1;
+    uint one = 1;
+
+    host_le = *(const unsigned char *)&one == 1;
+
+    for (; line < end; line = eol + 1, first = false)
+    {
+        if (!(eol = (const char *)memchr(line, '\n', end - line)))
+            return false;
+
+        std::vector<std::string> words;
+        for (const char *p = skip_space(line, eol), *q; p < eol; p = skip_space(q, eol))
+        {
+            q = skip_token(p, eol);
+            words.push_back(std::string(p, q));
+        }
+
+        if (first)
+        {
+            if (words.size() != 1 || words[0] != "ply")
+                return false;
+        }
+        else if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+            continue;
+        else if (words[0] == "format" && words.size() >= 2)
+        {
+            if (words[1] == "ascii")
+                format = PLY_ASCII;
+            else if (words[1] == "binary_little_endian")
+                format = PLY_BINARY_LE;
+            else if (words[1] == "binary_big_endian")
+                format = PLY_BINARY_BE;
+            else
+                return false;
+        }
+        else if (words[0] == "element" && words.size() == 3)
+        {
+            ply_element e;
+            e.name = words[1];
+            e.count = (uint)strtoul(words[2].c_str(), NULL, 10);
+            elements.push_back(e);
+        }
+        else if (words[0] == "property" && !elements.empty())
+        {
+            ply_property prop;
+
+            if (words.size() == 5 && words[1] == "list")
+            {
+                prop.count_type = ply_parse_type(words[2]);
+                prop.type = ply_parse_type(words[3]);
+                prop.name = words[4];
+                if (prop.count_type == PLY_NONE)
+                    return false;
+            }
+            else if (words.size() == 3)
+            {
+                prop.count_type = PLY_NONE;
+                prop.type = ply_parse_type(words[1]);
+                prop.name = words[2];
+            }
+            else
+                return false;
+
+            if (prop.type == PLY_NONE)
+                return false;
+            elements.back().props.push_back(prop);
+        }
+        else if (words[0] == "end_header")
+        {
+            if (format < 0)
+                return false;
+
+            c.p = eol + 1;
+            c.end = end;
+            c.format = format;
+            c.swap = format != PLY_ASCII && host_le != (format == PLY_BINARY_LE);
+            return true;
+        }
+        else
+            return false;
+    }
+
+    return false;
+}
+
+static int ply_find(const ply_element& e, const char *name)
+{
+    for (uint i = 0; i < e.props.size(); i++)
+        if (e.props[i].name == name && e.props[i].count_type == PLY_NONE)
+            return (int)i;
+    return -1;
+}
+
+bool mx_read_ply(const char *filename, MxStdModel& m)
+{
+    if (m.vert_count() || m.face_count())
+        return false;
+
+    MxMappedFile file(filename);
+    std::vector<ply_element> elements;
+    ply_cursor c;
+
+    if (!file.is_open() || !ply_read_header(file, c, elements))
+        return false;
+
+    MxDynBlock<float> positions(2), normals(2), colors(2);
+    MxDynBlock<uint> corners(2), poly(16);
+    MxDynBlock<double> values(16);
+    bool has_vertices = false, has_normals = false, has_colors = false;
+    uint nverts = 0, i, j, k;
+
+    for (uint ei = 0; ei < elements.size(); ei++)
+    {
+        const ply_element& e = elements[ei];
+        uint nprops = (uint)e.props.size();
+
+        values.room_for(MAX(nprops, 1u));
+
+        if (e.name == "vertex" && !has_vertices)
+        {
+            int pos[3] = { ply_find(e, "x"), ply_find(e, "y"), ply_find(e, "z") };
+            int nrm[3] = { ply_find(e, "nx"), ply_find(e, "ny"), ply_find(e, "nz") };
+            int rgb[3] = { ply_find(e, "red"), ply_find(e, "green"), ply_find(e, "blue") };
+            float rgb_scale[3];
+            uint stride = 0, offsets[64];
+            bool fixed = c.format != PLY_ASCII && nprops <= 64;
+
+            if (pos[X] < 0 || pos[Y] < 0 || pos[Z] < 0)
+                return false;
+
+            has_vertices = true;
+            has_normals = nrm[X] >= 0 && nrm[Y] >= 0 && nrm[Z] >= 0;
+            has_colors = rgb[0] >= 0 && rgb[1] >= 0 && rgb[2] >= 0;
+            for (k = 0; k < 3; k++)
+                rgb_scale[k] = !has_colors || e.props[rgb[k]].type >= PLY_FLOAT32 ? 1.0f : 1.0f / 255.0f;
+
+            nverts = e.count;
+            positions.room_for(3 * nverts);
+            if (has_normals)
+                normals.room_for(3 * nverts);
+            if (has_colors)
+                colors.room_for(3 * nverts);
+
+            for (j = 0; fixed && j < nprops; j++)
+            {
+                offsets[j] = stride;
+                stride += ply_type_sizes[e.props[j].type];
+                fixed = e.props[j].count_type == PLY_NONE;
+            }
+
+            if (fixed)
+            {
+                // Binary records of one size decode in parallel
+                if ((size_t)(c.end - c.p) / stride < nverts)
+                    return false;
+
+                const char *base = c.p;
+                mx_parallel_for(nverts, [&](uint v)
+                {
+                    const char *r = base + (size_t)v * stride;
+
+                    for (uint a = 0; a < 3; a++)
+                    {
+                        positions[3 * v + a] = (float)ply_decode(r + offsets[pos[a]], e.props[pos[a]].type, c.swap);
+                        if (has_normals)
+                            normals[3 * v + a] = (float)ply_decode(r + offsets[nrm[a]], e.props[nrm[a]].type, c.swap);
+                        if (has_colors)
+                            colors[3 * v + a] = (float)ply_decode(r + offsets[rgb[a]], e.props[rgb[a]].type, c.swap) * rgb_scale[a];
+                    }
+                }, 4096);
+                c.p += (size_t)nverts * stride;
+                continue;
+            }
+
+            for (i = 0; i < nverts; i++)
+            {
+                for (j = 0; j < nprops; j++)
+                    if (!ply_read_property(c, e.props[j], values[j]))
+                        return false;
+
+                for (k = 0; k < 3; k++)
+                {
+                    positions[3 * i + k] = (float)values[pos[k]];
+                    if (has_normals)
+                        normals[3 * i + k] = (float)values[nrm[k]];
+                    if (has_colors)
+                        colors[3 * i + k] = (float)values[rgb[k]] * rgb_scale[k];
+                }
+            }
+        }
+        else if (e.name == "face")
+        {
+            int list = -1;
+
+            for (j = 0; j < nprops; j++)
+                if (e.props[j].count_type != PLY_NONE &&
+                    (e.props[j].name == "vertex_indices" || e.props[j].name == "vertex_index"))
+                    list = (int)j;
+
+            for (i = 0; i < e.count; i++)
+            {
+                poly.reset();
+                for (j = 0; j < nprops; j++)
+                    if (!ply_read_property(c, e.props[j], values[j], (int)j == list ? &poly : NULL))
+                        return false;
+
+                // Polygons become fans around their first corner
+                for (k = 2; k < (uint)poly.length(); k++)
+                {
+                    corners.add(poly[0]);
+                    corners.add(poly[k - 1]);
+                    corners.add(poly[k]);
+                }
+            }
+        }
+        else
+        {
+            for (i = 0; i < e.count; i++)
+                for (j = 0; j < nprops; j++)
+                    if (!ply_read_property(c, e.props[j], values[j]))
+                        return false;
+        }
+    }
+
+    if (!has_vertices)
+        return false;
+
+    uint nfaces = corners.length() / 3;
+
+    for (i = 0; i < 3 * nfaces; i++)
+        if (corners[i] >= nverts)
+            return false;
+
+    m.reserve(nverts, nfaces);
+    for (i = 0; i < nverts; i++)
+        m.add_vertex(&positions[3 * i]);
+    for (i = 0; i < nfaces; i++)
+        m.add_face(&corners[3 * i]);
+
+    if (has_normals)
+    {
+        m.normal_binding(MX_PERVERTEX);
+        for (i = 0; i < nverts; i++)
+        {
+            mxv_unitize(&normals[3 * i], 3);
+            m.add_normal(normals[3 * i + X], normals[3 * i + Y], normals[3 * i + Z]);
+        }
+    }
+
+    if (has_colors)
+    {
+        m.color_binding(MX_PERVERTEX);
+        for (i = 0; i < nverts; i++)
+            m.add_color(colors[3 * i + 0], colors[3 * i + 1], colors[3 * i + 2]);
+    }
+
+    return true;
+}
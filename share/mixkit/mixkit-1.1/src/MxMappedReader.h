@@ -0,0 +1,62 @@
+#ifndef MXMAPPEDREADER_INCLUDED // -*- C++ -*-
+#define MXMAPPEDREADER_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+/************************************************************************
+
+  Memory-mapped model readers
+
+  The file is mapped instead of streamed and cut into chunks at line
+  boundaries. One parallel pass counts the vertices and faces of every
+  chunk, so the model blocks are sized once. A second parallel pass
+  parses the chunks at their known offsets. Then the vertices and faces
+  are added in file order.
+
+  mx_read_mapped() reads the plain subset of SMF and OBJ: vertices,
+  triangles, per-vertex colors and normals, and begin/end blocks that
+  leave the vertex numbering alone. Comments and the OBJ grouping
+  commands are skipped. For anything else, such as a transform, a quad
+  or a bad index, it returns false without touching the model, and the
+  caller should fall back to MxSMFReader or MxOBJReader. Models read
+  either way are identical.
+
+  mx_read_ply() reads ASCII and binary PLY. It takes the vertex position,
+  normal and color, and the vertex_indices list of each face. Polygons
+  are split into fans, and other elements and properties are skipped.
+
+ ************************************************************************/
+
+#include "MxStdModel.h"
+
+#include <stddef.h>
+
+class MxMappedFile
+{
+private:
+    const char *data;
+    size_t data_size;
+
+#if defined(_WIN32)
+    void *file, *mapping;
+#else
+    int fd;
+#endif
+
+public:
+    MxMappedFile(const char *filename);
+    ~MxMappedFile();
+
+    bool is_open() const { return data != NULL; }
+    const char *begin() const { return data; }
+    const char *end() const { return data + data_size; }
+    size_t size() const { return data_size; }
+};
+
+// Both read into an empty model and return false if they cannot
+extern bool mx_read_mapped(const char *filename, MxStdModel& m);
+extern bool mx_read_ply(const char *filename, MxStdModel& m);
+
+// MXMAPPEDREADER_INCLUDED
+#endif
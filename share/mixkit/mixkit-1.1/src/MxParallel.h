@@ -0,0 +1,61 @@
+#ifndef MXPARALLEL_INCLUDED // -*- C++ -*-
+#define MXPARALLEL_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+/************************************************************************
+
+  Thread helpers
+
+ ************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+inline uint mx_thread_count()
+{
+    uint n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+// Runs func(i) for i in [0, count) on up to nthreads threads, or on all
+// hardware threads when nthreads is 0, handing out grain consecutive
+// indices at a time. With one thread it is a plain loop on the caller.
+template<class F> inline void mx_parallel_for(uint count, const F& func, uint grain = 1, uint nthreads = 0)
+{
+    std::vector<std::thread> threads;
+    std::atomic<uint> next(0);
+    uint i;
+
+    if (nthreads == 0)
+        nthreads = mx_thread_count();
+    nthreads = MIN(nthreads, (count + grain - 1) / grain);
+
+    if (nthreads <= 1)
+    {
+        for (i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+
+    auto worker = [&]()
+    {
+        uint j, end;
+        while ((j = next.fetch_add(grain)) < count)
+            for (end = MIN(j + grain, count); j < end; j++)
+                func(j);
+    };
+
+    for (i = 1; i < nthreads; i++)
+        threads.push_back(std::thread(worker));
+
+    worker();
+
+    for (i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+// MXPARALLEL_INCLUDED
+#endif
@@ -0,0 +1,24 @@
+/************************************************************************
+
+  Fixed dimension n-D Quadric Error Metrics
+
+ ************************************************************************/
+
+#include "stdmix.h"
+#include "MxQMetricN.h"
+
+// The dimensions MxVdpmSlim::compute_dimension() can produce: position,
+// plus any of color (3), texture (2) and normal (3).
+MxQuadricSet *MxQuadricSet::create(uint dim, uint count)
+{
+    switch (dim)
+    {
+    case 3:  return new MxQuadricSetN<3>(count);
+    case 5:  return new MxQuadricSetN<5>(count);
+    case 6:  return new MxQuadricSetN<6>(count);
+    case 8:  return new MxQuadricSetN<8>(count);
+    case 9:  return new MxQuadricSetN<9>(count);
+    case 11: return new MxQuadricSetN<11>(count);
+    default: return NULL;
+    }
+}
@@ -0,0 +1,332 @@
+#ifndef MXQMETRICN_INCLUDED // -*- C++ -*-
+#define MXQMETRICN_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+/************************************************************************
+
+  Fixed dimension n-D Quadric Error Metric
+
+  MxQuadricN<N> holds the same quadric as an N dimensional MxQuadric,
+  with the symmetric tensor packed and no heap allocations. All the
+  arithmetic is done in the same order as MxQuadric, so the results
+  are identical; SSE2 is only used where lanes are independent.
+
+ ************************************************************************/
+
+#include "MxQMetric.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MX_QUADRIC_SSE2
+#include <emmintrin.h>
+#endif
+
+// r[k] += s[k], for k in [0, n)
+inline void mxq_addinto(double *r, const double *s, uint n)
+{
+    uint k = 0;
+#ifdef MX_QUADRIC_SSE2
+    for (; k + 2 <= n; k += 2)
+        _mm_storeu_pd(r + k, _mm_add_pd(_mm_loadu_pd(r + k), _mm_loadu_pd(s + k)));
+#endif
+    for (; k < n; k++)
+        r[k] += s[k];
+}
+
+// r[k] -= s[k], for k in [0, n)
+inline void mxq_subfrom(double *r, const double *s, uint n)
+{
+    uint k = 0;
+#ifdef MX_QUADRIC_SSE2
+    for (; k + 2 <= n; k += 2)
+        _mm_storeu_pd(r + k, _mm_sub_pd(_mm_loadu_pd(r + k), _mm_loadu_pd(s + k)));
+#endif
+    for (; k < n; k++)
+        r[k] -= s[k];
+}
+
+// r[k] -= s[k]*t, for k in [0, n)
+inline void mxq_subscaled(double *r, const double *s, double t, uint n)
+{
+    uint k = 0;
+#ifdef MX_QUADRIC_SSE2
+    __m128d tt = _mm_set1_pd(t);
+    for (; k + 2 <= n; k += 2)
+        _mm_storeu_pd(r + k, _mm_sub_pd(_mm_loadu_pd(r + k), _mm_mul_pd(_mm_loadu_pd(s + k), tt)));
+#endif
+    for (; k < n; k++)
+        r[k] -= s[k] * t;
+}
+
+// r[k] /= d, for k in [0, n)
+inline void mxq_invscale(double *r, double d, uint n)
+{
+    uint k = 0;
+#ifdef MX_QUADRIC_SSE2
+    __m128d dd = _mm_set1_pd(d);
+    for (; k + 2 <= n; k += 2)
+        _mm_storeu_pd(r + k, _mm_div_pd(_mm_loadu_pd(r + k), dd));
+#endif
+    for (; k < n; k++)
+        r[k] /= d;
+}
+
+template<uint N>
+class MxQuadricN
+{
+public:
+    enum { TENSOR = N * (N + 1) / 2, SIZE = TENSOR + N + 2 };
+
+private:
+    double q[SIZE];     // upper triangle of A by rows, b, c, r
+
+    static uint index(uint i, uint j)
+    {
+        if (i > j) { uint t = i; i = j; j = t; }
+        return i * N - i * (i + 1) / 2 + j;
+    }
+
+public:
+    void clear() { for (uint k = 0; k < SIZE; k++) q[k] = 0.0; }
+
+    double offset() const { return q[TENSOR + N]; }
+    double area() const { return q[TENSOR + N + 1]; }
+
+    MxQuadricN& operator=(const MxQuadric& Q)
+    {
+        uint i, j;
+
+        AssertBound(Q.vector().dim() == N);
+
+        for (i = 0; i < N; i++)  for (j = i; j < N; j++)
+            q[index(i, j)] = Q.tensor()(i, j);
+
+        for (i = 0; i < N; i++)
+            q[TENSOR + i] = Q.vector()[i];
+
+        q[TENSOR + N] = Q.offset();
+        q[TENSOR + N + 1] = Q.area();
+        return *this;
+    }
+
+    MxQuadricN& operator+=(const MxQuadricN& Q) { mxq_addinto(q, Q.q, SIZE); return *this; }
+    MxQuadricN& operator-=(const MxQuadricN& Q) { mxq_subfrom(q, Q.q, SIZE); return *this; }
+
+    // Expand the tensor to a dense N*N matrix
+    void tensor(double *A) const
+    {
+        for (uint i = 0; i < N; i++)  for (uint j = 0; j < N; j++)
+            A[i * N + j] = q[index(i, j)];
+    }
+
+    // Same as MxQuadric::evaluate(), with A from tensor()
+    double evaluate(const double *A, const double *v) const
+    {
+        const double *b = q + TENSOR;
+        double Av[N], vAv = 0.0, bv = 0.0;
+        uint i = 0, j;
+
+#ifdef MX_QUADRIC_SSE2
+        // Rows i and i+1 of A are columns of the symmetric A, contiguous in row j
+        for (; i + 2 <= N; i += 2)
+        {
+            __m128d r = _mm_setzero_pd();
+            for (j = 0; j < N; j++)
+                r = _mm_add_pd(r, _mm_mul_pd(_mm_loadu_pd(A + j * N + i), _mm_set1_pd(v[j])));
+            _mm_storeu_pd(Av + i, r);
+        }
+#endif
+        for (; i < N; i++)
+        {
+            Av[i] = 0.0;
+            for (j = 0; j < N; j++)
+                Av[i] += A[i * N + j] * v[j];
+        }
+
+        for (i = 0; i < N; i++)  vAv += v[i] * Av[i];
+        for (i = 0; i < N; i++)  bv += b[i] * v[i];
+
+        return vAv + 2 * bv + offset();
+    }
+
+    double evaluate(const double *v) const
+    {
+        double A[N * N];
+        tensor(A);
+        return evaluate(A, v);
+    }
+
+    // Same as MxQuadric::optimize(), with A from tensor()
+    bool optimize(const double *A, double *v) const;
+};
+
+// Same Gauss-Jordan elimination with partial pivoting as mxm_invert()
+template<uint N>
+inline double mxq_invert(double *A, double *B)
+{
+    uint i, j, k;
+    double max, t, det, pivot;
+
+    for (i = 0; i < N; i++)  for (j = 0; j < N; j++)
+        B[i * N + j] = (double)(i == j);
+
+    det = 1.0;
+    for (i = 0; i < N; i++)
+    {
+        max = -1.;
+        for (k = i; k < N; k++)
+            if (fabs(A[k * N + i]) > max)
+            {
+                max = fabs(A[k * N + i]);
+                j = k;
+            }
+        if (max <= 0.) return 0.;
+        if (j != i)
+        {
+            for (k = i; k < N; k++)
+            {
+                t = A[i * N + k];  A[i * N + k] = A[j * N + k];  A[j * N + k] = t;
+            }
+            for (k = 0; k < N; k++)
+            {
+                t = B[i * N + k];  B[i * N + k] = B[j * N + k];  B[j * N + k] = t;
+            }
+            det = -det;
+        }
+        pivot = A[i * N + i];
+        det *= pivot;
+        mxq_invscale(A + i * N + i + 1, pivot, N - i - 1);
+        mxq_invscale(B + i * N, pivot, N);
+
+        for (j = i + 1; j < N; j++)
+        {
+            t = A[j * N + i];
+            mxq_subscaled(A + j * N + i + 1, A + i * N + i + 1, t, N - i - 1);
+            mxq_subscaled(B + j * N, B + i * N, t, N);
+        }
+    }
+
+    for (i = N - 1; i > 0; i--)
+    {
+        for (j = 0; j < i; j++)
+        {
+            t = A[j * N + i];
+            mxq_subscaled(B + j * N, B + i * N, t, N);
+        }
+    }
+    return det;
+}
+
+template<uint N>
+bool MxQuadricN<N>::optimize(const double *A, double *v) const
+{
+    const double *b = q + TENSOR;
+    double A2[N * N], Ainv[N * N];
+    uint i, j;
+
+    for (i = 0; i < N * N; i++)
+        A2[i] = A[i];
+
+    double det = mxq_invert<N>(A2, Ainv);
+    if (FEQ(det, 0.0, 1e-12))
+        return false;
+
+    // v = -(Ainv * b)
+    for (i = 0; i < N; i++)
+    {
+        double r = 0.0;
+        for (j = 0; j < N; j++)
+            r += Ainv[i * N + j] * b[j];
+        v[i] = -r;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// A block of quadrics, one per vertex, whose dimension is only known at
+// runtime. create() picks the MxQuadricN<N> instance once; the virtual
+// calls then run without any allocation.
+//
+
+class MxQuadricSet
+{
+public:
+    virtual ~MxQuadricSet() { }
+
+    virtual void set(uint i, const MxQuadric& Q) = 0;
+    virtual void set(uint i, const MxQuadricSet& S, uint j) = 0;    // Q_i = S_j, S of the same dimension
+    virtual void add(uint i, const MxQuadric& Q) = 0;
+    virtual void add(uint i, const MxQuadricSet& S, uint j) = 0;    // Q_i += S_j, S of the same dimension
+    virtual void add(uint i, uint j) = 0;        // Q_i += Q_j
+    virtual void subtract(uint i, uint j) = 0;   // Q_i -= Q_j
+
+    // With Q = Q_i + Q_j: evaluate Q at v, or place v at its minimum and
+    // evaluate it there. optimize() returns false if Q is singular.
+    virtual double evaluate(uint i, uint j, const double *v, double *area) const = 0;
+    virtual bool optimize(uint i, uint j, double *v, double *err, double *area) const = 0;
+
+    // Returns NULL if dim is not one of MxVdpmSlim's dimensions
+    static MxQuadricSet *create(uint dim, uint count);
+};
+
+template<uint N>
+class MxQuadricSetN : public MxQuadricSet
+{
+private:
+    MxBlock< MxQuadricN<N> > quadrics;
+
+public:
+    MxQuadricSetN(uint count) : quadrics(count)
+    {
+        for (uint i = 0; i < count; i++)
+            quadrics(i).clear();
+    }
+
+    virtual void set(uint i, const MxQuadric& Q) { quadrics(i) = Q; }
+    virtual void set(uint i, const MxQuadricSet& S, uint j)
+    {
+        quadrics(i) = static_cast<const MxQuadricSetN<N>&>(S).quadrics(j);
+    }
+    virtual void add(uint i, const MxQuadric& Q)
+    {
+        MxQuadricN<N> Qn;
+        Qn = Q;
+        quadrics(i) += Qn;
+    }
+    virtual void add(uint i, const MxQuadricSet& S, uint j)
+    {
+        quadrics(i) += static_cast<const MxQuadricSetN<N>&>(S).quadrics(j);
+    }
+    virtual void add(uint i, uint j) { quadrics(i) += quadrics(j); }
+    virtual void subtract(uint i, uint j) { quadrics(i) -= quadrics(j); }
+
+    virtual double evaluate(uint i, uint j, const double *v, double *area) const
+    {
+        MxQuadricN<N> Q = quadrics(i);
+        Q += quadrics(j);
+
+        *area = Q.area();
+        return Q.evaluate(v);
+    }
+
+    virtual bool optimize(uint i, uint j, double *v, double *err, double *area) const
+    {
+        MxQuadricN<N> Q = quadrics(i);
+        double A[N * N];
+
+        Q += quadrics(j);
+        Q.tensor(A);
+
+        *area = Q.area();
+        if (!Q.optimize(A, v))
+            return false;
+
+        *err = Q.evaluate(A, v);
+        return true;
+    }
+};
+
+// MXQMETRICN_INCLUDED
+#endif
@@ -0,0 +1,122 @@
+/************************************************************************
+
+  Growable record arrays that can spill to disk
+
+ ************************************************************************/
+
+#include "stdmix.h"
+#include "MxSpillBlock.h"
+
+#include <string>
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#else
+#  include <stdlib.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+MxSpillFile::MxSpillFile()
+{
+    data = NULL;
+    data_size = 0;
+
+#if defined(_WIN32)
+    file = INVALID_HANDLE_VALUE;
+    mapping = NULL;
+#else
+    fd = -1;
+#endif
+}
+
+MxSpillFile::~MxSpillFile()
+{
+    unmap();
+
+#if defined(_WIN32)
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+#else
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+void MxSpillFile::unmap()
+{
+#if defined(_WIN32)
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    mapping = NULL;
+#else
+    if (data)
+        munmap(data, data_size);
+#endif
+
+    data = NULL;
+    data_size = 0;
+}
+
+bool MxSpillFile::open(const char *dir)
+{
+#if defined(_WIN32)
+    char name[MAX_PATH];
+
+    if (!GetTempFileNameA(dir, "vdp", 0, name))
+        return false;
+
+    // The file goes away with its last handle
+    file = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                       FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        DeleteFileA(name);
+        return false;
+    }
+#else
+    std::string name = std::string(dir) + "/vdpmXXXXXX";
+
+    fd = mkstemp(&name[0]);
+    if (fd < 0)
+        return false;
+
+    // The file goes away with its descriptor
+    unlink(name.c_str());
+#endif
+
+    return true;
+}
+
+char *MxSpillFile::resize(size_t size)
+{
+    unmap();
+
+#if defined(_WIN32)
+    unsigned long long n = size;
+
+    // Mapping more than the file holds extends it
+    mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(n >> 32), (DWORD)n, NULL);
+    if (!mapping)
+        return NULL;
+
+    data = (char *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+#else
+    void *p;
+
+    if (ftruncate(fd, (off_t)size) != 0)
+        return NULL;
+
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED)
+        data = (char *)p;
+#endif
+
+    if (data)
+        data_size = size;
+    return data;
+}
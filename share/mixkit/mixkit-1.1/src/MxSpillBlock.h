@@ -0,0 +1,134 @@
+#ifndef MXSPILLBLOCK_INCLUDED // -*- C++ -*-
+#define MXSPILLBLOCK_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+/************************************************************************
+
+  Growable record arrays that can spill to disk
+
+  MxSpillBlock keeps plain records in one contiguous array that doubles
+  as it fills, like MxDynBlock. The array starts on the heap. After
+  spill_to() it lives in a temporary file instead, mapped into memory
+  and remapped whenever it grows, so the system pages the records out
+  rather than holding them all in the heap. The file is deleted when
+  the block is.
+
+  Records are moved with memcpy and never constructed or destructed.
+  References into the block are invalidated when it grows.
+
+ ************************************************************************/
+
+#include "MxDynBlock.h"
+
+#include <stddef.h>
+
+class MxSpillFile
+{
+private:
+    char *data;
+    size_t data_size;
+
+#if defined(_WIN32)
+    void *file, *mapping;
+#else
+    int fd;
+#endif
+
+    void unmap();
+
+public:
+    MxSpillFile();
+    ~MxSpillFile();
+
+    // Creates an empty temporary file in dir
+    bool open(const char *dir);
+
+    // Sets the file size and remaps it; the contents are kept
+    char *resize(size_t size);
+
+    char *begin() { return data; }
+    size_t size() const { return data_size; }
+};
+
+template<class T>
+class MxSpillBlock
+{
+private:
+    T *block;
+    uint fill, space;
+    MxSpillFile *file;		// NULL while the records are on the heap
+
+    void reserve(uint n)
+    {
+        if (file)
+            block = (T *)file->resize(sizeof(T) * (size_t)n);
+        else
+            block = (T *)realloc(block, sizeof(T) * (size_t)n);
+
+        if (!block)
+            mxmsg_signal(MXMSG_FATAL, "Unable to grow a record block.");
+        space = n;
+    }
+
+    // Blocks own their memory and are not copied
+    MxSpillBlock(const MxSpillBlock&);
+    MxSpillBlock& operator=(const MxSpillBlock&);
+
+public:
+    MxSpillBlock(uint n=2) : block(NULL), fill(0), space(0), file(NULL) { reserve(MAX(n, 1u)); }
+    ~MxSpillBlock() { if (file) delete file; else free(block); }
+
+    // Moves the records to a temporary file in dir. Returns false and
+    // stays on the heap if the file cannot be created.
+    bool spill_to(const char *dir)
+    {
+        MxSpillFile *f;
+        T *p;
+
+        if (file)
+            return true;
+
+        f = new MxSpillFile;
+        if (!f->open(dir) || !(p = (T *)f->resize(sizeof(T) * (size_t)space)))
+        {
+            delete f;
+            return false;
+        }
+
+        memcpy(p, block, sizeof(T) * (size_t)fill);
+        free(block);
+        block = p;
+        file = f;
+        return true;
+    }
+
+    bool is_spilled() const { return file != NULL; }
+
+    uint length() const { return fill; }
+
+    T&       operator[](uint i)       { AssertBound(i < fill); return block[i]; }
+    const T& operator[](uint i) const { AssertBound(i < fill); return block[i]; }
+    T&       operator()(uint i)       { return (*this)[i]; }
+    const T& operator()(uint i) const { return (*this)[i]; }
+
+    T       *begin()       { return block; }
+    const T *begin() const { return block; }
+
+    T&       last()       { return (*this)[fill - 1]; }
+    const T& last() const { return (*this)[fill - 1]; }
+
+    T& add()
+    {
+        if (fill == space)  reserve(space * 2);
+        return block[fill++];
+    }
+
+    void add(const T& t) { add() = t; }
+    void drop(uint d=1) { fill -= d; }
+    void reset() { fill = 0; }
+};
+
+// MXSPILLBLOCK_INCLUDED
+#endif
@@ -93,6 +93,15 @@ MxStdModel *MxStdModel::clone()
     return m;
 }
 
+void MxStdModel::reserve(uint nvert, uint nface)
+{
+    MxBlockModel::reserve(nvert, nface);
+
+    if( v_data.total_space() < (int)nvert )  v_data.resize(nvert);
+    if( face_links.total_space() < (int)nvert )  face_links.resize(nvert);
+    if( f_data.total_space() < (int)nface )  f_data.resize(nface);
+}
+
 void MxStdModel::mark_neighborhood(MxVertexID vid, unsigned short mark)
 {
     AssertBound( vid < vert_count() ); 
@@ -102,6 +102,7 @@ public:
 	}
     virtual ~MxStdModel();
     MxStdModel *clone();
+    void reserve(uint nvert, uint nface);
 
     ////////////////////////////////////////////////////////////////////////
     //  Tagging and marking
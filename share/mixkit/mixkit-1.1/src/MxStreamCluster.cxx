@@ -0,0 +1,570 @@
+/************************************************************************
+
+  Out-of-core vertex clustering
+
+ ************************************************************************/
+
+#include "stdmix.h"
+#include "MxStreamCluster.h"
+#include "MxGeom3D.h"
+#include "MxVector.h"
+
+#include <float.h>
+#include <algorithm>
+#include <unordered_set>
+
+#define STREAM_MAXLINE 65536
+
+// Vertices this close in the spill file are read in one run
+#define STREAM_GAP 64
+
+// Holes with at most this many edges are below the grid resolution
+#define STREAM_HOLE 8
+
+// Pieces with fewer faces than this are clustering debris
+#define STREAM_DEBRIS 16
+
+#if defined(_MSC_VER)
+#  define mx_fseek64 _fseeki64
+#else
+#  define mx_fseek64 fseeko
+#endif
+
+static bool sorted_less(const uint *a, const uint *b)
+{
+    uint s[3] = { a[0], a[1], a[2] }, t[3] = { b[0], b[1], b[2] };
+
+    std::sort(s, s + 3);
+    std::sort(t, t + 3);
+    return std::lexicographical_compare(s, s + 3, t, t + 3);
+}
+
+static unsigned long long edge_key(uint a, uint b)
+{
+    return ((unsigned long long)a << 32) | b;
+}
+
+MxStreamCluster::MxStreamCluster(uint g, uint w)
+    : grid(MAX(g, 1u)), window(MAX(w, 1u)), spill(NULL), cell_size(0.0f)
+{
+    input_verts = input_faces = 0;
+    dims[0] = dims[1] = dims[2] = 1;
+}
+
+MxStreamCluster::~MxStreamCluster()
+{
+    if (spill)
+        fclose(spill);
+}
+
+bool MxStreamCluster::spill_vertices(FILE *in)
+{
+    char *line = new char[STREAM_MAXLINE];
+    bool result = false;
+    uint i;
+
+    for (i = 0; i < 3; i++)
+    {
+        bounds[0][i] = FLT_MAX;
+        bounds[1][i] = -FLT_MAX;
+    }
+
+    while (fgets(line, STREAM_MAXLINE, in))
+    {
+        char *op = strtok(line, " \t\r\n");
+        float v[3];
+
+        if (!op || !streq(op, "v"))
+            continue;
+
+        for (i = 0; i < 3; i++)
+        {
+            char *arg = strtok(NULL, " \t\r\n");
+
+            v[i] = arg ? (float)atof(arg) : 0.0f;
+            bounds[0][i] = MIN(bounds[0][i], v[i]);
+            bounds[1][i] = MAX(bounds[1][i], v[i]);
+        }
+
+        if (fwrite(v, sizeof(float), 3, spill) != 3)
+            goto error;
+
+        input_verts++;
+    }
+
+    result = !ferror(in);
+
+error:
+    delete[] line;
+    return result;
+}
+
+uint MxStreamCluster::cell_of(const float *v)
+{
+    uint index[3], i;
+
+    for (i = 0; i < 3; i++)
+    {
+        index[i] = (uint)((v[i] - bounds[0][i]) / cell_size);
+        index[i] = MIN(index[i], dims[i] - 1);
+    }
+
+    unsigned long long key = ((unsigned long long)index[2] * dims[1] + index[1]) * dims[0] + index[0];
+    std::unordered_map<unsigned long long, uint>::iterator it = cell_ids.find(key);
+
+    if (it != cell_ids.end())
+        return it->second;
+
+    cell& c = cells.add();
+
+    c.Q.clear();
+    c.sum[X] = c.sum[Y] = c.sum[Z] = 0.0;
+    c.count = 0;
+    for (i = 0; i < 3; i++)
+        c.index[i] = index[i];
+
+    cell_ids[key] = cells.last_id();
+    return cells.last_id();
+}
+
+bool MxStreamCluster::fetch_positions()
+{
+    uint i, j, k;
+
+    verts.reset();
+    for (i = 0; i < (uint)faces.length(); i++)
+        for (k = 0; k < 3; k++)
+            verts.add(faces(i).v[k]);
+
+    std::sort(verts.begin(), verts.end());
+    verts.drop(verts.length() - (int)(std::unique(verts.begin(), verts.end()) - verts.begin()));
+
+    uint n = verts.length();
+
+    positions.room_for(3 * n);
+
+    for (i = 0; i < n; i = j)
+    {
+        for (j = i + 1; j < n && verts(j) - verts(j - 1) <= STREAM_GAP; j++)
+            ;
+
+        uint first = verts(i), span = verts(j - 1) - first + 1;
+
+        run.room_for(3 * span);
+        if (mx_fseek64(spill, (long long)first * 3 * sizeof(float), SEEK_SET) != 0 ||
+            fread(&run(0), 3 * sizeof(float), span, spill) != span)
+            return false;
+
+        for (k = i; k < j; k++)
+        {
+            const float *p = &run(3 * (verts(k) - first));
+
+            positions(3 * k + X) = p[X];
+            positions(3 * k + Y) = p[Y];
+            positions(3 * k + Z) = p[Z];
+        }
+    }
+    return true;
+}
+
+bool MxStreamCluster::flush_window()
+{
+    uint i, k;
+
+    if (faces.length() == 0)
+        return true;
+
+    if (!fetch_positions())
+        return false;
+
+    for (i = 0; i < (uint)faces.length(); i++)
+    {
+        const float *p[3];
+        uint c[3];
+
+        for (k = 0; k < 3; k++)
+        {
+            uint at = (uint)(std::lower_bound(verts.begin(), verts.end(), faces(i).v[k]) - verts.begin());
+
+            p[k] = &positions(3 * at);
+            c[k] = cell_of(p[k]);
+
+            cell& C = cells(c[k]);
+            C.sum[X] += p[k][X];
+            C.sum[Y] += p[k][Y];
+            C.sum[Z] += p[k][Z];
+            C.count++;
+        }
+
+        Vec3 v1(p[0]), v2(p[1]), v3(p[2]);
+        double area = triangle_area(v1, v2, v3);
+
+        // Like MX_WEIGHT_AREA, once into each cell the face touches
+        if (area > 0.0)
+        {
+            Vec4 plane = triangle_plane<Vec3,Vec4>(v1, v2, v3);
+            MxQuadric3 Q(plane[X], plane[Y], plane[Z], plane[W], area);
+
+            Q *= Q.area();
+            cells(c[0]).Q += Q;
+            if (c[1] != c[0])
+                cells(c[1]).Q += Q;
+            if (c[2] != c[0] && c[2] != c[1])
+                cells(c[2]).Q += Q;
+        }
+
+        if (c[0] != c[1] && c[1] != c[2] && c[2] != c[0])
+        {
+            triangle& t = triangles.add();
+
+            t.v[0] = c[0];
+            t.v[1] = c[1];
+            t.v[2] = c[2];
+        }
+    }
+
+    faces.reset();
+    return true;
+}
+
+// Keeps one face per set of three cells. Many input faces collapse onto the
+// same cells, and a folded sheet collapses onto both orientations. A face
+// that repeats a directed edge of a kept face is dropped too, so every edge
+// ends up with at most two consistently oriented faces, as MxVdpmSlim needs.
+void MxStreamCluster::merge_triangles()
+{
+    std::unordered_set<unsigned long long> edges;
+    uint i, k, n = 0;
+
+    std::sort(triangles.begin(), triangles.end(),
+        [](const triangle& a, const triangle& b) { return sorted_less(a.v, b.v); });
+
+    for (i = 0; i < (uint)triangles.length(); i++)
+    {
+        const uint *v = triangles(i).v;
+        unsigned long long e[3];
+
+        if (n > 0 && !sorted_less(triangles(n - 1).v, v))
+            continue;
+
+        for (k = 0; k < 3; k++)
+            e[k] = edge_key(v[k], v[(k + 1) % 3]);
+
+        if (edges.count(e[0]) || edges.count(e[1]) || edges.count(e[2]))
+            continue;
+
+        edges.insert(e, e + 3);
+        triangles(n++) = triangles(i);
+    }
+
+    triangles.drop(triangles.length() - n);
+}
+
+// Gives each fan around a cell its own vertex. Dropping faces above can
+// leave cells whose faces meet only at the cell, which the runtime cannot
+// split. Fan k > 0 of a cell gets a new vertex at the same position.
+void MxStreamCluster::split_vertices()
+{
+    uint n = cells.length(), corner_count = 3 * triangles.length(), i, j, k;
+    MxBlock<uint> start(n + 1), corners(MAX(corner_count, 1u)), fan(MAX(corner_count, 1u));
+
+    vertex_cells.reset();
+    for (i = 0; i < n; i++)
+        vertex_cells.add(i);
+
+    for (i = 0; i <= n; i++)
+        start(i) = 0;
+    for (i = 0; i < corner_count; i++)
+        start(triangles(i / 3).v[i % 3] + 1)++;
+    for (i = 0; i < n; i++)
+        start(i + 1) += start(i);
+    for (i = 0; i < corner_count; i++)
+        corners(start(triangles(i / 3).v[i % 3])++) = i;
+    for (i = n; i > 0; i--)
+        start(i) = start(i - 1);
+    start(0) = 0;
+
+    for (uint c = 0; c < n; c++)
+    {
+        uint first = start(c), count = start(c + 1) - first, fans = 0;
+
+        // Corners are in the same fan when their faces share an edge
+        for (i = 0; i < count; i++)
+            fan(first + i) = i;
+
+        for (i = 0; i < count; i++)
+            for (j = i + 1; j < count; j++)
+            {
+                uint a = corners(first + i), b = corners(first + j);
+                const uint *fa = triangles(a / 3).v, *fb = triangles(b / 3).v;
+
+                if (fan(first + i) != fan(first + j) &&
+                    (fa[(a + 1) % 3] == fb[(b + 2) % 3] || fb[(b + 1) % 3] == fa[(a + 2) % 3]))
+                {
+                    uint from = fan(first + j), to = fan(first + i);
+
+                    for (k = 0; k < count; k++)
+                        if (fan(first + k) == from)
+                            fan(first + k) = to;
+                }
+            }
+
+        for (i = 0; i < count; i++)
+        {
+            uint label = fan(first + i), v;
+
+            if (label == UINT_MAX)
+                continue;
+
+            v = fans++ ? vertex_cells.length() : c;
+            if (v != c)
+                vertex_cells.add(c);
+
+            for (k = i; k < count; k++)
+                if (fan(first + k) == label)
+                {
+                    triangles(corners(first + k) / 3).v[corners(first + k) % 3] = v;
+                    fan(first + k) = UINT_MAX;
+                }
+        }
+    }
+}
+
+static uint find_root(MxBlock<uint>& parent, uint x)
+{
+    while (parent(x) != x)
+        x = parent(x) = parent(parent(x));
+    return x;
+}
+
+// Removes the small pieces that thin features break into. They would
+// otherwise collapse into closed solids of a face or two.
+void MxStreamCluster::remove_debris()
+{
+    uint n = MAX((uint)vertex_cells.length(), 1u), i, k, kept = 0;
+    MxBlock<uint> parent(n), size(n);
+
+    for (i = 0; i < n; i++)
+    {
+        parent(i) = i;
+        size(i) = 0;
+    }
+
+    for (i = 0; i < (uint)triangles.length(); i++)
+        for (k = 1; k < 3; k++)
+            parent(find_root(parent, triangles(i).v[k])) = find_root(parent, triangles(i).v[0]);
+
+    for (i = 0; i < (uint)triangles.length(); i++)
+        size(find_root(parent, triangles(i).v[0]))++;
+
+    for (i = 0; i < (uint)triangles.length(); i++)
+        if (size(find_root(parent, triangles(i).v[0])) >= STREAM_DEBRIS)
+            triangles(kept++) = triangles(i);
+
+    triangles.drop(triangles.length() - kept);
+}
+
+// Closes the small holes left where faces were dropped. The runtime cannot
+// refine a hierarchy that collapses such a hole down to a degenerate one.
+void MxStreamCluster::fill_holes()
+{
+    std::unordered_set<unsigned long long> edges;
+    std::unordered_map<uint, uint> next;        // around each hole
+    std::unordered_set<uint> seen;
+    uint i, k;
+
+    for (i = 0; i < (uint)triangles.length(); i++)
+        for (k = 0; k < 3; k++)
+            edges.insert(edge_key(triangles(i).v[k], triangles(i).v[(k + 1) % 3]));
+
+    for (i = 0; i < (uint)triangles.length(); i++)
+        for (k = 0; k < 3; k++)
+        {
+            uint a = triangles(i).v[k], b = triangles(i).v[(k + 1) % 3];
+
+            if (!edges.count(edge_key(b, a)))
+                next[b] = a;
+        }
+
+    for (std::unordered_map<uint, uint>::iterator it = next.begin(); it != next.end(); ++it)
+    {
+        uint loop[STREAM_HOLE + 1], n = 0, x = it->first;
+        bool open = true;
+
+        while (!seen.count(x))
+        {
+            seen.insert(x);
+            if (n <= STREAM_HOLE)
+                loop[n] = x;
+            n++;
+
+            std::unordered_map<uint, uint>::iterator to = next.find(x);
+            if (to == next.end())
+                break;
+            x = to->second;
+            open = (x != it->first);
+        }
+
+        if (open || n < 3 || n > STREAM_HOLE)
+            continue;
+
+        // A fan around loop[0], unless one of its diagonals is already an edge
+        for (k = 2; k + 1 < n; k++)
+            if (edges.count(edge_key(loop[0], loop[k])) || edges.count(edge_key(loop[k], loop[0])))
+                break;
+        if (k + 1 < n)
+            continue;
+
+        for (k = 1; k + 1 < n; k++)
+        {
+            triangle& t = triangles.add();
+
+            t.v[0] = loop[0];
+            t.v[1] = loop[k];
+            t.v[2] = loop[k + 1];
+        }
+    }
+}
+
+bool MxStreamCluster::read(const char *filename)
+{
+    FILE *in = fopen(filename, "r");
+    char *line = NULL;
+    bool result = false;
+    uint next_vertex = 1, i;
+    float extent = 0.0f;
+
+    if (!in)
+        return false;
+
+    line = new char[STREAM_MAXLINE];
+
+    spill = tmpfile();
+    if (!spill)
+    {
+        mxmsg_signal(MXMSG_WARN, "Failed to create the vertex spill file.");
+        goto error;
+    }
+
+    if (!spill_vertices(in) || input_verts == 0)
+        goto error;
+
+    for (i = 0; i < 3; i++)
+        extent = MAX(extent, bounds[1][i] - bounds[0][i]);
+
+    cell_size = (extent > 0.0f) ? extent / grid : 1.0f;
+    for (i = 0; i < 3; i++)
+        dims[i] = MIN(grid, (uint)((bounds[1][i] - bounds[0][i]) / cell_size) + 1);
+
+    rewind(in);
+    while (fgets(line, STREAM_MAXLINE, in))
+    {
+        char *op = strtok(line, " \t\r\n");
+        char *arg;
+        uint first = UINT_MAX, prev = UINT_MAX;
+
+        if (!op)
+            continue;
+        if (streq(op, "v"))
+        {
+            next_vertex++;
+            continue;
+        }
+        if (!streq(op, "f") && !streq(op, "t"))
+            continue;
+
+        // Polygons are split into fans around their first corner
+        while ((arg = strtok(NULL, " \t\r\n")) != NULL)
+        {
+            int id = atoi(arg);
+            uint v;
+
+            if (id < 0)
+                id += next_vertex;
+            if (id < 1 || (uint)id > input_verts)
+            {
+                mxmsg_signalf(MXMSG_WARN, "Face #%u refers to a missing vertex.  Ignoring it.", input_faces + 1);
+                break;
+            }
+            v = id - 1;
+
+            if (first == UINT_MAX)
+                first = v;
+            else if (prev == UINT_MAX)
+                prev = v;
+            else
+            {
+                triangle& t = faces.add();
+
+                t.v[0] = first;
+                t.v[1] = prev;
+                t.v[2] = v;
+                prev = v;
+                input_faces++;
+
+                if ((uint)faces.length() >= window && !flush_window())
+                    goto error;
+            }
+        }
+    }
+
+    if (ferror(in) || !flush_window())
+        goto error;
+
+    merge_triangles();
+    split_vertices();
+    remove_debris();
+    fill_holes();
+    result = true;
+
+error:
+    if (spill)
+    {
+        fclose(spill);
+        spill = NULL;
+    }
+    delete[] line;
+    fclose(in);
+    return result;
+}
+
+void MxStreamCluster::emit(MxStdModel& m) const
+{
+    MxBlock<uint> ids(MAX(vertex_cells.length(), 1));
+    uint i, k;
+
+    for (i = 0; i < (uint)vertex_cells.length(); i++)
+        ids(i) = UINT_MAX;
+
+    for (i = 0; i < (uint)triangles.length(); i++)
+    {
+        uint f[3];
+
+        for (k = 0; k < 3; k++)
+        {
+            uint v = triangles(i).v[k];
+
+            if (ids(v) == UINT_MAX)
+            {
+                const cell& C = cells(vertex_cells(v));
+                Vec3 p;
+                bool inside = C.Q.optimize(p);
+
+                for (uint j = 0; inside && j < 3; j++)
+                {
+                    double lo = bounds[0][j] + C.index[j] * cell_size;
+
+                    inside = p[j] >= lo && p[j] <= lo + cell_size;
+                }
+
+                if (!inside)
+                    p = Vec3(C.sum[X], C.sum[Y], C.sum[Z]) / (double)C.count;
+
+                ids(v) = m.add_vertex((float)p[X], (float)p[Y], (float)p[Z]);
+            }
+            f[k] = ids(v);
+        }
+
+        m.add_face(f[0], f[1], f[2]);
+    }
+}
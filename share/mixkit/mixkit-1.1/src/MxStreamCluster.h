@@ -0,0 +1,92 @@
+#ifndef MXSTREAMCLUSTER_INCLUDED // -*- C++ -*-
+#define MXSTREAMCLUSTER_INCLUDED
+#if !defined(__GNUC__)
+#  pragma once
+#endif
+
+/************************************************************************
+
+  Out-of-core vertex clustering
+
+  A lossy preprocessing step, not an out-of-core hierarchy. It reduces
+  an SMF or OBJ file that may not fit in memory to a mesh that does,
+  and MxVdpmSlim then builds the hierarchy from that mesh, so the finest
+  level is the clustered mesh rather than the input. The file is streamed
+  twice. The first pass spills the vertex positions to a temporary file
+  and measures the bounds. The second pass reads the faces in windows,
+  fetches the positions a window needs from the spill file, and adds the
+  quadric of every face to the grid cells of its corners. Memory grows
+  with the window and the number of occupied cells, not with the input.
+
+  Each cell becomes one vertex, placed at the minimum of its quadric when
+  that lies in the cell, otherwise at the mean of its corners. Faces
+  whose corners fall in three different cells survive, unless they would
+  make an edge non-manifold. Vertices are split until each has a single
+  fan, tiny pieces are dropped, and holes of a few edges are filled. Only
+  positions and v/f/t commands are read; properties, transforms and
+  begin/end blocks are ignored.
+
+ ************************************************************************/
+
+#include "MxStdModel.h"
+#include "MxQMetric3.h"
+
+#include <stdio.h>
+#include <unordered_map>
+
+class MxStreamCluster
+{
+private:
+    struct cell
+    {
+        MxQuadric3 Q;
+        double sum[3];          // corners that fell in the cell, for the fallback
+        uint count;
+        uint index[3];          // grid coordinates
+    };
+
+    struct triangle { uint v[3]; };
+
+    uint grid, window;
+    FILE *spill;                // positions, 3 floats per input vertex
+
+    float bounds[2][3];
+    float cell_size;
+    uint dims[3];
+
+    MxDynBlock<cell> cells;
+    std::unordered_map<unsigned long long, uint> cell_ids;
+    MxDynBlock<triangle> triangles;
+    MxDynBlock<uint> vertex_cells;  // cell of each output vertex
+
+    // One window of faces, and the sorted vertices they use
+    MxDynBlock<triangle> faces;
+    MxDynBlock<uint> verts;
+    MxDynBlock<float> positions;
+    MxDynBlock<float> run;      // one read from the spill file
+
+    bool spill_vertices(FILE *in);
+    bool fetch_positions();
+    uint cell_of(const float *v);
+    bool flush_window();
+    void merge_triangles();
+    void split_vertices();
+    void remove_debris();
+    void fill_holes();
+
+public:
+    uint input_verts, input_faces;
+
+    // grid cells along the longest side of the bounds, window faces per pass
+    MxStreamCluster(uint grid, uint window = 1 << 20);
+    ~MxStreamCluster();
+
+    // Streams filename, which must be seekable; returns false on failure
+    bool read(const char *filename);
+
+    // Adds the cluster vertices and the surviving faces to m
+    void emit(MxStdModel& m) const;
+};
+
+// MXSTREAMCLUSTER_INCLUDED
+#endif
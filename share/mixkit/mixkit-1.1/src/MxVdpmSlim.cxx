@@ -1,21 +1,42 @@
 #include "stdmix.h"
 #include "MxVdpmSlim.h"
 #include "MxGeom3D.h"
+#include "MxHausdorff.h"
+#include "MxParallel.h"
+
+#include <algorithm>
 
 #include "compute_error.h"
 #include "geomutils.h"
 #include "block_list.h"
 
-typedef MxQuadric Quadric;
+// A block of decimate_partitioned()
+class MxVdpmBlock
+{
+public:
+    MxDynBlock<MxFaceID> faces;		// valid faces, ascending; index is the local id
+    MxDynBlock<MxVertexID> verts;	// their corners, ascending; index is the local id
+
+    // Results, in ids of the whole model
+    MxDynBlock<MxVdpmPairContraction> contractions;
+    MxDynBlock<float> costs;
+    MxDynBlock<MxVertexID> survivors;	// interior vertices still valid
+    MxDynBlock<MxVertex> positions;
+    MxDynBlock<MxColor> colors;
+    MxDynBlock<MxNormal> normals;
+    MxDynBlock<MxTexCoord> texcoords;
+};
 
 MxVdpmSlim::MxVdpmSlim(MxStdModel *m0)
     : MxStdSlim(m0),
-    __quadrics(m0->vert_count()),
+    edges(3 * m0->vert_count() + 1),
+    edge_heap(3 * m0->vert_count() + 1),
     edge_links(m0->vert_count()),
     vertex_geoms(m0->vert_count()),
     vertex_radiuses(m0->vert_count()),
     face_normals(m0->face_count()),
-    vertex_neighbors(m0->vert_count())
+    vertex_neighbors(m0->vert_count()),
+    vertex_contractions(m0->vert_count())
 {
     consider_color();
     consider_texture();
@@ -36,20 +57,20 @@ MxVdpmSlim::MxVdpmSlim(MxStdModel *m0)
 
     bounds.complete();
 
+    for (MxVertexID v = 0; v < m->vert_count(); v++)
+        vertex_contractions(v) = UINT_MAX;
+
     will_decouple_quadrics = false;
+    hausdorff_freq = 0;
+    threads = 0;
+    quadrics = NULL;
+    block = NULL;
     contraction_callback = NULL;
 }
 
 MxVdpmSlim::~MxVdpmSlim()
 {
-    uint i;
-
-    // Delete everything remaining in the heap
-    for (i = 0; i < heap.size(); i++)
-        delete ((edge_info *)heap.item(i));
-
-    for (i = 0; i < quadric_count(); i++)
-        delete __quadrics[i];
+    delete quadrics;
 }
 
 void MxVdpmSlim::consider_color(bool will)
@@ -110,6 +131,34 @@ void MxVdpmSlim::pack_to_vector(MxVertexID id, MxVector& v)
     }
 }
 
+void MxVdpmSlim::pack_to_vector(MxVertexID id, float *v)
+{
+    SanityCheck(id < m->vert_count());
+
+    v[0] = m->vertex(id)[0];
+    v[1] = m->vertex(id)[1];
+    v[2] = m->vertex(id)[2];
+
+    uint i = 3;
+    if (use_color)
+    {
+        v[i++] = m->color(id).R();
+        v[i++] = m->color(id).G();
+        v[i++] = m->color(id).B();
+    }
+    if (use_texture)
+    {
+        v[i++] = m->texcoord(id)[0];
+        v[i++] = m->texcoord(id)[1];
+    }
+    if (use_normals)
+    {
+        v[i++] = m->normal(id)[0];
+        v[i++] = m->normal(id)[1];
+        v[i++] = m->normal(id)[2];
+    }
+}
+
 void MxVdpmSlim::pack_prop_to_vector(MxVertexID id, MxVector& v, uint target)
 {
     if (target == 0)
@@ -164,9 +213,8 @@ static inline void CLAMP(double& v, double lo, double hi)
     if (v > hi) v = hi;
 }
 
-void MxVdpmSlim::unpack_from_vector(MxVertexID id, MxVector& v)
+void MxVdpmSlim::unpack_from_vector(MxVertexID id, double *v)
 {
-    SanityCheck(v.dim() >= D);
     SanityCheck(id < m->vert_count());
 
     m->vertex(id)[0] = v[0];
@@ -195,6 +243,15 @@ void MxVdpmSlim::unpack_from_vector(MxVertexID id, MxVector& v)
     }
 }
 
+void MxVdpmSlim::unpack_from_vector(MxVertexID id, const float *v)
+{
+    double w[MXVDPM_MAXDIM];
+
+    for (uint i = 0; i < D; i++)
+        w[i] = v[i];
+    unpack_from_vector(id, w);
+}
+
 void MxVdpmSlim::unpack_prop_from_vector(MxVertexID id, MxVector& v, uint target)
 {
     if (target == 0)
@@ -293,23 +350,50 @@ void MxVdpmSlim::compute_face_quadric(MxFaceID i, MxQuadric& Q)
 
 void MxVdpmSlim::collect_quadrics()
 {
-    for (uint j = 0; j < quadric_count(); j++)
-        __quadrics[j] = new MxQuadric(dim());
-
-    for (MxFaceID i = 0; i < m->face_count(); i++)
+    // The dimension is settled now, so pick the fixed size quadrics once
+    delete quadrics;
+    quadrics = MxQuadricSet::create(dim(), m->vert_count());
+    SanityCheck(quadrics);
+
+    // Face quadrics are computed in parallel a block at a time. Each thread
+    // then owns a range of vertices and adds the block's quadrics to them in
+    // face order, so every sum is the same as a serial loop over the faces.
+    const uint block_size = 65536;
+    uint face_count = m->face_count(), vert_count = m->vert_count(), ranges = threads ? threads : mx_thread_count();
+    MxQuadricSet *face_quadrics = MxQuadricSet::create(dim(), MIN(block_size, face_count));
+
+    for (MxFaceID first = 0; first < face_count; first += block_size)
     {
-        MxFace& f = m->face(i);
+        uint count = MIN(block_size, face_count - first);
 
-        MxQuadric Q(dim());
-        compute_face_quadric(i, Q);
+        mx_parallel_for(count, [&](uint k)
+        {
+            MxQuadric Q(dim());
+            compute_face_quadric(first + k, Q);
+
+            // 	if( weight_by_area )
+            // 	    Q *= Q.area();
+
+            face_quadrics->set(k, Q);
+        }, 64, threads);
+
+        mx_parallel_for(ranges, [&](uint r)
+        {
+            MxVertexID lo = (MxVertexID)((double)vert_count * r / ranges);
+            MxVertexID hi = (MxVertexID)((double)vert_count * (r + 1) / ranges);
 
-        // 	if( weight_by_area )
-        // 	    Q *= Q.area();
+            for (uint k = 0; k < count; k++)
+            {
+                MxFace& f = m->face(first + k);
 
-        quadric(f[0]) += Q;
-        quadric(f[1]) += Q;
-        quadric(f[2]) += Q;
+                for (uint c = 0; c < 3; c++)
+                    if (f[c] >= lo && f[c] < hi)
+                        quadrics->add(f[c], *face_quadrics, k);
+            }
+        }, 1, threads);
     }
+
+    delete face_quadrics;
 }
 
 void MxVdpmSlim::initialize()
@@ -327,20 +411,13 @@ void MxVdpmSlim::initialize()
     is_initialized = true;
 }
 
-void MxVdpmSlim::compute_target_placement(edge_info *info)
+float MxVdpmSlim::compute_target_placement(edge_info& info)
 {
-    MxVertexID i = info->v1, j = info->v2;
+    MxVertexID i = info.v1, j = info.v2;
 
-    const MxQuadric &Qi = quadric(i), &Qj = quadric(j);
-    MxQuadric Q = Qi;  Q += Qj;
+    double err, area;
 
-    double err;
-
-    if (Q.optimize(info->target))
-    {
-        err = Q(info->target);
-    }
-    else
+    if (!quadrics->optimize(i, j, info.target, &err, &area))
     {
         // Fall back only on endpoints
 
@@ -349,27 +426,27 @@ void MxVdpmSlim::compute_target_placement(edge_info *info)
         pack_to_vector(i, v_i);
         pack_to_vector(j, v_j);
 
-        double e_i = Q(v_i);
-        double e_j = Q(v_j);
+        double e_i = quadrics->evaluate(i, j, v_i, &area);
+        double e_j = quadrics->evaluate(i, j, v_j, &area);
 
         if (e_i <= e_j)
         {
-            info->target = v_i;
+            mxv_set(info.target, v_i, dim());
             err = e_i;
         }
         else
         {
-            info->target = v_j;
+            mxv_set(info.target, v_j, dim());
             err = e_j;
         }
     }
 
     if (err < 0) err += 1e200; // The punishment of negative error, make it a great positive error
-    err += 1e-10 * Q.area();  // Make sure that area works even the error is zero
+    err += 1e-10 * area;  // Make sure that area works even the error is zero
 
     //     if( weight_by_area )
     // 	err / Q.area();
-    info->heap_key(-err);
+    return (float)-err;
 }
 
 bool MxVdpmSlim::decimate(uint target)
@@ -394,55 +471,52 @@ bool MxVdpmSlim::decimate(uint target)
 
     while (valid_faces > target)
     {
-        edge_info *info = (edge_info *)heap.extract();
-        if (!info)
+        uint e;
+        float key;
+
+        if (!edge_heap.extract(&e, &key))
             return false;
 
-        MxVertexID v1 = info->v1, v2 = info->v2;
+        MxVertexID v1 = edges(e).v1, v2 = edges(e).v2;
 
         if (m->vertex_is_valid(v1) && m->vertex_is_valid(v2))
         {
+            const double *t = edges(e).target;
+
             m->compute_contraction(v1, v2, &conx);
 
-            conx.dv1[X] = (float)info->target[X] - m->vertex(v1)[X];
-            conx.dv1[Y] = (float)info->target[Y] - m->vertex(v1)[Y];
-            conx.dv1[Z] = (float)info->target[Z] - m->vertex(v1)[Z];
-            conx.dv2[X] = (float)info->target[X] - m->vertex(v2)[X];
-            conx.dv2[Y] = (float)info->target[Y] - m->vertex(v2)[Y];
-            conx.dv2[Z] = (float)info->target[Z] - m->vertex(v2)[Z];
+            conx.dv1[X] = (float)t[X] - m->vertex(v1)[X];
+            conx.dv1[Y] = (float)t[Y] - m->vertex(v1)[Y];
+            conx.dv1[Z] = (float)t[Z] - m->vertex(v1)[Z];
+            conx.dv2[X] = (float)t[X] - m->vertex(v2)[X];
+            conx.dv2[Y] = (float)t[Y] - m->vertex(v2)[Y];
+            conx.dv2[Z] = (float)t[Z] - m->vertex(v2)[Z];
 
             pack_to_vector(v1, conx.vt);
             pack_to_vector(v2, conx.vu);
 
-            if (!conx.update_faces(*this))
+            // Inside a block, the locked cut would otherwise fan into one
+            // vertex of huge degree that the runtime cannot split reliably
+            if ((block && conx.delta_faces.length() > vertex_degree_limit) || !conx.update_faces(*this))
             {
-                uint i;
-
-                for (i = 0; i < edge_links(v1).size(); i++)
-                    if (edge_links(v1)(i) == info)
-                    {
-                        edge_links(v1).remove(i);
-                        break;
-                    }
-
-                for (i = 0; i < edge_links(v2).size(); i++)
-                    if (edge_links(v2)(i) == info)
-                    {
-                        edge_links(v2).remove(i);
-                        break;
-                    }
-
-                delete info;
+                unlink_edge(e, v1);
+                unlink_edge(e, v2);
+                free_edge(e);
                 continue;
             }
-            apply_contraction(conx, info);
+            apply_contraction(conx, e);
 
             pack_to_vector(v1, conx.vs);
 
-            if (contraction_callback)
-                (*contraction_callback)(conx, -info->heap_key());
+            if (block)
+            {
+                block->contractions.add(conx);
+                block->costs.add(-key);
+            }
+            else if (contraction_callback)
+                (*contraction_callback)(conx, -key);
         }
-        delete info;
+        free_edge(e);
 
         //if (valid_faces < m->face_count() / 10 && !check_model())
         //    return false;
@@ -456,17 +530,143 @@ bool MxVdpmSlim::decimate(uint target)
 //
 // This is *very* close to the code in MxEdgeQSlim
 
+uint MxVdpmSlim::alloc_edge()
+{
+    if (free_edges.length() > 0)
+        return free_edges.drop();
+
+    edges.add();
+    return edges.last_id();
+}
+
+void MxVdpmSlim::free_edge(uint e)
+{
+    SanityCheck(!edge_heap.contains(e));
+    free_edges.add(e);
+}
+
+void MxVdpmSlim::link_edge(uint e, MxVertexID v)
+{
+    edges(e).link(v) = edge_links(v).length();
+    edge_links(v).add(e);
+}
+
+// Same swap with the last entry as MxDynBlock::remove(), so the order
+// of the link lists is what the original linear search produced.
+void MxVdpmSlim::unlink_edge(uint e, MxVertexID v)
+{
+    edge_list& links = edge_links(v);
+    uint i = edges(e).link(v);
+
+    SanityCheck(links(i) == e);
+    links.remove(i);
+    if (i < (uint)links.length())
+        edges(links(i)).link(v) = i;
+}
+
+uint MxVdpmSlim::add_edge(MxVertexID i, MxVertexID j)
+{
+    uint e = alloc_edge();
+
+    edges(e).v1 = i;
+    edges(e).v2 = j;
+
+    link_edge(e, i);
+    link_edge(e, j);
+
+    return e;
+}
+
 void MxVdpmSlim::create_edge(MxVertexID i, MxVertexID j)
 {
-    edge_info *info = new edge_info(dim());
+    compute_edge_info(add_edge(i, j));
+}
+
+static bool face_has(const MxFace& f, MxVertexID v)
+{
+    return f[0] == v || f[1] == v || f[2] == v;
+}
+
+// The vertices u > v that share one or two faces with v, in the order
+// collect_vertex_star() finds them; edges with more faces are counted in
+// skipped. Unlike the marking queries of MxStdModel this only reads the
+// model, so it can run on many vertices at once. ends may be NULL.
+static uint collect_vertex_edges(MxStdModel *m, MxVertexID v, MxVertexID *ends, uint *skipped)
+{
+    const MxFaceList& N = m->neighbors(v);
+    uint a, b, c, k, count = 0;
+
+    *skipped = 0;
+    for (a = 0; a < N.length(); a++)
+    {
+        const MxFace& f = m->face(N[a]);
+
+        for (c = 0; c < 3; c++)
+        {
+            MxVertexID u = f[c];
+            uint faces = 0;
+
+            if (u <= v)  // Only add particular edge once
+                continue;
+
+            // Only at the first appearance of u
+            for (b = 0; b < c && f[b] != u; b++);
+            if (b < c) continue;
+            for (b = 0; b < a && !face_has(m->face(N[b]), u); b++);
+            if (b < a) continue;
+
+            // Count the distinct faces of v containing u
+            for (b = a; b < N.length(); b++)
+                if (face_has(m->face(N[b]), u))
+                {
+                    for (k = a; k < b && N[k] != N[b]; k++);
+                    if (k == b) faces++;
+                }
+
+            if (faces > 2)
+                (*skipped)++;
+            else
+            {
+                if (ends) ends[count] = u;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Same edges as MxEdgeQSlim::collect_edges(), found and placed in parallel.
+// The edges are created in the order of a serial scan and the heap is built
+// from their keys at once, so the result does not depend on the threads.
+void MxVdpmSlim::collect_edges()
+{
+    uint vert_count = m->vert_count();
+    MxBlock<uint> offsets(vert_count + 1), skipped(vert_count + 1);
+    MxVertexID i;
+    uint j;
 
-    edge_links(i).add(info);
-    edge_links(j).add(info);
+    SanityCheck(edges.length() == 0);
 
-    info->v1 = i;
-    info->v2 = j;
+    mx_parallel_for(vert_count, [&](uint v) { offsets(v + 1) = collect_vertex_edges(m, v, NULL, &skipped(v)); }, 256, threads);
+
+    offsets(0) = 0;
+    for (i = 0; i < vert_count; i++)
+        offsets(i + 1) += offsets(i);
+
+    MxBlock<MxVertexID> ends(offsets(vert_count) + 1);
+    mx_parallel_for(vert_count, [&](uint v) { collect_vertex_edges(m, v, &ends(offsets(v)), &skipped(v)); }, 256, threads);
+
+    for (i = 0; i < vert_count; i++)
+    {
+        for (j = 0; j < skipped(i); j++)
+            mxmsg_signal(MXMSG_NOTE, "Ignoring non-manifold edge");
+        for (j = offsets(i); j < offsets(i + 1); j++)
+            add_edge(i, ends(j));
+    }
 
-    compute_edge_info(info);
+    MxBlock<float> keys(edges.length() + 1);
+    mx_parallel_for(edges.length(), [&](uint e) { keys(e) = compute_target_placement(edges(e)); }, 64, threads);
+    edge_heap.build(keys, edges.length());
 }
 
 void MxVdpmSlim::discontinuity_constraint(MxVertexID i, MxVertexID j,
@@ -488,23 +688,23 @@ void MxVdpmSlim::discontinuity_constraint(MxVertexID i, MxVertexID j,
 
         MxQuadric Q(Q3, dim());
 
-        quadric(i) += Q;
-        quadric(j) += Q;
+        quadrics->add(i, Q);
+        quadrics->add(j, Q);
     }
 }
 
 void MxVdpmSlim::apply_contraction(const MxPairContraction& conx,
-    edge_info *info)
+    uint e)
 {
     valid_verts--;
     valid_faces -= conx.dead_faces.length();
-    quadric(conx.v1) += quadric(conx.v2);
+    quadrics->add(conx.v1, conx.v2);
 
     update_pre_contract(conx);
 
     m->apply_contraction(conx);
 
-    unpack_from_vector(conx.v1, info->target);
+    unpack_from_vector(conx.v1, edges(e).target);
 
     // Must update edge_info here so that the meshing penalties
     // will be computed with respect to the new mesh rather than the old
@@ -516,38 +716,308 @@ void MxVdpmSlim::apply_contraction(const MxPairContraction& conx,
 
 ////////////////////////////////////////////////////////////////////////
 //
-// These were copied *unmodified* from MxEdgeQSlim
-// (with some unsupported features commented out).
+// Partitioned decimation
+//
+// Each level cuts the model into a grid of blocks by face centroid. A
+// vertex whose faces all lie in one block is interior to it, the others
+// are locked. Every block is copied into a model of its own and decimated
+// on a worker thread without touching its locked vertices, so the blocks
+// contract disjoint sets of faces. Their contractions are then replayed
+// here in block order, through contraction_callback as if decimate() had
+// made them, which stitches them into one hierarchy. Each level halves
+// the number of blocks along each axis, so the cuts of one level are
+// decimated by the next, and decimate() finishes on the whole model.
 //
 
-void MxVdpmSlim::collect_edges()
+static uint local_id(const MxDynBlock<uint>& ids, uint id)
 {
-    MxVertexList star;
-    MxFaceList faces;
+    return (uint)(std::lower_bound(ids.begin(), ids.end(), id) - ids.begin());
+}
 
-    for (MxVertexID i = 0; i < m->vert_count(); i++)
+static void global_face(FID& f, const MxDynBlock<MxFaceID>& faces)
+{
+    if (f != (FID)UINT_MAX)
+        f = faces(f);
+}
+
+// Drop every edge of v, so that v is neither moved nor removed
+void MxVdpmSlim::lock_vertex(MxVertexID v)
+{
+    edge_list& links = edge_links(v);
+
+    while (links.length() > 0)
     {
-        star.reset();
-        m->collect_vertex_star(i, star);
+        uint e = links.last();
 
-        for (uint j = 0; j < star.length(); j++)
+        unlink_edge(e, edges(e).opposite_vertex(v));
+        unlink_edge(e, v);
+        edge_heap.remove(e);
+        free_edge(e);
+    }
+}
+
+void MxVdpmSlim::reset_edges()
+{
+    edges.reset();
+    free_edges.reset();
+    edge_heap.reset();
+
+    for (MxVertexID v = 0; v < m->vert_count(); v++)
+        edge_links(v).reset();
+}
+
+// Take the quadrics of the block's vertices from the whole model's slim,
+// instead of computing them from the faces of the block alone.
+void MxVdpmSlim::initialize_block(const MxVdpmSlim& parent, const MxVdpmBlock& B)
+{
+    delete quadrics;
+    quadrics = MxQuadricSet::create(dim(), m->vert_count());
+    SanityCheck(quadrics && dim() == parent.dim());
+
+    for (MxVertexID v = 0; v < m->vert_count(); v++)
+        quadrics->set(v, *parent.quadrics, B.verts(v));
+
+    collect_edges();
+    is_initialized = true;
+}
+
+// Decimate the faces of block id to target in a model of their own, and
+// keep its contractions and surviving interior vertices in global ids.
+void MxVdpmSlim::decimate_block(MxVdpmBlock& B, uint id, const MxBlock<uint>& owners, uint target)
+{
+    bool normals = (m->normal_binding() == MX_PERVERTEX);
+    uint i, k, interior = 0;
+
+    for (i = 0; i < (uint)B.faces.length(); i++)
+        for (k = 0; k < 3; k++)
+            B.verts.add(m->face(B.faces(i))[k]);
+
+    std::sort(B.verts.begin(), B.verts.end());
+    B.verts.drop((int)(B.verts.end() - std::unique(B.verts.begin(), B.verts.end())));
+
+    for (i = 0; i < (uint)B.verts.length(); i++)
+        if (owners(B.verts(i)) == id)
+            interior++;
+
+    if (interior == 0 || (uint)B.faces.length() <= target)
+        return;
+
+    MxStdModel sub(B.verts.length(), B.faces.length());
+
+    for (i = 0; i < (uint)B.verts.length(); i++)
+    {
+        MxVertex& v = m->vertex(B.verts(i));
+        sub.add_vertex(v[0], v[1], v[2]);
+    }
+
+    // Attributes are copied as stored, to keep their quantization
+    if (use_color)
+    {
+        sub.color_binding(MX_PERVERTEX);
+        for (i = 0; i < (uint)B.verts.length(); i++)
         {
-            if (i < star(j))  // Only add particular edge once
-            {
-                faces.reset();
-                m->collect_edge_neighbors(i, star[j], faces);
-                if (faces.length() > 0 && faces.length() <= 2)
-                {
-                    create_edge(i, star(j));
-                }
-                else if (faces.length() > 2)
-                    mxmsg_signal(MXMSG_NOTE, "Ignoring non-manifold edge");
-                // ELSE: ignore boundary edges
-            }
+            sub.add_color(0, 0, 0);
+            sub.color(i) = m->color(B.verts(i));
+        }
+    }
+    if (normals)
+    {
+        sub.normal_binding(MX_PERVERTEX);
+        for (i = 0; i < (uint)B.verts.length(); i++)
+        {
+            sub.add_normal(0, 0, 0);
+            sub.normal(i) = m->normal(B.verts(i));
         }
     }
+    if (use_texture)
+    {
+        sub.texcoord_binding(MX_PERVERTEX);
+        for (i = 0; i < (uint)B.verts.length(); i++)
+            sub.add_texcoord(m->texcoord(B.verts(i))[0], m->texcoord(B.verts(i))[1]);
+    }
+
+    for (i = 0; i < (uint)B.faces.length(); i++)
+    {
+        MxFace& f = m->face(B.faces(i));
+        sub.add_face(local_id(B.verts, f[0]), local_id(B.verts, f[1]), local_id(B.verts, f[2]));
+    }
+
+    MxVdpmSlim slim(&sub);
+
+    // Blocks already run one per worker thread
+    slim.threads = 1;
+    slim.placement_policy = placement_policy;
+    slim.weighting_policy = weighting_policy;
+    slim.will_join_only = will_join_only;
+    slim.boundary_weight = boundary_weight;
+    slim.compactness_ratio = compactness_ratio;
+    slim.meshing_penalty = meshing_penalty;
+    slim.local_validity_threshold = local_validity_threshold;
+    slim.vertex_degree_limit = vertex_degree_limit;
+    slim.will_decouple_quadrics = will_decouple_quadrics;
+    slim.consider_color(use_color);
+    slim.consider_texture(use_texture);
+    slim.consider_normals(use_normals);
+
+    slim.initialize_block(*this, B);
+
+    for (i = 0; i < (uint)B.verts.length(); i++)
+        if (owners(B.verts(i)) != id)
+            slim.lock_vertex(i);
+
+    slim.block = &B;
+    slim.decimate(target);
+
+    for (i = 0; i < (uint)B.contractions.length(); i++)
+    {
+        MxVdpmPairContraction& conx = B.contractions(i);
+
+        conx.v1 = B.verts(conx.v1);
+        conx.v2 = B.verts(conx.v2);
+
+        for (k = 0; k < (uint)conx.delta_faces.length(); k++)
+            conx.delta_faces(k) = B.faces(conx.delta_faces(k));
+        for (k = 0; k < (uint)conx.dead_faces.length(); k++)
+            conx.dead_faces(k) = B.faces(conx.dead_faces(k));
+
+        global_face(conx.fl, B.faces);
+        global_face(conx.fr, B.faces);
+        global_face(conx.fn0, B.faces);
+        global_face(conx.fn1, B.faces);
+        global_face(conx.fn2, B.faces);
+        global_face(conx.fn3, B.faces);
+    }
+
+    for (i = 0; i < (uint)B.verts.length(); i++)
+    {
+        if (owners(B.verts(i)) != id || !sub.vertex_is_valid(i))
+            continue;
+
+        B.survivors.add(B.verts(i));
+        B.positions.add(sub.vertex(i));
+        if (use_color)  B.colors.add(sub.color(i));
+        if (normals)  B.normals.add(sub.normal(i));
+        if (use_texture)  B.texcoords.add(sub.texcoord(i));
+    }
+}
+
+// Apply the contractions of a block to this model in the order they were
+// made. v1 is placed exactly where the block left it, from conx.vs.
+void MxVdpmSlim::replay_block(MxVdpmBlock& B)
+{
+    uint i, n = 3 + (use_color ? 3 : 0) + (use_texture ? 2 : 0);
+
+    for (i = 0; i < (uint)B.contractions.length(); i++)
+    {
+        MxVdpmPairContraction& conx = B.contractions(i);
+
+        valid_verts--;
+        valid_faces -= conx.dead_faces.length();
+        quadrics->add(conx.v1, conx.v2);
+
+        m->apply_contraction(conx);
+
+        m->vertex(conx.v1)[0] = (float)conx.vs[0];
+        m->vertex(conx.v1)[1] = (float)conx.vs[1];
+        m->vertex(conx.v1)[2] = (float)conx.vs[2];
+        if (use_normals)
+            m->normal(conx.v1).set(conx.vs[n], conx.vs[n + 1], conx.vs[n + 2]);
+
+        if (contraction_callback)
+            (*contraction_callback)(conx, B.costs(i));
+    }
+
+    for (i = 0; i < (uint)B.survivors.length(); i++)
+    {
+        MxVertexID v = B.survivors(i);
+
+        m->vertex(v) = B.positions(i);
+        if (use_color)  m->color(v) = B.colors(i);
+        if (B.normals.length() > 0)  m->normal(v) = B.normals(i);
+        if (use_texture)  m->texcoord(v) = B.texcoords(i);
+    }
+}
+
+// One level of decimate_partitioned(), with n blocks along each axis
+void MxVdpmSlim::decimate_level(uint target, uint n)
+{
+    uint face_count = m->face_count(), vert_count = m->vert_count();
+    uint block_count = n * n * n, faces = valid_faces, i;
+    MxBlock<uint> face_blocks(face_count + 1), vert_blocks(vert_count + 1);
+    MxBlock<MxVdpmBlock> blocks(block_count);
+
+    mx_parallel_for(face_count, [&](uint f)
+    {
+        uint cell = 0;
+
+        face_blocks(f) = UINT_MAX;
+        if (!m->face_is_valid(f))
+            return;
+
+        for (uint k = 3; k-- > 0;)
+        {
+            double c = ((double)m->corner(f, 0)[k] + m->corner(f, 1)[k] + m->corner(f, 2)[k]) / 3.0;
+            double extent = bounds.max[k] - bounds.min[k];
+            int j = extent > 0 ? (int)floor(n * (c - bounds.min[k]) / extent) : 0;
+
+            cell = cell * n + (uint)MAX(0, MIN(j, (int)n - 1));
+        }
+        face_blocks(f) = cell;
+    }, 256, threads);
+
+    mx_parallel_for(vert_count, [&](uint v)
+    {
+        const MxFaceList& N = m->neighbors(v);
+        uint owner = N.length() > 0 ? face_blocks(N[0]) : UINT_MAX;
+
+        for (uint k = 1; k < (uint)N.length() && owner != UINT_MAX; k++)
+            if (face_blocks(N[k]) != owner)
+                owner = UINT_MAX;
+
+        vert_blocks(v) = owner;
+    }, 256, threads);
+
+    for (i = 0; i < face_count; i++)
+        if (face_blocks(i) != UINT_MAX)
+            blocks(face_blocks(i)).faces.add(i);
+
+    // A block keeps its share of target, but no less than a quarter of its
+    // faces, so that no region is taken much further than the levels above
+    // will take the whole model.
+    mx_parallel_for(block_count, [&](uint b)
+    {
+        MxVdpmBlock& B = blocks(b);
+        uint share = (uint)ceil((double)target * B.faces.length() / faces);
+
+        decimate_block(B, b, vert_blocks, MAX(share, (uint)B.faces.length() / 4));
+    }, 1, threads);
+
+    for (i = 0; i < block_count; i++)
+        replay_block(blocks(i));
+}
+
+// Same as decimate(), but first decimates spatial blocks in parallel,
+// starting from blocks^3 of them. blocks <= 1 is plain decimate().
+bool MxVdpmSlim::decimate_partitioned(uint target, uint blocks)
+{
+    if (blocks <= 1)
+        return decimate(target);
+
+    for (uint n = blocks; n > 1 && valid_faces > target; n = (n + 1) / 2)
+        decimate_level(target, n);
+
+    reset_edges();
+    collect_edges();
+
+    return decimate(target);
 }
 
+////////////////////////////////////////////////////////////////////////
+//
+// These were copied *unmodified* from MxEdgeQSlim
+// (with some unsupported features commented out).
+//
+
 void MxVdpmSlim::constrain_boundaries()
 {
     MxVertexList star;
@@ -569,9 +1039,9 @@ void MxVdpmSlim::constrain_boundaries()
     }
 }
 
-void MxVdpmSlim::compute_edge_info(edge_info *info)
+void MxVdpmSlim::compute_edge_info(uint e)
 {
-    compute_target_placement(info);
+    float key = compute_target_placement(edges(e));
 
     //     if( will_normalize_error )
     //     {
@@ -582,27 +1052,27 @@ void MxVdpmSlim::compute_edge_info(edge_info *info)
     //         info->heap_key(info->heap_key() / e_max);
     //     }
 
-    finalize_edge_update(info);
+    finalize_edge_update(e, key);
 }
 
-void MxVdpmSlim::finalize_edge_update(edge_info *info)
+void MxVdpmSlim::finalize_edge_update(uint e, float key)
 {
     //     if( meshing_penalty > 1.0 )
     //         apply_mesh_penalties(info);
 
-    if (info->is_in_heap())
-        heap.update(info);
+    if (edge_heap.contains(e))
+        edge_heap.update(e, key);
     else
-        heap.insert(info);
+        edge_heap.insert(e, key);
 #if (SAFETY >= 2)
-    mxmsg_signalf(MXMSG_TRACE, "info[%d] {%u %u}", info->get_heap_pos(), info->v1, info->v2);
+    mxmsg_signalf(MXMSG_TRACE, "info[%u] {%u %u}", e, edges(e).v1, edges(e).v2);
 #endif
 }
 
 void MxVdpmSlim::update_pre_contract(const MxPairContraction& conx)
 {
     MxVertexID v1 = conx.v1, v2 = conx.v2;
-    uint i, j;
+    uint i;
 
     star.reset();
     //
@@ -613,30 +1083,30 @@ void MxVdpmSlim::update_pre_contract(const MxPairContraction& conx)
     // from the edge links maintained at v1.
     //
     for (i = 0; i < edge_links(v1).length(); i++)
-        star.add(edge_links(v1)[i]->opposite_vertex(v1));
+        star.add(edges(edge_links(v1)[i]).opposite_vertex(v1));
 
     for (i = 0; i < edge_links(v2).length(); i++)
     {
-        edge_info *e = edge_links(v2)(i);
-        MxVertexID u = (e->v1 == v2) ? e->v2 : e->v1;
-        SanityCheck(e->v1 == v2 || e->v2 == v2);
+        uint e = edge_links(v2)(i);
+        edge_info& info = edges(e);
+        MxVertexID u = info.opposite_vertex(v2);
         SanityCheck(u != v2);
 
         if (u == v1 || varray_find(star, u))
         {
             // This is a useless link --- kill it
-            bool found = varray_find(edge_links(u), e, &j);
-            assert(found);
-            edge_links(u).remove(j);
-            heap.remove(e);
-            if (u != v1) delete e; // (v1,v2) will be deleted later
+            unlink_edge(e, u);
+            edge_heap.remove(e);
+            if (u != v1) free_edge(e); // (v1,v2) will be freed later
         }
         else
         {
             // Relink this to v1
-            e->v1 = v1;
-            e->v2 = u;
-            edge_links(v1).add(e);
+            uint link_u = info.link(u);
+            info.v1 = v1;
+            info.v2 = u;
+            info.link2 = link_u;
+            link_edge(e, v1);
         }
     }
 
@@ -660,9 +1130,8 @@ void MxVdpmSlim::update_post_expand(const MxPairContraction& conx)
     i = 0;
     while (i < edge_links(v1).length())
     {
-        edge_info *e = edge_links(v1)(i);
-        MxVertexID u = (e->v1 == v1) ? e->v2 : e->v1;
-        SanityCheck(e->v1 == v1 || e->v2 == v1);
+        uint e = edge_links(v1)(i);
+        MxVertexID u = edges(e).opposite_vertex(v1);
         SanityCheck(u != v1 && u != v2);
 
         bool v1_linked = varray_find(star, u);
@@ -679,10 +1148,13 @@ void MxVdpmSlim::update_post_expand(const MxPairContraction& conx)
             //         Need to find out why, and whether it's my
             //         expectation or the code that's wrong.
             // SanityCheck(v2_linked);
-            e->v1 = v2;
-            e->v2 = u;
-            edge_links(v2).add(e);
-            edge_links(v1).remove(i);
+            edge_info& info = edges(e);
+            uint link_u = info.link(u);
+            unlink_edge(e, v1);
+            info.v1 = v2;
+            info.v2 = u;
+            info.link2 = link_u;
+            link_edge(e, v2);
         }
 
         compute_edge_info(e);
@@ -703,13 +1175,82 @@ void MxVdpmSlim::apply_expansion(const MxPairContraction& conx)
     // Post-expansion update
     valid_verts++;
     valid_faces += conx.dead_faces.length();
-    quadric(conx.v1) -= quadric(conx.v2);
+    quadrics->subtract(conx.v1, conx.v2);
 
     update_post_expand(conx);
 
     MxVdpmPairContraction &prop_conx = (MxVdpmPairContraction &)conx;
     unpack_from_vector(conx.v1, prop_conx.vt);
     unpack_from_vector(conx.v2, prop_conx.vu);
+
+    if (prop_conx.index != UINT_MAX)
+    {
+        vertex_contractions(conx.v1) = prop_conx.child_v1;
+        vertex_contractions(conx.v2) = prop_conx.child_v2;
+    }
+}
+
+// Append conx to the vertex hierarchy. The children of conx are the latest
+// contractions that kept v1 and v2, so no search of the history is needed.
+void MxVdpmSlim::link_contraction(MxVdpmHistory& history, MxVdpmPairContraction& conx)
+{
+    conx.index = history.length();
+    conx.child_v1 = vertex_contractions(conx.v1);
+    conx.child_v2 = vertex_contractions(conx.v2);
+
+    if (conx.child_v1 != UINT_MAX)
+        history(conx.child_v1).parent = conx.index;
+
+    if (conx.child_v2 != UINT_MAX)
+        history(conx.child_v2).parent = conx.index;
+
+    vertex_contractions(conx.v1) = conx.index;
+    vertex_contractions(conx.v2) = UINT_MAX;
+}
+
+void MxVdpmHistory::add(const MxVdpmPairContraction& conx)
+{
+    MxVdpmRecord& r = records.add();
+    uint i;
+
+    (MxVdpmNode&)r = conx;
+    r.v1 = conx.v1;
+    r.v2 = conx.v2;
+    mxv_set(r.dv1, conx.dv1, 3);
+    mxv_set(r.dv2, conx.dv2, 3);
+    r.delta_pivot = conx.delta_pivot;
+
+    r.faces = face_arena.length();
+    r.dead_count = conx.dead_faces.length();
+    r.delta_count = conx.delta_faces.length();
+    for (i = 0; i < r.dead_count; i++)
+        face_arena.add(conx.dead_faces(i));
+    for (i = 0; i < r.delta_count; i++)
+        face_arena.add(conx.delta_faces(i));
+}
+
+void MxVdpmHistory::drop(MxVdpmPairContraction& conx)
+{
+    const MxVdpmRecord& r = records.last();
+    const MxFaceID *faces = dead_faces(r);
+    uint i;
+
+    (MxVdpmNode&)conx = r;
+    conx.v1 = r.v1;
+    conx.v2 = r.v2;
+    mxv_set(conx.dv1, r.dv1, 3);
+    mxv_set(conx.dv2, r.dv2, 3);
+    conx.delta_pivot = r.delta_pivot;
+
+    conx.dead_faces.reset();
+    for (i = 0; i < r.dead_count; i++)
+        conx.dead_faces.add(*faces++);
+    conx.delta_faces.reset();
+    for (i = 0; i < r.delta_count; i++)
+        conx.delta_faces.add(*faces++);
+
+    face_arena.drop(r.dead_count + r.delta_count);
+    records.drop();
 }
 
 void MxVdpmSlim::collect_radiuses()
@@ -903,7 +1444,7 @@ bool MxVdpmSlim::check_model()
     return true;
 }
 
-void MxVdpmPairContraction::update_radius(const MxDynBlock<MxVdpmPairContraction>& history,
+void MxVdpmRecord::update_radius(const MxVdpmHistory& history,
     const MxBlock<float>& vertex_radiuses, MxStdModel *m)
 {
     if (child_v1 != UINT_MAX)
@@ -917,7 +1458,7 @@ void MxVdpmPairContraction::update_radius(const MxDynBlock<MxVdpmPairContraction
         compute_radius_from_vertex(v2, vertex_radiuses, m);
 }
 
-void MxVdpmPairContraction::compute_radius_from_child(const MxVdpmPairContraction& child)
+void MxVdpmRecord::compute_radius_from_child(const MxVdpmRecord& child)
 {
     float dv[3], vs1[3], vs2[3];
 
@@ -935,7 +1476,7 @@ void MxVdpmPairContraction::compute_radius_from_child(const MxVdpmPairContractio
         radius = r;
 }
 
-void MxVdpmPairContraction::compute_radius_from_vertex(MxVertexID v, const MxBlock<float>& vertex_radiuses, MxStdModel *m)
+void MxVdpmRecord::compute_radius_from_vertex(MxVertexID v, const MxBlock<float>& vertex_radiuses, MxStdModel *m)
 {
     float dv[3], vs1[3], vs2[3];
 
@@ -953,7 +1494,7 @@ void MxVdpmPairContraction::compute_radius_from_vertex(MxVertexID v, const MxBlo
         radius = r;
 }
 
-void MxVdpmPairContraction::update_cone(const MxDynBlock<MxVdpmPairContraction>& history, MxVdpmSlim& slim)
+void MxVdpmRecord::update_cone(const MxVdpmHistory& history, MxVdpmSlim& slim)
 {
     float nv[3], dot, min_dot, alpha;
     uint i = 3;
@@ -990,8 +1531,8 @@ void MxVdpmPairContraction::update_cone(const MxDynBlock<MxVdpmPairContraction>&
     sin2alpha *= 2;
 }
 
-float MxVdpmPairContraction::compute_cone_from_child(const MxDynBlock<MxVdpmPairContraction>& history,
-    const MxVdpmPairContraction& conx, MxVdpmSlim& slim, float nv[3])
+float MxVdpmRecord::compute_cone_from_child(const MxVdpmHistory& history,
+    const MxVdpmRecord& conx, MxVdpmSlim& slim, float nv[3])
 {
     float min_dot, dot;
 
@@ -1013,7 +1554,7 @@ float MxVdpmPairContraction::compute_cone_from_child(const MxDynBlock<MxVdpmPair
     return min_dot;
 }
 
-float MxVdpmPairContraction::compute_cone_from_vertex(MxVertexID v, MxVdpmSlim& slim, float nv[3])
+float MxVdpmRecord::compute_cone_from_vertex(MxVertexID v, MxVdpmSlim& slim, float nv[3])
 {
     const MxFaceList& faces = slim.vertex_neighbors(v);
     float dot, min_dot = FLT_MAX;
@@ -1028,37 +1569,11 @@ float MxVdpmPairContraction::compute_cone_from_vertex(MxVertexID v, MxVdpmSlim&
     return min_dot;
 }
 
-static struct model* create_model_from_simplified(MxVdpmSlim& slim, MxFaceList& faces)
+// Appends the vertices of faces to slim.deviation_points, in the order they
+// are first referenced, and the faces indexed into them to slim.deviation_faces.
+// Positions are taken from the simplified model or from the original geometry.
+static uint capture_faces(MxVdpmSlim& slim, const MxFaceList& faces, bool simplified)
 {
-    struct model *tmesh;
-    vertex_t bbmin, bbmax;
-    int nvtcs = 0;
-    int nfaces = 0;
-    int f0, f1, f2;
-    float x, y, z;
-    int rcode = 1;
-    struct block_list *head_verts, *cur_vert;
-    struct block_list *head_faces, *cur_face;
-
-    head_verts = (struct block_list*)malloc(sizeof(struct block_list));
-    head_faces = (struct block_list*)malloc(sizeof(struct block_list));
-
-    cur_vert = head_verts;
-    cur_face = head_faces;
-
-    bbmin.x = bbmin.y = bbmin.z = FLT_MAX;
-    bbmax.x = bbmax.y = bbmax.z = -FLT_MAX;
-    tmesh = (struct model*)calloc(1, sizeof(struct model));
-
-    rcode = init_block_list(head_verts, sizeof(vertex_t));
-    if (rcode < 0)
-        return NULL;
-
-    rcode = init_block_list(head_faces, sizeof(face_t));
-    if (rcode < 0)
-        return NULL;
-
-    // Collects vertex list
     MxVertexList vertices;
     int i, j, k;
 
@@ -1074,210 +1589,140 @@ static struct model* create_model_from_simplified(MxVdpmSlim& slim, MxFaceList&
                 if (vertices(k) == f(j))
                     break;
             }
-            if (k < vertices.length())
-                continue;
+            if (k == vertices.length())
+                vertices.add(f(j));
 
-            vertices.add(f(j));
+            slim.deviation_faces.add(k);
         }
     }
 
-    MxBlock<MxVertexID> vmap(slim.model().vert_count());  // Maps old VIDs to new VIDs
-    MxVertexID next_vert = 0;
-
     for (i = 0; i < vertices.length(); i++)
     {
-        vmap(vertices(i)) = next_vert++;
-
-        MxVertex& mv = slim.model().vertex(vertices(i));
-
-        x = mv(X);
-        y = mv(Y);
-        z = mv(Z);
+        if (simplified)
+        {
+            MxVertex& mv = slim.model().vertex(vertices(i));
 
-        if (cur_vert->elem_filled == cur_vert->nelem) {
-            /* Reallocate storage if needed */
-            cur_vert = get_next_block(cur_vert);
-            if (cur_vert == NULL) {
-                return NULL;
-            }
+            slim.deviation_points.add(mv(X));
+            slim.deviation_points.add(mv(Y));
+            slim.deviation_points.add(mv(Z));
         }
-        BLOCK_LIST_TAIL(cur_vert, vertex_t).x = x;
-        BLOCK_LIST_TAIL(cur_vert, vertex_t).y = y;
-        BLOCK_LIST_TAIL_INCR(cur_vert, vertex_t).z = z;
-        nvtcs++;
-
-        if (x < bbmin.x) bbmin.x = x;
-        if (x > bbmax.x) bbmax.x = x;
-        if (y < bbmin.y) bbmin.y = y;
-        if (y > bbmax.y) bbmax.y = y;
-        if (z < bbmin.z) bbmin.z = z;
-        if (z > bbmax.z) bbmax.z = z;
-    }
-
-    for (i = 0; i < faces.length(); i++)
-    {
-        MxFace& f = slim.model().face(faces(i));
-
-        f0 = vmap(f(0));
-        f1 = vmap(f(1));
-        f2 = vmap(f(2));
-
-        if (cur_face->elem_filled == cur_face->nelem) {
-            /* Reallocate storage if needed */
-            cur_face = get_next_block(cur_face);
-            if (cur_face == NULL) {
-                return NULL;
-            }
+        else
+        {
+            slim.deviation_points.add(slim.vertex_geoms(vertices(i))[0]);
+            slim.deviation_points.add(slim.vertex_geoms(vertices(i))[1]);
+            slim.deviation_points.add(slim.vertex_geoms(vertices(i))[2]);
         }
-
-        BLOCK_LIST_TAIL(cur_face, face_t).f0 = f0;
-        BLOCK_LIST_TAIL(cur_face, face_t).f1 = f1;
-        BLOCK_LIST_TAIL_INCR(cur_face, face_t).f2 = f2;
-        nfaces++;
     }
-
-    tmesh->bBox[0] = bbmin;
-    tmesh->bBox[1] = bbmax;
-    tmesh->num_vert = nvtcs;
-    tmesh->num_faces = nfaces;
-    tmesh->vertices = (vertex_t*)malloc(nvtcs*sizeof(vertex_t));
-    tmesh->faces = (face_t*)malloc(nfaces*sizeof(face_t));
-    rcode = gather_block_list(head_verts, tmesh->vertices,
-        nvtcs*sizeof(vertex_t));
-    rcode = gather_block_list(head_faces, tmesh->faces,
-        nfaces*sizeof(face_t));
-    free_block_list(&head_verts);
-    free_block_list(&head_faces);
-
-    return tmesh;
+    return vertices.length();
 }
 
-static struct model* create_model_from_origin(MxVdpmSlim& slim, MxFaceList& faces)
+static struct model* create_model_from_points(const float *points, uint nvtcs, const uint *indices, uint nfaces)
 {
     struct model *tmesh;
     vertex_t bbmin, bbmax;
-    int nvtcs = 0;
-    int nfaces = 0;
-    int f0, f1, f2;
-    float x, y, z;
-    int rcode = 1;
-    struct block_list *head_verts, *cur_vert;
-    struct block_list *head_faces, *cur_face;
-
-    head_verts = (struct block_list*)malloc(sizeof(struct block_list));
-    head_faces = (struct block_list*)malloc(sizeof(struct block_list));
-
-    cur_vert = head_verts;
-    cur_face = head_faces;
+    uint i;
 
     bbmin.x = bbmin.y = bbmin.z = FLT_MAX;
     bbmax.x = bbmax.y = bbmax.z = -FLT_MAX;
     tmesh = (struct model*)calloc(1, sizeof(struct model));
 
-    rcode = init_block_list(head_verts, sizeof(vertex_t));
-    if (rcode < 0)
-        return NULL;
-
-    rcode = init_block_list(head_faces, sizeof(face_t));
-    if (rcode < 0)
-        return NULL;
-
-    // Collects vertex list
-    MxVertexList vertices;
-    int i, j, k;
+    tmesh->num_vert = nvtcs;
+    tmesh->num_faces = nfaces;
+    tmesh->vertices = (vertex_t*)malloc(nvtcs*sizeof(vertex_t));
+    tmesh->faces = (face_t*)malloc(nfaces*sizeof(face_t));
 
-    vertices.reset();
-    for (i = 0; i < faces.length(); i++)
+    for (i = 0; i < nvtcs; i++)
     {
-        MxFace& f = slim.model().face(faces(i));
-
-        for (j = 0; j < 3; j++)
-        {
-            for (k = 0; k < vertices.length(); k++)
-            {
-                if (vertices(k) == f(j))
-                    break;
-            }
-            if (k < vertices.length())
-                continue;
-
-            vertices.add(f(j));
-        }
+        vertex_t& v = tmesh->vertices[i];
+
+        v.x = points[i * 3];
+        v.y = points[i * 3 + 1];
+        v.z = points[i * 3 + 2];
+
+        if (v.x < bbmin.x) bbmin.x = v.x;
+        if (v.x > bbmax.x) bbmax.x = v.x;
+        if (v.y < bbmin.y) bbmin.y = v.y;
+        if (v.y > bbmax.y) bbmax.y = v.y;
+        if (v.z < bbmin.z) bbmin.z = v.z;
+        if (v.z > bbmax.z) bbmax.z = v.z;
     }
 
-    MxBlock<MxVertexID> vmap(slim.model().vert_count());  // Maps old VIDs to new VIDs
-    MxVertexID next_vert = 0;
-
-    for (i = 0; i < vertices.length(); i++)
+    for (i = 0; i < nfaces; i++)
     {
-        vmap(vertices(i)) = next_vert++;
+        tmesh->faces[i].f0 = indices[i * 3];
+        tmesh->faces[i].f1 = indices[i * 3 + 1];
+        tmesh->faces[i].f2 = indices[i * 3 + 2];
+    }
 
-        x = slim.vertex_geoms(vertices(i))[0];
-        y = slim.vertex_geoms(vertices(i))[1];
-        z = slim.vertex_geoms(vertices(i))[2];
+    tmesh->bBox[0] = bbmin;
+    tmesh->bBox[1] = bbmax;
 
-        if (cur_vert->elem_filled == cur_vert->nelem) {
-            /* Reallocate storage if needed */
-            cur_vert = get_next_block(cur_vert);
-            if (cur_vert == NULL) {
-                return NULL;
-            }
-        }
-        BLOCK_LIST_TAIL(cur_vert, vertex_t).x = x;
-        BLOCK_LIST_TAIL(cur_vert, vertex_t).y = y;
-        BLOCK_LIST_TAIL_INCR(cur_vert, vertex_t).z = z;
-        nvtcs++;
+    return tmesh;
+}
 
-        if (x < bbmin.x) bbmin.x = x;
-        if (x > bbmax.x) bbmax.x = x;
-        if (y < bbmin.y) bbmin.y = y;
-        if (y > bbmax.y) bbmax.y = y;
-        if (z < bbmin.z) bbmin.z = z;
-        if (z > bbmax.z) bbmax.z = z;
-    }
+// Capture what update_deviation() needs while the model is in the state right
+// after this contraction: the normal of v1, the faces around v1 with their
+// simplified positions, and the original faces of v1 and v2 with their original
+// positions. The subtrees of v1 and v2 cover exactly the union of those.
+//
+// Layout in slim.deviation_points: normal, model 1 vertices, model 2 vertices.
+// Layout in slim.deviation_faces: model 1 vertex and face counts, model 2 vertex
+// and face counts, model 1 faces, model 2 faces.
+void MxVdpmPairContraction::capture_deviation(MxVdpmSlim& slim)
+{
+    MxFaceList& model1_faces = slim.model().neighbors(v1);
+    MxFaceList model2_faces;
+    uint header;
 
-    for (i = 0; i < faces.length(); i++)
-    {
-        MxFace& f = slim.model().face(faces(i));
+    model2_faces.reset();
+    collect_neighbors_from_vertex(v1, slim, model2_faces);
+    collect_neighbors_from_vertex(v2, slim, model2_faces);
 
-        f0 = vmap(f(0));
-        f1 = vmap(f(1));
-        f2 = vmap(f(2));
+    deviation_points = slim.deviation_points.length();
+    deviation_faces = slim.deviation_faces.length();
 
-        if (cur_face->elem_filled == cur_face->nelem) {
-            /* Reallocate storage if needed */
-            cur_face = get_next_block(cur_face);
-            if (cur_face == NULL) {
-                return NULL;
-            }
-        }
+    MxNormal& mn = slim.model().normal(v1);
+    slim.deviation_points.add(mn[0]);
+    slim.deviation_points.add(mn[1]);
+    slim.deviation_points.add(mn[2]);
+
+    header = deviation_faces;
+    slim.deviation_faces.add(0);
+    slim.deviation_faces.add(model1_faces.length());
+    slim.deviation_faces.add(0);
+    slim.deviation_faces.add(model2_faces.length());
+
+    slim.deviation_faces(header) = capture_faces(slim, model1_faces, true);
+    slim.deviation_faces(header + 2) = capture_faces(slim, model2_faces, false);
+}
 
-        BLOCK_LIST_TAIL(cur_face, face_t).f0 = f0;
-        BLOCK_LIST_TAIL(cur_face, face_t).f1 = f1;
-        BLOCK_LIST_TAIL_INCR(cur_face, face_t).f2 = f2;
-        nfaces++;
+static struct model* create_model_from_captured(const MxVdpmSlim& slim, const MxVdpmRecord& conx, uint model)
+{
+    const float *points = &slim.deviation_points(conx.deviation_points + 3);
+    const uint *header = &slim.deviation_faces(conx.deviation_faces);
+    const uint *indices = header + 4;
+
+    if (model == 2)
+    {
+        points += header[0] * 3;
+        indices += header[1] * 3;
+        header += 2;
     }
+    return create_model_from_points(points, header[0], indices, header[1]);
+}
 
-    tmesh->bBox[0] = bbmin;
-    tmesh->bBox[1] = bbmax;
-    tmesh->num_vert = nvtcs;
-    tmesh->num_faces = nfaces;
-    tmesh->vertices = (vertex_t*)malloc(nvtcs*sizeof(vertex_t));
-    tmesh->faces = (face_t*)malloc(nfaces*sizeof(face_t));
-    rcode = gather_block_list(head_verts, tmesh->vertices,
-        nvtcs*sizeof(vertex_t));
-    rcode = gather_block_list(head_faces, tmesh->faces,
-        nfaces*sizeof(face_t));
-    free_block_list(&head_verts);
-    free_block_list(&head_faces);
+// Number of random values dist_surf_surf() draws for this contraction.
+uint MxVdpmRecord::sampled_face_count(const MxVdpmSlim& slim) const
+{
+    struct model *mesh = create_model_from_captured(slim, *this, 1);
+    uint count = ::sampled_face_count(mesh);
 
-    return tmesh;
+    __free_raw_model(mesh);
+    return count;
 }
 
-void MxVdpmPairContraction::update_deviation(const MxDynBlock<MxVdpmPairContraction>& history, MxVdpmSlim& slim)
+void MxVdpmRecord::update_deviation(const MxVdpmSlim& slim, const int *rand_values)
 {
-    MxFaceList& model1_faces = slim.model().neighbors(v1);
-    MxFaceList model2_faces;
     struct model_error model1, model2;
     struct dist_surf_surf_stats stats;
     double bbox2_diag;
@@ -1286,23 +1731,19 @@ void MxVdpmPairContraction::update_deviation(const MxDynBlock<MxVdpmPairContract
 
     dir_error = 0.0f;
 
-    model2_faces.reset();
-
-    if (child_v1 != UINT_MAX)
-        collect_neighbors_from_child(history, history(child_v1), slim, model2_faces);
-    else
-        collect_neighbors_from_vertex(v1, slim, model2_faces);
-
-    if (child_v2 != UINT_MAX)
-        collect_neighbors_from_child(history, history(child_v2), slim, model2_faces);
-    else
-        collect_neighbors_from_vertex(v2, slim, model2_faces);
+    // v1 lost all its faces; there is nothing to sample
+    if (slim.deviation_faces(deviation_faces + 1) == 0)
+    {
+        uni_error = 0.0f;
+        return;
+    }
 
     memset(&model1, 0, sizeof(model1));
     memset(&model2, 0, sizeof(model2));
 
-    model1.mesh = create_model_from_simplified(slim, model1_faces);
-    model2.mesh = create_model_from_origin(slim, model2_faces);
+    model1.mesh = create_model_from_captured(slim, *this, 1);
+    model1.rand_values = rand_values;
+    model2.mesh = create_model_from_captured(slim, *this, 2);
 
     bbox2_diag = dist_v(&model2.mesh->bBox[0], &model2.mesh->bBox[1]);
     abs_sampling_step = 0.2*bbox2_diag;
@@ -1318,10 +1759,9 @@ void MxVdpmPairContraction::update_deviation(const MxDynBlock<MxVdpmPairContract
     n1[1] = stats.max_dist_vec.y;
     n1[2] = stats.max_dist_vec.z;
 
-    MxNormal& mn = slim.model().normal(v1);
-    n2[0] = mn[0];
-    n2[1] = mn[1];
-    n2[2] = mn[2];
+    n2[0] = slim.deviation_points(deviation_points);
+    n2[1] = slim.deviation_points(deviation_points + 1);
+    n2[2] = slim.deviation_points(deviation_points + 2);
     mxv_cross3(r, n1, n2);
 
     uni_error = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
@@ -1329,18 +1769,55 @@ void MxVdpmPairContraction::update_deviation(const MxDynBlock<MxVdpmPairContract
     dir_error *= dir_error;
 }
 
-void MxVdpmPairContraction::collect_neighbors_from_child(const MxDynBlock<MxVdpmPairContraction>& history,
-    const MxVdpmPairContraction& conx, MxVdpmSlim& slim, MxFaceList& faces)
+// Same as update_deviation(), but the deviation vector is the exact offset to
+// the closest point of the original faces, at the sample of the simplified faces
+// that is farthest from them.
+void MxVdpmRecord::update_hausdorff_deviation(const MxVdpmSlim& slim)
 {
-    if (conx.child_v1 != UINT_MAX)
-        collect_neighbors_from_child(history, history(conx.child_v1), slim, faces);
-    else
-        collect_neighbors_from_vertex(v1, slim, faces);
+    const float *n2 = &slim.deviation_points(deviation_points);
+    const float *points1 = n2 + 3;
+    const uint *header = &slim.deviation_faces(deviation_faces);
+    const uint *faces1 = header + 4;
+    const float *points2 = points1 + header[0] * 3;
+    const uint *faces2 = faces1 + header[1] * 3;
+    float r[3], n1[3];
 
-    if (conx.child_v2 != UINT_MAX)
-        collect_neighbors_from_child(history, history(conx.child_v2), slim, faces);
-    else
-        collect_neighbors_from_vertex(v2, slim, faces);
+    MxHausdorff original(points2, faces2, header[3]);
+    original.max_dist2(points1, header[0], faces1, header[1], slim.hausdorff_freq, n1);
+
+    mxv_cross3(r, n1, n2);
+
+    uni_error = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+    dir_error = mxv_dot(n1, n2, 3);
+    dir_error *= dir_error;
+}
+
+// Compute the deviations of all contractions captured by capture_deviation().
+// Unless hausdorff_freq is set, the random values that sampling would have drawn serially are drawn up front
+// in history order, so the results match a serial computation exactly.
+void MxVdpmSlim::update_deviations(MxVdpmHistory& history)
+{
+    uint count = history.length();
+    MxBlock<uint> offsets(count + 1);
+    uint i;
+
+    if (hausdorff_freq > 0)
+    {
+        mx_parallel_for(count, [&](uint j) { history(j).update_hausdorff_deviation(*this); }, 1, threads);
+        return;
+    }
+
+    mx_parallel_for(count, [&](uint j) { offsets(j + 1) = history(j).sampled_face_count(*this); }, 1, threads);
+
+    offsets(0) = 0;
+    for (i = 0; i < count; i++)
+        offsets(i + 1) += offsets(i);
+
+    MxBlock<int> rand_values(offsets(count) + 1);
+    for (i = 0; i < offsets(count); i++)
+        rand_values(i) = rand();
+
+    mx_parallel_for(count, [&](uint j) { history(j).update_deviation(*this, &rand_values(offsets(j))); }, 1, threads);
 }
 
 void MxVdpmPairContraction::collect_neighbors_from_vertex(MxVertexID v, MxVdpmSlim& slim, MxFaceList& faces)
@@ -1556,6 +2033,71 @@ static FID find_face(MxStdModel& m, MxFaceList& faces, VID v1, VID v2, VID v3)
     return (FID)UINT_MAX;
 }
 
+static void remap_face(MxStdModel& m, FID f, VID v1, VID v2, VID vids[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        vids[i] = m.face(f)(i);
+        if (vids[i] == v2)
+            vids[i] = v1;
+    }
+    std::sort(vids, vids + 3);
+}
+
+// Whether contracting v2 into v1 would fold two delta faces onto the same
+// corners, close the hole a boundary edge is on, or leave the far corner
+// of a dead face without faces. The star stays manifold in each case, but
+// the runtime cannot split such a vertex again.
+static bool changes_topology(MxStdModel& m, MxFaceList& dead, MxFaceList& faces, VID v1, VID v2)
+{
+    VID a[3], b[3];
+    int i, j, k, count, dead_count = dead.length();
+
+    for (i = 0; i < dead_count; i++)
+    {
+        VID vk = m.face(dead(i)).opposite_vertex(v1, v2);
+
+        for (j = 0; j < faces.length() && !has_vertex(m, faces(j), vk); j++)
+            ;
+        if (j == faces.length())
+            return true;
+    }
+
+    for (i = 0; i < faces.length(); i++)
+    {
+        remap_face(m, faces(i), v1, v2, a);
+
+        for (j = i + 1; j < faces.length(); j++)
+        {
+            remap_face(m, faces(j), v1, v2, b);
+            if (a[0] == b[0] && a[1] == b[1] && a[2] == b[2])
+                return true;
+        }
+    }
+
+    if (dead_count != 1 || faces.length() == 0)
+        return false;
+
+    // v1 stays on the boundary while one of its edges has a single face
+    for (i = 0; i < faces.length(); i++)
+    {
+        remap_face(m, faces(i), v1, v2, a);
+
+        for (k = 0; k < 3; k++)
+        {
+            if (a[k] == v1)
+                continue;
+
+            for (j = 0, count = 0; j < faces.length(); j++)
+                if (has_vertex(m, faces(j), a[k]))
+                    count++;
+            if (count == 1)
+                return false;
+        }
+    }
+    return true;
+}
+
 bool MxVdpmPairContraction::update_faces(MxVdpmSlim& slim)
 {
     MxStdModel& m = slim.model();
@@ -1585,6 +2127,9 @@ bool MxVdpmPairContraction::update_faces(MxVdpmSlim& slim)
     if (dead_faces.length() <= 0 || dead_faces.length() > 2)
         return false;
 
+    if (changes_topology(m, dead_faces, delta_faces, v1, v2))
+        return false;
+
     for (int k = 0; k < dead_faces.length(); k++)
     {
         FID fk = dead_faces(k);
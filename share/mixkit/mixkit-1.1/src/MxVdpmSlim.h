@@ -5,46 +5,107 @@
 #endif
 
 #include "MxStdSlim.h"
-#include "MxQMetric.h"
+#include "MxQMetricN.h"
+#include "MxIndexedHeap.h"
 #include "MxGeom3D.h"
+#include "MxSpillBlock.h"
 
-class MxVdpmVector : public MxVector
+#define MXVDPM_MAXDIM 11		// position, color, texture coordinates and normal
+
+class MxVdpmSlim;
+class MxVdpmBlock;
+class MxVdpmHistory;
+
+// The vertex hierarchy part of a contraction
+class MxVdpmNode
 {
 public:
-    MxVdpmVector() : MxVector(11) { }
+    uint index, parent, child_v1, child_v2, v_i;
+    float vt[MXVDPM_MAXDIM], vu[MXVDPM_MAXDIM];	// v1 and v2 before the contraction; first D entries used
+    float vs[MXVDPM_MAXDIM];			// v1 after it
+    float radius;
+    float sin2alpha;
+    float uni_error;
+    float dir_error;
+    FID fl, fr, fn0, fn1, fn2, fn3;
+    uint deviation_points, deviation_faces;    // offsets of the captured neighborhoods in the slim pools
+
+    void init_node()
+    {
+        index = parent = child_v1 = child_v2 = v_i = UINT_MAX;
+        radius = sin2alpha = uni_error = dir_error = 0.0f;
+        fn0 = fn1 = fn2 = fn3 = UINT_MAX;
+        deviation_points = deviation_faces = UINT_MAX;
+    }
 };
 
-class MxVdpmSlim;
+class MxVdpmPairContraction : public MxPairContraction, public MxVdpmNode
+{
+private:
+    void collect_neighbors_from_vertex(MxVertexID, MxVdpmSlim&, MxFaceList&);
+
+public:
+    MxVdpmPairContraction() { init_node(); }
+
+    void capture_deviation(MxVdpmSlim&);
+    bool update_faces(MxVdpmSlim&);
+};
 
-class MxVdpmPairContraction : public MxPairContraction
+// A contraction as MxVdpmHistory keeps it. It has a fixed size and no
+// allocations of its own; its dead faces, then its delta faces, are in
+// the face arena of the history.
+class MxVdpmRecord : public MxVdpmNode
 {
 private:
-    void compute_radius_from_child(const MxVdpmPairContraction&);
+    void compute_radius_from_child(const MxVdpmRecord&);
     void compute_radius_from_vertex(MxVertexID, const MxBlock<float>&, MxStdModel*);
 
-    float compute_cone_from_child(const MxDynBlock<MxVdpmPairContraction>&, const MxVdpmPairContraction&, MxVdpmSlim&, float[3]);
+    float compute_cone_from_child(const MxVdpmHistory&, const MxVdpmRecord&, MxVdpmSlim&, float[3]);
     float compute_cone_from_vertex(MxVertexID, MxVdpmSlim&, float[3]);
 
-    void collect_neighbors_from_child(const MxDynBlock<MxVdpmPairContraction>&, const MxVdpmPairContraction&, MxVdpmSlim&, MxFaceList&);
-    void collect_neighbors_from_vertex(MxVertexID, MxVdpmSlim&, MxFaceList&);
+public:
+    MxVertexID v1, v2;
+    float dv1[3], dv2[3];
+    uint delta_pivot;
+    uint faces;				// offset in the face arena
+    uint dead_count, delta_count;
+
+    void update_radius(const MxVdpmHistory&, const MxBlock<float>&, MxStdModel*);
+    void update_cone(const MxVdpmHistory&, MxVdpmSlim&);
+    uint sampled_face_count(const MxVdpmSlim&) const;
+    void update_deviation(const MxVdpmSlim&, const int *rand_values);
+    void update_hausdorff_deviation(const MxVdpmSlim&);
+};
+
+class MxVdpmHistory
+{
+private:
+    MxSpillBlock<MxVdpmRecord> records;
+    MxSpillBlock<MxFaceID> face_arena;
 
 public:
-    uint index, parent, child_v1, child_v2, v_i;
-    MxVdpmVector vt, vu, vs;
-    float radius;
-    float sin2alpha;
-    float uni_error;
-    float dir_error;
-    FID fl, fr, fn0, fn1, fn2, fn3;
+    MxVdpmHistory(uint n=100) : records(n), face_arena(4 * n) { }
 
-    MxVdpmPairContraction() : index(UINT_MAX), parent(UINT_MAX), child_v1(UINT_MAX), child_v2(UINT_MAX), v_i(UINT_MAX),
-        radius(0.0f), sin2alpha(0.0f), uni_error(0.0f), dir_error(0.0f),
-        fn0(UINT_MAX), fn1(UINT_MAX), fn2(UINT_MAX), fn3(UINT_MAX) { }
+    // Keeps the records in temporary files in dir instead of the heap
+    bool spill_to(const char *dir)
+        { return records.spill_to(dir) && face_arena.spill_to(dir); }
 
-    void update_radius(const MxDynBlock<MxVdpmPairContraction>&, const MxBlock<float>&, MxStdModel*);
-    void update_cone(const MxDynBlock<MxVdpmPairContraction>&, MxVdpmSlim&);
-    void update_deviation(const MxDynBlock<MxVdpmPairContraction>&, MxVdpmSlim&);
-    bool update_faces(MxVdpmSlim&);
+    uint length() const { return records.length(); }
+
+    MxVdpmRecord&       operator[](uint i)       { return records[i]; }
+    const MxVdpmRecord& operator[](uint i) const { return records[i]; }
+    MxVdpmRecord&       operator()(uint i)       { return records[i]; }
+    const MxVdpmRecord& operator()(uint i) const { return records[i]; }
+
+    const MxFaceID *dead_faces(const MxVdpmRecord& r) const
+        { return face_arena.begin() + r.faces; }
+    const MxFaceID *delta_faces(const MxVdpmRecord& r) const
+        { return face_arena.begin() + r.faces + r.dead_count; }
+
+    void add(const MxVdpmPairContraction&);
+
+    // Removes the latest record and rebuilds its contraction in conx
+    void drop(MxVdpmPairContraction& conx);
 };
 
 class MxVdpmSlim : public MxStdSlim
@@ -52,24 +113,31 @@ class MxVdpmSlim : public MxStdSlim
 private:
     uint D;
 
-    class edge_info : public MxHeapable
+    // Edges live in a pool and are referred to by index. Each one keeps its
+    // position in the link list of each endpoint, so unlinking is O(1).
+    class edge_info
     {
     public:
         MxVertexID v1, v2;
-        MxVector target;
+        uint link1, link2;		// positions in edge_links(v1) and edge_links(v2)
+        double target[MXVDPM_MAXDIM];	// first D entries used
 
-        MxVertexID opposite_vertex(MxVertexID v)
+        MxVertexID opposite_vertex(MxVertexID v) const
         {
             if (v == v1) return v2;
             else { SanityCheck(v == v2); return v1; }
         }
 
-        edge_info(uint D) : target(D) { }
+        uint& link(MxVertexID v) { return (v == v1) ? link1 : link2; }
     };
-    typedef MxSizedDynBlock<edge_info*, 6> edge_list;
+    typedef MxSizedDynBlock<uint, 6> edge_list;
 
+    MxDynBlock<edge_info> edges;	// edge pool
+    MxDynBlock<uint> free_edges;	// released slots of the pool
+    MxIndexedHeap edge_heap;		// edges keyed by -error
     MxBlock<edge_list> edge_links;	// 1 per vertex
-    MxBlock<MxQuadric*> __quadrics;	// 1 per vertex
+    MxQuadricSet *quadrics;		// 1 per vertex, of dimension D
+    MxVdpmBlock *block;			// collects the contractions of a partition block
 
     //
     // Temporary variables used by methods
@@ -78,7 +146,9 @@ private:
 protected:
     uint compute_dimension(MxStdModel *);
     void pack_to_vector(MxVertexID, MxVector&);
-    void unpack_from_vector(MxVertexID, MxVector&);
+    void pack_to_vector(MxVertexID, float *);
+    void unpack_from_vector(MxVertexID, double *);
+    void unpack_from_vector(MxVertexID, const float *);
     uint prop_count();
     void pack_prop_to_vector(MxVertexID, MxVector&, uint);
     void unpack_prop_from_vector(MxVertexID, MxVector&, uint);
@@ -86,15 +156,28 @@ protected:
     void compute_face_quadric(MxFaceID, MxQuadric&);
     void collect_quadrics();
 
+    uint alloc_edge();
+    void free_edge(uint);
+    void link_edge(uint, MxVertexID);
+    void unlink_edge(uint, MxVertexID);
+    uint add_edge(MxVertexID, MxVertexID);
+
     void create_edge(MxVertexID, MxVertexID);
     void collect_edges();
     void constrain_boundaries();
     void discontinuity_constraint(MxVertexID, MxVertexID, const MxFaceList&);
-    void compute_edge_info(edge_info *);
-    void finalize_edge_update(edge_info *);
-    void compute_target_placement(edge_info *);
-
-    void apply_contraction(const MxPairContraction&, edge_info *);
+    void compute_edge_info(uint);
+    void finalize_edge_update(uint, float);
+    float compute_target_placement(edge_info&);
+
+    void apply_contraction(const MxPairContraction&, uint);
+    void lock_vertex(MxVertexID);
+    void reset_edges();
+
+    void initialize_block(const MxVdpmSlim&, const MxVdpmBlock&);
+    void decimate_block(MxVdpmBlock&, uint, const MxBlock<uint>&, uint);
+    void replay_block(MxVdpmBlock&);
+    void decimate_level(uint, uint);
     void update_pre_contract(const MxPairContraction&);
     void update_pre_expand(const MxPairContraction&);
     void update_post_expand(const MxPairContraction&);
@@ -108,11 +191,16 @@ public:
     bool use_texture;
     bool use_normals;
     bool will_decouple_quadrics;
+    uint hausdorff_freq;    // >0 measures deviations with MxHausdorff at this sampling frequency
+    uint threads;           // threads for the parallel passes, 0 for all hardware threads
 
     MxBlock<float[3]> vertex_geoms;			// 1 per vertex
     MxBlock<float> vertex_radiuses;			// 1 per vertex
     MxBlock<float[3]> face_normals;			// 1 per face
     MxBlock<MxFaceList> vertex_neighbors;	// 1 per vertex
+    MxBlock<uint> vertex_contractions;		// 1 per vertex, latest contraction keeping it
+    MxDynBlock<float> deviation_points;		// neighborhoods captured for deferred deviations
+    MxDynBlock<uint> deviation_faces;
     MxBounds bounds;
 
 public:
@@ -125,17 +213,15 @@ public:
     void consider_texture(bool will = true);
     void consider_normals(bool will = true);
 
-    uint quadric_count() const { return __quadrics.length(); }
-    MxQuadric&       quadric(uint i)       { return *(__quadrics(i)); }
-    const MxQuadric& quadric(uint i) const { return *(__quadrics(i)); }
-
 
     void initialize();
     bool decimate(uint);
+    bool decimate_partitioned(uint target, uint blocks);
     bool check_model();
 
     void apply_expansion(const MxPairContraction& conx);
-    const MxQuadric& vertex_quadric(MxVertexID v) { return quadric(v); }
+    void link_contraction(MxVdpmHistory& history, MxVdpmPairContraction& conx);
+    void update_deviations(MxVdpmHistory& history);
     void(*contraction_callback)(const MxPairContraction&, float);
 };
 
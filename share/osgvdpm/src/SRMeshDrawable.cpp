@@ -1,3 +1,4 @@
+#include "vdpm/OpenGL4Renderer.h"
 #include "vdpm/OpenGLRenderer.h"
 #include "vdpm/SRMesh.h"
 #include "vdpm/Viewport.h"
@@ -46,7 +47,11 @@ void SRMeshDrawable::drawImplementation(RenderInfo& renderInfo) const
 
         status = REALIZING;
 
+    #ifdef VDPM_RENDERER_OPENGL4
+        srmesh->realize(&vdpm::OpenGL4Renderer::getInstance());
+    #else
         srmesh->realize(&vdpm::OpenGLRenderer::getInstance());
+    #endif
 
         viewport = new vdpm::Viewport();
         srmesh->setViewport(viewport);
@@ -76,6 +81,11 @@ void SRMeshDrawable::drawImplementation(RenderInfo& renderInfo) const
             userData->getStats()->setAttribute(framenumber, SRMeshUserStats::afaceCountName, afaceCount);
             userData->getStats()->setAttribute(framenumber, SRMeshUserStats::vmorphCountName, srmesh->getVMorphCount());
             userData->getStats()->setAttribute(framenumber, SRMeshUserStats::afaceCountPerTStripName, ((tstripCount > 0) ? ((float)afaceCount / tstripCount) : 0));
+
+            // vsplits, ecols and turned back coarsenings of the previous frame
+            const vdpm::ChurnStats& churn = srmesh->getChurnStats();
+            userData->getStats()->setAttribute(framenumber, SRMeshUserStats::churnName, churn.vsplits + churn.ecols + churn.aborts);
+            srmesh->resetChurnStats();
         }
         pause = userData->getPause();
     }
@@ -83,10 +93,19 @@ void SRMeshDrawable::drawImplementation(RenderInfo& renderInfo) const
     {
         srmesh->updateViewport();
 
-    #ifdef VDPM_GEOMORPHS
-        srmesh->updateVMorphs();
-    #endif
-        srmesh->adaptRefine();
+        if (status == REALIZED)
+        {
+            // reach the detail of the first view at once instead of refining over many frames
+            srmesh->refineImmediately(viewport, srmesh->getTau());
+            status = CONVERGED;
+        }
+        else
+        {
+        #ifdef VDPM_GEOMORPHS
+            srmesh->updateVMorphs();
+        #endif
+            srmesh->adaptRefine();
+        }
         srmesh->updateScene();
     }
     srmesh->draw();
@@ -26,6 +26,7 @@ const std::string SRMeshUserStats::tauName                  = "vdpmTau";
 const std::string SRMeshUserStats::afaceCountName           = "vdpmAFaceCount";
 const std::string SRMeshUserStats::vmorphCountName          = "vdpmVmorphCount";
 const std::string SRMeshUserStats::afaceCountPerTStripName  = "vdpmAFaceCountPerTStrip";
+const std::string SRMeshUserStats::churnName                = "vdpmChurn";
 
 void SRMeshUserStats::init(osgViewer::StatsHandler* statsHandler)
 {
@@ -37,4 +38,6 @@ void SRMeshUserStats::init(osgViewer::StatsHandler* statsHandler)
         vmorphCountName, 1.0, true, false, "", "", UINT_MAX);
     statsHandler->addUserStatsLine("Avg. Faces per TStrip", osg::Vec4(0.7, 0.7, 0.7, 1), osg::Vec4(0.7, 0.7, 0.7, 0.5),
         afaceCountPerTStripName, 1.0, true, false, "", "", 100.0);
+    statsHandler->addUserStatsLine("Churn", osg::Vec4(0.7, 0.7, 0.7, 1), osg::Vec4(0.7, 0.7, 0.7, 0.5),
+        churnName, 1.0, true, false, "", "", 1000.0);
 }
@@ -22,19 +22,23 @@
 
 namespace vdpm
 {
+    // Free lists of the runtime objects of one mesh. Each SRMesh owns its allocator, so meshes
+    // refined on different threads share no mutable state.
     class Allocator
     {
     public:
+        Allocator();
         ~Allocator();
 
-        static Allocator& getInstance();
-
+        // with VDPM_INDEX_TOPOLOGY these live in pools of the mesh instead
+    #ifndef VDPM_INDEX_TOPOLOGY
         AVertex* allocAVertex();
         void freeAVertex(AVertex* avertex);
         AFace* allocAFace();
         void freeAFace(AFace* aface);
         TStrip* allocTStrip();
-        void freeTStrip(TStrip* tstrip, AFace& afaces);
+        void freeTStrip(TStrip* tstrip);
+    #endif
 
     #ifdef VDPM_GEOMORPHS
         VMorph* allocVMorph();
@@ -42,13 +46,13 @@ namespace vdpm
     #endif // VDPM_GEOMORPHS
 
     private:
-        Allocator();
-
     #ifdef VDPM_REUSE_OBJECTS
-        static AVertex* freeAVertices;
-        static AFace* freeAFaces;
-        static TStrip* freeTStrips;
-        static VMorph* freeVMorphs;
+    #ifndef VDPM_INDEX_TOPOLOGY
+        AVertex* freeAVertices;
+        AFace* freeAFaces;
+        TStrip* freeTStrips;
+    #endif
+        VMorph* freeVMorphs;
     #endif // VDPM_REUSE_OBJECTS
     };
 } // namespace vdpm
@@ -22,17 +22,25 @@
 #define VDPM_RENDERER_OPENGL_VBO
 #define VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
 #define VDPM_RENDERER_OPENGL_IBO
+//#define VDPM_RENDERER_OPENGL4
 #define VDPM_ORIENTED_AWAY
 #define VDPM_GEOMORPHS
 #define VDPM_GEOMORPHS_PLUS
 #define VDPM_REGULATION
 //#define VDPM_REGULATION_FORCE
 #define VDPM_AMORTIZATION
+//#define VDPM_HYSTERESIS
 #define VDPM_TSTRIP_SWAP
 //#define VDPM_TSTRIP_RESTRIP_ALL
 //#define VDPM_PREDICT_VIEW_POSITION
 //#define VDPM_SCREEN_ERROR_STRICT
 #define VDPM_REUSE_OBJECTS
+#define VDPM_VSPLIT_DEPENDENCIES
+//#define VDPM_INDEX_TOPOLOGY
+//#define VDPM_IMPORTANCE_REGIONS
+//#define VDPM_FACE_BVH
+//#define VDPM_STREAMING
 #define VDPM_MAX_ATTRIBS 5
+#define VDPM_MAX_IMPORTANCE_REGIONS 8
 
 #endif // VDPM_CONFIG_H
@@ -0,0 +1,87 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_DEFERREDRENDERER_H
+#define VDPM_DEFERREDRENDERER_H
+
+#include <vector>
+#include "vdpm/Renderer.h"
+
+namespace vdpm
+{
+    // Renderer that lets a mesh be refined away from the thread owning the graphics context.
+    // The mesh works on system memory copies of its buffers, and submit() applies buffer
+    // creation, resizes and modified ranges to the target renderer in one go. Use one instance
+    // per mesh and call submit() after realize() and after each refinement. submit(),
+    // updateViewport() and draw() reach the target and must be called on its thread while no job
+    // runs on the mesh. Delete the mesh before its DeferredRenderer. Requires
+    // VDPM_RENDERER_OPENGL_VBO.
+    class DeferredRenderer : public Renderer
+    {
+    public:
+        DeferredRenderer(Renderer* target);
+        ~DeferredRenderer();
+
+        void submit();
+
+        void* createBuffer(RendererBuffer target, unsigned int size, const void* data);
+        void destroyBuffer(void* buf);
+        void setBufferData(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, const void* data);
+        void* resizeBuffer(RendererBuffer target, void* buf, unsigned int size);
+        void* mapBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, RendererAccess access);
+        void unmapBuffer(RendererBuffer target, void* buf);
+        void flushBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size);
+        void updateDrawCommands(SRMesh* srmesh);
+
+        void updateViewport(Viewport* viewport);
+        void draw(SRMesh* srmesh);
+
+    private:
+        struct DeferredRange
+        {
+            unsigned int offset, size;
+        };
+
+        struct DeferredBuffer
+        {
+            void* buf;                      // buffer of the target renderer, NULL until submitted
+            RendererBuffer target;
+            unsigned int size;              // size of buf
+            std::vector<uint8_t> data;      // contents as the mesh sees them
+            std::vector<uint8_t> submitted; // vertex buffers only: contents as last submitted
+            unsigned int writeBegin, writeEnd; // vertex buffers only: range written since last submit
+            std::vector<DeferredRange> ranges;
+            unsigned int mapOffset, mapSize, mapCount;
+            RendererAccess access;
+            bool flushed;
+        };
+
+        void addRange(DeferredBuffer* db, unsigned int offset, unsigned int size);
+        void addWriteRange(DeferredBuffer* db, unsigned int offset, unsigned int size);
+        void compareWrites(DeferredBuffer* db);
+        void addChangedRanges(DeferredBuffer* db, unsigned int offset, unsigned int size);
+        void bindTargetBuffers(SRMesh* srmesh, void** saved);
+        void restoreBuffers(SRMesh* srmesh, void** saved);
+
+        Renderer* target;
+        std::vector<DeferredBuffer*> buffers;
+        std::vector<DeferredBuffer*> destroyed;
+        SRMesh* drawCommandsMesh;
+    };
+} // namespace vdpm
+
+#endif // VDPM_DEFERREDRENDERER_H
@@ -0,0 +1,81 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_FACEBVH_H
+#define VDPM_FACEBVH_H
+
+#include <vector>
+#include "vdpm/Types.h"
+
+namespace vdpm
+{
+    struct FaceBVHHit
+    {
+        AFace* aface;
+        float distance;     // along the ray
+        Point point;
+        float u, v;         // barycentric coordinates of point relative to the first corner
+    };
+
+    // Dynamic bounding volume hierarchy over the active faces of a mesh. Leaves keep a copy of
+    // their triangle inside a slightly enlarged box, so small vertex motion only updates the copy
+    // while larger changes reinsert the leaf. Tree rotations keep it balanced as faces come and go.
+    // Queries only read the tree and may run on several threads while the mesh is not refined.
+    class FaceBVH
+    {
+    public:
+        FaceBVH();
+        ~FaceBVH();
+
+        unsigned int insert(AFace* aface, const Point& p0, const Point& p1, const Point& p2);
+        void update(unsigned int leaf, const Point& p0, const Point& p1, const Point& p2);
+        void remove(unsigned int leaf);
+        void clear();
+
+        unsigned int getFaceCount() { return faceCount; }
+        bool getBounds(Point& min, Point& max);
+
+        bool intersectRay(const Point& origin, const Vector& direction, float maxDistance, FaceBVHHit& hit);
+        unsigned int querySphere(const Point& center, float radius, AFace** afaces, unsigned int maxCount);
+
+        // highest surface point on the line through position along up, which must be normalized
+        bool queryHeight(const Point& position, const Vector& up, FaceBVHHit& hit);
+
+    private:
+        struct Node
+        {
+            Point boxMin, boxMax;
+            int parent, child0, child1, height;
+            AFace* aface;
+            Point p[3];
+        };
+
+        int allocNode();
+        void freeNode(int node);
+        void setLeafBox(int leaf);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int a);
+        void updateNode(int node);
+
+        std::vector<Node> nodes;
+        int root, freeNodes;
+        unsigned int faceCount;
+    };
+} // namespace vdpm
+
+#endif // VDPM_FACEBVH_H
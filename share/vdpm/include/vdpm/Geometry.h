@@ -18,6 +18,7 @@
 #ifndef VDPM_GEOMETRY_H
 #define VDPM_GEOMETRY_H
 
+#include <cstdint>
 #include "vdpm/Types.h"
 #include "vdpm/Renderer.h"
 
@@ -25,6 +26,7 @@ namespace vdpm
 {
     class Geometry
     {
+        friend class DeferredRenderer;
         friend class SRMesh;
 
     public:
@@ -33,10 +35,21 @@ namespace vdpm
         int realize(Renderer* renderer);
         int resize(unsigned int count);
 
-    #ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-        void mapVGeom();
-        void unmapVGeom();
-    #endif // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
+        // A VBO is written through a system memory copy. Vertices written there are marked
+        // dirty and upload() sends them in a few coalesced ranges, each mapped write only with
+        // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM or set directly without it. Both do nothing when
+        // the vertices are written in place.
+        void setDirty(unsigned int index)
+        {
+        #ifdef VDPM_RENDERER_OPENGL_VBO
+            dirty[index >> 6] |= (uint64_t)1 << (index & 63);
+            if (index < dirtyBegin)
+                dirtyBegin = index;
+            if (index >= dirtyEnd)
+                dirtyEnd = index + 1;
+        #endif
+        }
+        void upload();
 
         float* getVertexPointer() { return &vgeoms->point.x; }
         float* getNormalPointer() { return &vgeoms->normal.x; }
@@ -49,12 +62,21 @@ namespace vdpm
     private:
         Geometry() {}
 
+    #ifdef VDPM_RENDERER_OPENGL_VBO
+        void uploadRange(unsigned int begin, unsigned int end);
+    #endif
+
         VGeom* vgeoms;
         void* vbo;
 
         unsigned int vgeomCount, vgeomSize, colorOffset, texCoordOffset;
         bool hasColor, hasTexCoord;
 
+    #ifdef VDPM_RENDERER_OPENGL_VBO
+        uint64_t* dirty;                    // one bit per vertex
+        unsigned int dirtyBegin, dirtyEnd;  // bounds of the set bits
+    #endif
+
         Renderer* renderer;
     };
 
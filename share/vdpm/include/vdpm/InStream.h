@@ -23,6 +23,8 @@ namespace vdpm
     class InStream
     {
     public:
+        virtual ~InStream() {}
+
         virtual void readChar(char& value) = 0;
         virtual void readUInt(unsigned int& value) = 0;
         virtual void readFloat(float& value) = 0;
@@ -0,0 +1,69 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_LODBAKER_H
+#define VDPM_LODBAKER_H
+
+#include <vector>
+#include "vdpm/Types.h"
+
+namespace vdpm
+{
+    struct BakedLOD
+    {
+        unsigned int vsplitCount;       // vsplits applied from the base mesh
+        float error;                    // largest uniform error of the vsplits not applied
+        unsigned int vgeomSize;         // bytes per vertex, laid out as in SRMesh::getVGeomSize()
+        std::vector<uint8_t> vgeoms;    // referenced vertices only, in first use order
+        std::vector<uint32_t> indices;  // triangle list ordered for the post-transform vertex cache
+
+        unsigned int getVertexCount() const { return vgeomSize ? (unsigned int)(vgeoms.size() / vgeomSize) : 0; }
+        unsigned int getFaceCount() const { return (unsigned int)(indices.size() / 3); }
+    };
+
+    // Extracts static meshes from the vsplit sequence of an SRMesh. The mesh is coarsened to its
+    // base mesh once and every bake() only applies further vsplits in sequence order, so a chain
+    // of LODs from coarse to fine costs one pass over the vsplit table. Baking changes the active
+    // faces of the mesh; call updateScene() before drawing it again.
+    class LODBaker
+    {
+    public:
+        LODBaker(SRMesh* srmesh);
+
+        int rewind();
+
+        // refines until faceCount would be exceeded or every remaining vsplit has an error
+        // below error (a distance, 0 for no limit), then outputs the current mesh
+        int bake(unsigned int faceCount, float error, BakedLOD& lod);
+
+        // lods[i] gets faceCounts[i], which are sorted ascending
+        int bakeChain(const unsigned int* faceCounts, unsigned int count, BakedLOD* lods);
+
+        unsigned int getVSplitIndex() { return next; }
+
+    private:
+        void output(BakedLOD& lod);
+        void optimizeVertexCache(std::vector<uint32_t>& indices, unsigned int vertexCount);
+
+        SRMesh* srmesh;
+        std::vector<float> remainingErrors;    // largest uni_error from each vsplit to the end
+        unsigned int next;
+        bool rewound;
+    };
+} // namespace vdpm
+
+#endif // VDPM_LODBAKER_H
@@ -0,0 +1,54 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_OPENGL4RENDERER_H
+#define VDPM_OPENGL4RENDERER_H
+
+#include "vdpm/OpenGLRenderer.h"
+
+namespace vdpm
+{
+    // OpenGL 4.x renderer built on ARB_buffer_storage and ARB_multi_draw_indirect.
+    // Buffers are mapped persistently once, vertex, index and draw-command buffers
+    // are triple-buffered per frame and guarded by fences, and each mesh is drawn
+    // with a single glMultiDrawElementsIndirect call from its vertex array object.
+    //
+    // Vertex data goes through the fixed-function arrays, as in OpenGLRenderer,
+    // so it needs a compatibility profile.
+    class OpenGL4Renderer : public OpenGLRenderer
+    {
+    public:
+        static OpenGL4Renderer& getInstance();
+
+        void* createBuffer(RendererBuffer target, unsigned int size, const void* data);
+        void destroyBuffer(void* buf);
+        void setBufferData(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, const void* data);
+        void* resizeBuffer(RendererBuffer target, void* buf, unsigned int size);
+        void* mapBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, RendererAccess access);
+        void unmapBuffer(RendererBuffer target, void* buf);
+        void flushBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size);
+
+        void updateDrawCommands(SRMesh* srmesh);
+        void draw(SRMesh* srmesh);
+
+    protected:
+        OpenGL4Renderer();
+        ~OpenGL4Renderer();
+    };
+} // namespace vdpm
+
+#endif // VDPM_OPENGL4RENDERER_H
@@ -23,6 +23,8 @@ namespace vdpm
     class OutStream
     {
     public:
+        virtual ~OutStream() {}
+
         virtual void writeChar(char& value) = 0;
         virtual void writeUInt(unsigned int& value) = 0;
         virtual void writeFloat(float& value) = 0;
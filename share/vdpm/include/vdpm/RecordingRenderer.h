@@ -0,0 +1,99 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_RECORDINGRENDERER_H
+#define VDPM_RECORDINGRENDERER_H
+
+#include <fstream>
+#include <map>
+#include <vector>
+#include "vdpm/Renderer.h"
+
+namespace vdpm
+{
+    // Statistics of one replayed interval, from the previous draw call up to and including the next one.
+    struct RendererTraceFrame
+    {
+        unsigned int index;
+        unsigned int calls;
+        uint64_t uploadBytes;   // bytes handed to the renderer (create/setBufferData/flush or unflushed write maps)
+        uint64_t writtenBytes;  // bytes that actually changed in mapped ranges
+        uint64_t recordedTime;  // ns spent in the recorded renderer
+        uint64_t replayTime;    // ns spent in the replay renderer
+    };
+
+    typedef void (*RendererTraceCallback)(const RendererTraceFrame& frame, void* param);
+
+    // Renderer that forwards every call to a target renderer (or to the CPU implementation of
+    // Renderer when the target is NULL) and logs buffer operations, byte ranges and call timing
+    // to a binary trace. A writable map hands the caller a staging copy of the range. When a range
+    // is flushed or unmapped, the staging copy is compared with a shadow copy of the buffer, the
+    // modified bytes are stored, and the range is copied into the target's mapping.
+    class RecordingRenderer : public Renderer
+    {
+    public:
+        RecordingRenderer(Renderer* target, const char filePath[]);
+        RecordingRenderer(Renderer* target, std::ostream* os);
+        ~RecordingRenderer();
+
+        void close();
+
+        void* createBuffer(RendererBuffer target, unsigned int size, const void* data);
+        void destroyBuffer(void* buf);
+        void setBufferData(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, const void* data);
+        void* resizeBuffer(RendererBuffer target, void* buf, unsigned int size);
+        void* mapBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, RendererAccess access);
+        void unmapBuffer(RendererBuffer target, void* buf);
+        void flushBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size);
+        void updateDrawCommands(SRMesh* srmesh);
+
+        void updateViewport(Viewport* viewport);
+        void draw(SRMesh* srmesh);
+
+        // Re-executes the buffer operations of a trace against a renderer. Draw and viewport
+        // records only delimit frames since the meshes are not part of the trace.
+        static int replay(const char filePath[], Renderer* target, RendererTraceCallback callback, void* param);
+        static int replay(std::istream& is, Renderer* target, RendererTraceCallback callback, void* param);
+
+    private:
+        struct BufferRecord
+        {
+            unsigned int id;
+            RendererBuffer target;
+            std::vector<uint8_t> shadow;
+            std::vector<uint8_t> staging;   // what the caller writes while mapped
+            uint8_t* mapped;
+            unsigned int mapOffset, mapSize;
+            RendererAccess access;
+            bool flushed;
+        };
+
+        void open();
+        void writeRecord(uint8_t op, unsigned int id, RendererBuffer target, unsigned int access,
+            unsigned int offset, unsigned int size, uint64_t start, uint64_t duration);
+        void writeMappedChanges(BufferRecord& record, unsigned int offset, unsigned int size);
+
+        Renderer* target;
+        std::ostream* os;
+        std::ofstream fout;
+        std::map<void*, BufferRecord> buffers;
+        unsigned int nextBufferId;
+        uint64_t startTime;
+    };
+} // namespace vdpm
+
+#endif // VDPM_RECORDINGRENDERER_H
@@ -45,6 +45,7 @@ namespace vdpm
         virtual void* mapBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, RendererAccess access);
         virtual void unmapBuffer(RendererBuffer target, void* buf);
         virtual void flushBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size);
+        virtual void updateDrawCommands(SRMesh* srmesh);
 
         virtual void updateViewport(Viewport* viewport) = 0;
         virtual void draw(SRMesh* srmesh) = 0;
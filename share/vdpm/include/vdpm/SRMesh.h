@@ -24,9 +24,13 @@
 
 namespace vdpm
 {
+    struct VGeomOps;
+
     class SRMesh
     {
+        friend class DeferredRenderer;
         friend class Serializer;
+        friend class StreamServer;
 
     public:
         ~SRMesh();
@@ -44,6 +48,50 @@ namespace vdpm
         void setAmortizeStep(unsigned int step);
     #endif
 
+    #ifdef VDPM_HYSTERESIS
+        // Coarsening starts only once the parent's screen error is below tau * scale, so a
+        // scale below 1 opens a band under tau where a vertex is neither split nor collapsed.
+        // A vertex just split, collapsed or turned back from coarsening keeps its state for
+        // cooldown calls of adaptRefine().
+        void setMergeTauScale(float scale);
+        void setCooldown(unsigned int frames);
+        float getMergeTau() { return tau * mergeTauScale; }
+    #endif
+
+        const ChurnStats& getChurnStats() { return churnStats; }
+        void resetChurnStats();
+
+    #ifdef VDPM_IMPORTANCE_REGIONS
+        // Regions scale tau where they apply, below 1 for more detail and above 1 for less.
+        // Later regions blend over earlier ones. Each returns a region index, or -1 when
+        // VDPM_MAX_IMPORTANCE_REGIONS are in use, an extent is not positive or the falloff is negative.
+        int addImportanceEllipse(float x, float y, float rx, float ry, float tauScale, float falloff);
+        int addImportanceSphere(const Point& center, float radius, float tauScale, float falloff);
+        int addImportanceBox(const Point& min, const Point& max, float tauScale, float falloff);
+        ImportanceRegion* getImportanceRegion(int region);
+        void removeImportanceRegion(int region);
+        void clearImportanceRegions();
+        void setDefaultTauScale(float tauScale);
+        void setBaseVertexTauScale(unsigned int i, float tauScale);
+    #endif
+
+    #ifdef VDPM_FACE_BVH
+        // The hierarchy over the active faces is filled by the next updateScene() and then
+        // follows every refinement, geomorphs included. NULL while disabled.
+        void setFaceBVHEnabled(bool enabled);
+        FaceBVH* getFaceBVH() { return bvh; }
+    #endif
+
+    #ifdef VDPM_STREAMING
+        // A streamed mesh starts as its base mesh and gains vsplit records as they arrive,
+        // in any order that delivers the prerequisites of a vsplit before it. Call between
+        // frames, from the thread that refines the mesh.
+        int addStreamedVSplit(unsigned int i, unsigned int vs_i, const unsigned int fn[4],
+            float radius, float sin2alpha, float uni_error, float dir_error, const VGeom* vt, const VGeom* vu);
+        bool isStreamed() { return streamed; }
+        unsigned int getStreamedVSplitCount() { return streamedVSplitCount; }
+    #endif
+
     #ifdef VDPM_GEOMORPHS
         void setGTime(unsigned int gtime);
         void updateVMorphs();
@@ -53,6 +101,21 @@ namespace vdpm
         void adaptRefine();
         void updateScene();
         void draw();
+        unsigned int getActiveFrontSize();
+        void saveActiveFront(uint32_t* front);
+        int restoreActiveFront(const uint32_t* front);
+        void refineImmediately(Viewport* viewport, float tau);
+
+        // Static extraction applies vsplits in the order of the vsplit table, where the faces
+        // each one needs are created by earlier ones, so every prefix of the table is a valid
+        // mesh. splitInSequence() applies vsplit i unless its faces are active already, without
+        // geomorphs, and returns 0, 1 when a streamed mesh lacks its record, or -1 when it is
+        // illegal. getVSplitError() is the squared uniform error of vsplit i.
+        unsigned int getVSplitCount() { return vsplitCount; }
+        float getVSplitError(unsigned int i) { return vsplits[i].uni_error; }
+        int splitInSequence(unsigned int i);
+        void getAFaceVGeomIndices(uint32_t* indices);    // 3 per active face
+        void copyVGeoms(const uint32_t* indices, unsigned int count, void* dst);
         void printStatus();
         void printAVertex(AVertex* avertex);
 
@@ -61,6 +124,7 @@ namespace vdpm
 
         float getTau() { return tau; };
         unsigned int getVertexCount() { return vcount; };
+        unsigned int getFaceCount() { return fcount; };
         unsigned int getAFaceCount() { return afaceCount; };
         unsigned int getTStripCount() { return tstripCount; };
 
@@ -93,11 +157,31 @@ namespace vdpm
         void vsplit(Vertex* vs);
         void ecol(Vertex* vs);
         void forceVSplit(Vertex* v);
+    #ifdef VDPM_VSPLIT_DEPENDENCIES
+        int buildVSplitDependencies();
+    #ifdef VDPM_STREAMING
+        void setVSplitDependencies(unsigned int i);
+    #endif
+    #endif
+    #if defined(VDPM_VSPLIT_DEPENDENCIES) || defined(VDPM_STREAMING)
+        unsigned int getVSplitDependencies(unsigned int i, unsigned int* deps);
+    #endif
         bool outsideViewFrustum(Vertex* vs);
     #ifdef VDPM_ORIENTED_AWAY
         bool orientedAway(Vertex* vs);
     #endif
-        bool screenErrorIllegal(Vertex* vs);
+        bool screenErrorIllegal(Vertex* vs) { return screenErrorIllegal(vs, kappa2); }
+        bool screenErrorIllegal(Vertex* vs, float k2);
+    #ifdef VDPM_FACE_BVH
+        void updateFaceBVH();
+        void updateFaceBVHLeaf(AFace* aface);
+        Point getDrawnPoint(AVertex* avertex);
+    #endif
+    #ifdef VDPM_IMPORTANCE_REGIONS
+        int addImportanceRegion(ImportanceShape shape, const Point& center, const Vector& extent, float tauScale, float falloff);
+        void updateImportance();
+        float getTauScale(Vertex* vs, const Point& point);
+    #endif
         bool vsplitLegal(Vertex* vs);
         bool ecolLegal(Vertex* vs);
     #ifdef VDPM_GEOMORPHS
@@ -106,8 +190,42 @@ namespace vdpm
         void abortCoarsening(AVertex* avertex);
     #endif // VDPM_GEOMORPHS
 
+        AVertex* allocAVertex();
+        void freeAVertex(AVertex* avertex);
+        AFace* allocAFace();
+        void freeAFace(AFace* aface);
+        TStrip* allocTStrip();
+        void freeTStrip(TStrip* tstrip);
         void addAVertex(AVertex* avertex);
         void addAFace(AFace* aface);
+        void initActiveLists();
+
+        // topology references resolve against the pools of this mesh
+    #ifdef VDPM_INDEX_TOPOLOGY
+        int createTopologyPools(unsigned int vcount, unsigned int fcount);
+
+        Vertex* getVertex(VertexRef r) { return r ? &vertices[r.getIndex() - 1] : NULL; }
+        Face* getFace(FaceRef r) { return r ? &faces[r.getIndex() - 1] : NULL; }
+        AVertex* getAVertex(AVertexRef r) { return r ? &avertexPool[r.getIndex() - 1] : NULL; }
+        AFace* getAFace(AFaceRef r) { return r ? &afacePool[r.getIndex() - 1] : NULL; }
+        TStrip* getTStrip(TStripRef r) { return r ? tstripPool[r.getIndex() - 1] : NULL; }
+        VertexRef ref(Vertex* p) { return VertexRef(p ? (uint32_t)(p - vertices) + 1 : 0); }
+        FaceRef ref(Face* p) { return FaceRef(p ? (uint32_t)(p - faces) + 1 : 0); }
+        AVertexRef ref(AVertex* p) { return AVertexRef(p ? (uint32_t)(p - avertexPool) + 1 : 0); }
+        AFaceRef ref(AFace* p) { return AFaceRef(p ? (uint32_t)(p - afacePool) + 1 : 0); }
+        TStripRef ref(TStrip* p) { return TStripRef(p ? p->index : 0); }
+    #else
+        Vertex* getVertex(VertexRef r) { return r; }
+        Face* getFace(FaceRef r) { return r; }
+        AVertex* getAVertex(AVertexRef r) { return r; }
+        AFace* getAFace(AFaceRef r) { return r; }
+        TStrip* getTStrip(TStripRef r) { return r; }
+        VertexRef ref(Vertex* p) { return p; }
+        FaceRef ref(Face* p) { return p; }
+        AVertexRef ref(AVertex* p) { return p; }
+        AFaceRef ref(AFace* p) { return p; }
+        TStripRef ref(TStrip* p) { return p; }
+    #endif // VDPM_INDEX_TOPOLOGY
 
     #ifndef NDEBUG
         void assertAVertices();
@@ -118,7 +236,14 @@ namespace vdpm
     #endif // VDPM_GEOMORPHS
     #endif // !NDEBUG
 
+#ifdef VDPM_VSPLIT_DEPENDENCIES
+        // prerequisites of each vsplit in CSR form: vsplitDeps[vsplitDepOffsets[i]..vsplitDepOffsets[i + 1]]
+        unsigned int* vsplitDepOffsets;
+        unsigned int* vsplitDeps;
+        VSplitFrame* vsplitStack;
+#else
         Vertex** vstack;
+#endif
         unsigned int* indicesBuffer;
         unsigned int** indicesArray;
         unsigned int* indicesCountArray;
@@ -131,8 +256,22 @@ namespace vdpm
         Vertex* vertices;
         Face* faces;
         VSplit* vsplits;
-        AVertex avertices, averticesEnd;
-        AFace afaces, afacesEnd;
+        AVertex *avertices, *averticesEnd;     // sentinels of the active lists
+        AFace *afaces, *afacesEnd;
+
+#ifdef VDPM_INDEX_TOPOLOGY
+        // the sentinels come first in the pools, the strips keep their slots once allocated
+        AVertex* avertexPool;
+        AFace* afacePool;
+        TStrip** tstripPool;
+        AVertex* freeAVertices;
+        AFace* freeAFaces;
+        TStrip* freeTStrips;
+        unsigned int avertexPoolTop, afacePoolTop, tstripPoolTop, tstripPoolSize;
+#else
+        AVertex avertexSentinels[2];
+        AFace afaceSentinels[2];
+#endif
         TStrip tstrips, tstripsEnd;
 
 #ifdef VDPM_TSTRIP_RESTRIP_ALL
@@ -145,9 +284,16 @@ namespace vdpm
         unsigned int vmorphCount, vmorphSize;
         TStrip gmorphTstrips, gmorphTstripsEnd;
         VGeom* vmorphVgeoms;
+        bool vmorphsSuppressed;
+
+        // kernels of the vertex attribute layout, picked by realize()
+        const VGeomOps* vgeomOps;
+        void (SRMesh::*updateVMorphsFunc)();
 #endif
         unsigned int vcount, fcount, baseVCount, baseFCount, vsplitCount, avertexCount, tstripCount, afaceCount, indicesArraySize, indicesBufferSize;
+#ifndef VDPM_VSPLIT_DEPENDENCIES
         int vstackSize;
+#endif
         float tanPhi, kappa2, tau;
 
 #ifdef VDPM_REGULATION
@@ -160,6 +306,30 @@ namespace vdpm
         unsigned int amortizeBudget, amortizeCount, amortizeStep;
 #endif
 
+#ifdef VDPM_HYSTERESIS
+        unsigned int* vertexHolds;  // per vertex, the refine frame until which its last vsplit or ecol stays
+        unsigned int refineFrame, cooldown;
+        float mergeTauScale;
+#endif
+        ChurnStats churnStats;
+
+#ifdef VDPM_FACE_BVH
+        FaceBVH* bvh;
+        bool bvhRebuild;
+#endif
+
+#ifdef VDPM_STREAMING
+        bool streamed;
+        unsigned int streamedVSplitCount;
+#endif
+
+#ifdef VDPM_IMPORTANCE_REGIONS
+        ImportanceRegion importanceRegions[VDPM_MAX_IMPORTANCE_REGIONS];
+        float* vertexTauScales;     // per vertex, inherited from its base vertex
+        float defaultTauScale;
+        bool importanceActive, vertexTauScalesDirty;
+#endif
+
         Vector boundMin;
         Vector boundMax;
 
@@ -172,8 +342,12 @@ namespace vdpm
     private:
         VGeom* getVGeom(unsigned int i) { return geometry.getVGeom(i); }
         void addTStrip(TStrip* tstrip);
+        unsigned int collapseOutsideFront(const uint32_t* front);
+        void resetScene();
         unsigned int getVGeomIndex(Vertex* vs);
+        inline Vertex* getSibling(Vertex* v);
         inline unsigned int getVertexIndex(AVertex* av, TStrip* tstrip);
+        inline bool screenErrorIllegal(VGeom* vs_geom, VSplit& vsp, const Point& viewPos, float k2);
     #ifdef VDPM_GEOMORPHS
         VMorph* createVMorph();
         void removeVMorph(VMorph* vmorph);
@@ -182,11 +356,8 @@ namespace vdpm
         bool isVMorphIndexFree(unsigned int index);
         VGeom* getVMorphVGeom(unsigned int index);
         void addGMorphTStrip(TStrip* tstrip);
-
-    #ifdef VDPM_GEOMORPHS_PLUS
-        void calcVGeomOnLine(const VGeom* vu_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom);
-        void calcVGeomOnFace(const VGeom* vu_vgeom, const VGeom* vs_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom);
-    #endif // VDPM_GEOMORPHS_PLUS
+        void selectVGeomKernels();
+        template<unsigned int N> void updateVMorphs();
     #endif // VDPM_GEOMORPHS
     };
 } // namespace vdpm
@@ -0,0 +1,77 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_SCHEDULER_H
+#define VDPM_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "vdpm/Types.h"
+
+namespace vdpm
+{
+    typedef void (*SchedulerJob)(void* param, unsigned int index);
+
+    // Work-stealing thread pool to refine several meshes in parallel. Jobs are spread over the
+    // worker queues and an idle worker steals from the others, so meshes with uneven refinement
+    // cost keep all cores busy. The calling thread joins in and run() returns once every job is
+    // done. Meshes scheduled together must not share a renderer or, with
+    // VDPM_PREDICT_VIEW_POSITION, a viewport; give each mesh a DeferredRenderer and call its
+    // submit() and SRMesh::draw() on the render thread after refine() returns.
+    class Scheduler
+    {
+    public:
+        Scheduler(unsigned int threadCount = 0);
+        ~Scheduler();
+
+        unsigned int getThreadCount() { return (unsigned int)workers.size(); }
+
+        void run(SchedulerJob job, void* param, unsigned int count);
+
+        // updateVMorphs(), adaptRefine() and updateScene() for each mesh
+        void refine(SRMesh** meshes, unsigned int count);
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<unsigned int> jobs;
+        };
+
+        void workerMain(unsigned int id);
+        bool popJob(unsigned int id, unsigned int& index);
+        void execute(unsigned int id);
+
+        std::vector<Worker*> workers;   // workers[0] is the thread calling run()
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable wakeCondition, doneCondition;
+        std::atomic<unsigned int> pending;
+        unsigned int generation;
+        bool quit;
+
+        SchedulerJob job;
+        void* param;
+    };
+} // namespace vdpm
+
+#endif // VDPM_SCHEDULER_H
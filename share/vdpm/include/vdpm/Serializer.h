@@ -36,11 +36,28 @@ namespace vdpm
         SRMesh* readSRMesh(InStream& is);
         int writeSRMesh(OutStream& os, SRMesh* srmesh);
 
+        int readActiveFront(InStream& is, SRMesh* srmesh);
+        int writeActiveFront(OutStream& os, SRMesh* srmesh);
+
+    #ifdef VDPM_STREAMING
+        // A streamed mesh is its base mesh followed by vsplit records of a fixed size, sent in
+        // any order that delivers the prerequisites of a vsplit before it.
+        SRMesh* readStreamedSRMesh(InStream& is);
+        int writeStreamedSRMesh(OutStream& os, SRMesh* srmesh);
+        unsigned int getStreamedVSplitSize(SRMesh* srmesh);
+        int readStreamedVSplit(InStream& is, SRMesh* srmesh);
+        int writeStreamedVSplit(OutStream& os, SRMesh* srmesh, unsigned int i);
+    #endif
+
     private:
         Serializer();
 
         int readSRMesh(InStream& is, SRMesh* srmesh);
         int readTextureName(InStream& is, SRMesh* srmesh);
+        void readVGeom(InStream& is, SRMesh* srmesh, VGeom* vgeom);
+        void writeVGeom(OutStream& os, SRMesh* srmesh, VGeom* vgeom);
+        void readBaseFaces(InStream& is, SRMesh* srmesh);
+        void writeBaseFaces(OutStream& os, SRMesh* srmesh);
     };
 } // namespace vdpm
 
@@ -0,0 +1,74 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_SOCKETSTREAM_H
+#define VDPM_SOCKETSTREAM_H
+
+#include <cstdint>
+#include <vector>
+#include "vdpm/InStream.h"
+#include "vdpm/OutStream.h"
+
+namespace vdpm
+{
+    typedef intptr_t SocketHandle;
+
+    const SocketHandle INVALID_SOCKET_HANDLE = -1;
+
+    // Buffered TCP connection. Reads block until the value has arrived unless fill() already
+    // received it; writes are sent by flush(). After a failed call every read returns zeros.
+    class SocketStream : public InStream, public OutStream
+    {
+    public:
+        SocketStream(SocketHandle socket);
+        ~SocketStream();
+
+        static SocketStream* connect(const char host[], unsigned short port);
+        static SocketHandle listen(unsigned short port, unsigned short* boundPort);
+        static SocketStream* accept(SocketHandle listener);
+        static void closeHandle(SocketHandle socket);
+
+        void close();
+        // sends the rest and waits up to timeout milliseconds for the peer to close first
+        void shutdown(int timeout);
+        bool isFailed() { return failed; }
+
+        // receives what has arrived, waiting up to timeout milliseconds for the first byte
+        int fill(int timeout);
+        unsigned int available() { return (unsigned int)(readBuffer.size() - readOffset); }
+        int flush();
+
+        void readChar(char& value);
+        void readUInt(unsigned int& value);
+        void readFloat(float& value);
+
+        void writeChar(char& value);
+        void writeUInt(unsigned int& value);
+        void writeFloat(float& value);
+
+    private:
+        void read(void* data, unsigned int size);
+        void write(const void* data, unsigned int size);
+
+        SocketHandle socket;
+        std::vector<uint8_t> readBuffer, writeBuffer;
+        unsigned int readOffset;
+        bool failed;
+    };
+} // namespace vdpm
+
+#endif // VDPM_SOCKETSTREAM_H
@@ -0,0 +1,60 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_STREAMCLIENT_H
+#define VDPM_STREAMCLIENT_H
+
+#include "vdpm/SocketStream.h"
+#include "vdpm/Types.h"
+
+#ifdef VDPM_STREAMING
+
+namespace vdpm
+{
+    // Receives a mesh from StreamServer. connect() returns the base mesh, which can be realized
+    // and drawn at once. update() adds the vsplit records that have arrived without waiting for
+    // more, so call it between frames and report the view with sendView() to steer the server.
+    // The mesh belongs to the caller and must outlive the client.
+    class StreamClient
+    {
+    public:
+        StreamClient();
+        ~StreamClient();
+
+        SRMesh* connect(const char host[], unsigned short port);
+        void close();
+
+        int sendView(Viewport* viewport);
+
+        // adds at most maxCount records and returns how many, or -1 when the stream failed
+        int update(unsigned int maxCount);
+        bool isComplete() { return complete; }
+
+    private:
+        // 1 once size bytes are buffered, 0 while they are on the way, -1 when the stream ended
+        int receive(unsigned int size);
+
+        SocketStream* stream;
+        SRMesh* srmesh;
+        unsigned int recordSize, token;
+        bool complete;
+    };
+} // namespace vdpm
+
+#endif // VDPM_STREAMING
+
+#endif // VDPM_STREAMCLIENT_H
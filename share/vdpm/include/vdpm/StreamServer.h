@@ -0,0 +1,91 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_STREAMSERVER_H
+#define VDPM_STREAMSERVER_H
+
+#include <vector>
+#include "vdpm/SocketStream.h"
+#include "vdpm/Types.h"
+
+#ifdef VDPM_STREAMING
+
+namespace vdpm
+{
+    // messages after the base mesh, each a token followed by its data
+    enum StreamMessage
+    {
+        STREAM_VSPLIT = 1,  // server to client: a vsplit record
+        STREAM_END,         // server to client: every record has been sent
+        STREAM_VIEW         // client to server: view position and the six clip planes
+    };
+
+    // Sends a mesh to StreamClient over TCP. The base mesh goes first, then the vsplit records
+    // that are ready in order of their screen error from the last view the client reported, so
+    // the detail in front of the viewer arrives before the rest. A record is ready once the
+    // records it depends on have been sent. The mesh must be loaded but not realized.
+    class StreamServer
+    {
+    public:
+        StreamServer(SRMesh* srmesh);
+        ~StreamServer();
+
+        // port 0 picks a free port, see getPort()
+        int listen(unsigned short port);
+        unsigned short getPort() { return port; }
+        void close();
+
+        // Waits for a client and streams the mesh to it, then returns. Several threads may
+        // serve at the same time.
+        int serve();
+
+        // records sent between checks for a new view
+        void setBatchSize(unsigned int count) { batchSize = count; }
+
+    private:
+        struct StreamView
+        {
+            Point viewPos;
+            float frustum[6][4];
+        };
+
+        struct StreamEntry
+        {
+            float priority;
+            unsigned int i;
+
+            bool operator<(const StreamEntry& other) const { return priority < other.priority; }
+        };
+
+        int buildDependencies();
+        int readView(SocketStream* stream, StreamView& view);
+        float getPriority(unsigned int i, const StreamView* view);
+
+        SRMesh* srmesh;
+
+        // prerequisites of each vsplit and the vsplits depending on it, in CSR form
+        std::vector<unsigned int> depCounts, dependentOffsets, dependents;
+
+        SocketHandle listener;
+        unsigned short port;
+        unsigned int batchSize;
+    };
+} // namespace vdpm
+
+#endif // VDPM_STREAMING
+
+#endif // VDPM_STREAMSERVER_H
@@ -18,6 +18,7 @@
 #ifndef VDPM_TYPES_H
 #define VDPM_TYPES_H
 
+#include <cstddef>
 #include <cstdint>
 #include "vdpm/Config.h"
 #include "vdpm/Utility.h"
@@ -26,11 +27,47 @@ namespace vdpm
 {
     typedef Vector Point;
 
+    struct Vertex;
+    struct Face;
     struct AVertex;
     struct AFace;
     struct TStrip;
     struct VMorph;
 
+#ifdef VDPM_INDEX_TOPOLOGY
+    // 32-bit reference into a pool of the mesh, 0 is the null reference. It does not
+    // know its pool, so only the owning mesh resolves it, see SRMesh::getAFace() and ref().
+    template<class T> class IndexRef
+    {
+        struct Null;
+
+    public:
+        IndexRef() {}
+        IndexRef(Null*) : index(0) {}
+        explicit IndexRef(uint32_t index) : index(index) {}
+
+        uint32_t getIndex() const { return index; }
+        explicit operator bool() const { return index != 0; }
+        bool operator==(IndexRef other) const { return index == other.index; }
+        bool operator!=(IndexRef other) const { return index != other.index; }
+
+    private:
+        uint32_t index;
+    };
+
+    typedef IndexRef<Vertex> VertexRef;
+    typedef IndexRef<Face> FaceRef;
+    typedef IndexRef<AVertex> AVertexRef;
+    typedef IndexRef<AFace> AFaceRef;
+    typedef IndexRef<TStrip> TStripRef;
+#else
+    typedef Vertex* VertexRef;
+    typedef Face* FaceRef;
+    typedef AVertex* AVertexRef;
+    typedef AFace* AFaceRef;
+    typedef TStrip* TStripRef;
+#endif // VDPM_INDEX_TOPOLOGY
+
     struct VGeom
     {
         Point point;
@@ -44,37 +81,48 @@ namespace vdpm
 
     struct Vertex
     {
-        AVertex* avertex;
-        Vertex* parent;
+        AVertexRef avertex;
+        VertexRef parent;
         unsigned int i;
     };
 
     struct Face
     {
-        AFace* aface;
+        AFaceRef aface;
     };
 
     struct VSplit
     {
         unsigned int vt_i, vu_i;
-        Face *fn0, *fn1, *fn2, *fn3;
+        FaceRef fn0, fn1, fn2, fn3;
         float radius, sin2alpha, uni_error, dir_error;
     };
 
+#ifdef VDPM_VSPLIT_DEPENDENCIES
+    struct VSplitFrame
+    {
+        unsigned int i;     // vsplit index
+        unsigned int next;  // next dependency to visit
+    };
+#endif // VDPM_VSPLIT_DEPENDENCIES
+
     struct AVertex
     {
-        AVertex *prev, *next;
-        Vertex* vertex;
+        AVertexRef prev, next;
+        VertexRef vertex;
         unsigned int i;
         VMorph* vmorph;
     };
 
     struct AFace
     {
-        AFace *prev, *next;
-        AVertex *v0, *v1, *v2;
-        AFace *n0, *n1, *n2;
-        TStrip* tstrip;
+        AFaceRef prev, next;
+        AVertexRef v0, v1, v2;
+        AFaceRef n0, n1, n2;
+        TStripRef tstrip;
+    #ifdef VDPM_FACE_BVH
+        unsigned int bvhLeaf;   // 0 when not in the hierarchy
+    #endif
     };
 
     struct TStrip
@@ -86,6 +134,9 @@ namespace vdpm
     #if defined(VDPM_GEOMORPHS) && !defined(VDPM_RECREATE_TSTRIPS)
         unsigned short gtime;
     #endif
+    #ifdef VDPM_INDEX_TOPOLOGY
+        uint32_t index;     // slot in the strip pool of the mesh
+    #endif
     };
 
 #ifdef VDPM_GEOMORPHS
@@ -100,7 +151,37 @@ namespace vdpm
     };
 #endif // VDPM_GEOMORPHS
 
+#ifdef VDPM_IMPORTANCE_REGIONS
+    enum ImportanceShape
+    {
+        IMPORTANCE_NONE,
+        IMPORTANCE_ELLIPSE, // center.x/y and extent.x/y in normalized device coordinates
+        IMPORTANCE_SPHERE,  // radius in extent.x
+        IMPORTANCE_BOX      // half size in extent
+    };
+
+    struct ImportanceRegion
+    {
+        ImportanceShape shape;
+        Point center;
+        Vector extent;
+        float tauScale;     // multiplies tau inside the region
+        float falloff;      // width of the blend to the outside, relative to the extent
+    };
+#endif // VDPM_IMPORTANCE_REGIONS
+
+    // topology updates since the last reset, to measure refinement churn
+    struct ChurnStats
+    {
+        unsigned int vsplits;
+        unsigned int ecols;
+        unsigned int coarsenings;   // geomorphs started toward an ecol
+        unsigned int aborts;        // coarsening geomorphs turned back before the ecol
+        unsigned int suppressed;    // vsplits and coarsenings held back by the hysteresis band or cooldown
+    };
+
     class Allocator;
+    class FaceBVH;
     class Renderer;
     class SRMesh;
     class Viewport;
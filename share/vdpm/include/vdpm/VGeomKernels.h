@@ -0,0 +1,209 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef VDPM_VGEOMKERNELS_H
+#define VDPM_VGEOMKERNELS_H
+
+#include <cstring>
+#include "vdpm/Types.h"
+
+namespace vdpm
+{
+    // floats per vertex of the attribute layouts: point and normal, then color and texcoord when present
+    enum VGeomLayout
+    {
+        VGEOM_LAYOUT_PN = 6,
+        VGEOM_LAYOUT_PNT = 8,
+        VGEOM_LAYOUT_PNC = 9,
+        VGEOM_LAYOUT_PNCT = 11
+    };
+
+    // kernels of one layout behind plain function pointers, for code that runs once per vsplit
+    struct VGeomOps
+    {
+        void (*copy)(VGeom* dst, const VGeom* src);
+        void (*increment)(VGeom* inc, const VGeom* goal, const VGeom* from, float steps);
+        void (*onLine)(const VGeom* vu_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom);
+        void (*onFace)(const VGeom* vu_vgeom, const VGeom* vs_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom);
+    };
+
+    // Vertex kernels for a layout of N floats. Every attribute is interpolated the same way, so the
+    // loops run over the whole vertex with a fixed trip count instead of testing for each attribute.
+    template<unsigned int N> struct VGeomKernels
+    {
+        static const unsigned int SIZE = sizeof(float) * N;
+        static const VGeomOps ops;
+
+        static void copy(VGeom* dst, const VGeom* src)
+        {
+            ::memcpy(reinterpret_cast<float*>(dst), reinterpret_cast<const float*>(src), SIZE);
+        }
+
+        // dst = src - inc * t
+        static void morph(VGeom* dst, const VGeom* src, const VGeom* inc, float t)
+        {
+            float* d = &dst->point.x;
+            const float* s = &src->point.x;
+            const float* i = &inc->point.x;
+
+            for (unsigned int k = 0; k < N; ++k)
+                d[k] = s[k] - i[k] * t;
+        }
+
+        // step that moves from to goal in steps updates
+        static void increment(VGeom* inc, const VGeom* goal, const VGeom* from, float steps)
+        {
+            float* d = &inc->point.x;
+            const float* g = &goal->point.x;
+            const float* f = &from->point.x;
+
+            for (unsigned int k = 0; k < N; ++k)
+                d[k] = (g[k] - f[k]) / steps;
+        }
+
+        // closest point to vu on the segment vl_vr, with the attributes interpolated along it
+        static void onLine(const VGeom* vu_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom)
+        {
+            Point vec_lu, vec_lr;
+            float lambda, result;
+
+            vec_lu = vu_vgeom->point - vl_vgeom->point;
+            vec_lr = vr_vgeom->point - vl_vgeom->point;
+            result = dotProduct(vec_lr, vec_lr);
+            lambda = (result) ? dotProduct(vec_lu, vec_lr) / result : 0.0f;
+
+            if (lambda <= 0.0f)
+            {
+                copy(vgeom, vl_vgeom);
+            }
+            else if (lambda >= 1.0f)
+            {
+                copy(vgeom, vr_vgeom);
+            }
+            else
+            {
+                float* d = &vgeom->point.x;
+                const float* l = &vl_vgeom->point.x;
+                const float* r = &vr_vgeom->point.x;
+
+                for (unsigned int k = 0; k < N; ++k)
+                    d[k] = l[k] + lambda * (r[k] - l[k]);
+            }
+        }
+
+        // vu projected onto the triangle vs_vr_vl, or onto its closest edge or corner when outside
+        static void onFace(const VGeom* vu_vgeom, const VGeom* vs_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom)
+        {
+            Point vec_sl, vec_sr, vec_su, faceNormal;
+            float lambda, result, dot00, dot01, dot02, dot11, dot12, invDenom, u, v;
+
+            vec_sl = vl_vgeom->point - vs_vgeom->point;
+            vec_sr = vr_vgeom->point - vs_vgeom->point;
+            faceNormal = crossProduct(vec_sl, vec_sr);
+            result = dotProduct(faceNormal, faceNormal);
+            lambda = (result) ? (dotProduct(faceNormal, vs_vgeom->point) -
+                dotProduct(faceNormal, vu_vgeom->point)) / result : 0.0f;
+            vgeom->point = vu_vgeom->point + lambda * faceNormal;
+            vec_su = vgeom->point - vs_vgeom->point;
+
+            // compute dot products
+            dot00 = dotProduct(vec_sr, vec_sr);
+            dot01 = dotProduct(vec_sr, vec_sl);
+            dot02 = dotProduct(vec_sr, vec_su);
+            dot11 = dotProduct(vec_sl, vec_sl);
+            dot12 = dotProduct(vec_sl, vec_su);
+
+            // compute barycentric coordinates
+            invDenom = 1.0f / (dot00 * dot11 - dot01 * dot01);
+            u = (dot11 * dot02 - dot01 * dot12) * invDenom;
+            v = (dot00 * dot12 - dot01 * dot02) * invDenom;
+
+            if (u >= 0.0f)
+            {
+                if (v >= 0.0f)
+                {
+                    if (u + v <= 1.0f)
+                    {
+                        // inside triangle, everything after the point is interpolated
+                        float* d = &vgeom->normal.x;
+                        const float* s = &vs_vgeom->normal.x;
+                        const float* r = &vr_vgeom->normal.x;
+                        const float* l = &vl_vgeom->normal.x;
+
+                        for (unsigned int k = 0; k < N - 3; ++k)
+                            d[k] = s[k] + u * (r[k] - s[k]) + v * (l[k] - s[k]);
+                    }
+                    else
+                    {
+                        // outside line vl_vr
+                        onLine(vu_vgeom, vl_vgeom, vr_vgeom, vgeom);
+                    }
+                }
+                else
+                {
+                    if (u + v <= 1.0f)
+                    {
+                        // outside line vs_vr
+                        onLine(vu_vgeom, vs_vgeom, vr_vgeom, vgeom);
+                    }
+                    else
+                    {
+                        // outside vr
+                        copy(vgeom, vr_vgeom);
+                    }
+                }
+            }
+            else
+            {
+                if (v >= 0.0f)
+                {
+                    if (u + v <= 1.0f)
+                    {
+                        // outside line vl_vs
+                        onLine(vu_vgeom, vl_vgeom, vs_vgeom, vgeom);
+                    }
+                    else
+                    {
+                        // outside vl
+                        copy(vgeom, vl_vgeom);
+                    }
+                }
+                else
+                {
+                    // outside vs
+                    copy(vgeom, vs_vgeom);
+                }
+            }
+        }
+    };
+
+    template<unsigned int N> const VGeomOps VGeomKernels<N>::ops =
+    {
+        VGeomKernels<N>::copy,
+        VGeomKernels<N>::increment,
+        VGeomKernels<N>::onLine,
+        VGeomKernels<N>::onFace
+    };
+
+    extern template struct VGeomKernels<VGEOM_LAYOUT_PN>;
+    extern template struct VGeomKernels<VGEOM_LAYOUT_PNT>;
+    extern template struct VGeomKernels<VGEOM_LAYOUT_PNC>;
+    extern template struct VGeomKernels<VGEOM_LAYOUT_PNCT>;
+
+} // namespace vdpm
+
+#endif // VDPM_VGEOMKERNELS_H
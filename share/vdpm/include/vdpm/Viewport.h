@@ -33,15 +33,32 @@ namespace vdpm
         static Viewport& getDefaultInstance();
 
         void setViewClipPlane(int plane, float a, float b, float c, float d);
+        const float* getViewClipPlane(int plane) { return frustum[plane]; }
         void setViewPosition(float x, float y, float z);
         const Point& getViewPosition() { return viewPos; }
 
+#ifdef VDPM_PREDICT_VIEW_POSITION
+        // time is in seconds; untimed updates are taken as one frame apart
+        void setViewPosition(float x, float y, float z, double time);
+        void setPredictionLimits(float maxSpeed, float maxAcceleration, float maxDistance);
+        void resetPrediction();
+        const Point& getPredictViewPosition() { return predictViewPos; }
+#endif
+
     protected:
+#ifdef VDPM_PREDICT_VIEW_POSITION
+        void predictViewPosition(unsigned int frames);
+#endif
+
         Point viewPos;
         float frustum[6][4];
 
 #ifdef VDPM_PREDICT_VIEW_POSITION
         Point predictViewPos, delta_e;
+        Vector velocity, acceleration;
+        double lastTime;
+        float frameTime, maxSpeed, maxAcceleration, maxDistance;
+        unsigned int samples;
 #endif
     };
 } // namespace vdpm
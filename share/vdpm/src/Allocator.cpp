@@ -5,24 +5,26 @@
 using namespace std;
 using namespace vdpm;
 
-#ifdef VDPM_REUSE_OBJECTS
-AVertex* Allocator::freeAVertices = NULL;
-AFace* Allocator::freeAFaces = NULL;
-TStrip* Allocator::freeTStrips = NULL;
-VMorph* Allocator::freeVMorphs = NULL;
-#endif // VDPM_REUSE_OBJECTS
-
 Allocator::Allocator()
 {
-    // do nothing
+#ifdef VDPM_REUSE_OBJECTS
+#ifndef VDPM_INDEX_TOPOLOGY
+    freeAVertices = NULL;
+    freeAFaces = NULL;
+    freeTStrips = NULL;
+#endif
+    freeVMorphs = NULL;
+#endif // VDPM_REUSE_OBJECTS
 }
 
 Allocator::~Allocator()
 {
 #ifdef VDPM_REUSE_OBJECTS
+#ifndef VDPM_INDEX_TOPOLOGY
     AVertex *avertex, *avertexNext;
     AFace *aface, *afaceNext;
     TStrip *tstrip, *tstripNext;
+#endif
 
 #ifdef VDPM_GEOMORPHS
     VMorph *vmorph, *vmorphNext;
@@ -36,6 +38,7 @@ Allocator::~Allocator()
     }
 #endif // VDPM_GEOMORPHS
 
+#ifndef VDPM_INDEX_TOPOLOGY
     tstrip = freeTStrips;
     while (tstrip)
     {
@@ -59,15 +62,11 @@ Allocator::~Allocator()
         delete avertex;
         avertex = avertexNext;
     }
+#endif // !VDPM_INDEX_TOPOLOGY
 #endif // VDPM_REUSE_OBJECTS
 }
 
-Allocator& Allocator::getInstance()
-{
-    static Allocator self;
-    return self;
-}
-
+#ifndef VDPM_INDEX_TOPOLOGY
 AVertex* Allocator::allocAVertex()
 {
 #ifdef VDPM_REUSE_OBJECTS
@@ -139,21 +138,8 @@ TStrip* Allocator::allocTStrip()
         return new TStrip();
 }
 
-void Allocator::freeTStrip(TStrip* tstrip, AFace& afaces)
+void Allocator::freeTStrip(TStrip* tstrip)
 {
-    AFace* aface;
-
-    for (aface = tstrip->afaces; aface->next; aface = aface->next)
-        aface->tstrip = NULL;
-    aface->tstrip = NULL;
-
-    delete[] tstrip->vgIndices;
-
-    aface->next = afaces.next;
-    afaces.next->prev = aface;
-    tstrip->afaces->prev = &afaces;
-    afaces.next = tstrip->afaces;
-
     tstrip->prev->next = tstrip->next;
     tstrip->next->prev = tstrip->prev;
 
@@ -163,8 +149,8 @@ void Allocator::freeTStrip(TStrip* tstrip, AFace& afaces)
 #else
     delete tstrip;
 #endif // VDPM_REUSE_OBJECTS
-
 }
+#endif // !VDPM_INDEX_TOPOLOGY
 
 #ifdef VDPM_GEOMORPHS
 VMorph* Allocator::allocVMorph()
@@ -0,0 +1,383 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "vdpm/DeferredRenderer.h"
+#include "vdpm/SRMesh.h"
+
+using namespace std;
+using namespace vdpm;
+
+// changed bytes closer than this are uploaded as one range
+#define DEFERRED_WRITE_GAP 32
+
+// unchanged blocks of this size are skipped with one comparison
+#define DEFERRED_COMPARE_BLOCK 64
+
+DeferredRenderer::DeferredRenderer(Renderer* target) : target(target), drawCommandsMesh(NULL)
+{
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+    unsigned int i;
+
+    for (i = 0; i < buffers.size(); ++i)
+    {
+        if (buffers[i]->buf)
+            target->destroyBuffer(buffers[i]->buf);
+
+        delete buffers[i];
+    }
+
+    for (i = 0; i < destroyed.size(); ++i)
+    {
+        if (destroyed[i]->buf)
+            target->destroyBuffer(destroyed[i]->buf);
+
+        delete destroyed[i];
+    }
+}
+
+void DeferredRenderer::addRange(DeferredBuffer* db, unsigned int offset, unsigned int size)
+{
+    DeferredRange range;
+
+    if (size == 0)
+        return;
+
+    if (!db->ranges.empty())
+    {
+        DeferredRange& last = db->ranges.back();
+
+        if (offset >= last.offset && offset <= last.offset + last.size + DEFERRED_WRITE_GAP)
+        {
+            last.size = max(last.offset + last.size, offset + size) - last.offset;
+            return;
+        }
+    }
+    range.offset = offset;
+    range.size = size;
+    db->ranges.push_back(range);
+}
+
+void DeferredRenderer::addWriteRange(DeferredBuffer* db, unsigned int offset, unsigned int size)
+{
+    if (db->writeBegin == db->writeEnd)
+    {
+        db->writeBegin = offset;
+        db->writeEnd = offset + size;
+    }
+    else
+    {
+        db->writeBegin = min(db->writeBegin, offset);
+        db->writeEnd = max(db->writeEnd, offset + size);
+    }
+}
+
+void DeferredRenderer::compareWrites(DeferredBuffer* db)
+{
+    if (db->writeBegin < db->writeEnd)
+        addChangedRanges(db, db->writeBegin, db->writeEnd - db->writeBegin);
+
+    db->writeBegin = db->writeEnd = 0;
+}
+
+void DeferredRenderer::addChangedRanges(DeferredBuffer* db, unsigned int offset, unsigned int size)
+{
+    const uint8_t* src = &db->data[offset];
+    uint8_t* dst = &db->submitted[offset];
+    unsigned int i = 0, begin, end;
+
+    while (i < size)
+    {
+        // most of a mapped vertex buffer is unchanged, so skip whole blocks first
+        if (i + DEFERRED_COMPARE_BLOCK <= size && ::memcmp(src + i, dst + i, DEFERRED_COMPARE_BLOCK) == 0)
+        {
+            i += DEFERRED_COMPARE_BLOCK;
+            continue;
+        }
+
+        if (src[i] == dst[i])
+        {
+            ++i;
+            continue;
+        }
+
+        // extend the run until DEFERRED_WRITE_GAP unchanged bytes in a row
+        begin = end = i;
+        while (i < size && i - end <= DEFERRED_WRITE_GAP)
+        {
+            if (src[i] != dst[i])
+                end = i;
+            ++i;
+        }
+        ++end;
+
+        ::memcpy(dst + begin, src + begin, end - begin);
+        addRange(db, offset + begin, end - begin);
+        i = end;
+    }
+}
+
+void* DeferredRenderer::createBuffer(RendererBuffer target, unsigned int size, const void* data)
+{
+    DeferredBuffer* db = new DeferredBuffer();
+
+    db->buf = NULL;
+    db->target = target;
+    db->size = 0;
+    db->data.assign(size, 0);
+    db->mapOffset = db->mapSize = 0;
+    db->access = RENDERER_READ_ONLY;
+    db->mapCount = 0;
+    db->flushed = false;
+    db->writeBegin = db->writeEnd = 0;
+
+    if (data)
+        ::memcpy(&db->data[0], data, size);
+
+    if (target == RENDERER_VERTEX_BUFFER)
+        db->submitted = db->data;
+
+    addRange(db, 0, size);
+    buffers.push_back(db);
+
+    return db;
+}
+
+void DeferredRenderer::destroyBuffer(void* buf)
+{
+    DeferredBuffer* db = (DeferredBuffer*)buf;
+    vector<DeferredBuffer*>::iterator it;
+
+    if (!db)
+        return;
+
+    it = find(buffers.begin(), buffers.end(), db);
+    assert(it != buffers.end());
+    buffers.erase(it);
+
+    // the target buffer may still be drawn until the next submit
+    db->data.clear();
+    db->submitted.clear();
+    db->ranges.clear();
+    destroyed.push_back(db);
+}
+
+void DeferredRenderer::setBufferData(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, const void* data)
+{
+    DeferredBuffer* db = (DeferredBuffer*)buf;
+
+    assert(offset + size <= db->data.size());
+    ::memcpy(&db->data[offset], data, size);
+
+    if (db->target == RENDERER_VERTEX_BUFFER)
+        addWriteRange(db, offset, size);
+    else
+        addRange(db, offset, size);
+}
+
+void* DeferredRenderer::resizeBuffer(RendererBuffer target, void* buf, unsigned int size)
+{
+    DeferredBuffer* db = (DeferredBuffer*)buf;
+    unsigned int oldSize = (unsigned int)db->data.size();
+
+    // like a reallocated buffer object, the resized buffer is no longer mapped
+    if (db->target == RENDERER_VERTEX_BUFFER)
+        compareWrites(db);
+    else if (db->mapCount > 0)
+        unmapBuffer(target, buf);
+
+    db->mapCount = 0;
+    db->data.resize(size, 0);
+
+    if (db->target == RENDERER_VERTEX_BUFFER)
+        db->submitted.resize(size, 0);
+
+    // the target buffer is reallocated by submit(), so ranges past its end are dropped there
+    if (size > oldSize)
+        addRange(db, oldSize, size - oldSize);
+
+    return db;
+}
+
+void* DeferredRenderer::mapBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, RendererAccess access)
+{
+    DeferredBuffer* db = (DeferredBuffer*)buf;
+
+    assert(offset + size <= db->data.size());
+
+    db->mapOffset = offset;
+    db->mapSize = size;
+    db->access = access;
+    db->flushed = false;
+    ++db->mapCount;
+
+    if (db->target == RENDERER_VERTEX_BUFFER && access != RENDERER_READ_ONLY)
+        addWriteRange(db, offset, size);
+
+    return &db->data[offset];
+}
+
+void DeferredRenderer::unmapBuffer(RendererBuffer target, void* buf)
+{
+    DeferredBuffer* db = (DeferredBuffer*)buf;
+
+    if (db->mapCount == 0)
+        return;
+
+    // the vertex buffer may be mapped more than once, so its writes are compared after the last unmap
+    if (--db->mapCount == 0 && db->target == RENDERER_VERTEX_BUFFER)
+        compareWrites(db);
+    else if (db->target == RENDERER_INDEX_BUFFER && db->access != RENDERER_READ_ONLY && !db->flushed)
+        addRange(db, db->mapOffset, db->mapSize);
+}
+
+void DeferredRenderer::flushBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size)
+{
+    DeferredBuffer* db = (DeferredBuffer*)buf;
+
+    // vertex buffers are compared instead since their flush ranges are not exact
+    if (db->target == RENDERER_VERTEX_BUFFER || db->mapCount == 0)
+        return;
+
+    // offset is relative to the mapped range
+    if (offset >= db->mapSize)
+        return;
+
+    size = min(size, db->mapSize - offset);
+    addRange(db, db->mapOffset + offset, size);
+    db->flushed = true;
+}
+
+void DeferredRenderer::updateDrawCommands(SRMesh* srmesh)
+{
+    drawCommandsMesh = srmesh;
+}
+
+void DeferredRenderer::submit()
+{
+    DeferredBuffer* db;
+    unsigned int i, j, begin, end, size;
+    uint8_t* ptr;
+    void* saved[2];
+
+    for (i = 0; i < destroyed.size(); ++i)
+    {
+        if (destroyed[i]->buf)
+            target->destroyBuffer(destroyed[i]->buf);
+
+        delete destroyed[i];
+    }
+    destroyed.clear();
+
+    for (i = 0; i < buffers.size(); ++i)
+    {
+        db = buffers[i];
+        size = (unsigned int)db->data.size();
+
+        compareWrites(db);
+
+        if (!db->buf)
+        {
+            db->buf = target->createBuffer(db->target, size, &db->data[0]);
+            db->size = size;
+            db->ranges.clear();
+            continue;
+        }
+
+        if (db->size != size)
+        {
+            db->buf = target->resizeBuffer(db->target, db->buf, size);
+            db->size = size;
+        }
+
+        if (db->ranges.empty())
+            continue;
+
+        begin = db->ranges[0].offset;
+        end = 0;
+
+        for (j = 0; j < db->ranges.size(); ++j)
+        {
+            begin = min(begin, db->ranges[j].offset);
+            end = max(end, db->ranges[j].offset + db->ranges[j].size);
+        }
+        end = min(end, size);
+
+        if (begin < end)
+        {
+            ptr = (uint8_t*)target->mapBuffer(db->target, db->buf, begin, end - begin, RENDERER_WRITE_ONLY);
+
+            for (j = 0; j < db->ranges.size(); ++j)
+            {
+                const DeferredRange& r = db->ranges[j];
+
+                if (r.offset >= end)
+                    continue;
+
+                ::memcpy(ptr + (r.offset - begin), &db->data[r.offset], min(r.size, end - r.offset));
+                target->flushBuffer(db->target, db->buf, r.offset - begin, min(r.size, end - r.offset));
+            }
+            target->unmapBuffer(db->target, db->buf);
+        }
+        db->ranges.clear();
+    }
+
+    if (drawCommandsMesh)
+    {
+        bindTargetBuffers(drawCommandsMesh, saved);
+        target->updateDrawCommands(drawCommandsMesh);
+        restoreBuffers(drawCommandsMesh, saved);
+        drawCommandsMesh = NULL;
+    }
+}
+
+void DeferredRenderer::bindTargetBuffers(SRMesh* srmesh, void** saved)
+{
+    saved[0] = srmesh->geometry.vbo;
+    saved[1] = srmesh->ibo;
+
+    if (saved[0])
+        srmesh->geometry.vbo = ((DeferredBuffer*)saved[0])->buf;
+
+    if (saved[1])
+        srmesh->ibo = ((DeferredBuffer*)saved[1])->buf;
+}
+
+void DeferredRenderer::restoreBuffers(SRMesh* srmesh, void** saved)
+{
+    srmesh->geometry.vbo = saved[0];
+    srmesh->ibo = saved[1];
+}
+
+void DeferredRenderer::updateViewport(Viewport* viewport)
+{
+    target->updateViewport(viewport);
+}
+
+void DeferredRenderer::draw(SRMesh* srmesh)
+{
+    void* saved[2];
+
+    bindTargetBuffers(srmesh, saved);
+    target->draw(srmesh);
+    restoreBuffers(srmesh, saved);
+}
@@ -0,0 +1,554 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <cassert>
+#include <cfloat>
+#include "vdpm/FaceBVH.h"
+
+using namespace std;
+using namespace vdpm;
+
+#define BVH_NULL            -1
+#define BVH_MARGIN          0.1f    // box enlargement relative to the largest triangle extent
+#define BVH_STACK_SIZE      128
+
+static inline Vector minVector(const Vector& a, const Vector& b)
+{
+    return Vector(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z);
+}
+
+static inline Vector maxVector(const Vector& a, const Vector& b)
+{
+    return Vector(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z);
+}
+
+static inline float boxArea(const Point& min, const Point& max)
+{
+    Vector d = max - min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static inline bool boxContains(const Point& outerMin, const Point& outerMax, const Point& min, const Point& max)
+{
+    return outerMin.x <= min.x && outerMin.y <= min.y && outerMin.z <= min.z &&
+        max.x <= outerMax.x && max.y <= outerMax.y && max.z <= outerMax.z;
+}
+
+static bool intersectRayBox(const Point& origin, const Vector& invDirection, float maxDistance, const Point& min, const Point& max)
+{
+    float t0 = 0.0f, t1 = maxDistance, tNear, tFar;
+    int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        tNear = (min[i] - origin[i]) * invDirection[i];
+        tFar = (max[i] - origin[i]) * invDirection[i];
+
+        if (tNear > tFar)
+        {
+            float t = tNear;
+            tNear = tFar;
+            tFar = t;
+        }
+
+        // NaN from 0 * inf leaves the bounds untouched
+        if (tNear > t0)
+            t0 = tNear;
+        if (tFar < t1)
+            t1 = tFar;
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+
+// Moller-Trumbore, both sides
+static bool intersectRayTriangle(const Point& origin, const Vector& direction, const Point* p, float& t, float& u, float& v)
+{
+    Vector e1 = p[1] - p[0];
+    Vector e2 = p[2] - p[0];
+    Vector pv = crossProduct(direction, e2);
+    float det = dotProduct(e1, pv);
+    Vector tv, qv;
+    float invDet;
+
+    if (det > -FLT_EPSILON && det < FLT_EPSILON)
+        return false;
+
+    invDet = 1.0f / det;
+    tv = origin - p[0];
+    u = dotProduct(tv, pv) * invDet;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    qv = crossProduct(tv, e1);
+    v = dotProduct(direction, qv) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    t = dotProduct(e2, qv) * invDet;
+    return t >= 0.0f;
+}
+
+// closest point on a triangle, from Ericson's Real-Time Collision Detection
+static Point closestPointOnTriangle(const Point& q, const Point* p)
+{
+    Vector ab = p[1] - p[0], ac = p[2] - p[0], ap = q - p[0], bp, cp;
+    float d1 = dotProduct(ab, ap), d2 = dotProduct(ac, ap), d3, d4, d5, d6, va, vb, vc, v, w;
+
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return p[0];
+
+    bp = q - p[1];
+    d3 = dotProduct(ab, bp);
+    d4 = dotProduct(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return p[1];
+
+    vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return p[0] + ab * (d1 / (d1 - d3));
+
+    cp = q - p[2];
+    d5 = dotProduct(ab, cp);
+    d6 = dotProduct(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return p[2];
+
+    vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return p[0] + ac * (d2 / (d2 - d6));
+
+    va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return p[1] + (p[2] - p[1]) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    v = vb / (va + vb + vc);
+    w = vc / (va + vb + vc);
+    return p[0] + ab * v + ac * w;
+}
+
+FaceBVH::FaceBVH() : root(BVH_NULL), freeNodes(BVH_NULL), faceCount(0)
+{
+}
+
+FaceBVH::~FaceBVH()
+{
+    // do nothing
+}
+
+void FaceBVH::clear()
+{
+    nodes.clear();
+    root = freeNodes = BVH_NULL;
+    faceCount = 0;
+}
+
+int FaceBVH::allocNode()
+{
+    int node;
+
+    if (freeNodes == BVH_NULL)
+    {
+        nodes.push_back(Node());
+        node = (int)nodes.size() - 1;
+    }
+    else
+    {
+        node = freeNodes;
+        freeNodes = nodes[node].parent;
+    }
+
+    nodes[node].parent = nodes[node].child0 = nodes[node].child1 = BVH_NULL;
+    nodes[node].height = 0;
+    nodes[node].aface = NULL;
+    return node;
+}
+
+void FaceBVH::freeNode(int node)
+{
+    nodes[node].parent = freeNodes;
+    nodes[node].height = -1;
+    nodes[node].aface = NULL;
+    freeNodes = node;
+}
+
+void FaceBVH::setLeafBox(int leaf)
+{
+    Node& n = nodes[leaf];
+    Point min = minVector(minVector(n.p[0], n.p[1]), n.p[2]);
+    Point max = maxVector(maxVector(n.p[0], n.p[1]), n.p[2]);
+    Vector d = max - min;
+    float margin = d.x;
+
+    if (d.y > margin)
+        margin = d.y;
+    if (d.z > margin)
+        margin = d.z;
+
+    margin = margin * BVH_MARGIN + FLT_EPSILON;
+    n.boxMin = min - Vector(margin);
+    n.boxMax = max + Vector(margin);
+}
+
+unsigned int FaceBVH::insert(AFace* aface, const Point& p0, const Point& p1, const Point& p2)
+{
+    int leaf = allocNode();
+
+    nodes[leaf].aface = aface;
+    nodes[leaf].p[0] = p0;
+    nodes[leaf].p[1] = p1;
+    nodes[leaf].p[2] = p2;
+    setLeafBox(leaf);
+    insertLeaf(leaf);
+    ++faceCount;
+
+    return leaf + 1;
+}
+
+void FaceBVH::update(unsigned int leaf, const Point& p0, const Point& p1, const Point& p2)
+{
+    int node = (int)leaf - 1;
+    Node& n = nodes[node];
+    Point min = minVector(minVector(p0, p1), p2);
+    Point max = maxVector(maxVector(p0, p1), p2);
+    Vector fat, d;
+
+    assert(n.aface && n.height == 0);
+
+    n.p[0] = p0;
+    n.p[1] = p1;
+    n.p[2] = p2;
+
+    // keep the box while the triangle stays inside and has not shrunk to a fraction of it
+    if (boxContains(n.boxMin, n.boxMax, min, max))
+    {
+        fat = n.boxMax - n.boxMin;
+        d = max - min;
+        if (boxArea(min, max) * 4.0f >= boxArea(n.boxMin, n.boxMax) ||
+            (d.x * 2.0f >= fat.x && d.y * 2.0f >= fat.y && d.z * 2.0f >= fat.z))
+            return;
+    }
+
+    removeLeaf(node);
+    setLeafBox(node);
+    insertLeaf(node);
+}
+
+void FaceBVH::remove(unsigned int leaf)
+{
+    int node = (int)leaf - 1;
+
+    assert(nodes[node].aface && nodes[node].height == 0);
+
+    removeLeaf(node);
+    freeNode(node);
+    --faceCount;
+}
+
+bool FaceBVH::getBounds(Point& min, Point& max)
+{
+    if (root == BVH_NULL)
+        return false;
+
+    min = nodes[root].boxMin;
+    max = nodes[root].boxMax;
+    return true;
+}
+
+void FaceBVH::updateNode(int node)
+{
+    Node& n = nodes[node];
+    const Node& c0 = nodes[n.child0];
+    const Node& c1 = nodes[n.child1];
+
+    n.boxMin = minVector(c0.boxMin, c1.boxMin);
+    n.boxMax = maxVector(c0.boxMax, c1.boxMax);
+    n.height = 1 + (c0.height > c1.height ? c0.height : c1.height);
+}
+
+void FaceBVH::insertLeaf(int leaf)
+{
+    Point leafMin, leafMax, min, max;
+    float area, combinedArea, cost, inheritanceCost, cost0, cost1;
+    int node, sibling, oldParent, newParent;
+
+    if (root == BVH_NULL)
+    {
+        root = leaf;
+        nodes[root].parent = BVH_NULL;
+        return;
+    }
+
+    // descend to the sibling with the least surface area increase
+    leafMin = nodes[leaf].boxMin;
+    leafMax = nodes[leaf].boxMax;
+    node = root;
+
+    while (nodes[node].height > 0)
+    {
+        const Node& n = nodes[node];
+        const Node& c0 = nodes[n.child0];
+        const Node& c1 = nodes[n.child1];
+
+        area = boxArea(n.boxMin, n.boxMax);
+        combinedArea = boxArea(minVector(n.boxMin, leafMin), maxVector(n.boxMax, leafMax));
+        cost = 2.0f * combinedArea;
+        inheritanceCost = 2.0f * (combinedArea - area);
+
+        cost0 = boxArea(minVector(c0.boxMin, leafMin), maxVector(c0.boxMax, leafMax)) + inheritanceCost;
+        if (c0.height > 0)
+            cost0 -= boxArea(c0.boxMin, c0.boxMax);
+
+        cost1 = boxArea(minVector(c1.boxMin, leafMin), maxVector(c1.boxMax, leafMax)) + inheritanceCost;
+        if (c1.height > 0)
+            cost1 -= boxArea(c1.boxMin, c1.boxMax);
+
+        if (cost < cost0 && cost < cost1)
+            break;
+
+        node = (cost0 < cost1) ? n.child0 : n.child1;
+    }
+
+    sibling = node;
+    newParent = allocNode();
+    oldParent = nodes[sibling].parent;
+
+    min = minVector(nodes[sibling].boxMin, leafMin);
+    max = maxVector(nodes[sibling].boxMax, leafMax);
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].boxMin = min;
+    nodes[newParent].boxMax = max;
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child0 = sibling;
+    nodes[newParent].child1 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == BVH_NULL)
+        root = newParent;
+    else if (nodes[oldParent].child0 == sibling)
+        nodes[oldParent].child0 = newParent;
+    else
+        nodes[oldParent].child1 = newParent;
+
+    for (node = nodes[leaf].parent; node != BVH_NULL; node = nodes[node].parent)
+    {
+        node = balance(node);
+        updateNode(node);
+    }
+}
+
+void FaceBVH::removeLeaf(int leaf)
+{
+    int parent, grandParent, sibling, node;
+
+    if (leaf == root)
+    {
+        root = BVH_NULL;
+        return;
+    }
+
+    parent = nodes[leaf].parent;
+    grandParent = nodes[parent].parent;
+    sibling = (nodes[parent].child0 == leaf) ? nodes[parent].child1 : nodes[parent].child0;
+
+    if (grandParent == BVH_NULL)
+    {
+        root = sibling;
+        nodes[sibling].parent = BVH_NULL;
+        freeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].child0 == parent)
+        nodes[grandParent].child0 = sibling;
+    else
+        nodes[grandParent].child1 = sibling;
+
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    for (node = grandParent; node != BVH_NULL; node = nodes[node].parent)
+    {
+        node = balance(node);
+        updateNode(node);
+    }
+}
+
+// rotates the taller grandchild of a up when its children differ in height by more than one,
+// returns the node now at the position of a
+int FaceBVH::balance(int a)
+{
+    int b, c, f, g, d, e, big;
+    int balanceFactor;
+
+    if (nodes[a].height < 2)
+        return a;
+
+    b = nodes[a].child0;
+    c = nodes[a].child1;
+    balanceFactor = nodes[c].height - nodes[b].height;
+
+    if (balanceFactor > 1 || balanceFactor < -1)
+    {
+        // the taller child of a moves up
+        big = (balanceFactor > 1) ? c : b;
+
+        f = nodes[big].child0;
+        g = nodes[big].child1;
+
+        nodes[big].child0 = a;
+        nodes[big].parent = nodes[a].parent;
+        nodes[a].parent = big;
+
+        if (nodes[big].parent == BVH_NULL)
+            root = big;
+        else if (nodes[nodes[big].parent].child0 == a)
+            nodes[nodes[big].parent].child0 = big;
+        else
+            nodes[nodes[big].parent].child1 = big;
+
+        // the taller grandchild stays under big, the other replaces big under a
+        if (nodes[f].height > nodes[g].height)
+        {
+            d = f;
+            e = g;
+        }
+        else
+        {
+            d = g;
+            e = f;
+        }
+
+        nodes[big].child1 = d;
+        if (big == c)
+            nodes[a].child1 = e;
+        else
+            nodes[a].child0 = e;
+        nodes[e].parent = a;
+
+        updateNode(a);
+        updateNode(big);
+        return big;
+    }
+    return a;
+}
+
+bool FaceBVH::intersectRay(const Point& origin, const Vector& direction, float maxDistance, FaceBVHHit& hit)
+{
+    int stack[BVH_STACK_SIZE];
+    int top = 0;
+    Vector invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float t, u, v;
+    bool found = false;
+
+    if (root == BVH_NULL)
+        return false;
+
+    stack[top++] = root;
+    while (top > 0)
+    {
+        const Node& n = nodes[stack[--top]];
+
+        if (!intersectRayBox(origin, invDirection, maxDistance, n.boxMin, n.boxMax))
+            continue;
+
+        if (n.height == 0)
+        {
+            if (intersectRayTriangle(origin, direction, n.p, t, u, v) && t <= maxDistance)
+            {
+                maxDistance = t;
+                hit.aface = n.aface;
+                hit.distance = t;
+                hit.point = origin + direction * t;
+                hit.u = u;
+                hit.v = v;
+                found = true;
+            }
+            continue;
+        }
+
+        assert(top + 2 <= BVH_STACK_SIZE);
+        stack[top++] = n.child0;
+        stack[top++] = n.child1;
+    }
+    return found;
+}
+
+unsigned int FaceBVH::querySphere(const Point& center, float radius, AFace** afaces, unsigned int maxCount)
+{
+    int stack[BVH_STACK_SIZE];
+    int top = 0;
+    unsigned int count = 0;
+    float radius2 = radius * radius;
+    Point q;
+
+    if (root == BVH_NULL)
+        return 0;
+
+    stack[top++] = root;
+    while (top > 0 && count < maxCount)
+    {
+        const Node& n = nodes[stack[--top]];
+
+        // distance from the center to the box
+        q = minVector(maxVector(center, n.boxMin), n.boxMax);
+        if (squareMagnitude(q - center) > radius2)
+            continue;
+
+        if (n.height == 0)
+        {
+            if (squareMagnitude(closestPointOnTriangle(center, n.p) - center) <= radius2)
+                afaces[count++] = n.aface;
+            continue;
+        }
+
+        assert(top + 2 <= BVH_STACK_SIZE);
+        stack[top++] = n.child0;
+        stack[top++] = n.child1;
+    }
+    return count;
+}
+
+bool FaceBVH::queryHeight(const Point& position, const Vector& up, FaceBVHHit& hit)
+{
+    const Node* n;
+    float top, h;
+    int i;
+
+    if (root == BVH_NULL)
+        return false;
+
+    // start the downward ray above the highest box corner
+    n = &nodes[root];
+    top = -FLT_MAX;
+    for (i = 0; i < 8; ++i)
+    {
+        Point corner((i & 1) ? n->boxMax.x : n->boxMin.x, (i & 2) ? n->boxMax.y : n->boxMin.y, (i & 4) ? n->boxMax.z : n->boxMin.z);
+        h = dotProduct(corner, up);
+        if (h > top)
+            top = h;
+    }
+    h = top - dotProduct(position, up) + 1.0f;
+
+    if (!intersectRay(position + up * h, up * -1.0f, FLT_MAX, hit))
+        return false;
+
+    hit.distance -= h;
+    return true;
+}
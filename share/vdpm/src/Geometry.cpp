@@ -1,10 +1,17 @@
 #include <cassert>
+#include <climits>
 #include <cstdlib>
+#include <cstring>
 #include "vdpm/Geometry.h"
 
 using namespace std;
 using namespace vdpm;
 
+// clean vertices between two dirty runs are sent along when that saves a call
+#define UPLOAD_GAP_SIZE 16
+
+#define DIRTY_WORD_COUNT(count) (((count) + 63) >> 6)
+
 int Geometry::create(unsigned int count, bool hasColor, bool hasTexCoord)
 {
     vgeomSize = sizeof(VGeom);
@@ -38,6 +45,10 @@ void Geometry::destroy()
         renderer->destroyBuffer(vbo);
 
     ::free(vgeoms);
+
+#ifdef VDPM_RENDERER_OPENGL_VBO
+    ::free(dirty);
+#endif
 }
 
 int Geometry::realize(Renderer* renderer)
@@ -46,48 +57,129 @@ int Geometry::realize(Renderer* renderer)
     if (!vbo)
         goto error;
 
-#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-    ::free(vgeoms);
-    vgeoms = NULL;
+#ifdef VDPM_RENDERER_OPENGL_VBO
+    dirty = (uint64_t*)::calloc(DIRTY_WORD_COUNT(vgeomCount), sizeof(uint64_t));
+    if (!dirty)
+        goto error;
+
+    dirtyBegin = UINT_MAX;
+    dirtyEnd = 0;
 #endif
 
     this->renderer = renderer;
     return 0;
 
 error:
-#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
+#ifdef VDPM_RENDERER_OPENGL_VBO
     if (vbo)
     {
         renderer->destroyBuffer(vbo);
         vbo = NULL;
     }
-#endif // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
+#endif // VDPM_RENDERER_OPENGL_VBO
 
     return -1;
 }
 
 int Geometry::resize(unsigned int count)
 {
+#ifdef VDPM_RENDERER_OPENGL_VBO
+    VGeom* newVgeoms;
+    uint64_t* newDirty;
+    unsigned int words = DIRTY_WORD_COUNT(vgeomCount), newWords = DIRTY_WORD_COUNT(count);
+
+    newVgeoms = (VGeom*)::realloc(vgeoms, vgeomSize * count);
+    if (!newVgeoms)
+        return -1;
+
+    vgeoms = newVgeoms;
+
+    newDirty = (uint64_t*)::realloc(dirty, sizeof(uint64_t) * newWords);
+    if (!newDirty)
+        return -1;
+
+    if (newWords > words)
+        ::memset(newDirty + words, 0, sizeof(uint64_t) * (newWords - words));
+
+    dirty = newDirty;
+#endif
+
     vbo = renderer->resizeBuffer(RENDERER_VERTEX_BUFFER, vbo, vgeomSize * count);
+    vgeomCount = count;
 #ifndef VDPM_RENDERER_OPENGL_VBO
     vgeoms = (VGeom*)vbo;
-#endif
-#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-    vgeoms = (VGeom*)renderer->mapBuffer(RENDERER_VERTEX_BUFFER, vbo, 0, vgeomSize * count, RENDERER_READ_WRITE);
 #endif
     return 0;
 }
 
-#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-void Geometry::mapVGeom()
+void Geometry::upload()
 {
-    assert(!vgeoms);
-    vgeoms = (VGeom*)renderer->mapBuffer(RENDERER_VERTEX_BUFFER, vbo, 0, vgeomSize * vgeomCount, RENDERER_READ_WRITE);
+#ifdef VDPM_RENDERER_OPENGL_VBO
+    unsigned int i, begin, end, runBegin;
+    uint64_t word;
+
+    if (dirtyBegin >= dirtyEnd)
+        return;
+
+    begin = end = UINT_MAX;
+    i = dirtyBegin;
+
+    while (i < dirtyEnd)
+    {
+        word = dirty[i >> 6] >> (i & 63);
+        if (!word)
+        {
+            i = (i | 63) + 1;
+            continue;
+        }
+
+        while (!(word & 1))
+        {
+            word >>= 1;
+            ++i;
+        }
+
+        runBegin = i;
+        while (i < dirtyEnd && (dirty[i >> 6] & ((uint64_t)1 << (i & 63))))
+            ++i;
+
+        // join the run to the pending range or send that range first
+        if (begin != UINT_MAX && runBegin - end <= UPLOAD_GAP_SIZE)
+        {
+            end = i;
+        }
+        else
+        {
+            if (begin != UINT_MAX)
+                uploadRange(begin, end);
+
+            begin = runBegin;
+            end = i;
+        }
+    }
+    uploadRange(begin, end);
+
+    ::memset(&dirty[dirtyBegin >> 6], 0, sizeof(uint64_t) * (((dirtyEnd - 1) >> 6) - (dirtyBegin >> 6) + 1));
+    dirtyBegin = UINT_MAX;
+    dirtyEnd = 0;
+#endif
 }
 
-void Geometry::unmapVGeom()
+#ifdef VDPM_RENDERER_OPENGL_VBO
+void Geometry::uploadRange(unsigned int begin, unsigned int end)
 {
+    unsigned int size = vgeomSize * (end - begin);
+
+#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
+    void* ptr = renderer->mapBuffer(RENDERER_VERTEX_BUFFER, vbo, vgeomSize * begin, size, RENDERER_WRITE_ONLY);
+    if (!ptr)
+        return;
+
+    ::memcpy(ptr, getVGeom(begin), size);
+    renderer->flushBuffer(RENDERER_VERTEX_BUFFER, vbo, 0, size);
     renderer->unmapBuffer(RENDERER_VERTEX_BUFFER, vbo);
-    vgeoms = NULL;
-}
+#else
+    renderer->setBufferData(RENDERER_VERTEX_BUFFER, vbo, vgeomSize * begin, size, getVGeom(begin));
 #endif // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
+}
+#endif // VDPM_RENDERER_OPENGL_VBO
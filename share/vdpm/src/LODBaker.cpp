@@ -0,0 +1,311 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include "vdpm/LODBaker.h"
+#include "vdpm/SRMesh.h"
+
+using namespace std;
+using namespace vdpm;
+
+// post-transform vertex cache model of the ordering, after Forsyth's linear-speed optimizer
+#define VERTEX_CACHE_SIZE       32
+#define CACHE_DECAY_POWER       1.5f
+#define LAST_TRI_SCORE          0.75f
+#define VALENCE_BOOST_SCALE     2.0f
+#define VALENCE_BOOST_POWER     0.5f
+
+static float getVertexScore(int cachePos, unsigned int remaining)
+{
+    float score = 0.0f;
+
+    if (remaining == 0)
+        return -1.0f;
+
+    if (cachePos >= 0)
+    {
+        // the three vertices of the last triangle score the same wherever they were added
+        if (cachePos < 3)
+            score = LAST_TRI_SCORE;
+        else
+            score = powf(1.0f - (cachePos - 3) * (1.0f / (VERTEX_CACHE_SIZE - 3)), CACHE_DECAY_POWER);
+    }
+
+    // favor vertices with few triangles left so they leave the working set early
+    score += VALENCE_BOOST_SCALE * powf((float)remaining, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+LODBaker::LODBaker(SRMesh* srmesh) : srmesh(srmesh), next(0), rewound(false)
+{
+}
+
+int LODBaker::rewind()
+{
+    uint32_t* front;
+    unsigned int i;
+    float error = 0.0f;
+    int ret;
+
+    // an empty front collapses the mesh down to the base mesh
+    front = new uint32_t[srmesh->getActiveFrontSize()]();
+    ret = srmesh->restoreActiveFront(front);
+    delete[] front;
+
+    if (ret)
+        return -1;
+
+    remainingErrors.resize(srmesh->getVSplitCount());
+    for (i = srmesh->getVSplitCount(); i-- > 0;)
+    {
+        if (srmesh->getVSplitError(i) > error)
+            error = srmesh->getVSplitError(i);
+
+        remainingErrors[i] = error;
+    }
+
+    next = 0;
+    rewound = true;
+    return 0;
+}
+
+int LODBaker::bake(unsigned int faceCount, float error, BakedLOD& lod)
+{
+    float error2 = error * error;
+    int ret = 0;
+
+    if (!rewound && rewind())
+        return -1;
+
+    // every prefix of the sequence is a valid mesh, so stop at the first vsplit over the limits
+    while (next < srmesh->getVSplitCount())
+    {
+        if (remainingErrors[next] < error2)
+            break;
+
+        if (srmesh->getAFaceCount() + 2 > faceCount)
+            break;
+
+        ret = srmesh->splitInSequence(next);
+        if (ret)
+            break;
+
+        ++next;
+    }
+
+    // a streamed mesh has the same prefix property up to its first missing record
+    if (ret > 0)
+        ret = 0;
+
+    if (ret == 0)
+        output(lod);
+
+    return ret;
+}
+
+int LODBaker::bakeChain(const unsigned int* faceCounts, unsigned int count, BakedLOD* lods)
+{
+    unsigned int i;
+
+    if (rewind())
+        return -1;
+
+    for (i = 0; i < count; ++i)
+    {
+        assert(i == 0 || faceCounts[i - 1] <= faceCounts[i]);
+
+        if (bake(faceCounts[i], 0.0f, lods[i]))
+            return -1;
+    }
+    return 0;
+}
+
+void LODBaker::output(BakedLOD& lod)
+{
+    vector<uint32_t> remap(srmesh->getVertexCount(), UINT_MAX), order, corners(srmesh->getAFaceCount() * 3), source;
+    unsigned int vertexCount = 0, i, j;
+
+    lod.vsplitCount = next;
+    lod.error = next < srmesh->getVSplitCount() ? sqrtf(remainingErrors[next]) : 0.0f;
+    lod.vgeomSize = srmesh->getVGeomSize();
+    lod.indices.resize(corners.size());
+
+    // rewind() left every active face unstripped and vsplits only add to that list
+    if (!corners.empty())
+        srmesh->getAFaceVGeomIndices(&corners[0]);
+
+    for (j = 0; j < corners.size(); ++j)
+    {
+        i = corners[j];
+        if (remap[i] == UINT_MAX)
+        {
+            remap[i] = vertexCount++;
+            order.push_back(i);
+        }
+        lod.indices[j] = remap[i];
+    }
+
+    optimizeVertexCache(lod.indices, vertexCount);
+
+    // number the vertices in the order the optimized triangles first use them
+    remap.assign(vertexCount, UINT_MAX);
+    source.reserve(vertexCount);
+
+    for (i = 0; i < lod.indices.size(); ++i)
+    {
+        j = lod.indices[i];
+        if (remap[j] == UINT_MAX)
+        {
+            remap[j] = (uint32_t)source.size();
+            source.push_back(order[j]);
+        }
+        lod.indices[i] = remap[j];
+    }
+
+    lod.vgeoms.resize(lod.vgeomSize * source.size());
+    if (!source.empty())
+        srmesh->copyVGeoms(&source[0], (unsigned int)source.size(), &lod.vgeoms[0]);
+}
+
+void LODBaker::optimizeVertexCache(vector<uint32_t>& indices, unsigned int vertexCount)
+{
+    unsigned int triCount = (unsigned int)indices.size() / 3;
+    vector<unsigned int> offsets(vertexCount + 1, 0), remaining(vertexCount, 0), triangles(indices.size());
+    vector<int> cachePos(vertexCount, -1);
+    vector<float> scores(vertexCount), triScores(triCount);
+    vector<bool> emitted(triCount, false);
+    vector<uint32_t> output;
+    unsigned int cache[VERTEX_CACHE_SIZE + 3], newCache[VERTEX_CACHE_SIZE + 3];
+    unsigned int cacheSize = 0, newCacheSize, cursor = 0, i, j, k, t, v;
+    int best = -1;
+    float bestScore;
+
+    if (triCount == 0)
+        return;
+
+    // triangles of each vertex in CSR form; the first remaining[v] are not emitted yet
+    for (i = 0; i < indices.size(); ++i)
+        ++remaining[indices[i]];
+
+    for (v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    ::memset(&remaining[0], 0, sizeof(unsigned int) * vertexCount);
+    for (i = 0; i < indices.size(); ++i)
+    {
+        v = indices[i];
+        triangles[offsets[v] + remaining[v]++] = i / 3;
+    }
+
+    for (v = 0; v < vertexCount; ++v)
+        scores[v] = getVertexScore(-1, remaining[v]);
+
+    bestScore = -1.0f;
+    for (t = 0; t < triCount; ++t)
+    {
+        triScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+        if (triScores[t] > bestScore)
+        {
+            bestScore = triScores[t];
+            best = t;
+        }
+    }
+
+    output.reserve(indices.size());
+
+    while (output.size() < indices.size())
+    {
+        // nothing in the cache has triangles left, so continue with the next unemitted one
+        if (best < 0)
+        {
+            while (emitted[cursor])
+                ++cursor;
+
+            best = cursor;
+        }
+
+        t = best;
+        emitted[t] = true;
+        newCacheSize = 0;
+
+        for (j = 0; j < 3; ++j)
+        {
+            v = indices[t * 3 + j];
+            output.push_back(v);
+            newCache[newCacheSize++] = v;
+
+            // drop the triangle from the remaining ones of its vertex
+            for (k = offsets[v]; triangles[k] != t; ++k)
+                ;
+            triangles[k] = triangles[offsets[v] + --remaining[v]];
+            triangles[offsets[v] + remaining[v]] = t;
+        }
+
+        for (i = 0; i < cacheSize; ++i)
+        {
+            v = cache[i];
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+                newCache[newCacheSize++] = v;
+        }
+
+        // vertices pushed out of the cache lose their position score
+        for (i = VERTEX_CACHE_SIZE; i < newCacheSize; ++i)
+        {
+            v = newCache[i];
+            cachePos[v] = -1;
+            scores[v] = getVertexScore(-1, remaining[v]);
+
+            for (k = offsets[v]; k < offsets[v] + remaining[v]; ++k)
+            {
+                t = triangles[k];
+                triScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+            }
+        }
+
+        cacheSize = newCacheSize < VERTEX_CACHE_SIZE ? newCacheSize : VERTEX_CACHE_SIZE;
+        for (i = 0; i < cacheSize; ++i)
+        {
+            v = cache[i] = newCache[i];
+            cachePos[v] = i;
+            scores[v] = getVertexScore(i, remaining[v]);
+        }
+
+        // only triangles around the cache changed, so the next one is chosen among them
+        best = -1;
+        bestScore = -1.0f;
+        for (i = 0; i < cacheSize; ++i)
+        {
+            v = cache[i];
+
+            for (k = offsets[v]; k < offsets[v] + remaining[v]; ++k)
+            {
+                t = triangles[k];
+                triScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                if (triScores[t] > bestScore)
+                {
+                    bestScore = triScores[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
@@ -0,0 +1,491 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <GL/gl.h>
+
+#ifndef _WIN32
+#include <GL/glx.h>
+#define wglGetProcAddress(name) glXGetProcAddressARB((const GLubyte*)(name))
+#endif
+
+#include "vdpm/OpenGL4Renderer.h"
+#include "vdpm/SRMesh.h"
+
+#ifdef VDPM_RENDERER_OPENGL4
+
+#if !defined(VDPM_RENDERER_OPENGL_VBO) || !defined(VDPM_RENDERER_OPENGL_IBO)
+#error VDPM_RENDERER_OPENGL4 requires VDPM_RENDERER_OPENGL_VBO and VDPM_RENDERER_OPENGL_IBO
+#endif
+
+using namespace std;
+using namespace vdpm;
+
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_COPY_READ_BUFFER 0x8F36
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+
+#define GL_MAP_READ_BIT 0x0001
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_CLIENT_STORAGE_BIT 0x0200
+
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+
+#define BUFFER_SECTIONS     3
+#define MIN_COMMAND_COUNT   64
+#define SYNC_TIMEOUT        1000000
+
+typedef ptrdiff_t GLintptr;
+typedef ptrdiff_t GLsizeiptr;
+typedef struct __GLsync* GLsync;
+typedef uint64_t GLuint64;
+
+typedef void (APIENTRY * PFNGLGENBUFFERSPROC) (GLsizei n, GLuint* buffers);
+typedef void (APIENTRY * PFNGLBINDBUFFERPROC) (GLenum target, GLuint buffer);
+typedef void (APIENTRY * PFNGLDELETEBUFFERSPROC) (GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY * PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void * (APIENTRY * PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef void (APIENTRY * PFNGLGENVERTEXARRAYSPROC) (GLsizei n, GLuint* arrays);
+typedef void (APIENTRY * PFNGLBINDVERTEXARRAYPROC) (GLuint array);
+typedef void (APIENTRY * PFNGLDELETEVERTEXARRAYSPROC) (GLsizei n, const GLuint* arrays);
+typedef void (APIENTRY * PFNGLMULTIDRAWELEMENTSINDIRECTPROC) (GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef GLsync (APIENTRY * PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRY * PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (APIENTRY * PFNGLDELETESYNCPROC) (GLsync sync);
+
+static PFNGLGENBUFFERSPROC glGenBuffers;
+static PFNGLBINDBUFFERPROC glBindBuffer;
+static PFNGLDELETEBUFFERSPROC glDeleteBuffers;
+static PFNGLBUFFERSTORAGEPROC glBufferStorage;
+static PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+static PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
+static PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
+static PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
+static PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect;
+static PFNGLFENCESYNCPROC glFenceSync;
+static PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+static PFNGLDELETESYNCPROC glDeleteSync;
+
+namespace
+{
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct WriteRange
+    {
+        unsigned int begin, end;
+
+        bool operator<(const WriteRange& other) const { return begin < other.begin; }
+    };
+
+    // Persistently mapped buffer of BUFFER_SECTIONS sections. The first write
+    // after a draw moves to the next section, so the CPU never writes what the
+    // GPU reads. That section is first brought up to date with the ranges
+    // written while it was not current, range by range as they were written.
+    struct PersistentBuffer
+    {
+        GLuint name;
+        GLenum target;
+        uint8_t* ptr;
+        unsigned int size, section;
+        bool drawn;                                 // the current section has been drawn
+        GLsync fences[BUFFER_SECTIONS];
+        vector<WriteRange> writes[BUFFER_SECTIONS]; // ranges written while each section was current
+
+        // vertex buffer only
+        GLuint vao, vaoElementBuffer;
+        unsigned int vaoSection;                    // section the vertex array points to
+
+        // index buffer only
+        GLuint commandName;
+        DrawElementsIndirectCommand* commands;
+        unsigned int commandCapacity, commandCount;
+    };
+}
+
+static void waitFence(GLsync& fence)
+{
+    GLenum result;
+
+    if (!fence)
+        return;
+
+    do
+    {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, SYNC_TIMEOUT);
+    } while (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED);
+
+    glDeleteSync(fence);
+    fence = NULL;
+}
+
+static void placeFence(GLsync& fence)
+{
+    if (fence)
+        glDeleteSync(fence);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+static void waitAllFences(PersistentBuffer* pb)
+{
+    for (unsigned int i = 0; i < BUFFER_SECTIONS; ++i)
+        waitFence(pb->fences[i]);
+}
+
+static void addWrite(PersistentBuffer* pb, unsigned int offset, unsigned int size)
+{
+    vector<WriteRange>& writes = pb->writes[pb->section];
+    WriteRange range = { offset, offset + size };
+
+    // writes mostly come in ascending order, so only the last range is joined
+    if (!writes.empty() && range.begin <= writes.back().end && range.end >= writes.back().begin)
+    {
+        writes.back().begin = min(writes.back().begin, range.begin);
+        writes.back().end = max(writes.back().end, range.end);
+    }
+    else
+    {
+        writes.push_back(range);
+    }
+}
+
+// Moves to the next section once per frame, on the first write after a draw
+static void rotateSection(PersistentBuffer* pb)
+{
+    static vector<WriteRange> ranges;
+    unsigned int prev = pb->section, begin, end, i, j;
+
+    if (!pb->drawn)
+        return;
+
+    pb->section = (pb->section + 1) % BUFFER_SECTIONS;
+    pb->drawn = false;
+
+    // make sure the GPU has finished with this section before it is written again
+    waitFence(pb->fences[pb->section]);
+
+    // catch up with the frames written to the other sections since
+    ranges.clear();
+    for (i = 0; i < BUFFER_SECTIONS; ++i)
+    {
+        if (i != pb->section)
+            ranges.insert(ranges.end(), pb->writes[i].begin(), pb->writes[i].end());
+    }
+    sort(ranges.begin(), ranges.end());
+
+    // ranges written in both frames are copied once
+    for (i = 0; i < ranges.size(); i = j)
+    {
+        begin = ranges[i].begin;
+        end = ranges[i].end;
+
+        for (j = i + 1; j < ranges.size() && ranges[j].begin <= end; ++j)
+            end = max(end, ranges[j].end);
+
+        ::memcpy(pb->ptr + pb->section * pb->size + begin, pb->ptr + prev * pb->size + begin, end - begin);
+    }
+
+    pb->writes[pb->section].clear();
+}
+
+static uint8_t* createStorage(GLenum target, GLuint& name, unsigned int size, const void* data, GLbitfield flags)
+{
+    uint8_t* ptr;
+
+    glGenBuffers(1, &name);
+    glBindBuffer(target, name);
+    glBufferStorage(target, size, data, flags);
+    ptr = (uint8_t*)glMapBufferRange(target, 0, size, flags & ~GL_CLIENT_STORAGE_BIT);
+    glBindBuffer(target, 0);
+    return ptr;
+}
+
+static GLbitfield storageFlags(GLenum target)
+{
+    // the vertex buffer is read back by refinement, keep it in cached client memory
+    if (target == GL_ARRAY_BUFFER)
+        return GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_CLIENT_STORAGE_BIT;
+
+    return GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+static void resizeCommands(PersistentBuffer* pb, unsigned int count)
+{
+    unsigned int capacity = pb->commandCapacity ? pb->commandCapacity : MIN_COMMAND_COUNT;
+
+    while (capacity < count)
+        capacity *= 2;
+
+    waitAllFences(pb);
+
+    if (pb->commandName)
+        glDeleteBuffers(1, &pb->commandName);
+
+    pb->commands = (DrawElementsIndirectCommand*)createStorage(GL_DRAW_INDIRECT_BUFFER, pb->commandName,
+        sizeof(DrawElementsIndirectCommand) * capacity * BUFFER_SECTIONS, NULL, storageFlags(GL_DRAW_INDIRECT_BUFFER));
+    pb->commandCapacity = capacity;
+}
+
+OpenGL4Renderer& OpenGL4Renderer::getInstance()
+{
+    static OpenGL4Renderer self;
+    return self;
+}
+
+OpenGL4Renderer::OpenGL4Renderer()
+{
+    if (!glBufferStorage)
+    {
+        glGenBuffers = (PFNGLGENBUFFERSPROC)wglGetProcAddress("glGenBuffers");
+        glBindBuffer = (PFNGLBINDBUFFERPROC)wglGetProcAddress("glBindBuffer");
+        glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)wglGetProcAddress("glDeleteBuffers");
+        glBufferStorage = (PFNGLBUFFERSTORAGEPROC)wglGetProcAddress("glBufferStorage");
+        glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)wglGetProcAddress("glMapBufferRange");
+        glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)wglGetProcAddress("glGenVertexArrays");
+        glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC)wglGetProcAddress("glBindVertexArray");
+        glDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC)wglGetProcAddress("glDeleteVertexArrays");
+        glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)wglGetProcAddress("glMultiDrawElementsIndirect");
+        glFenceSync = (PFNGLFENCESYNCPROC)wglGetProcAddress("glFenceSync");
+        glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)wglGetProcAddress("glClientWaitSync");
+        glDeleteSync = (PFNGLDELETESYNCPROC)wglGetProcAddress("glDeleteSync");
+    }
+}
+
+OpenGL4Renderer::~OpenGL4Renderer()
+{
+    // do nothing
+}
+
+void* OpenGL4Renderer::createBuffer(RendererBuffer target, unsigned int size, const void* data)
+{
+    PersistentBuffer* pb = new PersistentBuffer();
+    if (!pb)
+        return NULL;
+
+    pb->target = (target == RENDERER_VERTEX_BUFFER) ? GL_ARRAY_BUFFER : GL_ELEMENT_ARRAY_BUFFER;
+    pb->size = size;
+    pb->ptr = createStorage(pb->target, pb->name, size * BUFFER_SECTIONS, NULL, storageFlags(pb->target));
+
+    if (!pb->ptr)
+    {
+        destroyBuffer(pb);
+        return NULL;
+    }
+
+    // the other sections copy the first one as they come around
+    if (data)
+        ::memcpy(pb->ptr, data, size);
+
+    addWrite(pb, 0, size);
+    return pb;
+}
+
+void OpenGL4Renderer::destroyBuffer(void* buf)
+{
+    PersistentBuffer* pb = (PersistentBuffer*)buf;
+
+    if (!pb)
+        return;
+
+    for (unsigned int i = 0; i < BUFFER_SECTIONS; ++i)
+    {
+        if (pb->fences[i])
+            glDeleteSync(pb->fences[i]);
+    }
+
+    if (pb->vao)
+        glDeleteVertexArrays(1, &pb->vao);
+
+    if (pb->commandName)
+        glDeleteBuffers(1, &pb->commandName);
+
+    if (pb->name)
+        glDeleteBuffers(1, &pb->name);
+
+    delete pb;
+}
+
+void OpenGL4Renderer::setBufferData(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, const void* data)
+{
+    uint8_t* ptr = (uint8_t*)mapBuffer(target, buf, offset, size, RENDERER_WRITE_ONLY);
+    ::memcpy(ptr, data, size);
+}
+
+void* OpenGL4Renderer::resizeBuffer(RendererBuffer target, void* buf, unsigned int size)
+{
+    PersistentBuffer* pb = (PersistentBuffer*)buf;
+    PersistentBuffer* newpb;
+
+    waitAllFences(pb);
+
+    // old contents are read straight from the persistent mapping
+    newpb = (PersistentBuffer*)createBuffer(target, size, NULL);
+    if (!newpb)
+        return NULL;
+
+    ::memcpy(newpb->ptr, pb->ptr + pb->section * pb->size, (pb->size < size) ? pb->size : size);
+    destroyBuffer(pb);
+    return newpb;
+}
+
+void* OpenGL4Renderer::mapBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, RendererAccess access)
+{
+    PersistentBuffer* pb = (PersistentBuffer*)buf;
+
+    if (access != RENDERER_READ_ONLY)
+    {
+        rotateSection(pb);
+        addWrite(pb, offset, size);
+    }
+    return pb->ptr + pb->section * pb->size + offset;
+}
+
+void OpenGL4Renderer::unmapBuffer(RendererBuffer target, void* buf)
+{
+    // coherent mapping, nothing to do
+}
+
+void OpenGL4Renderer::flushBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size)
+{
+    // coherent mapping, nothing to do
+}
+
+void OpenGL4Renderer::updateDrawCommands(SRMesh* srmesh)
+{
+    PersistentBuffer* pb = (PersistentBuffer*)srmesh->getElementArrayBuffer();
+    unsigned int count = srmesh->getTStripCount();
+    unsigned int** indicesArray = srmesh->getIndicesPointer();
+    unsigned int* indicesCountArray = srmesh->getIndicesCountPointer();
+    DrawElementsIndirectCommand* cmd;
+    unsigned int base, i;
+
+    if (!pb)
+        return;
+
+    if (count > pb->commandCapacity)
+        resizeCommands(pb, count);
+
+    // command section follows the index section, both are guarded by the same fence
+    cmd = pb->commands + pb->section * pb->commandCapacity;
+    base = pb->section * pb->size / sizeof(unsigned int);
+
+    for (i = 0; i < count; ++i)
+    {
+        cmd[i].count = indicesCountArray[i];
+        cmd[i].instanceCount = 1;
+        cmd[i].firstIndex = base + (unsigned int)((uintptr_t)indicesArray[i] / sizeof(unsigned int));
+        cmd[i].baseVertex = 0;
+        cmd[i].baseInstance = 0;
+    }
+    pb->commandCount = count;
+}
+
+void OpenGL4Renderer::draw(SRMesh* srmesh)
+{
+    PersistentBuffer* vb = (PersistentBuffer*)srmesh->getArrayBuffer();
+    PersistentBuffer* ib = (PersistentBuffer*)srmesh->getElementArrayBuffer();
+    unsigned int vgeomSize = srmesh->getVGeomSize();
+    uintptr_t base;
+
+    if (!ib || !ib->commandCount)
+        return;
+
+    if (!vb->vao)
+    {
+        glGenVertexArrays(1, &vb->vao);
+        glBindVertexArray(vb->vao);
+
+        // the same fixed-function arrays as OpenGLRenderer::draw, kept in the vertex array
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+
+        if (srmesh->hasColor())
+            glEnableClientState(GL_COLOR_ARRAY);
+
+        if (srmesh->hasTexCoord())
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+        vb->vaoElementBuffer = 0;
+        vb->vaoSection = UINT_MAX;
+    }
+    else
+    {
+        glBindVertexArray(vb->vao);
+    }
+
+    // point the arrays at the current section of the vertex buffer
+    if (vb->vaoSection != vb->section)
+    {
+        base = vb->section * vb->size;
+        glBindBuffer(GL_ARRAY_BUFFER, vb->name);
+
+        glVertexPointer(3, GL_FLOAT, vgeomSize, (void*)(base + offsetof(VGeom, point)));
+        glNormalPointer(GL_FLOAT, vgeomSize, (void*)(base + offsetof(VGeom, normal)));
+
+        if (srmesh->hasColor())
+            glColorPointer(3, GL_FLOAT, vgeomSize, (void*)(base + srmesh->getColorOffset()));
+
+        if (srmesh->hasTexCoord())
+            glTexCoordPointer(2, GL_FLOAT, vgeomSize, (void*)(base + srmesh->getTexCoordOffset()));
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        vb->vaoSection = vb->section;
+    }
+
+    // element buffer binding is part of the vertex array state
+    if (vb->vaoElementBuffer != ib->name)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->name);
+        vb->vaoElementBuffer = ib->name;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ib->commandName);
+    glMultiDrawElementsIndirect(GL_TRIANGLE_STRIP, GL_UNSIGNED_INT,
+        (const void*)(sizeof(DrawElementsIndirectCommand) * ib->section * ib->commandCapacity), ib->commandCount, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+
+    placeFence(ib->fences[ib->section]);
+    placeFence(vb->fences[vb->section]);
+    ib->drawn = vb->drawn = true;
+}
+
+#endif // VDPM_RENDERER_OPENGL4
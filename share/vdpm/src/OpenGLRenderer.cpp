@@ -124,9 +124,9 @@ void OpenGLRenderer::setBufferData(RendererBuffer target, void* buf, unsigned in
 {
 #ifdef VDPM_RENDERER_OPENGL_VBO
     GLenum gltarget = (target == RENDERER_VERTEX_BUFFER) ? GL_ARRAY_BUFFER : GL_ELEMENT_ARRAY_BUFFER;
-    glBindBuffer(target, (GLuint)buf);
-    glBufferSubData(target, offset, size, data);
-    glBindBuffer(target, 0);
+    glBindBuffer(gltarget, (GLuint)buf);
+    glBufferSubData(gltarget, offset, size, data);
+    glBindBuffer(gltarget, 0);
 #else
     Renderer::setBufferData(target, buf, offset, size, data);
 #endif
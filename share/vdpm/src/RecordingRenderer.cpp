@@ -0,0 +1,631 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "vdpm/Log.h"
+#include "vdpm/RecordingRenderer.h"
+
+using namespace std;
+using namespace vdpm;
+
+#define TRACE_MAGIC_0 'v'
+#define TRACE_MAGIC_1 'd'
+#define TRACE_MAGIC_2 'p'
+#define TRACE_MAGIC_3 'r'
+#define TRACE_VERSION 1
+
+// changed bytes closer than this are stored as one run
+#define TRACE_WRITE_GAP 32
+
+enum TraceOp
+{
+    TRACE_CREATE = 1,
+    TRACE_DESTROY,
+    TRACE_SET_DATA,
+    TRACE_RESIZE,
+    TRACE_MAP,
+    TRACE_UNMAP,
+    TRACE_FLUSH,
+    TRACE_WRITE,
+    TRACE_UPDATE_DRAW_COMMANDS,
+    TRACE_UPDATE_VIEWPORT,
+    TRACE_DRAW,
+    TRACE_END
+};
+
+struct TraceRecord
+{
+    uint8_t op;
+    uint32_t id;
+    uint8_t target;
+    uint8_t access;
+    uint32_t offset;
+    uint32_t size;
+    uint64_t start;
+    uint32_t duration;
+};
+
+struct ReplayBuffer
+{
+    void* buf;
+    RendererBuffer target;
+    uint8_t* mapped;
+    unsigned int mapOffset, mapSize;
+    RendererAccess access;
+    bool flushed;
+};
+
+template<typename T> static inline void writeValue(ostream& os, T value)
+{
+    os.write((const char*)&value, sizeof(T));
+}
+
+template<typename T> static inline void readValue(istream& is, T& value)
+{
+    is.read((char*)&value, sizeof(T));
+}
+
+static inline uint64_t now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool readRecord(istream& is, TraceRecord& rec)
+{
+    readValue(is, rec.op);
+    readValue(is, rec.id);
+    readValue(is, rec.target);
+    readValue(is, rec.access);
+    readValue(is, rec.offset);
+    readValue(is, rec.size);
+    readValue(is, rec.start);
+    readValue(is, rec.duration);
+    return is.good();
+}
+
+RecordingRenderer::RecordingRenderer(Renderer* target, const char filePath[]) : target(target), os(NULL), nextBufferId(1)
+{
+    fout.open(filePath, ofstream::out | ofstream::binary | ofstream::trunc);
+
+    if (!fout.is_open())
+    {
+        Log::println("failed to open %s", filePath);
+        return;
+    }
+    os = &fout;
+    open();
+}
+
+RecordingRenderer::RecordingRenderer(Renderer* target, std::ostream* os) : target(target), os(os), nextBufferId(1)
+{
+    if (os)
+        open();
+}
+
+RecordingRenderer::~RecordingRenderer()
+{
+    close();
+}
+
+void RecordingRenderer::open()
+{
+    startTime = now();
+
+    writeValue<char>(*os, TRACE_MAGIC_0);
+    writeValue<char>(*os, TRACE_MAGIC_1);
+    writeValue<char>(*os, TRACE_MAGIC_2);
+    writeValue<char>(*os, TRACE_MAGIC_3);
+    writeValue<uint32_t>(*os, TRACE_VERSION);
+}
+
+void RecordingRenderer::close()
+{
+    if (!os)
+        return;
+
+    writeRecord(TRACE_END, 0, RENDERER_VERTEX_BUFFER, 0, 0, 0, now(), 0);
+    os->flush();
+
+    if (os == &fout)
+        fout.close();
+
+    os = NULL;
+}
+
+void RecordingRenderer::writeRecord(uint8_t op, unsigned int id, RendererBuffer target, unsigned int access,
+    unsigned int offset, unsigned int size, uint64_t start, uint64_t duration)
+{
+    writeValue<uint8_t>(*os, op);
+    writeValue<uint32_t>(*os, id);
+    writeValue<uint8_t>(*os, (uint8_t)target);
+    writeValue<uint8_t>(*os, (uint8_t)access);
+    writeValue<uint32_t>(*os, offset);
+    writeValue<uint32_t>(*os, size);
+    writeValue<uint64_t>(*os, start - startTime);
+    writeValue<uint32_t>(*os, (duration > UINT32_MAX) ? UINT32_MAX : (uint32_t)duration);
+}
+
+// Records the bytes of the staging copy that differ from the shadow in [offset, offset + size)
+// of the mapped range, then hands that range to the target's mapping.
+void RecordingRenderer::writeMappedChanges(BufferRecord& record, unsigned int offset, unsigned int size)
+{
+    const uint8_t* src = &record.staging[0];
+    uint8_t* dst = &record.shadow[record.mapOffset];
+    unsigned int i = offset, begin, end;
+
+    if (offset >= record.mapSize)
+        return;
+
+    size = min(size, record.mapSize - offset);
+
+    while (i < offset + size)
+    {
+        if (src[i] == dst[i])
+        {
+            ++i;
+            continue;
+        }
+
+        // extend the run until TRACE_WRITE_GAP unchanged bytes in a row
+        begin = end = i;
+        while (i < offset + size && i - end <= TRACE_WRITE_GAP)
+        {
+            if (src[i] != dst[i])
+                end = i;
+            ++i;
+        }
+        ++end;
+
+        ::memcpy(dst + begin, src + begin, end - begin);
+
+        if (os)
+        {
+            writeRecord(TRACE_WRITE, record.id, record.target, 0, record.mapOffset + begin, end - begin, now(), 0);
+            os->write((const char*)(src + begin), end - begin);
+        }
+        i = end;
+    }
+
+    if (record.mapped)
+        ::memcpy(record.mapped + offset, src + offset, size);
+}
+
+void* RecordingRenderer::createBuffer(RendererBuffer target, unsigned int size, const void* data)
+{
+    uint64_t start = now();
+    void* buf = this->target ? this->target->createBuffer(target, size, data) : Renderer::createBuffer(target, size, data);
+    uint64_t duration = now() - start;
+
+    if (!buf)
+        return NULL;
+
+    BufferRecord& record = buffers[buf];
+    record.id = nextBufferId++;
+    record.target = target;
+    record.shadow.assign(size, 0);
+    record.mapped = NULL;
+    record.mapOffset = record.mapSize = 0;
+    record.access = RENDERER_READ_ONLY;
+    record.flushed = false;
+
+    if (data)
+        ::memcpy(&record.shadow[0], data, size);
+
+    if (os)
+    {
+        writeRecord(TRACE_CREATE, record.id, target, 0, 0, size, start, duration);
+        writeValue<uint8_t>(*os, data ? 1 : 0);
+        if (data)
+            os->write((const char*)data, size);
+    }
+    return buf;
+}
+
+void RecordingRenderer::destroyBuffer(void* buf)
+{
+    map<void*, BufferRecord>::iterator it = buffers.find(buf);
+    uint64_t start = now();
+
+    if (target)
+        target->destroyBuffer(buf);
+    else
+        Renderer::destroyBuffer(buf);
+
+    if (it == buffers.end())
+        return;
+
+    if (os)
+        writeRecord(TRACE_DESTROY, it->second.id, RENDERER_VERTEX_BUFFER, 0, 0, 0, start, now() - start);
+
+    buffers.erase(it);
+}
+
+void RecordingRenderer::setBufferData(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, const void* data)
+{
+    BufferRecord& record = buffers[buf];
+    uint64_t start = now();
+
+    if (this->target)
+        this->target->setBufferData(target, buf, offset, size, data);
+    else
+        Renderer::setBufferData(target, buf, offset, size, data);
+
+    if (record.shadow.size() < offset + size)
+        record.shadow.resize(offset + size, 0);
+
+    ::memcpy(&record.shadow[offset], data, size);
+
+    if (os)
+    {
+        writeRecord(TRACE_SET_DATA, record.id, target, 0, offset, size, start, now() - start);
+        os->write((const char*)data, size);
+    }
+}
+
+void* RecordingRenderer::resizeBuffer(RendererBuffer target, void* buf, unsigned int size)
+{
+    map<void*, BufferRecord>::iterator it = buffers.find(buf);
+    BufferRecord record;
+    uint64_t start, duration;
+    void* newbuf;
+
+    assert(it != buffers.end());
+
+    if (it->second.mapped)
+        unmapBuffer(target, buf);
+
+    record = it->second;
+    buffers.erase(it);
+
+    start = now();
+    newbuf = this->target ? this->target->resizeBuffer(target, buf, size) : Renderer::resizeBuffer(target, buf, size);
+    duration = now() - start;
+
+    if (!newbuf)
+        return NULL;
+
+    record.shadow.resize(size, 0);
+    buffers[newbuf] = record;
+
+    if (os)
+        writeRecord(TRACE_RESIZE, record.id, target, 0, 0, size, start, duration);
+
+    return newbuf;
+}
+
+void* RecordingRenderer::mapBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size, RendererAccess access)
+{
+    BufferRecord& record = buffers[buf];
+    uint64_t start = now();
+    void* ptr = this->target ? this->target->mapBuffer(target, buf, offset, size, access) : Renderer::mapBuffer(target, buf, offset, size, access);
+    uint64_t duration = now() - start;
+
+    if (record.shadow.size() < offset + size)
+        record.shadow.resize(offset + size, 0);
+
+    record.mapped = (uint8_t*)ptr;
+    record.mapOffset = offset;
+    record.mapSize = size;
+    record.access = access;
+    record.flushed = false;
+
+    if (os)
+        writeRecord(TRACE_MAP, record.id, target, access, offset, size, start, duration);
+
+    if (!ptr || !size || access == RENDERER_READ_ONLY)
+        return ptr;
+
+    // the caller writes a staging copy, so a write-only mapping is never read back
+    if (access == RENDERER_WRITE_ONLY)
+        record.staging.assign(record.shadow.begin() + offset, record.shadow.begin() + offset + size);
+    else
+        record.staging.assign((uint8_t*)ptr, (uint8_t*)ptr + size);
+
+    return &record.staging[0];
+}
+
+void RecordingRenderer::unmapBuffer(RendererBuffer target, void* buf)
+{
+    BufferRecord& record = buffers[buf];
+    uint64_t start;
+
+    // writes outside the flushed ranges still reach the mapping
+    if (record.mapped && record.access != RENDERER_READ_ONLY)
+        writeMappedChanges(record, 0, record.mapSize);
+
+    start = now();
+
+    if (this->target)
+        this->target->unmapBuffer(target, buf);
+    else
+        Renderer::unmapBuffer(target, buf);
+
+    if (os)
+        writeRecord(TRACE_UNMAP, record.id, target, record.access, record.mapOffset, record.mapSize, start, now() - start);
+
+    record.mapped = NULL;
+    record.staging.clear();
+}
+
+void RecordingRenderer::flushBuffer(RendererBuffer target, void* buf, unsigned int offset, unsigned int size)
+{
+    BufferRecord& record = buffers[buf];
+    uint64_t start;
+
+    // the flushed bytes are recorded before the flush that uploads them
+    if (record.mapped && record.access != RENDERER_READ_ONLY)
+        writeMappedChanges(record, offset, size);
+
+    start = now();
+
+    if (this->target)
+        this->target->flushBuffer(target, buf, offset, size);
+    else
+        Renderer::flushBuffer(target, buf, offset, size);
+
+    record.flushed = true;
+
+    if (os)
+        writeRecord(TRACE_FLUSH, record.id, target, record.access, offset, size, start, now() - start);
+}
+
+void RecordingRenderer::updateDrawCommands(SRMesh* srmesh)
+{
+    uint64_t start = now();
+
+    if (target)
+        target->updateDrawCommands(srmesh);
+
+    if (os)
+        writeRecord(TRACE_UPDATE_DRAW_COMMANDS, 0, RENDERER_INDEX_BUFFER, 0, 0, 0, start, now() - start);
+}
+
+void RecordingRenderer::updateViewport(Viewport* viewport)
+{
+    uint64_t start = now();
+
+    if (target)
+        target->updateViewport(viewport);
+
+    if (os)
+        writeRecord(TRACE_UPDATE_VIEWPORT, 0, RENDERER_VERTEX_BUFFER, 0, 0, 0, start, now() - start);
+}
+
+void RecordingRenderer::draw(SRMesh* srmesh)
+{
+    uint64_t start = now();
+
+    if (target)
+        target->draw(srmesh);
+
+    if (os)
+        writeRecord(TRACE_DRAW, 0, RENDERER_VERTEX_BUFFER, 0, 0, 0, start, now() - start);
+}
+
+int RecordingRenderer::replay(const char filePath[], Renderer* target, RendererTraceCallback callback, void* param)
+{
+    ifstream fin(filePath, ifstream::in | ifstream::binary);
+
+    if (!fin.is_open())
+    {
+        Log::println("failed to open %s", filePath);
+        return -1;
+    }
+    return replay(fin, target, callback, param);
+}
+
+int RecordingRenderer::replay(std::istream& is, Renderer* target, RendererTraceCallback callback, void* param)
+{
+    map<unsigned int, ReplayBuffer> buffers;
+    map<unsigned int, ReplayBuffer>::iterator it;
+    ReplayBuffer* rb;
+    RecordingRenderer* recorder = dynamic_cast<RecordingRenderer*>(target);
+    vector<uint8_t> data;
+    RendererTraceFrame frame;
+    TraceRecord rec;
+    uint64_t start;
+    uint32_t version;
+    unsigned int frameIndex = 0;
+    uint8_t hasData;
+    char magic[4];
+
+    assert(target);
+
+    readValue(is, magic);
+    readValue(is, version);
+
+    if (!is.good() || magic[0] != TRACE_MAGIC_0 || magic[1] != TRACE_MAGIC_1 || magic[2] != TRACE_MAGIC_2 || magic[3] != TRACE_MAGIC_3)
+    {
+        Log::println("invalid renderer trace");
+        goto error;
+    }
+
+    if (version != TRACE_VERSION)
+    {
+        Log::println("unsupported renderer trace version %u", version);
+        goto error;
+    }
+
+    ::memset(&frame, 0, sizeof(frame));
+
+    while (readRecord(is, rec) && rec.op != TRACE_END)
+    {
+        RendererBuffer bufTarget = (RendererBuffer)rec.target;
+
+        ++frame.calls;
+        frame.recordedTime += rec.duration;
+
+        if (rec.op == TRACE_CREATE || rec.op == TRACE_SET_DATA || rec.op == TRACE_WRITE)
+        {
+            hasData = 1;
+            if (rec.op == TRACE_CREATE)
+                readValue(is, hasData);
+
+            if (hasData)
+            {
+                data.resize((size_t)rec.size + 1);
+                is.read((char*)&data[0], rec.size);
+            }
+        }
+
+        if (!is.good())
+        {
+            Log::println("truncated renderer trace");
+            goto error;
+        }
+
+        // frame markers carry no buffer; every other record but a create names a live one
+        rb = NULL;
+        if (rec.op == TRACE_CREATE)
+        {
+            if (buffers.count(rec.id))
+            {
+                Log::println("duplicate buffer %u in renderer trace", rec.id);
+                goto error;
+            }
+            rb = &buffers[rec.id];
+        }
+        else if (rec.op < TRACE_UPDATE_DRAW_COMMANDS)
+        {
+            it = buffers.find(rec.id);
+            if (it == buffers.end())
+            {
+                Log::println("unknown buffer %u in renderer trace", rec.id);
+                goto error;
+            }
+            rb = &it->second;
+        }
+
+        // writes, flushes and unmaps need a mapping, and writes must stay inside it
+        if ((rec.op == TRACE_WRITE || rec.op == TRACE_FLUSH || rec.op == TRACE_UNMAP) && !rb->mapped)
+        {
+            Log::println("buffer %u is not mapped in renderer trace", rec.id);
+            goto error;
+        }
+
+        if (rec.op == TRACE_WRITE &&
+            (rec.offset < rb->mapOffset || rec.size > rb->mapSize || rec.offset - rb->mapOffset > rb->mapSize - rec.size))
+        {
+            Log::println("write outside the mapped range in renderer trace");
+            goto error;
+        }
+
+        start = now();
+
+        switch (rec.op)
+        {
+        case TRACE_CREATE:
+        {
+            uint8_t* copy = NULL;
+
+            // the CPU renderer adopts the initial data block, so hand it a block it may keep
+            if (hasData)
+            {
+                copy = (uint8_t*)::malloc(rec.size);
+                ::memcpy(copy, &data[0], rec.size);
+                frame.uploadBytes += rec.size;
+            }
+            rb->buf = target->createBuffer(bufTarget, rec.size, copy);
+            rb->target = bufTarget;
+            rb->mapped = NULL;
+
+            if (copy && rb->buf != copy)
+                ::free(copy);
+            break;
+        }
+
+        case TRACE_DESTROY:
+            target->destroyBuffer(rb->buf);
+            buffers.erase(rec.id);
+            break;
+
+        case TRACE_SET_DATA:
+            target->setBufferData(bufTarget, rb->buf, rec.offset, rec.size, &data[0]);
+            frame.uploadBytes += rec.size;
+            break;
+
+        case TRACE_RESIZE:
+            rb->buf = target->resizeBuffer(bufTarget, rb->buf, rec.size);
+            break;
+
+        case TRACE_MAP:
+            rb->mapped = (uint8_t*)target->mapBuffer(bufTarget, rb->buf, rec.offset, rec.size, (RendererAccess)rec.access);
+            rb->mapOffset = rec.offset;
+            rb->mapSize = rec.size;
+            rb->access = (RendererAccess)rec.access;
+            rb->flushed = false;
+            break;
+
+        case TRACE_WRITE:
+            ::memcpy(rb->mapped + rec.offset - rb->mapOffset, &data[0], rec.size);
+            frame.writtenBytes += rec.size;
+            break;
+
+        case TRACE_FLUSH:
+            target->flushBuffer(bufTarget, rb->buf, rec.offset, rec.size);
+            frame.uploadBytes += rec.size;
+            rb->flushed = true;
+            break;
+
+        case TRACE_UNMAP:
+            target->unmapBuffer(bufTarget, rb->buf);
+
+            // without an explicit flush the whole mapped range is uploaded
+            if (rb->access != RENDERER_READ_ONLY && !rb->flushed)
+                frame.uploadBytes += rb->mapSize;
+
+            rb->mapped = NULL;
+            break;
+
+        case TRACE_UPDATE_DRAW_COMMANDS:
+        case TRACE_UPDATE_VIEWPORT:
+        case TRACE_DRAW:
+            // keep frame markers when the replay itself is recorded
+            if (recorder && recorder->os)
+                recorder->writeRecord(rec.op, 0, bufTarget, 0, 0, 0, start, 0);
+
+            if (rec.op != TRACE_DRAW)
+                break;
+
+            frame.replayTime += now() - start;
+
+            if (callback)
+                callback(frame, param);
+
+            ::memset(&frame, 0, sizeof(frame));
+            frame.index = ++frameIndex;
+            continue;
+
+        default:
+            break;
+        }
+        frame.replayTime += now() - start;
+    }
+
+    if (frame.calls && callback)
+        callback(frame, param);
+
+    return 0;
+
+error:
+    return -1;
+}
@@ -65,3 +65,8 @@ void Renderer::flushBuffer(RendererBuffer target, void* buf, unsigned int offset
 {
     // DO NOTHING
 }
+
+void Renderer::updateDrawCommands(SRMesh* srmesh)
+{
+    // DO NOTHING
+}
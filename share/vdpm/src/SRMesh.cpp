@@ -20,9 +20,11 @@
 #include <cstring>
 #include <fstream>
 #include "vdpm/Allocator.h"
+#include "vdpm/FaceBVH.h"
 #include "vdpm/Log.h"
 #include "vdpm/Renderer.h"
 #include "vdpm/SRMesh.h"
+#include "vdpm/VGeomKernels.h"
 #include "vdpm/Viewport.h"
 
 using namespace std;
@@ -37,14 +39,25 @@ using namespace vdpm;
 #define AMORTIZATION_STEP       1
 typedef Vertex*                 VertexPointer;
 
+#ifdef VDPM_GEOMORPHS
+template struct vdpm::VGeomKernels<VGEOM_LAYOUT_PN>;
+template struct vdpm::VGeomKernels<VGEOM_LAYOUT_PNT>;
+template struct vdpm::VGeomKernels<VGEOM_LAYOUT_PNC>;
+template struct vdpm::VGeomKernels<VGEOM_LAYOUT_PNCT>;
+#endif
+
 SRMesh::SRMesh()
 {
     ::memset(this, 0, sizeof(SRMesh));
 
-    avertices.next = &averticesEnd;
-    averticesEnd.prev = &avertices;
-    afaces.next = &afacesEnd;
-    afacesEnd.prev = &afaces;
+#ifndef VDPM_INDEX_TOPOLOGY
+    // with VDPM_INDEX_TOPOLOGY the sentinels are in the pools, see createTopologyPools()
+    avertices = &avertexSentinels[0];
+    averticesEnd = &avertexSentinels[1];
+    afaces = &afaceSentinels[0];
+    afacesEnd = &afaceSentinels[1];
+    initActiveLists();
+#endif
     tstrips.next = &tstripsEnd;
     tstripsEnd.prev = &tstrips;
 #ifdef VDPM_GEOMORPHS
@@ -54,23 +67,36 @@ SRMesh::SRMesh()
     gmorphTstrips.next = &gmorphTstripsEnd;
     gmorphTstripsEnd.prev = &gmorphTstrips;
 #endif
+#ifndef VDPM_VSPLIT_DEPENDENCIES
     vstackSize = VSTACK_SIZE;
+#endif
 
 #ifdef VDPM_REGULATION
     targetAFaceCount = UINT_MAX;
 #endif
 
 #ifdef VDPM_AMORTIZATION
-    amortizeAvertex = &averticesEnd;
     amortizeStep = AMORTIZATION_STEP;
 #endif
+
+#ifdef VDPM_HYSTERESIS
+    mergeTauScale = 1.0f;
+#endif
+
+#ifdef VDPM_IMPORTANCE_REGIONS
+    defaultTauScale = 1.0f;
+#endif
+
+    allocator = new Allocator();
 }
 
 SRMesh::~SRMesh()
 {
+#ifndef VDPM_INDEX_TOPOLOGY
     AVertex *avertex, *avertexNext;
     AFace *aface, *afaceNext;
-    TStrip *tstrip, *tstripNext;
+#endif
+    TStrip* tstrip;
 #ifdef VDPM_GEOMORPHS
     VMorph *vmorph, *vmorphNext;
 
@@ -81,37 +107,42 @@ SRMesh::~SRMesh()
         delete vmorph;
         vmorph = vmorphNext;
     }
+    // strips hand their faces back to afaces
     tstrip = gmorphTstrips.next;
     while (tstrip != &gmorphTstripsEnd)
     {
-        tstripNext = tstrip->next;
-        delete[] tstrip->vgIndices;
-        delete tstrip;
-        tstrip = tstripNext;
+        freeTStrip(tstrip);
+        tstrip = gmorphTstrips.next;
     }
 #endif // VDPM_GEOMORPHS
     tstrip = tstrips.next;
     while (tstrip != &tstripsEnd)
     {
-        tstripNext = tstrip->next;
-        delete[] tstrip->vgIndices;
-        delete tstrip;
-        tstrip = tstripNext;
+        freeTStrip(tstrip);
+        tstrip = tstrips.next;
     }
-    aface = afaces.next;
-    while (aface != &afacesEnd)
+#ifdef VDPM_INDEX_TOPOLOGY
+    for (unsigned int i = 0; i < tstripPoolTop; ++i)
+        delete tstripPool[i];
+    ::free(tstripPool);
+    delete[] afacePool;
+    delete[] avertexPool;
+#else
+    aface = getAFace(afaces->next);
+    while (aface != afacesEnd)
     {
-        afaceNext = aface->next;
+        afaceNext = getAFace(aface->next);
         delete aface;
         aface = afaceNext;
     }
-    avertex = avertices.next;
-    while (avertex != &averticesEnd)
+    avertex = getAVertex(avertices->next);
+    while (avertex != averticesEnd)
     {
-        avertexNext = avertex->next;
+        avertexNext = getAVertex(avertex->next);
         delete avertex;
         avertex = avertexNext;
     }
+#endif // VDPM_INDEX_TOPOLOGY
     delete[] vsplits;
     delete[] faces;
 
@@ -126,15 +157,36 @@ SRMesh::~SRMesh()
     delete[] indicesCountArray;
     delete[] indicesArray;
     ::free(indicesBuffer);
+#ifdef VDPM_VSPLIT_DEPENDENCIES
+    delete[] vsplitDepOffsets;
+    delete[] vsplitDeps;
+    delete[] vsplitStack;
+#else
     ::free(vstack);
+#endif
     delete[] texname;
+#ifdef VDPM_IMPORTANCE_REGIONS
+    delete[] vertexTauScales;
+#endif
+#ifdef VDPM_HYSTERESIS
+    ::free(vertexHolds);
+#endif
+#ifdef VDPM_FACE_BVH
+    delete bvh;
+#endif
+    delete allocator;
 }
 
 int SRMesh::realize(Renderer* renderer)
 {
+#ifdef VDPM_VSPLIT_DEPENDENCIES
+    if (buildVSplitDependencies())
+        goto error;
+#else
     vstack = (VertexPointer*)::malloc(sizeof(VertexPointer) * VSTACK_SIZE);
     if (!vstack)
         goto error;
+#endif
 
     indicesBuffer = (unsigned int*)::malloc(sizeof(unsigned int) * INDICES_BUFFER_SIZE);
     if (!indicesBuffer)
@@ -155,6 +207,13 @@ int SRMesh::realize(Renderer* renderer)
     if (geometry.realize(renderer))
         goto error;
 
+#ifdef VDPM_GEOMORPHS
+    selectVGeomKernels();
+
+    // geomorph vertices are written in place after the vertices
+    vmorphVgeoms = getVGeom(vcount);
+#endif // VDPM_GEOMORPHS
+
 #ifdef VDPM_TSTRIP_RESTRIP_ALL
     tstripDirty = true;
 #endif
@@ -163,7 +222,15 @@ int SRMesh::realize(Renderer* renderer)
     return 0;
 
 error:
+#ifdef VDPM_VSPLIT_DEPENDENCIES
+    delete[] vsplitDepOffsets;
+    delete[] vsplitDeps;
+    delete[] vsplitStack;
+    vsplitDepOffsets = vsplitDeps = NULL;
+    vsplitStack = NULL;
+#else
     ::free(vstack);
+#endif
     ::free(indicesBuffer);
     delete[] indicesArray;
     delete[] indicesCountArray;
@@ -202,6 +269,295 @@ void SRMesh::setTargetAFaceCount(unsigned int count)
 }
 #endif
 
+#ifdef VDPM_IMPORTANCE_REGIONS
+int SRMesh::addImportanceEllipse(float x, float y, float rx, float ry, float tauScale, float falloff)
+{
+    return addImportanceRegion(IMPORTANCE_ELLIPSE, Point(x, y, 0.0f), Vector(rx, ry, 0.0f), tauScale, falloff);
+}
+
+int SRMesh::addImportanceSphere(const Point& center, float radius, float tauScale, float falloff)
+{
+    return addImportanceRegion(IMPORTANCE_SPHERE, center, Vector(radius, radius, radius), tauScale, falloff);
+}
+
+int SRMesh::addImportanceBox(const Point& min, const Point& max, float tauScale, float falloff)
+{
+    return addImportanceRegion(IMPORTANCE_BOX, (min + max) / 2, (max - min) / 2, tauScale, falloff);
+}
+
+int SRMesh::addImportanceRegion(ImportanceShape shape, const Point& center, const Vector& extent, float tauScale, float falloff)
+{
+    int i;
+
+    // getTauScale() divides by the extent; an ellipse has no z extent
+    if (!(extent.x > 0.0f) || !(extent.y > 0.0f) ||
+        (shape != IMPORTANCE_ELLIPSE && !(extent.z > 0.0f)) || !(falloff >= 0.0f))
+    {
+        Log::println("invalid importance region");
+        return -1;
+    }
+
+    for (i = 0; i < VDPM_MAX_IMPORTANCE_REGIONS; ++i)
+    {
+        ImportanceRegion& region = importanceRegions[i];
+
+        if (region.shape != IMPORTANCE_NONE)
+            continue;
+
+        region.shape = shape;
+        region.center = center;
+        region.extent = extent;
+        region.tauScale = tauScale;
+        region.falloff = falloff;
+        return i;
+    }
+
+    Log::println("no free importance region");
+    return -1;
+}
+
+ImportanceRegion* SRMesh::getImportanceRegion(int region)
+{
+    assert(region >= 0 && region < VDPM_MAX_IMPORTANCE_REGIONS);
+    return &importanceRegions[region];
+}
+
+void SRMesh::removeImportanceRegion(int region)
+{
+    assert(region >= 0 && region < VDPM_MAX_IMPORTANCE_REGIONS);
+    importanceRegions[region].shape = IMPORTANCE_NONE;
+}
+
+void SRMesh::clearImportanceRegions()
+{
+    int i;
+
+    for (i = 0; i < VDPM_MAX_IMPORTANCE_REGIONS; ++i)
+        importanceRegions[i].shape = IMPORTANCE_NONE;
+}
+
+void SRMesh::setDefaultTauScale(float tauScale)
+{
+    defaultTauScale = tauScale;
+}
+
+void SRMesh::setBaseVertexTauScale(unsigned int i, float tauScale)
+{
+    unsigned int j;
+
+    assert(i < baseVCount);
+
+    if (!vertexTauScales)
+    {
+        vertexTauScales = new float[vcount];
+        for (j = 0; j < vcount; ++j)
+            vertexTauScales[j] = 1.0f;
+    }
+    vertexTauScales[i] = tauScale;
+    vertexTauScalesDirty = true;
+}
+
+void SRMesh::updateImportance()
+{
+    unsigned int i;
+
+    if (vertexTauScalesDirty)
+    {
+        // a parent always precedes its children
+        for (i = baseVCount; i < vcount; ++i)
+        {
+        #ifdef VDPM_STREAMING
+            // set by addStreamedVSplit() once the record arrives
+            if (!vertices[i].parent)
+                continue;
+        #endif
+            vertexTauScales[i] = vertexTauScales[getVertex(vertices[i].parent) - vertices];
+        }
+
+        vertexTauScalesDirty = false;
+    }
+
+    importanceActive = (defaultTauScale != 1.0f) || vertexTauScales;
+
+    for (i = 0; i < VDPM_MAX_IMPORTANCE_REGIONS && !importanceActive; ++i)
+        importanceActive = (importanceRegions[i].shape != IMPORTANCE_NONE);
+}
+
+float SRMesh::getTauScale(Vertex* vs, const Point& point)
+{
+    float scale = defaultTauScale;
+    float d, w, x, y;
+    int i;
+
+    for (i = 0; i < VDPM_MAX_IMPORTANCE_REGIONS; ++i)
+    {
+        const ImportanceRegion& region = importanceRegions[i];
+
+        switch (region.shape)
+        {
+        case IMPORTANCE_ELLIPSE:
+        {
+            // distances to the side planes give the projected position for symmetric frusta
+            float r = viewport->frustum[0][0] * point.x + viewport->frustum[0][1] * point.y + viewport->frustum[0][2] * point.z + viewport->frustum[0][3];
+            float l = viewport->frustum[1][0] * point.x + viewport->frustum[1][1] * point.y + viewport->frustum[1][2] * point.z + viewport->frustum[1][3];
+            float b = viewport->frustum[2][0] * point.x + viewport->frustum[2][1] * point.y + viewport->frustum[2][2] * point.z + viewport->frustum[2][3];
+            float t = viewport->frustum[3][0] * point.x + viewport->frustum[3][1] * point.y + viewport->frustum[3][2] * point.z + viewport->frustum[3][3];
+
+            if (l + r <= 0.0f || b + t <= 0.0f)
+                continue;
+
+            x = ((l - r) / (l + r) - region.center.x) / region.extent.x;
+            y = ((b - t) / (b + t) - region.center.y) / region.extent.y;
+            d = sqrt(x * x + y * y);
+            break;
+        }
+        case IMPORTANCE_SPHERE:
+            d = magnitude(point - region.center) / region.extent.x;
+            break;
+
+        case IMPORTANCE_BOX:
+            x = fabs(point.x - region.center.x) / region.extent.x;
+            y = fabs(point.y - region.center.y) / region.extent.y;
+            d = fabs(point.z - region.center.z) / region.extent.z;
+            if (x > d)
+                d = x;
+            if (y > d)
+                d = y;
+            break;
+
+        default:
+            continue;
+        }
+
+        if (d <= 1.0f)
+            w = 1.0f;
+        else if (d < 1.0f + region.falloff)
+            w = 1.0f - (d - 1.0f) / region.falloff;
+        else
+            continue;
+
+        scale += (region.tauScale - scale) * w;
+    }
+
+    if (vertexTauScales)
+        scale *= vertexTauScales[vs - vertices];
+
+    return scale;
+}
+#endif // VDPM_IMPORTANCE_REGIONS
+
+#ifdef VDPM_FACE_BVH
+void SRMesh::setFaceBVHEnabled(bool enabled)
+{
+    TStrip* tstrip;
+    AFace* aface;
+
+    if (enabled)
+    {
+        if (!bvh)
+        {
+            bvh = new FaceBVH();
+            bvhRebuild = true;
+        }
+        return;
+    }
+
+    if (!bvh)
+        return;
+
+    // faces keep their leaf indices until they are freed, so clear them all
+    for (aface = getAFace(afaces->next); aface != afacesEnd; aface = getAFace(aface->next))
+        aface->bvhLeaf = 0;
+
+    for (tstrip = tstrips.next; tstrip != &tstripsEnd; tstrip = tstrip->next)
+    {
+        for (aface = tstrip->afaces; aface; aface = getAFace(aface->next))
+            aface->bvhLeaf = 0;
+    }
+#if defined(VDPM_GEOMORPHS) && !defined(VDPM_TSTRIP_RESTRIP_ALL)
+    for (tstrip = gmorphTstrips.next; tstrip != &gmorphTstripsEnd; tstrip = tstrip->next)
+    {
+        for (aface = tstrip->afaces; aface; aface = getAFace(aface->next))
+            aface->bvhLeaf = 0;
+    }
+#endif
+    delete bvh;
+    bvh = NULL;
+}
+
+Point SRMesh::getDrawnPoint(AVertex* avertex)
+{
+#ifdef VDPM_GEOMORPHS
+    VMorph* vmorph = avertex->vmorph;
+
+    if (vmorph)
+    {
+        if (vmorphVgeoms)
+            return getVMorphVGeom(vmorph->vgIndex)->point;
+    }
+#endif // VDPM_GEOMORPHS
+
+    return getVGeom(avertex->i)->point;
+}
+
+void SRMesh::updateFaceBVHLeaf(AFace* aface)
+{
+    Point p0 = getDrawnPoint(getAVertex(aface->v0));
+    Point p1 = getDrawnPoint(getAVertex(aface->v1));
+    Point p2 = getDrawnPoint(getAVertex(aface->v2));
+
+    if (aface->bvhLeaf)
+        bvh->update(aface->bvhLeaf, p0, p1, p2);
+    else
+        aface->bvhLeaf = bvh->insert(aface, p0, p1, p2);
+}
+
+void SRMesh::updateFaceBVH()
+{
+    TStrip* tstrip;
+    AFace* aface;
+    bool all = bvhRebuild;
+
+    if (bvhRebuild)
+    {
+        bvh->clear();
+        bvhRebuild = false;
+    }
+
+#ifdef VDPM_TSTRIP_RESTRIP_ALL
+    // every strip is rebuilt when anything changed, and morphing faces are not kept apart
+    if (tstripDirty)
+        all = true;
+#ifdef VDPM_GEOMORPHS
+    if (vmorphCount > 0)
+        all = true;
+#endif
+#endif // VDPM_TSTRIP_RESTRIP_ALL
+
+    // new faces and faces whose vertices changed are waiting to be stripped
+    for (aface = getAFace(afaces->next); aface != afacesEnd; aface = getAFace(aface->next))
+        updateFaceBVHLeaf(aface);
+
+    if (all)
+    {
+        for (tstrip = tstrips.next; tstrip != &tstripsEnd; tstrip = tstrip->next)
+        {
+            for (aface = tstrip->afaces; aface; aface = getAFace(aface->next))
+                updateFaceBVHLeaf(aface);
+        }
+    }
+
+#if defined(VDPM_GEOMORPHS) && !defined(VDPM_TSTRIP_RESTRIP_ALL)
+    // faces around morphing vertices move every frame
+    for (tstrip = gmorphTstrips.next; tstrip != &gmorphTstripsEnd; tstrip = tstrip->next)
+    {
+        for (aface = tstrip->afaces; aface; aface = getAFace(aface->next))
+            updateFaceBVHLeaf(aface);
+    }
+#endif
+}
+#endif // VDPM_FACE_BVH
+
 #ifdef VDPM_AMORTIZATION
 
 void SRMesh::setAmortizeStep(unsigned int step)
@@ -210,6 +566,27 @@ void SRMesh::setAmortizeStep(unsigned int step)
 }
 #endif
 
+#ifdef VDPM_HYSTERESIS
+
+void SRMesh::setMergeTauScale(float scale)
+{
+    if (scale <= 0.0f || scale > 1.0f)
+        return;
+
+    mergeTauScale = scale;
+}
+
+void SRMesh::setCooldown(unsigned int frames)
+{
+    cooldown = frames;
+}
+#endif // VDPM_HYSTERESIS
+
+void SRMesh::resetChurnStats()
+{
+    ::memset(&churnStats, 0, sizeof(churnStats));
+}
+
 #ifdef VDPM_GEOMORPHS
 
 void SRMesh::setGTime(unsigned int gtime)
@@ -221,20 +598,15 @@ void SRMesh::setGTime(unsigned int gtime)
 }
 
 void SRMesh::updateVMorphs()
+{
+    (this->*updateVMorphsFunc)();
+}
+
+template<unsigned int N> void SRMesh::updateVMorphs()
 {
     VMorph* vmorph = vmorphs.next;
     Vertex* v_parent;
 
-    if (vmorph != &vmorphsEnd && !vmorphVgeoms)
-    {
-    #ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-        geometry.mapVGeom();
-        vmorphVgeoms = getVGeom(vcount);
-    #else
-        vmorphVgeoms = (VGeom*)renderer->mapBuffer(RENDERER_VERTEX_BUFFER, geometry.vbo, geometry.vgeomSize * vcount, geometry.vgeomSize * vmorphSize, RENDERER_WRITE_ONLY);
-    #endif // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-    }
-
     while (vmorph != &vmorphsEnd)
     {
         assert(vmorph->prev);
@@ -243,7 +615,7 @@ void SRMesh::updateVMorphs()
         {
             if (vmorph->coarsening)
             {
-                v_parent = vmorph->avertex->vertex->parent;
+                v_parent = getVertex(getVertex(vmorph->avertex->vertex)->parent);
 
                 if (v_parent && ecolLegal(v_parent))
                 {
@@ -290,9 +662,9 @@ void SRMesh::updateVMorphs()
 
             if (vmorph->coarsening)
             {
-                Vertex* v_parent = vmorph->avertex->vertex->parent;
+                Vertex* v_parent = getVertex(getVertex(vmorph->avertex->vertex)->parent);
                 if (v_parent->avertex)
-                    vgeom = getVGeom(v_parent->avertex->i);
+                    vgeom = getVGeom(getAVertex(v_parent->avertex)->i);
                 else
                     vgeom = getVGeom(getVGeomIndex(v_parent));
             }
@@ -301,28 +673,8 @@ void SRMesh::updateVMorphs()
                 vgeom = getVGeom(vmorph->avertex->i);
             }
 
-            vmorphVgeom->point = vgeom->point - vmorph->vgInc.point * (float)t;
-            vmorphVgeom->normal = vgeom->normal - vmorph->vgInc.normal * (float)t;
-
-            if (hasColor())
-            {
-                float* vmorphVgeomColor = geometry.getVGeomColor(vmorphVgeom);
-                float* vgeomColor = geometry.getVGeomColor(vgeom);
-                float* vgIncColor = geometry.getVGeomColor(&vmorph->vgInc);
-
-                for (int i = 0; i < 3; ++i)
-                    vmorphVgeomColor[i] = vgeomColor[i] - vgIncColor[i] * t;
-            }
-
-            if (hasTexCoord())
-            {
-                float* vmorphVgeomTexCoord = geometry.getVGeomTexCoord(vmorphVgeom);
-                float* vgeomTexCoord = geometry.getVGeomTexCoord(vgeom);
-                float* vgIncTexCoord = geometry.getVGeomTexCoord(&vmorph->vgInc);
-
-                for (int i = 0; i < 2; ++i)
-                    vmorphVgeomTexCoord[i] = vgeomTexCoord[i] - vgIncTexCoord[i] * t;
-            }
+            VGeomKernels<N>::morph(vmorphVgeom, vgeom, &vmorph->vgInc, (float)t);
+            geometry.setDirty(vmorph->vgIndex);
             --vmorph->gtime;
             vmorph = vmorph->next;
             assert(vmorph->prev);
@@ -344,45 +696,50 @@ void SRMesh::adaptRefine()
 {
     Vertex* vs;
     AVertex* avertex;
+#if defined(VDPM_HYSTERESIS) && defined(VDPM_GEOMORPHS)
+    float mergeKappa2 = kappa2 * mergeTauScale * mergeTauScale;
+#endif
+
+#ifdef VDPM_HYSTERESIS
+    ++refineFrame;
+#endif
+
+#ifdef VDPM_IMPORTANCE_REGIONS
+    updateImportance();
+#endif
 
 #ifdef VDPM_AMORTIZATION
-    if (amortizeAvertex == &averticesEnd)
+    if (amortizeAvertex == averticesEnd)
     {
-        amortizeAvertex = avertices.next;
+        amortizeAvertex = getAVertex(avertices->next);
         amortizeBudget = avertexCount / amortizeStep;
     }
     amortizeCount = 0;
     avertex = amortizeAvertex;
 #else
-    avertex = avertices.next;
+    avertex = getAVertex(avertices->next);
 
 #endif // VDPM_AMORTIZATION
 
-#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-    if (avertex != &averticesEnd && !geometry.vgeoms)
-    {
-        geometry.mapVGeom();
-    #ifdef VDPM_GEOMORPHS
-        vmorphVgeoms = getVGeom(vcount);
-    #endif
-    }
-#endif // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-
 #ifdef VDPM_PREDICT_VIEW_POSITION
-    viewport->predictViewPos = viewport->viewPos + viewport->delta_e * gtime;
+#ifdef VDPM_GEOMORPHS
+    viewport->predictViewPosition(gtime);
+#else
+    viewport->predictViewPosition(1);
 #endif
+#endif // VDPM_PREDICT_VIEW_POSITION
 
 #ifndef NDEBUG
     assertAVertices();
 #endif
 
-    while (avertex != &averticesEnd
+    while (avertex != averticesEnd
     #ifdef VDPM_AMORTIZATION
         && amortizeCount++ <= amortizeBudget
     #endif
         )
     {
-        vs = avertex->vertex;
+        vs = getVertex(avertex->vertex);
     #ifdef VDPM_GEOMORPHS
         VMorph* vmorph = avertex->vmorph;
     #endif
@@ -393,19 +750,24 @@ void SRMesh::adaptRefine()
         #endif
             screenErrorIllegal(vs))
         {
+        #ifdef VDPM_HYSTERESIS
+            if (vertexHolds[vs - vertices] > refineFrame)
+                ++churnStats.suppressed;
+            else
+        #endif
         #ifdef VDPM_REGULATION_FORCE
             if (afaceCount < targetAFaceCount)
         #endif
             forceVSplit(vs);
 
             assert(avertex->next);
-            avertex = avertex->next;
+            avertex = getAVertex(avertex->next);
         }
-        else if (vs->parent && ecolLegal(vs->parent))
+        else if (vs->parent && ecolLegal(getVertex(vs->parent)))
         {
-            if (outsideViewFrustum(vs->parent)
+            if (outsideViewFrustum(getVertex(vs->parent))
             #ifdef VDPM_ORIENTED_AWAY
-                || orientedAway(vs->parent)
+                || orientedAway(getVertex(vs->parent))
             #endif
                 )
             {
@@ -415,12 +777,12 @@ void SRMesh::adaptRefine()
                     if (finishCoarsening(avertex))
                     {
                         assert(avertex->next);
-                        avertex = avertex->next;
-                        ecol(vs->parent);
+                        avertex = getAVertex(avertex->next);
+                        ecol(getVertex(vs->parent));
                     }
                     else
                     {
-                        avertex = avertex->next;
+                        avertex = getAVertex(avertex->next);
                     }
                 }
                 else if (!vmorph)
@@ -428,34 +790,34 @@ void SRMesh::adaptRefine()
                     if (finishCoarsening(avertex))
                     {
                         assert(avertex->next);
-                        avertex = avertex->next;
-                        ecol(vs->parent);
+                        avertex = getAVertex(avertex->next);
+                        ecol(getVertex(vs->parent));
                     }
                     else
                     {
                         assert(avertex->next);
-                        avertex = avertex->next;
+                        avertex = getAVertex(avertex->next);
                     }
                 }
                 else
                 {
                     assert(avertex->next);
-                    avertex = avertex->next;
+                    avertex = getAVertex(avertex->next);
                 }
             #else
                 assert(avertex->next);
-                avertex = avertex->next;
-                ecol(vs->parent);
+                avertex = getAVertex(avertex->next);
+                ecol(getVertex(vs->parent));
             #endif // VDPM_GEOMORPHS
             }
         #ifdef VDPM_GEOMORPHS
-            else if (screenErrorIllegal(vs->parent))
+            else if (screenErrorIllegal(getVertex(vs->parent)))
             {
                 if (vmorph && vmorph->coarsening)
                     abortCoarsening(avertex);
 
                 assert(avertex->next);
-                avertex = avertex->next;
+                avertex = getAVertex(avertex->next);
             }
             else if (vmorph && vmorph->coarsening)
             {
@@ -464,29 +826,38 @@ void SRMesh::adaptRefine()
                     if (finishCoarsening(avertex))
                     {
                         assert(avertex->next);
-                        avertex = avertex->next;
-                        ecol(vs->parent);
+                        avertex = getAVertex(avertex->next);
+                        ecol(getVertex(vs->parent));
                     }
                     else
                     {
                         assert(avertex->next);
-                        avertex = avertex->next;
+                        avertex = getAVertex(avertex->next);
                     }
                 }
                 else
                 {
-                    avertex = avertex->next;
+                    avertex = getAVertex(avertex->next);
                     assert(avertex);
                 }
             }
+        #ifdef VDPM_HYSTERESIS
+            else if (vertexHolds[getVertex(vs->parent) - vertices] > refineFrame || screenErrorIllegal(getVertex(vs->parent), mergeKappa2))
+            {
+                // inside the band or cooling down
+                ++churnStats.suppressed;
+                assert(avertex->next);
+                avertex = getAVertex(avertex->next);
+            }
+        #endif
         #endif // VDPM_GEOMORPHS
             else
             {
             #ifdef VDPM_GEOMORPHS
-                startCoarsening(vs->parent);
+                startCoarsening(getVertex(vs->parent));
             #endif
                 assert(avertex->next);
-                avertex = avertex->next;
+                avertex = getAVertex(avertex->next);
             }
         }
     #ifdef VDPM_GEOMORPHS
@@ -494,13 +865,13 @@ void SRMesh::adaptRefine()
         {
             abortCoarsening(avertex);
             assert(avertex->next);
-            avertex = avertex->next;
+            avertex = getAVertex(avertex->next);
         }
     #endif // VDPM_GEOMORPHS
         else
         {
             assert(avertex->next);
-            avertex = avertex->next;
+            avertex = getAVertex(avertex->next);
         }
     }
 
@@ -527,24 +898,12 @@ void SRMesh::updateScene()
     AFace* aface;
     bool updated = false;
 
-#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-    if (geometry.vgeoms)
-    {
-        geometry.unmapVGeom();
-    #ifdef VDPM_GEOMORPHS
-        vmorphVgeoms = NULL;
-    #endif
-    }
-#else
-#ifdef VDPM_GEOMORPHS
-    if (vmorphVgeoms)
-    {
-        renderer->flushBuffer(RENDERER_VERTEX_BUFFER, geometry.vbo, geometry.vgeomSize * vcount, geometry.vgeomSize * vmorphSize);
-        renderer->unmapBuffer(RENDERER_VERTEX_BUFFER, geometry.vbo);
-        vmorphVgeoms = NULL;
-    }
-#endif // VDPM_GEOMORPHS
-#endif // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
+#ifdef VDPM_FACE_BVH
+    if (bvh)
+        updateFaceBVH();
+#endif
+
+    geometry.upload();
 
 #ifdef VDPM_TSTRIP_RESTRIP_ALL
     if (!tstripDirty)
@@ -553,7 +912,7 @@ void SRMesh::updateScene()
     tstrip = tstrips.next;
     while (tstrip != &tstripsEnd)
     {
-        allocator->freeTStrip(tstrip, afaces);
+        freeTStrip(tstrip);
         tstrip = tstrips.next;
     }
     tstripCount = 0;
@@ -567,7 +926,7 @@ void SRMesh::updateScene()
         assert(tstrip->gtime != USHRT_MAX);
         if (tstrip->gtime <= 0)
         {
-            allocator->freeTStrip(tstrip, afaces);
+            freeTStrip(tstrip);
             --tstripCount;
         }
         --tstrip->gtime;
@@ -575,8 +934,8 @@ void SRMesh::updateScene()
     }
 #endif // VDPM_TSTRIP_RESTRIP_ALL
 
-    aface = afaces.next;
-    while (aface != &afacesEnd)
+    aface = getAFace(afaces->next);
+    while (aface != afacesEnd)
     {
         AFace *afaceNext, *afacePrev;
         unsigned int indicesBufferTop;
@@ -589,45 +948,45 @@ void SRMesh::updateScene()
         oddStrip = true;    // three ways of exit as default
         afacePrev = aface;
 
-        tstrip = allocator->allocTStrip();
+        tstrip = allocTStrip();
         ++tstripCount;
 
     #if defined(VDPM_GEOMORPHS) && !defined(VDPM_TSTRIP_RESTRIP_ALL)
         tstrip->gtime = USHRT_MAX;
     #endif
 
-        while (afacePrev != &afacesEnd)
+        while (afacePrev != afacesEnd)
         {
-            noExit0 = !afacePrev->n0 || afacePrev->n0->tstrip;
-            noExit1 = !afacePrev->n1 || afacePrev->n1->tstrip;
+            noExit0 = !afacePrev->n0 || getAFace(afacePrev->n0)->tstrip;
+            noExit1 = !afacePrev->n1 || getAFace(afacePrev->n1)->tstrip;
             if (noExit0 && noExit1)
             {
-                indicesBuffer[0] = getVertexIndex(afacePrev->v1, tstrip);
-                indicesBuffer[1] = getVertexIndex(afacePrev->v2, tstrip);
-                indicesBuffer[2] = getVertexIndex(afacePrev->v0, tstrip);
+                indicesBuffer[0] = getVertexIndex(getAVertex(afacePrev->v1), tstrip);
+                indicesBuffer[1] = getVertexIndex(getAVertex(afacePrev->v2), tstrip);
+                indicesBuffer[2] = getVertexIndex(getAVertex(afacePrev->v0), tstrip);
                 aface = afacePrev;
-                afaceNext = afacePrev->n2;
+                afaceNext = getAFace(afacePrev->n2);
                 oddStrip = false;
                 break;
             }
-            noExit2 = !afacePrev->n2 || afacePrev->n2->tstrip;
+            noExit2 = !afacePrev->n2 || getAFace(afacePrev->n2)->tstrip;
             if (noExit0 && noExit2)
             {
-                indicesBuffer[0] = getVertexIndex(afacePrev->v0, tstrip);
-                indicesBuffer[1] = getVertexIndex(afacePrev->v1, tstrip);
-                indicesBuffer[2] = getVertexIndex(afacePrev->v2, tstrip);
+                indicesBuffer[0] = getVertexIndex(getAVertex(afacePrev->v0), tstrip);
+                indicesBuffer[1] = getVertexIndex(getAVertex(afacePrev->v1), tstrip);
+                indicesBuffer[2] = getVertexIndex(getAVertex(afacePrev->v2), tstrip);
                 aface = afacePrev;
-                afaceNext = afacePrev->n1;
+                afaceNext = getAFace(afacePrev->n1);
                 oddStrip = false;
                 break;
             }
             else if (noExit1 && noExit2)
             {
-                indicesBuffer[0] = getVertexIndex(afacePrev->v2, tstrip);
-                indicesBuffer[1] = getVertexIndex(afacePrev->v0, tstrip);
-                indicesBuffer[2] = getVertexIndex(afacePrev->v1, tstrip);
+                indicesBuffer[0] = getVertexIndex(getAVertex(afacePrev->v2), tstrip);
+                indicesBuffer[1] = getVertexIndex(getAVertex(afacePrev->v0), tstrip);
+                indicesBuffer[2] = getVertexIndex(getAVertex(afacePrev->v1), tstrip);
                 aface = afacePrev;
-                afaceNext = afacePrev->n0;
+                afaceNext = getAFace(afacePrev->n0);
                 oddStrip = false;
                 break;
             }
@@ -635,41 +994,41 @@ void SRMesh::updateScene()
             {
                 if (noExit0)    // set n1 as exit
                 {
-                    indicesBuffer[0] = getVertexIndex(afacePrev->v0, tstrip);
-                    indicesBuffer[1] = getVertexIndex(afacePrev->v1, tstrip);
-                    indicesBuffer[2] = getVertexIndex(afacePrev->v2, tstrip);
+                    indicesBuffer[0] = getVertexIndex(getAVertex(afacePrev->v0), tstrip);
+                    indicesBuffer[1] = getVertexIndex(getAVertex(afacePrev->v1), tstrip);
+                    indicesBuffer[2] = getVertexIndex(getAVertex(afacePrev->v2), tstrip);
                     aface = afacePrev;
-                    afaceNext = afacePrev->n1;
+                    afaceNext = getAFace(afacePrev->n1);
                     oddStrip = false;
                 }
                 else if (noExit1)    // set n2 as exit
                 {
-                    indicesBuffer[0] = getVertexIndex(afacePrev->v1, tstrip);
-                    indicesBuffer[1] = getVertexIndex(afacePrev->v2, tstrip);
-                    indicesBuffer[2] = getVertexIndex(afacePrev->v0, tstrip);
+                    indicesBuffer[0] = getVertexIndex(getAVertex(afacePrev->v1), tstrip);
+                    indicesBuffer[1] = getVertexIndex(getAVertex(afacePrev->v2), tstrip);
+                    indicesBuffer[2] = getVertexIndex(getAVertex(afacePrev->v0), tstrip);
                     aface = afacePrev;
-                    afaceNext = afacePrev->n2;
+                    afaceNext = getAFace(afacePrev->n2);
                     oddStrip = false;
                 }
                 else if (noExit2)    // set n0 as exit
                 {
-                    indicesBuffer[0] = getVertexIndex(afacePrev->v2, tstrip);
-                    indicesBuffer[1] = getVertexIndex(afacePrev->v0, tstrip);
-                    indicesBuffer[2] = getVertexIndex(afacePrev->v1, tstrip);
+                    indicesBuffer[0] = getVertexIndex(getAVertex(afacePrev->v2), tstrip);
+                    indicesBuffer[1] = getVertexIndex(getAVertex(afacePrev->v0), tstrip);
+                    indicesBuffer[2] = getVertexIndex(getAVertex(afacePrev->v1), tstrip);
                     aface = afacePrev;
-                    afaceNext = afacePrev->n0;
+                    afaceNext = getAFace(afacePrev->n0);
                     oddStrip = false;
                 }
             }
-            afacePrev = afacePrev->next;
+            afacePrev = getAFace(afacePrev->next);
         }
         if (oddStrip)
         {
-            aface = afaces.next;
-            indicesBuffer[0] = getVertexIndex(aface->v0, tstrip);
-            indicesBuffer[1] = getVertexIndex(aface->v1, tstrip);
-            indicesBuffer[2] = getVertexIndex(aface->v2, tstrip);
-            afaceNext = aface->n1;
+            aface = getAFace(afaces->next);
+            indicesBuffer[0] = getVertexIndex(getAVertex(aface->v0), tstrip);
+            indicesBuffer[1] = getVertexIndex(getAVertex(aface->v1), tstrip);
+            indicesBuffer[2] = getVertexIndex(getAVertex(aface->v2), tstrip);
+            afaceNext = getAFace(aface->n1);
         }
         else
             oddStrip = true;
@@ -678,9 +1037,9 @@ void SRMesh::updateScene()
         assert(aface->next != NULL);
 
         indicesBufferTop = 2;
-        aface->prev->next = aface->next;
-        aface->next->prev = aface->prev;
-        aface->tstrip = tstrip;
+        getAFace(aface->prev)->next = aface->next;
+        getAFace(aface->next)->prev = aface->prev;
+        aface->tstrip = ref(tstrip);
         tstrip->afaces = aface;
         updated = true;
 
@@ -699,10 +1058,10 @@ void SRMesh::updateScene()
             if (!swapped)
         #endif
             {
-                afaceNext->prev->next = afaceNext->next;
-                afaceNext->next->prev = afaceNext->prev;
-                aface->next = afaceNext;
-                afaceNext->prev = aface;
+                getAFace(afaceNext->prev)->next = afaceNext->next;
+                getAFace(afaceNext->next)->prev = afaceNext->prev;
+                aface->next = ref(afaceNext);
+                afaceNext->prev = ref(aface);
 
                 afacePrev = aface;
                 aface = afaceNext;
@@ -712,49 +1071,49 @@ void SRMesh::updateScene()
             {
                 oddStrip = false;
 
-                if (afacePrev == afaceNext->n0)
+                if (afacePrev == getAFace(afaceNext->n0))
                 {
                 #ifdef VDPM_TSTRIP_SWAP
-                    if (swapped || (afaceNext->n2 && !afaceNext->n2->tstrip))
+                    if (swapped || (afaceNext->n2 && !getAFace(afaceNext->n2)->tstrip))
                     {
-                        i = getVertexIndex(afaceNext->v2, tstrip);
-                        afaceNext = afaceNext->n2;
+                        i = getVertexIndex(getAVertex(afaceNext->v2), tstrip);
+                        afaceNext = getAFace(afaceNext->n2);
                         swapped = false;
                     }
-                    else if (afaceNext->n1 && !afaceNext->n1->tstrip)
+                    else if (afaceNext->n1 && !getAFace(afaceNext->n1)->tstrip)
                     {
-                        i = getVertexIndex(afaceNext->v1, tstrip);
+                        i = getVertexIndex(getAVertex(afaceNext->v1), tstrip);
                         swapped = true;
                     }
                     else
                     {
                 #endif // VDPM_TSTRIP_SWAP
-                        i = getVertexIndex(afaceNext->v2, tstrip);
-                        afaceNext = afaceNext->n2;
+                        i = getVertexIndex(getAVertex(afaceNext->v2), tstrip);
+                        afaceNext = getAFace(afaceNext->n2);
                 #ifdef VDPM_TSTRIP_SWAP
                         swapped = false;
                     }
                 #endif // VDPM_TSTRIP_SWAP
                 }
-                else if (afacePrev == afaceNext->n1)
+                else if (afacePrev == getAFace(afaceNext->n1))
                 {
                 #ifdef VDPM_TSTRIP_SWAP
-                    if (swapped || (afaceNext->n0 && !afaceNext->n0->tstrip))
+                    if (swapped || (afaceNext->n0 && !getAFace(afaceNext->n0)->tstrip))
                     {
-                        i = getVertexIndex(afaceNext->v0, tstrip);
-                        afaceNext = afaceNext->n0;
+                        i = getVertexIndex(getAVertex(afaceNext->v0), tstrip);
+                        afaceNext = getAFace(afaceNext->n0);
                         swapped = false;
                     }
-                    else if (afaceNext->n2 && !afaceNext->n2->tstrip)
+                    else if (afaceNext->n2 && !getAFace(afaceNext->n2)->tstrip)
                     {
-                        i = getVertexIndex(afaceNext->v2, tstrip);
+                        i = getVertexIndex(getAVertex(afaceNext->v2), tstrip);
                         swapped = true;
                     }
                     else
                     {
                 #endif // VDPM_TSTRIP_SWAP
-                        i = getVertexIndex(afaceNext->v0, tstrip);
-                        afaceNext = afaceNext->n0;
+                        i = getVertexIndex(getAVertex(afaceNext->v0), tstrip);
+                        afaceNext = getAFace(afaceNext->n0);
                 #ifdef VDPM_TSTRIP_SWAP
                         swapped = false;
                     }
@@ -764,22 +1123,22 @@ void SRMesh::updateScene()
                 {
                     //assert(afacePrev == afaceNext->n2);
                 #ifdef VDPM_TSTRIP_SWAP
-                    if (swapped || (afaceNext->n2 && !afaceNext->n2->tstrip))
+                    if (swapped || (afaceNext->n2 && !getAFace(afaceNext->n2)->tstrip))
                     {
-                        i = getVertexIndex(afaceNext->v1, tstrip);
-                        afaceNext = afaceNext->n1;
+                        i = getVertexIndex(getAVertex(afaceNext->v1), tstrip);
+                        afaceNext = getAFace(afaceNext->n1);
                         swapped = false;
                     }
-                    else if (afaceNext->n0 && !afaceNext->n0->tstrip)
+                    else if (afaceNext->n0 && !getAFace(afaceNext->n0)->tstrip)
                     {
-                        i = getVertexIndex(afaceNext->v0, tstrip);
+                        i = getVertexIndex(getAVertex(afaceNext->v0), tstrip);
                         swapped = true;
                     }
                     else
                     {
                 #endif // VDPM_TSTRIP_SWAP
-                        i = getVertexIndex(afaceNext->v1, tstrip);
-                        afaceNext = afaceNext->n1;
+                        i = getVertexIndex(getAVertex(afaceNext->v1), tstrip);
+                        afaceNext = getAFace(afaceNext->n1);
                 #ifdef VDPM_TSTRIP_SWAP
                         swapped = false;
                     }
@@ -790,49 +1149,49 @@ void SRMesh::updateScene()
             {
                 oddStrip = true;
 
-                if (afacePrev == afaceNext->n0)
+                if (afacePrev == getAFace(afaceNext->n0))
                 {
                 #ifdef VDPM_TSTRIP_SWAP
-                    if (swapped || (afaceNext->n1 && !afaceNext->n1->tstrip))
+                    if (swapped || (afaceNext->n1 && !getAFace(afaceNext->n1)->tstrip))
                     {
-                        i = getVertexIndex(afaceNext->v2, tstrip);
-                        afaceNext = afaceNext->n1;
+                        i = getVertexIndex(getAVertex(afaceNext->v2), tstrip);
+                        afaceNext = getAFace(afaceNext->n1);
                         swapped = false;
                     }
-                    else if (afaceNext->n2 && !afaceNext->n2->tstrip)
+                    else if (afaceNext->n2 && !getAFace(afaceNext->n2)->tstrip)
                     {
-                        i = getVertexIndex(afaceNext->v0, tstrip);
+                        i = getVertexIndex(getAVertex(afaceNext->v0), tstrip);
                         swapped = true;
                     }
                     else
                     {
                 #endif // VDPM_TSTRIP_SWAP
-                        i = getVertexIndex(afaceNext->v2, tstrip);
-                        afaceNext = afaceNext->n1;
+                        i = getVertexIndex(getAVertex(afaceNext->v2), tstrip);
+                        afaceNext = getAFace(afaceNext->n1);
                 #ifdef VDPM_TSTRIP_SWAP
                         swapped = false;
                     }
                 #endif // VDPM_TSTRIP_SWAP
                 }
-                else if (afacePrev == afaceNext->n2)
+                else if (afacePrev == getAFace(afaceNext->n2))
                 {
                 #ifdef VDPM_TSTRIP_SWAP
-                    if (swapped || (afaceNext->n0 && !afaceNext->n0->tstrip))
+                    if (swapped || (afaceNext->n0 && !getAFace(afaceNext->n0)->tstrip))
                     {
-                        i = getVertexIndex(afaceNext->v1, tstrip);
-                        afaceNext = afaceNext->n0;
+                        i = getVertexIndex(getAVertex(afaceNext->v1), tstrip);
+                        afaceNext = getAFace(afaceNext->n0);
                         swapped = false;
                     }
-                    else if (afaceNext->n1 && !afaceNext->n1->tstrip)
+                    else if (afaceNext->n1 && !getAFace(afaceNext->n1)->tstrip)
                     {
-                        i = getVertexIndex(afaceNext->v2, tstrip);
+                        i = getVertexIndex(getAVertex(afaceNext->v2), tstrip);
                         swapped = true;
                     }
                     else
                     {
                     #endif // VDPM_TSTRIP_SWAP
-                        i = getVertexIndex(afaceNext->v1, tstrip);
-                        afaceNext = afaceNext->n0;
+                        i = getVertexIndex(getAVertex(afaceNext->v1), tstrip);
+                        afaceNext = getAFace(afaceNext->n0);
                     #ifdef VDPM_TSTRIP_SWAP
                         swapped = false;
                         }
@@ -843,22 +1202,22 @@ void SRMesh::updateScene()
                     //assert(afacePrev == afaceNext->n1);
 
                 #ifdef VDPM_TSTRIP_SWAP
-                    if (swapped || (afaceNext->n2 && !afaceNext->n2->tstrip))
+                    if (swapped || (afaceNext->n2 && !getAFace(afaceNext->n2)->tstrip))
                     {
-                        i = getVertexIndex(afaceNext->v0, tstrip);
-                        afaceNext = afaceNext->n2;
+                        i = getVertexIndex(getAVertex(afaceNext->v0), tstrip);
+                        afaceNext = getAFace(afaceNext->n2);
                         swapped = false;
                     }
-                    else if (afaceNext->n0 && !afaceNext->n0->tstrip)
+                    else if (afaceNext->n0 && !getAFace(afaceNext->n0)->tstrip)
                     {
-                        i = getVertexIndex(afaceNext->v1, tstrip);
+                        i = getVertexIndex(getAVertex(afaceNext->v1), tstrip);
                         swapped = true;
                     }
                     else
                     {
                 #endif // VDPM_TSTRIP_SWAP
-                        i = getVertexIndex(afaceNext->v0, tstrip);
-                        afaceNext = afaceNext->n2;
+                        i = getVertexIndex(getAVertex(afaceNext->v0), tstrip);
+                        afaceNext = getAFace(afaceNext->n2);
                 #ifdef VDPM_TSTRIP_SWAP
                         swapped = false;
                     }
@@ -870,7 +1229,7 @@ void SRMesh::updateScene()
             if (!swapped)
         #endif
             {
-                aface->tstrip = tstrip;
+                aface->tstrip = ref(tstrip);
             }
             indicesBuffer[++indicesBufferTop] = i;
         }
@@ -890,7 +1249,7 @@ void SRMesh::updateScene()
         tstrip->vgIndices = new unsigned int[tstrip->vgCount];
         ::memcpy(tstrip->vgIndices, indicesBuffer, tstrip->vgCount * sizeof(unsigned int));
 
-        aface = afaces.next;
+        aface = getAFace(afaces->next);
     }
 
     if (updated)
@@ -956,6 +1315,7 @@ void SRMesh::updateScene()
         renderer->unmapBuffer(RENDERER_INDEX_BUFFER, ibo);
 
     #endif // VDPM_RENDERER_OPENGL_IBO
+        renderer->updateDrawCommands(this);
     }
 }
 
@@ -964,6 +1324,333 @@ void SRMesh::draw()
     renderer->draw(this);
 }
 
+unsigned int SRMesh::getActiveFrontSize()
+{
+    return (vsplitCount + 31) / 32;
+}
+
+void SRMesh::saveActiveFront(uint32_t* front)
+{
+    unsigned int i;
+    Face* fl;
+
+    ::memset(front, 0, sizeof(uint32_t) * getActiveFrontSize());
+
+    // the active front is fully described by the set of applied vsplits,
+    // and a vsplit is applied iff one of its faces fl, fr is active
+    fl = &faces[baseFCount];
+    for (i = 0; i < vsplitCount; ++i, fl += 2)
+    {
+        if (fl->aface || (fl + 1)->aface)
+            front[i >> 5] |= 1u << (i & 31);
+    }
+}
+
+int SRMesh::restoreActiveFront(const uint32_t* front)
+{
+    unsigned int i;
+
+    // the restored front is geomorph-free and restripped once by updateScene()
+    resetScene();
+
+    // collapse what the saved front lacks, in reverse refinement order so dependents go first
+    collapseOutsideFront(front);
+
+#ifdef VDPM_GEOMORPHS
+    vmorphsSuppressed = true;
+#endif
+
+    // split in refinement order, which meets the prerequisites of the saved vsplits on the way
+    for (i = 0; i < vsplitCount; ++i)
+    {
+        if (!(front[i >> 5] & (1u << (i & 31))))
+            continue;
+
+    #ifdef VDPM_STREAMING
+        // the record of this vsplit has not arrived
+        if (!vertices[baseVCount + i * 2].parent)
+            continue;
+    #endif
+        forceVSplit(getVertex(vertices[baseVCount + i * 2].parent));
+    }
+
+#ifdef VDPM_GEOMORPHS
+    vmorphsSuppressed = false;
+#endif
+
+#ifdef VDPM_AMORTIZATION
+    amortizeAvertex = averticesEnd;
+#endif
+
+    // prerequisites can be collapsed again once their dependents are split, so a saved
+    // front need not be closed; this collapses the ones it had dropped
+    return collapseOutsideFront(front) ? -1 : 0;
+}
+
+void SRMesh::refineImmediately(Viewport* viewport, float tau)
+{
+    unsigned int i;
+    Vertex* vs;
+    Face* fl;
+
+    setViewport(viewport);
+    setTau(tau);
+
+#ifdef VDPM_IMPORTANCE_REGIONS
+    updateImportance();
+#endif
+
+#ifdef VDPM_PREDICT_VIEW_POSITION
+    // nothing is morphing, so there is no travel time to refine ahead for
+    viewport->predictViewPosition(0);
+#endif
+
+    // without strips and geomorphs a vsplit or ecol only relinks faces; updateScene() restrips once
+    resetScene();
+
+    // coarsen first, in reverse refinement order, so refining below has the face budget
+    for (i = vsplitCount; i-- > 0;)
+    {
+        fl = &faces[baseFCount + i * 2];
+        if (!fl->aface && !(fl + 1)->aface)
+            continue;
+
+        vs = getVertex(vertices[baseVCount + i * 2].parent);
+
+        if ((outsideViewFrustum(vs) ||
+        #ifdef VDPM_ORIENTED_AWAY
+            orientedAway(vs) ||
+        #endif
+            !screenErrorIllegal(vs)) && ecolLegal(vs))
+        {
+            ecol(vs);
+        }
+    }
+
+#ifdef VDPM_GEOMORPHS
+    vmorphsSuppressed = true;
+#endif
+
+    // a vertex is created before its own vsplit in refinement order, so one pass reaches every level
+    for (i = 0; i < vsplitCount; ++i)
+    {
+        fl = &faces[baseFCount + i * 2];
+        if (fl->aface || (fl + 1)->aface)
+            continue;
+
+        vs = getVertex(vertices[baseVCount + i * 2].parent);
+    #ifdef VDPM_STREAMING
+        if (!vs)
+            continue;
+    #endif
+        if (!vs->avertex)
+            continue;
+
+        if (outsideViewFrustum(vs) ||
+        #ifdef VDPM_ORIENTED_AWAY
+            orientedAway(vs) ||
+        #endif
+            !screenErrorIllegal(vs))
+        {
+            continue;
+        }
+
+    #ifdef VDPM_REGULATION
+        if (afaceCount >= targetAFaceCount)
+            break;
+    #endif
+
+        forceVSplit(vs);
+    }
+
+#ifdef VDPM_GEOMORPHS
+    vmorphsSuppressed = false;
+#endif
+
+#ifdef VDPM_AMORTIZATION
+    amortizeAvertex = averticesEnd;
+#endif
+}
+
+int SRMesh::splitInSequence(unsigned int i)
+{
+    Face* fl = &faces[baseFCount + i * 2];
+    Vertex* vs;
+
+    assert(i < vsplitCount);
+
+    if (fl->aface || (fl + 1)->aface)
+        return 0;
+
+    vs = getVertex(vertices[baseVCount + i * 2].parent);
+
+#ifdef VDPM_STREAMING
+    // the record of this vsplit has not arrived
+    if (!vs)
+        return 1;
+#endif
+
+    // the faces a vsplit needs are created by earlier ones, so it is legal in sequence order
+    if (!vs->avertex || !vsplitLegal(vs))
+        return -1;
+
+#ifdef VDPM_GEOMORPHS
+    vmorphsSuppressed = true;
+#endif
+    vsplit(vs);
+#ifdef VDPM_GEOMORPHS
+    vmorphsSuppressed = false;
+#endif
+    return 0;
+}
+
+void SRMesh::getAFaceVGeomIndices(uint32_t* indices)
+{
+    AFace* aface;
+
+    for (aface = getAFace(afaces->next); aface != afacesEnd; aface = getAFace(aface->next))
+    {
+        *indices++ = getAVertex(aface->v0)->i;
+        *indices++ = getAVertex(aface->v1)->i;
+        *indices++ = getAVertex(aface->v2)->i;
+    }
+}
+
+void SRMesh::copyVGeoms(const uint32_t* indices, unsigned int count, void* dst)
+{
+    uint8_t* p = (uint8_t*)dst;
+    unsigned int i;
+
+    for (i = 0; i < count; ++i, p += geometry.vgeomSize)
+        ::memcpy(p, getVGeom(indices[i]), geometry.vgeomSize);
+}
+
+#ifdef VDPM_STREAMING
+int SRMesh::addStreamedVSplit(unsigned int i, unsigned int vs_i, const unsigned int fn[4],
+    float radius, float sin2alpha, float uni_error, float dir_error, const VGeom* vt, const VGeom* vu)
+{
+    unsigned int vt_i = baseVCount + i * 2, j, k;
+    Vertex* vs;
+    FaceRef* fns[4];
+
+    if (!streamed || i >= vsplitCount || vs_i >= vt_i || vertices[vt_i].parent)
+        return -1;
+
+    // the parent vertex must exist and must not be split by another record
+    vs = &vertices[vs_i];
+    if ((vs_i >= baseVCount && !vs->parent) || vs->i != UINT_MAX)
+        return -1;
+
+    for (j = 0; j < 4; ++j)
+    {
+        if (fn[j] == UINT_MAX || fn[j] < baseFCount)
+            continue;
+
+        if (fn[j] >= fcount)
+            return -1;
+
+        // faces fl, fr of vsplit k are stored at baseFCount + k * 2
+        k = (fn[j] - baseFCount) >> 1;
+        if (!vertices[baseVCount + k * 2].parent)
+            return -1;
+    }
+
+    fns[0] = &vsplits[i].fn0;
+    fns[1] = &vsplits[i].fn1;
+    fns[2] = &vsplits[i].fn2;
+    fns[3] = &vsplits[i].fn3;
+
+    for (j = 0; j < 4; ++j)
+        *fns[j] = ref((fn[j] == UINT_MAX) ? NULL : &faces[fn[j]]);
+
+    vsplits[i].radius = radius;
+    vsplits[i].sin2alpha = sin2alpha;
+    vsplits[i].uni_error = uni_error;
+    vsplits[i].dir_error = dir_error;
+
+    ::memcpy(getVGeom(vt_i), vt, geometry.vgeomSize);
+    ::memcpy(getVGeom(vt_i + 1), vu, geometry.vgeomSize);
+
+    // sent to the vertex buffer by the next updateScene()
+    if (renderer)
+    {
+        geometry.setDirty(vt_i);
+        geometry.setDirty(vt_i + 1);
+    }
+
+    vertices[vt_i].parent = ref(vs);
+    vertices[vt_i + 1].parent = ref(vs);
+
+#ifdef VDPM_IMPORTANCE_REGIONS
+    if (vertexTauScales)
+        vertexTauScales[vt_i] = vertexTauScales[vt_i + 1] = vertexTauScales[vs_i];
+#endif
+
+#ifdef VDPM_VSPLIT_DEPENDENCIES
+    if (vsplitDeps)
+        setVSplitDependencies(i);
+#endif
+
+    // adaptRefine() splits a vertex only once it has a vsplit
+    vs->i = i;
+    ++streamedVSplitCount;
+    return 0;
+}
+#endif // VDPM_STREAMING
+
+unsigned int SRMesh::collapseOutsideFront(const uint32_t* front)
+{
+    unsigned int i, remains = 0;
+    Vertex* vs;
+    Face* fl;
+
+    for (i = vsplitCount; i-- > 0;)
+    {
+        if (front[i >> 5] & (1u << (i & 31)))
+            continue;
+
+        fl = &faces[baseFCount + i * 2];
+        if (!fl->aface && !(fl + 1)->aface)
+            continue;
+
+        vs = getVertex(vertices[baseVCount + i * 2].parent);
+        if (ecolLegal(vs))
+            ecol(vs);
+        else
+            ++remains;
+    }
+    return remains;
+}
+
+void SRMesh::resetScene()
+{
+    TStrip* tstrip;
+
+#ifdef VDPM_GEOMORPHS
+    while (vmorphs.next != &vmorphsEnd)
+        removeVMorph(vmorphs.next);
+
+    tstrip = gmorphTstrips.next;
+    while (tstrip != &gmorphTstripsEnd)
+    {
+        freeTStrip(tstrip);
+        tstrip = gmorphTstrips.next;
+    }
+#endif // VDPM_GEOMORPHS
+
+    tstrip = tstrips.next;
+    while (tstrip != &tstripsEnd)
+    {
+        freeTStrip(tstrip);
+        tstrip = tstrips.next;
+    }
+    tstripCount = 0;
+
+#ifdef VDPM_TSTRIP_RESTRIP_ALL
+    tstripDirty = true;
+#endif
+}
+
 void SRMesh::printStatus()
 {
     Log::println("vertices:");
@@ -992,13 +1679,13 @@ void SRMesh::printStatus()
     Log::println("active vertices:");
     AVertex *avertex, *avertexNext;
 
-    avertex = avertices.next;
-    while (avertex != &averticesEnd)
+    avertex = getAVertex(avertices->next);
+    while (avertex != averticesEnd)
     {
         unsigned int i = avertex->i;
         VGeom* vgeom = getVGeom(i);
 
-        avertexNext = avertex->next;
+        avertexNext = getAVertex(avertex->next);
 
         Log::println("v[%d] p:{%f %f %f}", i, vgeom->point.x, vgeom->point.y, vgeom->point.z);
 
@@ -1013,23 +1700,23 @@ void SRMesh::printStatus()
             char buf0[128], buf1[32];
 
             buf0[0] = '\0';
-            if (faces[i].aface->n0)
+            if (getAFace(faces[i].aface)->n0)
             {
-                sprintf(buf1, " n0:{%d %d %d}", faces[i].aface->n0->v0->i, faces[i].aface->n0->v1->i, faces[i].aface->n0->v2->i);
+                sprintf(buf1, " n0:{%d %d %d}", getAVertex(getAFace(getAFace(faces[i].aface)->n0)->v0)->i, getAVertex(getAFace(getAFace(faces[i].aface)->n0)->v1)->i, getAVertex(getAFace(getAFace(faces[i].aface)->n0)->v2)->i);
                 strcat(buf0, buf1);
             }
-            if (faces[i].aface->n1)
+            if (getAFace(faces[i].aface)->n1)
             {
-                sprintf(buf1, " n1:{%d %d %d}", faces[i].aface->n1->v0->i, faces[i].aface->n1->v1->i, faces[i].aface->n1->v2->i);
+                sprintf(buf1, " n1:{%d %d %d}", getAVertex(getAFace(getAFace(faces[i].aface)->n1)->v0)->i, getAVertex(getAFace(getAFace(faces[i].aface)->n1)->v1)->i, getAVertex(getAFace(getAFace(faces[i].aface)->n1)->v2)->i);
                 strcat(buf0, buf1);
             }
-            if (faces[i].aface->n2)
+            if (getAFace(faces[i].aface)->n2)
             {
-                sprintf(buf1, " n2:{%d %d %d}", faces[i].aface->n2->v0->i, faces[i].aface->n2->v1->i, faces[i].aface->n2->v2->i);
+                sprintf(buf1, " n2:{%d %d %d}", getAVertex(getAFace(getAFace(faces[i].aface)->n2)->v0)->i, getAVertex(getAFace(getAFace(faces[i].aface)->n2)->v1)->i, getAVertex(getAFace(getAFace(faces[i].aface)->n2)->v2)->i);
                 strcat(buf0, buf1);
             }
 
-            Log::println("f[%d] {%d %d %d}%s", i, faces[i].aface->v0->i, faces[i].aface->v1->i, faces[i].aface->v2->i, buf0);
+            Log::println("f[%d] {%d %d %d}%s", i, getAVertex(getAFace(faces[i].aface)->v0)->i, getAVertex(getAFace(faces[i].aface)->v1)->i, getAVertex(getAFace(faces[i].aface)->v2)->i, buf0);
         }
     }
 
@@ -1055,9 +1742,9 @@ void SRMesh::printStatus()
         aface = tstrip->afaces;
         while (aface != NULL)
         {
-            afaceNext = aface->next;
+            afaceNext = getAFace(aface->next);
 
-            sprintf(buf2, "{%d %d %d}", aface->v0->i, aface->v1->i, aface->v2->i);
+            sprintf(buf2, "{%d %d %d}", getAVertex(aface->v0)->i, getAVertex(aface->v1)->i, getAVertex(aface->v2)->i);
             strcat(buf1, buf2);
 
             aface = afaceNext;
@@ -1081,29 +1768,29 @@ void SRMesh::testEcol()
     AVertex *avertex, *avertexNext;
     unsigned int max_i = 0;
 
-    avertex = avertices.next;
-    while (avertex != &averticesEnd)
+    avertex = getAVertex(avertices->next);
+    while (avertex != averticesEnd)
     {
-        avertexNext = avertex->next;
-        if (avertex->i != (unsigned int)(-1) && avertex->i > max_i && avertex->vertex->parent && ecolLegal(avertex->vertex->parent))
+        avertexNext = getAVertex(avertex->next);
+        if (avertex->i != (unsigned int)(-1) && avertex->i > max_i && getVertex(avertex->vertex)->parent && ecolLegal(getVertex(getVertex(avertex->vertex)->parent)))
         {
             max_i = avertex->i;
         }
         avertex = avertexNext;
     }
 
-    avertex = avertices.next;
-    while (avertex != &averticesEnd)
+    avertex = getAVertex(avertices->next);
+    while (avertex != averticesEnd)
     {
-        avertexNext = avertex->next;
+        avertexNext = getAVertex(avertex->next);
         if (avertex->i == max_i)
         {
-            if (avertex->vertex->parent)
+            if (getVertex(avertex->vertex)->parent)
             {
             #ifdef VDPM_GEOMORPHS
-                startCoarsening(avertex->vertex->parent);
+                startCoarsening(getVertex(getVertex(avertex->vertex)->parent));
             #else
-                ecol(avertex->vertex->parent);
+                ecol(getVertex(getVertex(avertex->vertex)->parent));
             #endif
             }
             break;
@@ -1117,24 +1804,24 @@ void SRMesh::testVsplit()
     AVertex *avertex, *avertexNext;
     unsigned int min_i = UINT_MAX;
 
-    avertex = avertices.next;
-    while (avertex != &averticesEnd)
+    avertex = getAVertex(avertices->next);
+    while (avertex != averticesEnd)
     {
-        avertexNext = avertex->next;
-        if (avertex->vertex->i != -1 && avertex->vertex->i < min_i)
+        avertexNext = getAVertex(avertex->next);
+        if (getVertex(avertex->vertex)->i != -1 && getVertex(avertex->vertex)->i < min_i)
         {
-            min_i = avertex->vertex->i;
+            min_i = getVertex(avertex->vertex)->i;
         }
         avertex = avertexNext;
     }
 
-    avertex = avertices.next;
-    while (avertex != &averticesEnd)
+    avertex = getAVertex(avertices->next);
+    while (avertex != averticesEnd)
     {
-        avertexNext = avertex->next;
-        if (avertex->vertex->i == min_i)
+        avertexNext = getAVertex(avertex->next);
+        if (getVertex(avertex->vertex)->i == min_i)
         {
-            forceVSplit(avertex->vertex);
+            forceVSplit(getVertex(avertex->vertex));
             break;
         }
         avertex = avertexNext;
@@ -1149,15 +1836,15 @@ void SRMesh::vsplit(Vertex* vs)
     Face *fl, *fr;
     AVertex *vl, *vr;
     VSplit* vsp = &vsplits[vs->i];
-    unsigned int vs_vgeom_i = vs->avertex->i;
+    unsigned int vs_vgeom_i = getAVertex(vs->avertex)->i;
 
 #ifndef NDEBUG
     assertAFaces();
 #endif
-    fn0 = (vsp->fn0) ? vsp->fn0->aface : NULL;
-    fn1 = (vsp->fn1) ? vsp->fn1->aface : NULL;
-    fn2 = (vsp->fn2) ? vsp->fn2->aface : NULL;
-    fn3 = (vsp->fn3) ? vsp->fn3->aface : NULL;
+    fn0 = (vsp->fn0) ? getAFace(getFace(vsp->fn0)->aface) : NULL;
+    fn1 = (vsp->fn1) ? getAFace(getFace(vsp->fn1)->aface) : NULL;
+    fn2 = (vsp->fn2) ? getAFace(getFace(vsp->fn2)->aface) : NULL;
+    fn3 = (vsp->fn3) ? getAFace(getFace(vsp->fn3)->aface) : NULL;
 
     vt = &vertices[baseVCount + vs->i * 2];
     fl = &faces[baseFCount + vs->i * 2];
@@ -1166,13 +1853,13 @@ void SRMesh::vsplit(Vertex* vs)
     fr = fl + 1;
 
     vt->avertex = vs->avertex;
-    vu->avertex = allocator->allocAVertex();
+    vu->avertex = ref(allocAVertex());
     vs->avertex = NULL;
-    vt->avertex->vertex = vt;
-    vu->avertex->vertex = vu;
-    addAVertex(vu->avertex);
-    vt->avertex->i = vsp->vt_i;
-    vu->avertex->i = vsp->vu_i;
+    getAVertex(vt->avertex)->vertex = ref(vt);
+    getAVertex(vu->avertex)->vertex = ref(vu);
+    addAVertex(getAVertex(vu->avertex));
+    getAVertex(vt->avertex)->i = vsp->vt_i;
+    getAVertex(vu->avertex)->i = vsp->vu_i;
 
     // update fn0..fn3 by current active faces
     if (fn0)
@@ -1182,17 +1869,17 @@ void SRMesh::vsplit(Vertex* vs)
             if (vt->avertex == fn0->v0)
             {
                 if (fn0->n0)
-                    fn1 = fn0->n0;
+                    fn1 = getAFace(fn0->n0);
             }
             else if (vt->avertex == fn0->v1)
             {
                 if (fn0->n1)
-                    fn1 = fn0->n1;
+                    fn1 = getAFace(fn0->n1);
             }
             else
             {
                 if (fn0->n2)
-                    fn1 = fn0->n2;
+                    fn1 = getAFace(fn0->n2);
             }
         }
     }
@@ -1201,17 +1888,17 @@ void SRMesh::vsplit(Vertex* vs)
         if (vt->avertex == fn1->v0)
         {
             if (fn1->n2)
-                fn0 = fn1->n2;
+                fn0 = getAFace(fn1->n2);
         }
         else if (vt->avertex == fn1->v1)
         {
             if (fn1->n0)
-                fn0 = fn1->n0;
+                fn0 = getAFace(fn1->n0);
         }
         else
         {
             if (fn1->n1)
-                fn0 = fn1->n1;
+                fn0 = getAFace(fn1->n1);
         }
     }
     if (fn2)
@@ -1221,17 +1908,17 @@ void SRMesh::vsplit(Vertex* vs)
             if (vt->avertex == fn2->v0)
             {
                 if (fn2->n2)
-                    fn3 = fn2->n2;
+                    fn3 = getAFace(fn2->n2);
             }
             else if (vt->avertex == fn2->v1)
             {
                 if (fn2->n0)
-                    fn3 = fn2->n0;
+                    fn3 = getAFace(fn2->n0);
             }
             else
             {
                 if (fn2->n1)
-                    fn3 = fn2->n1;
+                    fn3 = getAFace(fn2->n1);
             }
         }
     }
@@ -1240,17 +1927,17 @@ void SRMesh::vsplit(Vertex* vs)
         if (vt->avertex == fn3->v0)
         {
             if (fn3->n0)
-                fn2 = fn3->n0;
+                fn2 = getAFace(fn3->n0);
         }
         else if (vt->avertex == fn3->v1)
         {
             if (fn3->n1)
-                fn2 = fn3->n1;
+                fn2 = getAFace(fn3->n1);
         }
         else
         {
             if (fn3->n2)
-                fn2 = fn3->n2;
+                fn2 = getAFace(fn3->n2);
         }
     }
 
@@ -1264,34 +1951,35 @@ void SRMesh::vsplit(Vertex* vs)
 
     if (fn0 || fn1)
     {
-        fl->aface = fl_aface = allocator->allocAFace();
+        fl_aface = allocAFace();
+        fl->aface = ref(fl_aface);
         addAFace(fl_aface);
 
         // find vl
         if (fn0)
         {
             if (vt->avertex == fn0->v0)
-                vl = fn0->v1;
+                vl = getAVertex(fn0->v1);
             else if (vt->avertex == fn0->v1)
-                vl = fn0->v2;
+                vl = getAVertex(fn0->v2);
             else
-                vl = fn0->v0;
+                vl = getAVertex(fn0->v0);
         }
         else
         {
             if (vt->avertex == fn1->v0)
-                vl = fn1->v2;
+                vl = getAVertex(fn1->v2);
             else if (vt->avertex == fn1->v1)
-                vl = fn1->v0;
+                vl = getAVertex(fn1->v0);
             else
-                vl = fn1->v1;
+                vl = getAVertex(fn1->v1);
         }
         // fill in entries of fl.aface
         fl_aface->v0 = vt->avertex;
         fl_aface->v1 = vu->avertex;
-        fl_aface->v2 = vl;
-        fl_aface->n1 = fn1;
-        fl_aface->n2 = fn0;
+        fl_aface->v2 = ref(vl);
+        fl_aface->n1 = ref(fn1);
+        fl_aface->n2 = ref(fn0);
         fl_aface->tstrip = NULL;
     }
     else
@@ -1299,34 +1987,35 @@ void SRMesh::vsplit(Vertex* vs)
 
     if (fn2 || fn3)
     {
-        fr->aface = fr_aface = allocator->allocAFace();
+        fr_aface = allocAFace();
+        fr->aface = ref(fr_aface);
         addAFace(fr_aface);
 
         // find vr
         if (fn2)
         {
             if (vt->avertex == fn2->v0)
-                vr = fn2->v2;
+                vr = getAVertex(fn2->v2);
             else if (vt->avertex == fn2->v1)
-                vr = fn2->v0;
+                vr = getAVertex(fn2->v0);
             else
-                vr = fn2->v1;
+                vr = getAVertex(fn2->v1);
         }
         else
         {
             if (vt->avertex == fn3->v0)
-                vr = fn3->v1;
+                vr = getAVertex(fn3->v1);
             else if (vt->avertex == fn3->v1)
-                vr = fn3->v2;
+                vr = getAVertex(fn3->v2);
             else
-                vr = fn3->v0;
+                vr = getAVertex(fn3->v0);
         }
         // fill in entries of fr.aface
         fr_aface->v0 = vt->avertex;
-        fr_aface->v1 = vr;
+        fr_aface->v1 = ref(vr);
         fr_aface->v2 = vu->avertex;
-        fr_aface->n0 = fn2;
-        fr_aface->n1 = fn3;
+        fr_aface->n0 = ref(fn2);
+        fr_aface->n1 = ref(fn3);
         fr_aface->tstrip = NULL;
     }
     else
@@ -1335,16 +2024,16 @@ void SRMesh::vsplit(Vertex* vs)
     // update fn0..3.neighbors[..] to point to fl, fr
     if (fl_aface)
     {
-        fl_aface->n0 = fr_aface;
+        fl_aface->n0 = ref(fr_aface);
 
         if (fn0)
         {
-            if (fn0->v0 == vl)
-                fn0->n2 = fl_aface;
-            else if (fn0->v1 == vl)
-                fn0->n0 = fl_aface;
+            if (getAVertex(fn0->v0) == vl)
+                fn0->n2 = ref(fl_aface);
+            else if (getAVertex(fn0->v1) == vl)
+                fn0->n0 = ref(fl_aface);
             else
-                fn0->n1 = fl_aface;
+                fn0->n1 = ref(fl_aface);
 
             assert(!fn0->n0 || (fn0->n0 != fn0->n1 && fn0->n0 != fn0->n2));
             assert(!fn0->n1 || (fn0->n1 != fn0->n0 && fn0->n1 != fn0->n2));
@@ -1352,33 +2041,33 @@ void SRMesh::vsplit(Vertex* vs)
         }
         if (fn1)
         {
-            if (fn1->v0 == vl)
-                fn1->n0 = fl_aface;
-            else if (fn1->v1 == vl)
-                fn1->n1 = fl_aface;
+            if (getAVertex(fn1->v0) == vl)
+                fn1->n0 = ref(fl_aface);
+            else if (getAVertex(fn1->v1) == vl)
+                fn1->n1 = ref(fl_aface);
             else
-                fn1->n2 = fl_aface;
+                fn1->n2 = ref(fl_aface);
 
             assert(!fn1->n0 || (fn1->n0 != fn1->n1 && fn1->n0 != fn1->n2));
             assert(!fn1->n1 || (fn1->n1 != fn1->n0 && fn1->n1 != fn1->n2));
             assert(!fn1->n2 || (fn1->n2 != fn1->n0 && fn1->n2 != fn1->n1));
         }
-        assert(!fn0 || !fn1 || (fn0->n0 != fn1 && fn0->n1 != fn1 && fn0->n2 != fn1));
-        assert(!fn0 || !fn1 || (fn1->n0 != fn0 && fn1->n1 != fn0 && fn1->n2 != fn0));
+        assert(!fn0 || !fn1 || (getAFace(fn0->n0) != fn1 && getAFace(fn0->n1) != fn1 && getAFace(fn0->n2) != fn1));
+        assert(!fn0 || !fn1 || (getAFace(fn1->n0) != fn0 && getAFace(fn1->n1) != fn0 && getAFace(fn1->n2) != fn0));
     }
 
     if (fr_aface)
     {
-        fr_aface->n2 = fl_aface;
+        fr_aface->n2 = ref(fl_aface);
 
         if (fn2)
         {
-            if (fn2->v0 == vr)
-                fn2->n0 = fr_aface;
-            else if (fn2->v1 == vr)
-                fn2->n1 = fr_aface;
+            if (getAVertex(fn2->v0) == vr)
+                fn2->n0 = ref(fr_aface);
+            else if (getAVertex(fn2->v1) == vr)
+                fn2->n1 = ref(fr_aface);
             else
-                fn2->n2 = fr_aface;
+                fn2->n2 = ref(fr_aface);
 
             assert(!fn2->n0 || (fn2->n0 != fn2->n1 && fn2->n0 != fn2->n2));
             assert(!fn2->n1 || (fn2->n1 != fn2->n0 && fn2->n1 != fn2->n2));
@@ -1386,27 +2075,27 @@ void SRMesh::vsplit(Vertex* vs)
         }
         if (fn3)
         {
-            if (fn3->v0 == vr)
-                fn3->n2 = fr_aface;
-            else if (fn3->v1 == vr)
-                fn3->n0 = fr_aface;
+            if (getAVertex(fn3->v0) == vr)
+                fn3->n2 = ref(fr_aface);
+            else if (getAVertex(fn3->v1) == vr)
+                fn3->n0 = ref(fr_aface);
             else
-                fn3->n1 = fr_aface;
+                fn3->n1 = ref(fr_aface);
 
             assert(!fn3->n0 || (fn3->n0 != fn3->n1 && fn3->n0 != fn3->n2));
             assert(!fn3->n1 || (fn3->n1 != fn3->n0 && fn3->n1 != fn3->n2));
             assert(!fn3->n2 || (fn3->n2 != fn3->n0 && fn3->n2 != fn3->n1));
         }
-        assert(!fn2 || !fn3 || (fn2->n0 != fn3 && fn2->n1 != fn3 && fn2->n2 != fn3));
-        assert(!fn2 || !fn3 || (fn3->n0 != fn2 && fn3->n1 != fn2 && fn3->n2 != fn2));
+        assert(!fn2 || !fn3 || (getAFace(fn2->n0) != fn3 && getAFace(fn2->n1) != fn3 && getAFace(fn2->n2) != fn3));
+        assert(!fn2 || !fn3 || (getAFace(fn3->n0) != fn2 && getAFace(fn3->n1) != fn2 && getAFace(fn3->n2) != fn2));
     }
 
-    assert(!fl_aface || !fr_aface || fl_aface->n0 == fr_aface);
-    assert(!fl_aface || !fr_aface || fr_aface->n2 == fl_aface);
-    assert(!fn0 || !fn2 || fn0 == fn2 || !fr_aface || (fn0->n0 != fr_aface && fn0->n1 != fr_aface && fn0->n2 != fr_aface));
-    assert(!fn1 || !fn3 || fn1 == fn3 || !fr_aface || (fn1->n0 != fr_aface && fn1->n1 != fr_aface && fn1->n2 != fr_aface));
-    assert(!fn0 || !fn2 || fn0 == fn2 || !fl_aface || (fn2->n0 != fl_aface && fn2->n1 != fl_aface && fn2->n2 != fl_aface));
-    assert(!fn1 || !fn3 || fn1 == fn3 || !fl_aface || (fn3->n0 != fl_aface && fn3->n1 != fl_aface && fn3->n2 != fl_aface));
+    assert(!fl_aface || !fr_aface || getAFace(fl_aface->n0) == fr_aface);
+    assert(!fl_aface || !fr_aface || getAFace(fr_aface->n2) == fl_aface);
+    assert(!fn0 || !fn2 || fn0 == fn2 || !fr_aface || (getAFace(fn0->n0) != fr_aface && getAFace(fn0->n1) != fr_aface && getAFace(fn0->n2) != fr_aface));
+    assert(!fn1 || !fn3 || fn1 == fn3 || !fr_aface || (getAFace(fn1->n0) != fr_aface && getAFace(fn1->n1) != fr_aface && getAFace(fn1->n2) != fr_aface));
+    assert(!fn0 || !fn2 || fn0 == fn2 || !fl_aface || (getAFace(fn2->n0) != fl_aface && getAFace(fn2->n1) != fl_aface && getAFace(fn2->n2) != fl_aface));
+    assert(!fn1 || !fn3 || fn1 == fn3 || !fl_aface || (getAFace(fn3->n0) != fl_aface && getAFace(fn3->n1) != fl_aface && getAFace(fn3->n2) != fl_aface));
 #ifndef NDEBUG
     assertAFaceNeighbors(fl_aface);
     assertAFaceNeighbors(fr_aface);
@@ -1425,24 +2114,24 @@ void SRMesh::vsplit(Vertex* vs)
         #ifndef VDPM_TSTRIP_RESTRIP_ALL
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
         #endif
             if (aface->v0 == vt->avertex)
             {
                 aface->v0 = vu->avertex;
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             }
             else if (aface->v1 == vt->avertex)
             {
                 aface->v1 = vu->avertex;
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             }
             else if (aface->v2 == vt->avertex)
             {
                 aface->v2 = vu->avertex;
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             }
             else
             {
@@ -1462,24 +2151,24 @@ void SRMesh::vsplit(Vertex* vs)
         #ifndef VDPM_TSTRIP_RESTRIP_ALL
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
         #endif
             if (aface->v0 == vt->avertex)
             {
                 aface->v0 = vu->avertex;
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             }
             else if (aface->v1 == vt->avertex)
             {
                 aface->v1 = vu->avertex;
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             }
             else if (aface->v2 == vt->avertex)
             {
                 aface->v2 = vu->avertex;
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             }
             else
             {
@@ -1499,16 +2188,16 @@ void SRMesh::vsplit(Vertex* vs)
         {
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
 
             if (aface->v0 == vt->avertex)
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             else if (aface->v1 == vt->avertex)
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             else if (aface->v2 == vt->avertex)
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             else
             {
                 assert(0);
@@ -1526,16 +2215,16 @@ void SRMesh::vsplit(Vertex* vs)
         {
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
 
             if (aface->v0 == vt->avertex)
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             else if (aface->v1 == vt->avertex)
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             else if (aface->v2 == vt->avertex)
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             else
             {
                 assert(0);
@@ -1544,18 +2233,18 @@ void SRMesh::vsplit(Vertex* vs)
         }
     }
 #endif // !VDPM_TSTRIP_RESTRIP_ALL
-    assert(!fn0 || !fl_aface || fn0->v0 != vt->avertex || fn0->n0 == fl_aface);
-    assert(!fn0 || !fl_aface || fn0->v1 != vt->avertex || fn0->n1 == fl_aface);
-    assert(!fn0 || !fl_aface || fn0->v2 != vt->avertex || fn0->n2 == fl_aface);
-    assert(!fn1 || !fl_aface || fn1->v0 != vu->avertex || fn1->n2 == fl_aface);
-    assert(!fn1 || !fl_aface || fn1->v1 != vu->avertex || fn1->n0 == fl_aface);
-    assert(!fn1 || !fl_aface || fn1->v2 != vu->avertex || fn1->n1 == fl_aface);
-    assert(!fn2 || !fr_aface || fn2->v0 != vt->avertex || fn2->n2 == fr_aface);
-    assert(!fn2 || !fr_aface || fn2->v1 != vt->avertex || fn2->n0 == fr_aface);
-    assert(!fn2 || !fr_aface || fn2->v2 != vt->avertex || fn2->n1 == fr_aface);
-    assert(!fn3 || !fr_aface || fn3->v0 != vu->avertex || fn3->n0 == fr_aface);
-    assert(!fn3 || !fr_aface || fn3->v1 != vu->avertex || fn3->n1 == fr_aface);
-    assert(!fn3 || !fr_aface || fn3->v2 != vu->avertex || fn3->n2 == fr_aface);
+    assert(!fn0 || !fl_aface || fn0->v0 != vt->avertex || getAFace(fn0->n0) == fl_aface);
+    assert(!fn0 || !fl_aface || fn0->v1 != vt->avertex || getAFace(fn0->n1) == fl_aface);
+    assert(!fn0 || !fl_aface || fn0->v2 != vt->avertex || getAFace(fn0->n2) == fl_aface);
+    assert(!fn1 || !fl_aface || fn1->v0 != vu->avertex || getAFace(fn1->n2) == fl_aface);
+    assert(!fn1 || !fl_aface || fn1->v1 != vu->avertex || getAFace(fn1->n0) == fl_aface);
+    assert(!fn1 || !fl_aface || fn1->v2 != vu->avertex || getAFace(fn1->n1) == fl_aface);
+    assert(!fn2 || !fr_aface || fn2->v0 != vt->avertex || getAFace(fn2->n2) == fr_aface);
+    assert(!fn2 || !fr_aface || fn2->v1 != vt->avertex || getAFace(fn2->n0) == fr_aface);
+    assert(!fn2 || !fr_aface || fn2->v2 != vt->avertex || getAFace(fn2->n1) == fr_aface);
+    assert(!fn3 || !fr_aface || fn3->v0 != vu->avertex || getAFace(fn3->n0) == fr_aface);
+    assert(!fn3 || !fr_aface || fn3->v1 != vu->avertex || getAFace(fn3->n1) == fr_aface);
+    assert(!fn3 || !fr_aface || fn3->v2 != vu->avertex || getAFace(fn3->n2) == fr_aface);
     assert(!fn0 || fn0->v0 == vt->avertex || fn0->v1 == vt->avertex || fn0->v2 == vt->avertex);
     assert(!fn1 || fn1->v0 == vu->avertex || fn1->v1 == vu->avertex || fn1->v2 == vu->avertex);
     assert(!fn2 || fn2->v0 == vt->avertex || fn2->v1 == vt->avertex || fn2->v2 == vt->avertex);
@@ -1568,9 +2257,9 @@ void SRMesh::vsplit(Vertex* vs)
 
 #ifdef VDPM_GEOMORPHS
     // geomorphs of vt, vu
-    VMorph* vm_t = vt->avertex->vmorph;
+    VMorph* vm_t = getAVertex(vt->avertex)->vmorph;
 
-    if (outsideViewFrustum(vs)
+    if (vmorphsSuppressed || outsideViewFrustum(vs)
     #ifdef VDPM_ORIENTED_AWAY
         || orientedAway(vs)
     #endif
@@ -1578,21 +2267,21 @@ void SRMesh::vsplit(Vertex* vs)
     {
         if (vm_t)
         {
-            assert(vm_t->avertex == vt->avertex);
+            assert(vm_t->avertex == getAVertex(vt->avertex));
 
             if (vm_t->coarsening)
             {
-                Vertex* v = (vs->parent == (vs + 1)->parent) ? vs + 1 : vs - 1;
+                Vertex* v = getSibling(vs);
                 if (v->avertex)
                 {
-                    VMorph* vmorph = v->avertex->vmorph;
+                    VMorph* vmorph = getAVertex(v->avertex)->vmorph;
                     if (vmorph)
                     {
-                        assert(vmorph->avertex == v->avertex);
+                        assert(vmorph->avertex == getAVertex(v->avertex));
 
-                        if (outsideViewFrustum(vs->parent)
+                        if (outsideViewFrustum(getVertex(vs->parent))
                         #ifdef VDPM_ORIENTED_AWAY
-                            || orientedAway(vs->parent)
+                            || orientedAway(getVertex(vs->parent))
                         #endif
                             )
                         {
@@ -1600,40 +2289,19 @@ void SRMesh::vsplit(Vertex* vs)
                         }
                         else
                         {
-                            VGeom* vgRefined = getVGeom(v->avertex->i);
+                            VGeom* vgRefined = getVGeom(getAVertex(v->avertex)->i);
                             VGeom* vgeom = getVMorphVGeom(vmorph->vgIndex);
                             vmorph->coarsening = false;
                             vmorph->gtime = gtime - vmorph->gtime;
-                            vmorph->vgInc.point = (vgRefined->point - vgeom->point) / vmorph->gtime;
-                            vmorph->vgInc.normal = (vgRefined->normal - vgeom->normal) / vmorph->gtime;
-
-                            if (hasColor())
-                            {
-                                float* vgIncColor = geometry.getVGeomColor(&vmorph->vgInc);
-                                float* vgRefinedColor = geometry.getVGeomColor(vgRefined);
-                                float* vgeomColor = geometry.getVGeomColor(vgeom);
-
-                                for (int i = 0; i < 3; ++i)
-                                    vgIncColor[i] = (vgRefinedColor[i] - vgeomColor[i]) / vmorph->gtime;
-                            }
-
-                            if (hasTexCoord())
-                            {
-                                float* vgIncTexCoord = geometry.getVGeomTexCoord(&vmorph->vgInc);
-                                float* vgRefinedTexCoord = geometry.getVGeomTexCoord(vgRefined);
-                                float* vgeomTexCoord = geometry.getVGeomTexCoord(vgeom);
-
-                                for (int i = 0; i < 2; ++i)
-                                    vgIncTexCoord[i] = (vgRefinedTexCoord[i] - vgeomTexCoord[i]) / vmorph->gtime;
-                            }
+                            vgeomOps->increment(&vmorph->vgInc, vgRefined, vgeom, vmorph->gtime);
                         }
                     }
                 }
             }
             removeVMorph(vm_t);
         }
-        assert(!vu->avertex->vmorph);
-        assert(!vt->avertex->vmorph);
+        assert(!getAVertex(vu->avertex)->vmorph);
+        assert(!getAVertex(vt->avertex)->vmorph);
     }
     else
     {
@@ -1645,76 +2313,55 @@ void SRMesh::vsplit(Vertex* vs)
         {
             if (vm_t->coarsening)
             {
-                Vertex* v = (vs->parent == (vs + 1)->parent) ? vs + 1 : vs - 1;
+                Vertex* v = getSibling(vs);
                 if (v->avertex)
                 {
-                    VMorph* vmorph = v->avertex->vmorph;
+                    VMorph* vmorph = getAVertex(v->avertex)->vmorph;
                     if (vmorph)
                     {
-                        VGeom*  vgRefined = getVGeom(v->avertex->i);
+                        VGeom*  vgRefined = getVGeom(getAVertex(v->avertex)->i);
                         VGeom* vgeom = getVMorphVGeom(vmorph->vgIndex);
 
                         vmorph->coarsening = false;
                         vmorph->gtime = gtime - vmorph->gtime;
-                        vmorph->vgInc.point = (vgRefined->point - vgeom->point) / vmorph->gtime;
-                        vmorph->vgInc.normal = (vgRefined->normal - vgeom->normal) / vmorph->gtime;
-
-                        if (hasColor())
-                        {
-                            float* vgIncColor = geometry.getVGeomColor(&vmorph->vgInc);
-                            float* vgRefinedColor = geometry.getVGeomColor(vgRefined);
-                            float* vgeomColor = geometry.getVGeomColor(vgeom);
-
-                            for (int i = 0; i < 3; ++i)
-                                vgIncColor[i] = (vgRefinedColor[i] - vgeomColor[i]) / vmorph->gtime;
-                        }
-
-                        if (hasTexCoord())
-                        {
-                            float* vgIncTexCoord = geometry.getVGeomTexCoord(&vmorph->vgInc);
-                            float* vgRefinedTexCoord = geometry.getVGeomTexCoord(vgRefined);
-                            float* vgeomTexCoord = geometry.getVGeomTexCoord(vgeom);
-
-                            for (int i = 0; i < 2; ++i)
-                                vgIncTexCoord[i] = (vgRefinedTexCoord[i] - vgeomTexCoord[i]) / vmorph->gtime;
-                        }
+                        vgeomOps->increment(&vmorph->vgInc, vgRefined, vgeom, vmorph->gtime);
                     }
                 }
             }
         }
         else
         {
-            vt->avertex->vmorph = vm_t = createVMorph();
+            getAVertex(vt->avertex)->vmorph = vm_t = createVMorph();
             vt_vgeom = getVMorphVGeom(vm_t->vgIndex);
-            ::memcpy(vt_vgeom, getVGeom(vs_vgeom_i), geometry.vgeomSize);
-            vm_t->avertex = vt->avertex;
+            vgeomOps->copy(vt_vgeom, getVGeom(vs_vgeom_i));
+            vm_t->avertex = getAVertex(vt->avertex);
         }
-        vu->avertex->vmorph = vm_u = createVMorph();
+        getAVertex(vu->avertex)->vmorph = vm_u = createVMorph();
         vu_vgeom = getVMorphVGeom(vm_u->vgIndex);
-        ::memcpy(vu_vgeom, getVGeom(vs_vgeom_i), geometry.vgeomSize);
-        vm_u->avertex = vu->avertex;
+        vgeomOps->copy(vu_vgeom, getVGeom(vs_vgeom_i));
+        vm_u->avertex = getAVertex(vu->avertex);
 
         vt_vgeom = getVMorphVGeom(vm_t->vgIndex); // get pointer again after possible realloc
 
-        VGeom* vtRefined = getVGeom(vt->avertex->i);
-        VGeom* vuRefined = getVGeom(vu->avertex->i);
+        VGeom* vtRefined = getVGeom(getAVertex(vt->avertex)->i);
+        VGeom* vuRefined = getVGeom(getAVertex(vu->avertex)->i);
 
 #ifdef VDPM_GEOMORPHS_PLUS
         if (!fr)
         {
             if (!fn0)
-                calcVGeomOnLine(vtRefined, vu_vgeom, getVGeom(vl->i), vt_vgeom);
+                vgeomOps->onLine(vtRefined, vu_vgeom, getVGeom(vl->i), vt_vgeom);
             else if (!fn1)
-                calcVGeomOnLine(vuRefined, vt_vgeom, getVGeom(vl->i), vu_vgeom);
+                vgeomOps->onLine(vuRefined, vt_vgeom, getVGeom(vl->i), vu_vgeom);
 
             pass = true;
         }
         else if (!fl)
         {
             if (!fn2)
-                calcVGeomOnLine(vtRefined, vu_vgeom, getVGeom(vr->i), vt_vgeom);
+                vgeomOps->onLine(vtRefined, vu_vgeom, getVGeom(vr->i), vt_vgeom);
             else if (!fn3)
-                calcVGeomOnLine(vuRefined, vt_vgeom, getVGeom(vr->i), vu_vgeom);
+                vgeomOps->onLine(vuRefined, vt_vgeom, getVGeom(vr->i), vu_vgeom);
 
             pass = true;
         }
@@ -1722,24 +2369,24 @@ void SRMesh::vsplit(Vertex* vs)
         {
             if (fn1 == fn3)
             {
-                calcVGeomOnFace(vuRefined, vt_vgeom, getVGeom(vl->i), getVGeom(vr->i), vu_vgeom);
+                vgeomOps->onFace(vuRefined, vt_vgeom, getVGeom(vl->i), getVGeom(vr->i), vu_vgeom);
                 pass = true;
             }
             else if (fn3)
             {
-                if (fn1->n0 == fn3)
+                if (getAFace(fn1->n0) == fn3)
                 {
-                    calcVGeomOnLine(vuRefined, vt_vgeom, getVGeom(fn1->v1->i), vu_vgeom);
+                    vgeomOps->onLine(vuRefined, vt_vgeom, getVGeom(getAVertex(fn1->v1)->i), vu_vgeom);
                     pass = true;
                 }
-                else if (fn1->n1 == fn3)
+                else if (getAFace(fn1->n1) == fn3)
                 {
-                    calcVGeomOnLine(vuRefined, vt_vgeom, getVGeom(fn1->v2->i), vu_vgeom);
+                    vgeomOps->onLine(vuRefined, vt_vgeom, getVGeom(getAVertex(fn1->v2)->i), vu_vgeom);
                     pass = true;
                 }
-                else if (fn1->n2 == fn3)
+                else if (getAFace(fn1->n2) == fn3)
                 {
-                    calcVGeomOnLine(vuRefined, vt_vgeom, getVGeom(fn1->v0->i), vu_vgeom);
+                    vgeomOps->onLine(vuRefined, vt_vgeom, getVGeom(getAVertex(fn1->v0)->i), vu_vgeom);
                     pass = true;
                 }
             }
@@ -1748,67 +2395,38 @@ void SRMesh::vsplit(Vertex* vs)
         {
             if (fn0 == fn2)
             {
-                calcVGeomOnFace(vtRefined, vu_vgeom, getVGeom(vr->i), getVGeom(vl->i), vt_vgeom);
+                vgeomOps->onFace(vtRefined, vu_vgeom, getVGeom(vr->i), getVGeom(vl->i), vt_vgeom);
             }
             else if (fn2)
             {
-                if (fn0->n0 == fn2)
-                    calcVGeomOnLine(vtRefined, vu_vgeom, getVGeom(fn0->v2->i), vt_vgeom);
-                else if (fn0->n1 == fn2)
-                    calcVGeomOnLine(vtRefined, vu_vgeom, getVGeom(fn0->v0->i), vt_vgeom);
-                else if (fn0->n2 == fn2)
-                    calcVGeomOnLine(vtRefined, vu_vgeom, getVGeom(fn0->v1->i), vt_vgeom);
+                if (getAFace(fn0->n0) == fn2)
+                    vgeomOps->onLine(vtRefined, vu_vgeom, getVGeom(getAVertex(fn0->v2)->i), vt_vgeom);
+                else if (getAFace(fn0->n1) == fn2)
+                    vgeomOps->onLine(vtRefined, vu_vgeom, getVGeom(getAVertex(fn0->v0)->i), vt_vgeom);
+                else if (getAFace(fn0->n2) == fn2)
+                    vgeomOps->onLine(vtRefined, vu_vgeom, getVGeom(getAVertex(fn0->v1)->i), vt_vgeom);
             }
         }
 
+        // vt may have been morphing already
+        geometry.setDirty(vm_t->vgIndex);
 #endif // VDPM_GEOMORPHS_PLUS
 
         vm_t->coarsening = false;
         vm_t->gtime = gtime;
-        vm_t->vgInc.point = (vtRefined->point - vt_vgeom->point) / gtime;
-        vm_t->vgInc.normal = (vtRefined->normal - vt_vgeom->normal) / gtime;
+        vgeomOps->increment(&vm_t->vgInc, vtRefined, vt_vgeom, gtime);
 
         vm_u->coarsening = false;
         vm_u->gtime = gtime;
-        vm_u->vgInc.point = (vuRefined->point - vu_vgeom->point) / gtime;
-        vm_u->vgInc.normal = (vuRefined->normal - vu_vgeom->normal) / gtime;
-
-        if (hasColor())
-        {
-            float* vgIncColor = geometry.getVGeomColor(&vm_t->vgInc);
-            float* vgRefinedColor = geometry.getVGeomColor(vtRefined);
-            float* vgeomColor = geometry.getVGeomColor(vt_vgeom);
-
-            for (int i = 0; i < 3; ++i)
-                vgIncColor[i] = (vgRefinedColor[i] - vgeomColor[i]) / gtime;
-
-            vgIncColor = geometry.getVGeomColor(&vm_u->vgInc);
-            vgRefinedColor = geometry.getVGeomColor(vuRefined);
-            vgeomColor = geometry.getVGeomColor(vu_vgeom);
-
-            for (int i = 0; i < 3; ++i)
-                vgIncColor[i] = (vgRefinedColor[i] - vgeomColor[i]) / gtime;
-        }
-
-        if (hasTexCoord())
-        {
-            float* vgIncTexCoord = geometry.getVGeomTexCoord(&vm_t->vgInc);
-            float* vgRefinedTexCoord = geometry.getVGeomTexCoord(vtRefined);
-            float* vgeomTexCoord = geometry.getVGeomTexCoord(vt_vgeom);
-
-            for (int i = 0; i < 2; ++i)
-                vgIncTexCoord[i] = (vgRefinedTexCoord[i] - vgeomTexCoord[i]) / gtime;
-
-            vgIncTexCoord = geometry.getVGeomTexCoord(&vm_u->vgInc);
-            vgRefinedTexCoord = geometry.getVGeomTexCoord(vuRefined);
-            vgeomTexCoord = geometry.getVGeomTexCoord(vu_vgeom);
-
-            for (int i = 0; i < 2; ++i)
-                vgIncTexCoord[i] = (vgRefinedTexCoord[i] - vgeomTexCoord[i]) / gtime;
-        }
+        vgeomOps->increment(&vm_u->vgInc, vuRefined, vu_vgeom, gtime);
     }
 #endif // VDPM_GEOMORPHS
 
+#ifdef VDPM_HYSTERESIS
+    vertexHolds[vs - vertices] = refineFrame + cooldown;
+#endif
+    ++churnStats.vsplits;
+
 #ifdef VDPM_TSTRIP_RESTRIP_ALL
     tstripDirty = true;
 #endif
@@ -1824,15 +2442,15 @@ void SRMesh::ecol(Vertex* vs)
     vu = vt + 1;
 
 #ifdef VDPM_GEOMORPHS
-    assert(!vu->avertex->vmorph);
+    assert(!getAVertex(vu->avertex)->vmorph);
 #endif
     fl = &faces[baseFCount + vs->i * 2];
     fr = fl + 1;
-    fl_aface = fl->aface;
-    fr_aface = fr->aface;
+    fl_aface = getAFace(fl->aface);
+    fr_aface = getAFace(fr->aface);
 
-    assert(!fl_aface || !fr_aface || fl_aface->n0 == fr_aface);
-    assert(!fl_aface || !fr_aface || fr_aface->n2 == fl_aface);
+    assert(!fl_aface || !fr_aface || getAFace(fl_aface->n0) == fr_aface);
+    assert(!fl_aface || !fr_aface || getAFace(fr_aface->n2) == fl_aface);
 
 #ifndef NDEBUG
     assertAFaceNeighbors(fl_aface);
@@ -1847,17 +2465,17 @@ void SRMesh::ecol(Vertex* vs)
     {
         if (fl_aface->tstrip)
         {
-            allocator->freeTStrip(fl_aface->tstrip, afaces);
+            freeTStrip(getTStrip(fl_aface->tstrip));
             --tstripCount;
         }
 
-        aface = fl_aface->n1;
+        aface = getAFace(fl_aface->n1);
         while (aface && aface != fr_aface)
         {
         #ifndef VDPM_TSTRIP_RESTRIP_ALL
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
         #endif
@@ -1865,17 +2483,17 @@ void SRMesh::ecol(Vertex* vs)
             if (aface->v0 == vu->avertex)
             {
                 aface->v0 = vt->avertex;
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             }
             else if (aface->v1 == vu->avertex)
             {
                 aface->v1 = vt->avertex;
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             }
             else if (aface->v2 == vu->avertex)
             {
                 aface->v2 = vt->avertex;
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             }
             else
             {
@@ -1886,30 +2504,30 @@ void SRMesh::ecol(Vertex* vs)
     }
     if (fr_aface && aface != fr_aface)
     {
-        aface = fr_aface->n1;
+        aface = getAFace(fr_aface->n1);
         while (aface)
         {
         #ifndef VDPM_TSTRIP_RESTRIP_ALL
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
         #endif
             if (aface->v0 == vu->avertex)
             {
                 aface->v0 = vt->avertex;
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             }
             else if (aface->v1 == vu->avertex)
             {
                 aface->v1 = vt->avertex;
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             }
             else if (aface->v2 == vu->avertex)
             {
                 aface->v2 = vt->avertex;
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             }
             else
             {
@@ -1925,26 +2543,26 @@ void SRMesh::ecol(Vertex* vs)
     {
         if (fr_aface->tstrip)
         {
-            allocator->freeTStrip(fr_aface->tstrip, afaces);
+            freeTStrip(getTStrip(fr_aface->tstrip));
             --tstripCount;
         }
 
     #ifndef VDPM_TSTRIP_RESTRIP_ALL
-        aface = fr_aface->n0;
+        aface = getAFace(fr_aface->n0);
         while (aface && aface != fl_aface)
         {
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
 
             if (aface->v0 == vt->avertex)
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             else if (aface->v1 == vt->avertex)
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             else if (aface->v2 == vt->avertex)
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             else
             {
                 assert(0);
@@ -1957,21 +2575,21 @@ void SRMesh::ecol(Vertex* vs)
     if (fl_aface && aface != fl_aface)
     {
         assert(!aface);
-        aface = fl_aface->n2;
+        aface = getAFace(fl_aface->n2);
         while (aface)
         {
             if (aface->tstrip)
             {
-                allocator->freeTStrip(aface->tstrip, afaces);
+                freeTStrip(getTStrip(aface->tstrip));
                 --tstripCount;
             }
 
             if (aface->v0 == vt->avertex)
-                aface = aface->n2;
+                aface = getAFace(aface->n2);
             else if (aface->v1 == vt->avertex)
-                aface = aface->n0;
+                aface = getAFace(aface->n0);
             else if (aface->v2 == vt->avertex)
-                aface = aface->n1;
+                aface = getAFace(aface->n1);
             else
             {
                 assert(0);
@@ -1987,8 +2605,8 @@ void SRMesh::ecol(Vertex* vs)
 #endif
     if (fl_aface)
     {
-        fn0 = fl_aface->n2;
-        fn1 = fl_aface->n1;
+        fn0 = getAFace(fl_aface->n2);
+        fn1 = getAFace(fl_aface->n1);
 
         assert(!fn0 || fn0 != fn1);
         assert(!fn1 || fn1 != fn0);
@@ -1996,11 +2614,11 @@ void SRMesh::ecol(Vertex* vs)
         if (fn0)
         {
             if (fn0->n0 == fl->aface)
-                fn0->n0 = fn1;
+                fn0->n0 = ref(fn1);
             else if (fn0->n1 == fl->aface)
-                fn0->n1 = fn1;
+                fn0->n1 = ref(fn1);
             else
-                fn0->n2 = fn1;
+                fn0->n2 = ref(fn1);
 
             assert(!fn0->n0 || (fn0->n0 != fn0->n1 && fn0->n0 != fn0->n2));
             assert(!fn0->n1 || (fn0->n1 != fn0->n0 && fn0->n1 != fn0->n2));
@@ -2010,18 +2628,18 @@ void SRMesh::ecol(Vertex* vs)
         if (fn1)
         {
             if (fn1->n0 == fl->aface)
-                fn1->n0 = fn0;
+                fn1->n0 = ref(fn0);
             else if (fn1->n1 == fl->aface)
-                fn1->n1 = fn0;
+                fn1->n1 = ref(fn0);
             else
-                fn1->n2 = fn0;
+                fn1->n2 = ref(fn0);
 
             assert(!fn1->n0 || (fn1->n0 != fn1->n1 && fn1->n0 != fn1->n2));
             assert(!fn1->n1 || (fn1->n1 != fn1->n0 && fn1->n1 != fn1->n2));
             assert(!fn1->n2 || (fn1->n2 != fn1->n0 && fn1->n2 != fn1->n1));
         }
         --afaceCount;
-        allocator->freeAFace(fl_aface);
+        freeAFace(fl_aface);
         fl->aface = NULL;
 
         assert(!fn0 || fn0->v0 == vt->avertex || fn0->v1 == vt->avertex || fn0->v2 == vt->avertex);
@@ -2030,8 +2648,8 @@ void SRMesh::ecol(Vertex* vs)
 
     if (fr_aface)
     {
-        fn2 = fr_aface->n0;
-        fn3 = fr_aface->n1;
+        fn2 = getAFace(fr_aface->n0);
+        fn3 = getAFace(fr_aface->n1);
 
         assert(!fn2 || fn2 != fn3);
         assert(!fn3 || fn3 != fn2);
@@ -2039,11 +2657,11 @@ void SRMesh::ecol(Vertex* vs)
         if (fn2)
         {
             if (fn2->n0 == fr->aface)
-                fn2->n0 = fn3;
+                fn2->n0 = ref(fn3);
             else if (fn2->n1 == fr->aface)
-                fn2->n1 = fn3;
+                fn2->n1 = ref(fn3);
             else
-                fn2->n2 = fn3;
+                fn2->n2 = ref(fn3);
 
             assert(!fn2->n0 || (fn2->n0 != fn2->n1 && fn2->n0 != fn2->n2));
             assert(!fn2->n1 || (fn2->n1 != fn2->n0 && fn2->n1 != fn2->n2));
@@ -2052,47 +2670,241 @@ void SRMesh::ecol(Vertex* vs)
         if (fn3)
         {
             if (fn3->n0 == fr->aface)
-                fn3->n0 = fn2;
+                fn3->n0 = ref(fn2);
             else if (fn3->n1 == fr->aface)
-                fn3->n1 = fn2;
+                fn3->n1 = ref(fn2);
             else
-                fn3->n2 = fn2;
+                fn3->n2 = ref(fn2);
 
             assert(!fn3->n0 || (fn3->n0 != fn3->n1 && fn3->n0 != fn3->n2));
             assert(!fn3->n1 || (fn3->n1 != fn3->n0 && fn3->n1 != fn3->n2));
             assert(!fn3->n2 || (fn3->n2 != fn3->n0 && fn3->n2 != fn3->n1));
         }
         --afaceCount;
-        allocator->freeAFace(fr_aface);
+        freeAFace(fr_aface);
         fr->aface = NULL;
 
-        assert(!fn2 || fn2->v0 == vt->avertex || fn2->v1 == vt->avertex || fn2->v2 == vt->avertex);
-        assert(!fn3 || fn3->v0 == vt->avertex || fn3->v1 == vt->avertex || fn3->v2 == vt->avertex);
+        assert(!fn2 || fn2->v0 == vt->avertex || fn2->v1 == vt->avertex || fn2->v2 == vt->avertex);
+        assert(!fn3 || fn3->v0 == vt->avertex || fn3->v1 == vt->avertex || fn3->v2 == vt->avertex);
+    }
+#ifndef NDEBUG
+    assertAFaces();
+#endif
+    vs->avertex = vt->avertex;
+    --avertexCount;
+
+#ifdef VDPM_AMORTIZATION
+    if (getAVertex(vu->avertex) == amortizeAvertex)
+        amortizeAvertex = getAVertex(getAVertex(vu->avertex)->next);
+
+#endif // VDPM_AMORTIZATION
+
+    freeAVertex(getAVertex(vu->avertex));
+
+    vu->avertex = NULL;
+    vt->avertex = NULL;
+    getAVertex(vs->avertex)->vertex = ref(vs);
+    getAVertex(vs->avertex)->i = getVGeomIndex(vs);
+
+#ifdef VDPM_HYSTERESIS
+    vertexHolds[vs - vertices] = refineFrame + cooldown;
+#endif
+    ++churnStats.ecols;
+
+#ifdef VDPM_TSTRIP_RESTRIP_ALL
+    tstripDirty = true;
+#endif
+}
+
+#if defined(VDPM_VSPLIT_DEPENDENCIES) || defined(VDPM_STREAMING)
+unsigned int SRMesh::getVSplitDependencies(unsigned int i, unsigned int* deps)
+{
+    unsigned int j, k, n = 0;
+    Face* fn[4];
+    Vertex* vs;
+
+    vs = getVertex(vertices[baseVCount + i * 2].parent);
+
+    if (vs->parent)
+        deps[n++] = getVertex(vs->parent)->i;
+
+    fn[0] = getFace(vsplits[i].fn0);
+    fn[1] = getFace(vsplits[i].fn1);
+    fn[2] = getFace(vsplits[i].fn2);
+    fn[3] = getFace(vsplits[i].fn3);
+
+    for (j = 0; j < 4; ++j)
+    {
+        if (!fn[j] || fn[j] < &faces[baseFCount])
+            continue;
+
+        // faces fl, fr of vsplit k are stored at baseFCount + k * 2
+        deps[n] = (unsigned int)(fn[j] - &faces[baseFCount]) >> 1;
+
+        for (k = 0; k < n; ++k)
+        {
+            if (deps[k] == deps[n])
+                break;
+        }
+        if (k == n)
+            ++n;
+    }
+    return n;
+}
+#endif // VDPM_VSPLIT_DEPENDENCIES || VDPM_STREAMING
+
+#ifdef VDPM_VSPLIT_DEPENDENCIES
+int SRMesh::buildVSplitDependencies()
+{
+    unsigned int *depths = NULL, i, j, n, count, maxDepth = 0;
+    unsigned int deps[5];
+
+    vsplitDepOffsets = new unsigned int[vsplitCount + 1];
+    if (!vsplitDepOffsets)
+        goto error;
+
+    // each vsplit depends on at most its own parent vsplit and the creators of fn0..fn3
+    vsplitDeps = new unsigned int[vsplitCount * 5 + 1];
+    if (!vsplitDeps)
+        goto error;
+
+#ifdef VDPM_STREAMING
+    if (streamed)
+    {
+        // records arrive in any order, so every vsplit has five slots filled on arrival
+        for (i = 0; i <= vsplitCount; ++i)
+            vsplitDepOffsets[i] = i * 5;
+
+        for (i = 0; i < vsplitCount; ++i)
+            setVSplitDependencies(i);
+
+        // the depth is not known in advance, but a search path never holds a vsplit twice
+        vsplitStack = new VSplitFrame[vsplitCount + 1];
+        if (!vsplitStack)
+            goto error;
+
+        return 0;
+    }
+#endif // VDPM_STREAMING
+
+    depths = new unsigned int[vsplitCount + 1];
+    if (!depths)
+        goto error;
+
+    count = 0;
+    for (i = 0; i < vsplitCount; ++i)
+    {
+        n = getVSplitDependencies(i, deps);
+
+        vsplitDepOffsets[i] = count;
+        depths[i] = 1;
+
+        for (j = 0; j < n; ++j)
+        {
+            vsplitDeps[count++] = deps[j];
+
+            // vsplits are stored in refinement order, so dependencies precede them
+            if (deps[j] < i)
+            {
+                if (depths[deps[j]] + 1 > depths[i])
+                    depths[i] = depths[deps[j]] + 1;
+            }
+            else
+            {
+                depths[i] = vsplitCount;
+            }
+        }
+
+        if (depths[i] > maxDepth)
+            maxDepth = depths[i];
     }
-#ifndef NDEBUG
-    assertAFaces();
-#endif
-    vs->avertex = vt->avertex;
-    --avertexCount;
+    vsplitDepOffsets[vsplitCount] = count;
 
-#ifdef VDPM_AMORTIZATION
-    if (vu->avertex == amortizeAvertex)
-        amortizeAvertex = vu->avertex->next;
+    // a search path never holds a vsplit twice, so the longest chain bounds the stack
+    vsplitStack = new VSplitFrame[maxDepth + 1];
+    if (!vsplitStack)
+        goto error;
 
-#endif // VDPM_AMORTIZATION
+    delete[] depths;
+    return 0;
 
-    allocator->freeAVertex(vu->avertex);
+error:
+    delete[] depths;
+    delete[] vsplitDepOffsets;
+    delete[] vsplitDeps;
+    vsplitDepOffsets = vsplitDeps = NULL;
 
-    vu->avertex = NULL;
-    vt->avertex = NULL;
-    vs->avertex->vertex = vs;
-    vs->avertex->i = getVGeomIndex(vs);
+    return -1;
+}
 
-#ifdef VDPM_TSTRIP_RESTRIP_ALL
-    tstripDirty = true;
-#endif
+#ifdef VDPM_STREAMING
+void SRMesh::setVSplitDependencies(unsigned int i)
+{
+    unsigned int* deps = &vsplitDeps[i * 5];
+    unsigned int n = 0;
+
+    // slots of a vsplit without a record and unused slots are skipped by forceVSplit()
+    if (vertices[baseVCount + i * 2].parent)
+        n = getVSplitDependencies(i, deps);
+
+    for (; n < 5; ++n)
+        deps[n] = UINT_MAX;
 }
+#endif // VDPM_STREAMING
+
+void SRMesh::forceVSplit(Vertex* v)
+{
+    VSplitFrame* frame;
+    Vertex* vs;
+    Face* fl;
+    int vstackTop;
+    unsigned int dep;
+
+    fl = &faces[baseFCount + v->i * 2];
+    if (fl->aface || (fl + 1)->aface)
+        return;
+
+    vstackTop = 0;
+    vsplitStack[0].i = v->i;
+    vsplitStack[0].next = vsplitDepOffsets[v->i];
+
+    // depth-first walk of the dependency closure, splitting in topological order
+    while (vstackTop >= 0)
+    {
+        frame = &vsplitStack[vstackTop];
 
+        while (frame->next < vsplitDepOffsets[frame->i + 1])
+        {
+            dep = vsplitDeps[frame->next++];
+        #ifdef VDPM_STREAMING
+            if (dep == UINT_MAX)
+                continue;
+        #endif
+            fl = &faces[baseFCount + dep * 2];
+
+            if (!fl->aface && !(fl + 1)->aface)
+            {
+                ++frame;
+                frame->i = dep;
+                frame->next = vsplitDepOffsets[dep];
+                ++vstackTop;
+            }
+        }
+
+        vs = getVertex(vertices[baseVCount + frame->i * 2].parent);
+
+        assert(vs->avertex);
+        assert(vsplitLegal(vs));
+        --vstackTop;
+        vsplit(vs);
+
+    #ifdef VDPM_REGULATION_FORCE
+        if (afaceCount >= targetAFaceCount)
+            return;
+    #endif
+    }
+}
+#else
 void SRMesh::forceVSplit(Vertex* v)
 {
     int vstackTop = 0;
@@ -2121,7 +2933,7 @@ void SRMesh::forceVSplit(Vertex* v)
 
         if (!vs->avertex)
         {
-            vstack[++vstackTop] = vs->parent;
+            vstack[++vstackTop] = getVertex(vs->parent);
             assert(vstack[vstackTop]);
         }
         else if (vsplitLegal(vs))
@@ -2140,36 +2952,37 @@ void SRMesh::forceVSplit(Vertex* v)
         {
             Face *fn0, *fn1, *fn2, *fn3;
 
-            fn0 = vsplits[vs->i].fn0;
+            fn0 = getFace(vsplits[vs->i].fn0);
             if (fn0 && !fn0->aface)
             {
-                vstack[++vstackTop] = vertices[baseVCount + (fn0 - &faces[baseFCount])].parent;
+                vstack[++vstackTop] = getVertex(vertices[baseVCount + (fn0 - &faces[baseFCount])].parent);
                 assert(vstack[vstackTop]);
             }
 
-            fn1 = vsplits[vs->i].fn1;
+            fn1 = getFace(vsplits[vs->i].fn1);
             if (fn1 && !fn1->aface)
             {
-                vstack[++vstackTop] = vertices[baseVCount + (fn1 - &faces[baseFCount])].parent;
+                vstack[++vstackTop] = getVertex(vertices[baseVCount + (fn1 - &faces[baseFCount])].parent);
                 assert(vstack[vstackTop]);
             }
 
-            fn2 = vsplits[vs->i].fn2;
+            fn2 = getFace(vsplits[vs->i].fn2);
             if (fn2 && !fn2->aface && fn2 != fn0)
             {
-                vstack[++vstackTop] = vertices[baseVCount + (fn2 - &faces[baseFCount])].parent;
+                vstack[++vstackTop] = getVertex(vertices[baseVCount + (fn2 - &faces[baseFCount])].parent);
                 assert(vstack[vstackTop]);
             }
 
-            fn3 = vsplits[vs->i].fn3;
+            fn3 = getFace(vsplits[vs->i].fn3);
             if (fn3 && !fn3->aface && fn3 != fn1)
             {
-                vstack[++vstackTop] = vertices[baseVCount + (fn3 - &faces[baseFCount])].parent;
+                vstack[++vstackTop] = getVertex(vertices[baseVCount + (fn3 - &faces[baseFCount])].parent);
                 assert(vstack[vstackTop]);
             }
         }
     }
 }
+#endif // VDPM_VSPLIT_DEPENDENCIES
 
 bool SRMesh::outsideViewFrustum(Vertex* vs)
 {
@@ -2179,7 +2992,7 @@ bool SRMesh::outsideViewFrustum(Vertex* vs)
     assert(vs->i != UINT_MAX);
 
     if (vs->avertex)
-        point = &getVGeom(vs->avertex->i)->point;
+        point = &getVGeom(getAVertex(vs->avertex)->i)->point;
     else
         point = &getVGeom(getVGeomIndex(vs))->point;
 
@@ -2197,7 +3010,7 @@ bool SRMesh::orientedAway(Vertex* vs)
 {
     VGeom* vs_geom;
     Point v_e;
-    AVertex* avertex = vs->avertex;
+    AVertex* avertex = getAVertex(vs->avertex);
     float result;
 
     if (avertex)
@@ -2205,30 +3018,41 @@ bool SRMesh::orientedAway(Vertex* vs)
     else
         vs_geom = getVGeom(getVGeomIndex(vs));
 
-#ifdef VDPM_PREDICT_VIEW_POSITION
-    v_e = vs_geom->point - viewport->predictViewPos;
-#else
     v_e = vs_geom->point - viewport->viewPos;
-#endif
 
     result = dotProduct(v_e, vs_geom->normal);
     if (result > 0.0f)
     {
         result *= result;
         if (result > dotProduct(v_e, v_e) * vsplits[vs->i].sin2alpha)
+        {
+        #ifdef VDPM_PREDICT_VIEW_POSITION
+            // still needed if it turns towards the predicted position
+            v_e = vs_geom->point - viewport->predictViewPos;
+
+            result = dotProduct(v_e, vs_geom->normal);
+            if (result <= 0.0f)
+                return false;
+
+            result *= result;
+            return result > dotProduct(v_e, v_e) * vsplits[vs->i].sin2alpha;
+        #else
             return true;
+        #endif // VDPM_PREDICT_VIEW_POSITION
+        }
     }
     return false;
 }
 #endif // VDPM_ORIENTED_AWAY
 
-bool SRMesh::screenErrorIllegal(Vertex* vs)
+bool SRMesh::screenErrorIllegal(Vertex* vs, float k2)
 {
     VGeom* vs_geom;
-    Point v_e;
-    AVertex* avertex = vs->avertex;
+    AVertex* avertex = getAVertex(vs->avertex);
     VSplit& vsp = vsplits[vs->i];
-    float lv2, ve_n;
+#ifdef VDPM_IMPORTANCE_REGIONS
+    float scale;
+#endif
 
     if (avertex)
     {
@@ -2238,24 +3062,46 @@ bool SRMesh::screenErrorIllegal(Vertex* vs)
     {
         vs_geom = getVGeom(getVGeomIndex(vs));
     }
+
+#ifdef VDPM_IMPORTANCE_REGIONS
+    if (importanceActive)
+    {
+        scale = getTauScale(vs, vs_geom->point);
+        k2 *= scale * scale;
+    }
+#endif
+
+    if (screenErrorIllegal(vs_geom, vsp, viewport->viewPos, k2))
+        return true;
+
 #ifdef VDPM_PREDICT_VIEW_POSITION
-    v_e = vs_geom->point - viewport->predictViewPos;
-#else
-    v_e = vs_geom->point - viewport->viewPos;
+    // refine ahead so geomorphs complete before the camera arrives
+    if (screenErrorIllegal(vs_geom, vsp, viewport->predictViewPos, k2))
+        return true;
 #endif
 
+    return false;
+}
+
+inline bool SRMesh::screenErrorIllegal(VGeom* vs_geom, VSplit& vsp, const Point& viewPos, float k2)
+{
+    Point v_e;
+    float lv2, ve_n;
+
+    v_e = vs_geom->point - viewPos;
+
 #ifdef VDPM_SCREEN_ERROR_STRICT
     lv2 = dotProduct(v_e, v_e) - vsp.radius;    // more strict
 #else
     lv2 = dotProduct(v_e, v_e);
 #endif
 
-    if (vsp.uni_error >= kappa2 * lv2)
+    if (vsp.uni_error >= k2 * lv2)
         return true;
 
     ve_n = dotProduct(v_e, vs_geom->normal);
 
-    if (vsp.dir_error * (lv2 - ve_n * ve_n) >= kappa2 * lv2 * lv2)
+    if (vsp.dir_error * (lv2 - ve_n * ve_n) >= k2 * lv2 * lv2)
         return true;
 
     return false;
@@ -2265,8 +3111,8 @@ bool SRMesh::vsplitLegal(Vertex* vs)
 {
     VSplit* vsp = &vsplits[vs->i];
 
-    if ((vsp->fn0 && !vsp->fn0->aface) || (vsp->fn1 && !vsp->fn1->aface) ||
-        (vsp->fn2 && !vsp->fn2->aface) || (vsp->fn3 && !vsp->fn3->aface))
+    if ((vsp->fn0 && !getFace(vsp->fn0)->aface) || (vsp->fn1 && !getFace(vsp->fn1)->aface) ||
+        (vsp->fn2 && !getFace(vsp->fn2)->aface) || (vsp->fn3 && !getFace(vsp->fn3)->aface))
         return false;
 
     return true;
@@ -2288,19 +3134,19 @@ bool SRMesh::ecolLegal(Vertex* vs)
 
         if (vsp->fn0)
         {
-            fn0 = vsp->fn0->aface;
-            if (!fn0 || fl->aface->n2 != fn0)
+            fn0 = getAFace(getFace(vsp->fn0)->aface);
+            if (!fn0 || getAFace(getAFace(fl->aface)->n2) != fn0)
                 return false;
         }
         if (vsp->fn1)
         {
-            fn1 = vsp->fn1->aface;
-            if (!fn1 || fl->aface->n1 != fn1)
+            fn1 = getAFace(getFace(vsp->fn1)->aface);
+            if (!fn1 || getAFace(getAFace(fl->aface)->n1) != fn1)
                 return false;
         }
     }
 
-    AFace* afr = (fl + 1)->aface;
+    AFace* afr = getAFace((fl + 1)->aface);
 
     if (afr)
     {
@@ -2308,14 +3154,14 @@ bool SRMesh::ecolLegal(Vertex* vs)
 
         if (vsp->fn2)
         {
-            fn2 = vsp->fn2->aface;
-            if (!fn2 || afr->n0 != fn2)
+            fn2 = getAFace(getFace(vsp->fn2)->aface);
+            if (!fn2 || getAFace(afr->n0) != fn2)
                 return false;
         }
         if (vsp->fn3)
         {
-            fn3 = vsp->fn3->aface;
-            if (!fn3 || afr->n1 != fn3)
+            fn3 = getAFace(getFace(vsp->fn3)->aface);
+            if (!fn3 || getAFace(afr->n1) != fn3)
                 return false;
         }
     }
@@ -2332,26 +3178,26 @@ void SRMesh::startCoarsening(Vertex* vs)
 
     vt = &vertices[baseVCount + vs->i * 2];
     vu = vt + 1;
-    vm_t = vt->avertex->vmorph;
-    vt_vgeom = getVGeom(vt->avertex->i);
+    vm_t = getAVertex(vt->avertex)->vmorph;
+    vt_vgeom = getVGeom(getAVertex(vt->avertex)->i);
     if (!vm_t)
     {
         VGeom* vmorphVgeom;
-        vt->avertex->vmorph = vm_t = createVMorph();
+        getAVertex(vt->avertex)->vmorph = vm_t = createVMorph();
         vmorphVgeom = getVMorphVGeom(vm_t->vgIndex);
-        ::memcpy(vmorphVgeom, vt_vgeom, geometry.vgeomSize);
-        vm_t->avertex = vt->avertex;
+        vgeomOps->copy(vmorphVgeom, vt_vgeom);
+        vm_t->avertex = getAVertex(vt->avertex);
     }
 
-    vm_u = vu->avertex->vmorph;
-    vu_vgeom = getVGeom(vu->avertex->i);
+    vm_u = getAVertex(vu->avertex)->vmorph;
+    vu_vgeom = getVGeom(getAVertex(vu->avertex)->i);
     if (!vm_u)
     {
         VGeom* vmorphVgeom;
-        vu->avertex->vmorph = vm_u = createVMorph();
+        getAVertex(vu->avertex)->vmorph = vm_u = createVMorph();
         vmorphVgeom = getVMorphVGeom(vm_u->vgIndex);
-        ::memcpy(vmorphVgeom, vu_vgeom, geometry.vgeomSize);
-        vm_u->avertex = vu->avertex;
+        vgeomOps->copy(vmorphVgeom, vu_vgeom);
+        vm_u->avertex = getAVertex(vu->avertex);
     }
     vt_goalVGeom = vu_goalVGeom = getVGeom(getVGeomIndex(vs));
 
@@ -2360,10 +3206,10 @@ void SRMesh::startCoarsening(Vertex* vs)
         AFace *fn0, *fn1, *fn2, *fn3, *aface;
         bool vt_notBound, vu_notBound;
 
-        fn0 = (vsplits[vs->i].fn0) ? vsplits[vs->i].fn0->aface : NULL;
-        fn1 = (vsplits[vs->i].fn1) ? vsplits[vs->i].fn1->aface : NULL;
-        fn2 = (vsplits[vs->i].fn2) ? vsplits[vs->i].fn2->aface : NULL;
-        fn3 = (vsplits[vs->i].fn3) ? vsplits[vs->i].fn3->aface : NULL;
+        fn0 = (vsplits[vs->i].fn0) ? getAFace(getFace(vsplits[vs->i].fn0)->aface) : NULL;
+        fn1 = (vsplits[vs->i].fn1) ? getAFace(getFace(vsplits[vs->i].fn1)->aface) : NULL;
+        fn2 = (vsplits[vs->i].fn2) ? getAFace(getFace(vsplits[vs->i].fn2)->aface) : NULL;
+        fn3 = (vsplits[vs->i].fn3) ? getAFace(getFace(vsplits[vs->i].fn3)->aface) : NULL;
 
         // update fn0..fn3 by current active faces
         if (fn0)
@@ -2373,17 +3219,17 @@ void SRMesh::startCoarsening(Vertex* vs)
                 if (vt->avertex == fn0->v0)
                 {
                     if (fn0->n1)
-                        fn1 = fn0->n1;
+                        fn1 = getAFace(fn0->n1);
                 }
                 else if (vt->avertex == fn0->v1)
                 {
                     if (fn0->n2)
-                        fn1 = fn0->n2;
+                        fn1 = getAFace(fn0->n2);
                 }
                 else
                 {
                     if (fn0->n0)
-                        fn1 = fn0->n0;
+                        fn1 = getAFace(fn0->n0);
                 }
             }
         }
@@ -2392,17 +3238,17 @@ void SRMesh::startCoarsening(Vertex* vs)
             if (vt->avertex == fn1->v0)
             {
                 if (fn1->n2)
-                    fn0 = fn1->n2;
+                    fn0 = getAFace(fn1->n2);
             }
             else if (vt->avertex == fn1->v1)
             {
                 if (fn1->n0)
-                    fn0 = fn1->n0;
+                    fn0 = getAFace(fn1->n0);
             }
             else
             {
                 if (fn1->n1)
-                    fn0 = fn1->n1;
+                    fn0 = getAFace(fn1->n1);
             }
         }
         if (fn2)
@@ -2412,17 +3258,17 @@ void SRMesh::startCoarsening(Vertex* vs)
                 if (vt->avertex == fn2->v0)
                 {
                     if (fn2->n2)
-                        fn3 = fn2->n2;
+                        fn3 = getAFace(fn2->n2);
                 }
                 else if (vt->avertex == fn2->v1)
                 {
                     if (fn2->n0)
-                        fn3 = fn2->n0;
+                        fn3 = getAFace(fn2->n0);
                 }
                 else
                 {
                     if (fn2->n1)
-                        fn3 = fn2->n1;
+                        fn3 = getAFace(fn2->n1);
                 }
             }
         }
@@ -2431,17 +3277,17 @@ void SRMesh::startCoarsening(Vertex* vs)
             if (vt->avertex == fn3->v0)
             {
                 if (fn3->n1)
-                    fn2 = fn3->n1;
+                    fn2 = getAFace(fn3->n1);
             }
             else if (vt->avertex == fn3->v1)
             {
                 if (fn3->n2)
-                    fn2 = fn3->n2;
+                    fn2 = getAFace(fn3->n2);
             }
             else
             {
                 if (fn3->n0)
-                    fn2 = fn3->n0;
+                    fn2 = getAFace(fn3->n0);
             }
         }
 
@@ -2454,11 +3300,11 @@ void SRMesh::startCoarsening(Vertex* vs)
             while (aface && aface != fn2)
             {
                 if (aface->v0 == vt->avertex)
-                    aface = aface->n2;
+                    aface = getAFace(aface->n2);
                 else if (aface->v1 == vt->avertex)
-                    aface = aface->n0;
+                    aface = getAFace(aface->n0);
                 else if (aface->v2 == vt->avertex)
-                    aface = aface->n1;
+                    aface = getAFace(aface->n1);
                 else
                     break;
             }
@@ -2472,11 +3318,11 @@ void SRMesh::startCoarsening(Vertex* vs)
             while (aface && aface != fn3)
             {
                 if (aface->v0 == vu->avertex)
-                    aface = aface->n1;
+                    aface = getAFace(aface->n1);
                 else if (aface->v1 == vu->avertex)
-                    aface = aface->n2;
+                    aface = getAFace(aface->n2);
                 else if (aface->v2 == vu->avertex)
-                    aface = aface->n0;
+                    aface = getAFace(aface->n0);
                 else
                     break;
             }
@@ -2494,20 +3340,20 @@ void SRMesh::startCoarsening(Vertex* vs)
                 if (fn0)
                 {
                     if (vt->avertex == fn0->v0)
-                        vl = fn0->v2;
+                        vl = getAVertex(fn0->v2);
                     else if (vt->avertex == fn0->v1)
-                        vl = fn0->v0;
+                        vl = getAVertex(fn0->v0);
                     else
-                        vl = fn0->v1;
+                        vl = getAVertex(fn0->v1);
                 }
                 else
                 {
                     if (vt->avertex == fn1->v0)
-                        vl = fn1->v1;
+                        vl = getAVertex(fn1->v1);
                     else if (vt->avertex == fn1->v1)
-                        vl = fn1->v2;
+                        vl = getAVertex(fn1->v2);
                     else
-                        vl = fn1->v0;
+                        vl = getAVertex(fn1->v0);
                 }
             }
             if (fn2 || fn3)
@@ -2515,20 +3361,20 @@ void SRMesh::startCoarsening(Vertex* vs)
                 if (fn2)
                 {
                     if (vt->avertex == fn2->v0)
-                        vr = fn2->v1;
+                        vr = getAVertex(fn2->v1);
                     else if (vt->avertex == fn2->v1)
-                        vr = fn2->v2;
+                        vr = getAVertex(fn2->v2);
                     else
-                        vr = fn2->v0;
+                        vr = getAVertex(fn2->v0);
                 }
                 else
                 {
                     if (vt->avertex == fn3->v0)
-                        vr = fn3->v2;
+                        vr = getAVertex(fn3->v2);
                     else if (vt->avertex == fn3->v1)
-                        vr = fn3->v0;
+                        vr = getAVertex(fn3->v0);
                     else
-                        vr = fn3->v1;
+                        vr = getAVertex(fn3->v1);
                 }
             }
 
@@ -2537,18 +3383,18 @@ void SRMesh::startCoarsening(Vertex* vs)
             else if (!fn2 && !fn3)
             {
                 if (!fn1)
-                    calcVGeomOnLine(vt_vgeom, vu_goalVGeom, getVGeom(vl->i), vt_goalVGeom);
+                    vgeomOps->onLine(vt_vgeom, vu_goalVGeom, getVGeom(vl->i), vt_goalVGeom);
                 else if (!fn0)
-                    calcVGeomOnLine(vu_vgeom, vt_goalVGeom, getVGeom(vl->i), vu_goalVGeom);
+                    vgeomOps->onLine(vu_vgeom, vt_goalVGeom, getVGeom(vl->i), vu_goalVGeom);
 
                 pass = true;
             }
             else if (!fn0 && !fn1)
             {
                 if (!fn2)
-                    calcVGeomOnLine(vt_vgeom, vu_goalVGeom, getVGeom(vr->i), vt_goalVGeom);
+                    vgeomOps->onLine(vt_vgeom, vu_goalVGeom, getVGeom(vr->i), vt_goalVGeom);
                 else if (!fn3)
-                    calcVGeomOnLine(vu_vgeom, vt_goalVGeom, getVGeom(vr->i), vu_goalVGeom);
+                    vgeomOps->onLine(vu_vgeom, vt_goalVGeom, getVGeom(vr->i), vu_goalVGeom);
 
                 pass = true;
             }
@@ -2556,29 +3402,29 @@ void SRMesh::startCoarsening(Vertex* vs)
             {
                 if (fn1 == fn3)
                 {
-                    calcVGeomOnFace(vu_vgeom, vt_goalVGeom, getVGeom(vl->i), getVGeom(vr->i), vu_goalVGeom);
+                    vgeomOps->onFace(vu_vgeom, vt_goalVGeom, getVGeom(vl->i), getVGeom(vr->i), vu_goalVGeom);
                     pass = true;
                 }
                 else if (fn3)
                 {
-                    if (fn1->n0 == fn3)
+                    if (getAFace(fn1->n0) == fn3)
                     {
-                        if (!fn1->v1->vmorph)
-                            calcVGeomOnLine(vu_vgeom, vt_goalVGeom, getVGeom(fn1->v1->i), vu_goalVGeom);
+                        if (!getAVertex(fn1->v1)->vmorph)
+                            vgeomOps->onLine(vu_vgeom, vt_goalVGeom, getVGeom(getAVertex(fn1->v1)->i), vu_goalVGeom);
 
                         pass = true;
                     }
-                    else if (fn1->n1 == fn3)
+                    else if (getAFace(fn1->n1) == fn3)
                     {
-                        if (!fn1->v2->vmorph)
-                            calcVGeomOnLine(vu_vgeom, vt_goalVGeom, getVGeom(fn1->v2->i), vu_goalVGeom);
+                        if (!getAVertex(fn1->v2)->vmorph)
+                            vgeomOps->onLine(vu_vgeom, vt_goalVGeom, getVGeom(getAVertex(fn1->v2)->i), vu_goalVGeom);
 
                         pass = true;
                     }
-                    else if (fn1->n2 == fn3)
+                    else if (getAFace(fn1->n2) == fn3)
                     {
-                        if (!fn1->v0->vmorph)
-                            calcVGeomOnLine(vu_vgeom, vt_goalVGeom, getVGeom(fn1->v0->i), vu_goalVGeom);
+                        if (!getAVertex(fn1->v0)->vmorph)
+                            vgeomOps->onLine(vu_vgeom, vt_goalVGeom, getVGeom(getAVertex(fn1->v0)->i), vu_goalVGeom);
 
                         pass = true;
                     }
@@ -2588,65 +3434,32 @@ void SRMesh::startCoarsening(Vertex* vs)
             {
                 if (fn0 == fn2)
                 {
-                    calcVGeomOnFace(vt_vgeom, vu_goalVGeom, getVGeom(vr->i), getVGeom(vl->i), vt_goalVGeom);
+                    vgeomOps->onFace(vt_vgeom, vu_goalVGeom, getVGeom(vr->i), getVGeom(vl->i), vt_goalVGeom);
                 }
                 else if (fn2)
                 {
-                    if (fn0->n0 == fn2 && !fn0->v2->vmorph)
-                        calcVGeomOnLine(vt_vgeom, vu_goalVGeom, getVGeom(fn0->v2->i), vt_goalVGeom);
-                    else if (fn0->n1 == fn2 && !fn0->v0->vmorph)
-                        calcVGeomOnLine(vt_vgeom, vu_goalVGeom, getVGeom(fn0->v0->i), vt_goalVGeom);
-                    else if (fn0->n2 == fn2 && !fn0->v1->vmorph)
-                        calcVGeomOnLine(vt_vgeom, vu_goalVGeom, getVGeom(fn0->v1->i), vt_goalVGeom);
+                    if (getAFace(fn0->n0) == fn2 && !getAVertex(fn0->v2)->vmorph)
+                        vgeomOps->onLine(vt_vgeom, vu_goalVGeom, getVGeom(getAVertex(fn0->v2)->i), vt_goalVGeom);
+                    else if (getAFace(fn0->n1) == fn2 && !getAVertex(fn0->v0)->vmorph)
+                        vgeomOps->onLine(vt_vgeom, vu_goalVGeom, getVGeom(getAVertex(fn0->v0)->i), vt_goalVGeom);
+                    else if (getAFace(fn0->n2) == fn2 && !getAVertex(fn0->v1)->vmorph)
+                        vgeomOps->onLine(vt_vgeom, vu_goalVGeom, getVGeom(getAVertex(fn0->v1)->i), vt_goalVGeom);
                 }
             }
         }
     }
+
+    // the goals are projected into the vertex of vs
+    geometry.setDirty(getVGeomIndex(vs));
 #endif // VDPM_GEOMORPHS_PLUS
 
     vm_t->gtime = gtime >> 1;    // gtime / 2
     vm_t->coarsening = true;
-    vm_t->vgInc.point = (vt_goalVGeom->point - vt_vgeom->point) / vm_t->gtime;
-    vm_t->vgInc.normal = (vt_goalVGeom->normal - vt_vgeom->normal) / vm_t->gtime;
+    vgeomOps->increment(&vm_t->vgInc, vt_goalVGeom, vt_vgeom, vm_t->gtime);
 
     vm_u->gtime = vm_t->gtime;
     vm_u->coarsening = true;
-    vm_u->vgInc.point = (vu_goalVGeom->point - vu_vgeom->point) / vm_u->gtime;
-    vm_u->vgInc.normal = (vu_goalVGeom->normal - vu_vgeom->normal) / vm_u->gtime;
-
-    if (hasColor())
-    {
-        float* vgIncColor = geometry.getVGeomColor(&vm_t->vgInc);
-        float* goalVGeomColor = geometry.getVGeomColor(vt_goalVGeom);
-        float* vgeomColor = geometry.getVGeomColor(vt_vgeom);
-
-        for (int i = 0; i < 3; ++i)
-            vgIncColor[i] = (goalVGeomColor[i] - vgeomColor[i]) / vm_t->gtime;
-
-        vgIncColor = geometry.getVGeomColor(&vm_u->vgInc);
-        goalVGeomColor = geometry.getVGeomColor(vu_goalVGeom);
-        vgeomColor = geometry.getVGeomColor(vu_vgeom);
-
-        for (int i = 0; i < 3; ++i)
-            vgIncColor[i] = (goalVGeomColor[i] - vgeomColor[i]) / vm_t->gtime;
-    }
-
-    if (hasTexCoord())
-    {
-        float* vgIncTexCoord = geometry.getVGeomTexCoord(&vm_t->vgInc);
-        float* goalVGeomTexCoord = geometry.getVGeomTexCoord(vt_goalVGeom);
-        float* vgeomTexCoord = geometry.getVGeomTexCoord(vt_vgeom);
-
-        for (int i = 0; i < 2; ++i)
-            vgIncTexCoord[i] = (goalVGeomTexCoord[i] - vgeomTexCoord[i]) / vm_t->gtime;
-
-        vgIncTexCoord = geometry.getVGeomTexCoord(&vm_u->vgInc);
-        goalVGeomTexCoord = geometry.getVGeomTexCoord(vu_goalVGeom);
-        vgeomTexCoord = geometry.getVGeomTexCoord(vu_vgeom);
-
-        for (int i = 0; i < 2; ++i)
-            vgIncTexCoord[i] = (goalVGeomTexCoord[i] - vgeomTexCoord[i]) / vm_t->gtime;
-    }
+    vgeomOps->increment(&vm_u->vgInc, vu_goalVGeom, vu_vgeom, vm_u->gtime);
 
 #ifdef VDPM_TSTRIP_RESTRIP_ALL
     tstripDirty = true;
@@ -2658,38 +3471,38 @@ void SRMesh::startCoarsening(Vertex* vs)
 
         fl = &faces[baseFCount + vs->i * 2];
         fr = fl + 1;
-        fl_aface = fl->aface;
-        fr_aface = fr->aface;
+        fl_aface = getAFace(fl->aface);
+        fr_aface = getAFace(fr->aface);
 
         aface = NULL;
         if (fl_aface)
         {
             if (fl_aface->tstrip)
             {
-                allocator->freeTStrip(fl_aface->tstrip, afaces);
+                freeTStrip(getTStrip(fl_aface->tstrip));
                 --tstripCount;
             }
 
-            aface = fl_aface->n1;
+            aface = getAFace(fl_aface->n1);
             while (aface && aface != fr_aface)
             {
                 if (aface->tstrip)
                 {
-                    allocator->freeTStrip(aface->tstrip, afaces);
+                    freeTStrip(getTStrip(aface->tstrip));
                     --tstripCount;
                 }
 
                 if (aface->v0 == vu->avertex)
                 {
-                    aface = aface->n0;
+                    aface = getAFace(aface->n0);
                 }
                 else if (aface->v1 == vu->avertex)
                 {
-                    aface = aface->n1;
+                    aface = getAFace(aface->n1);
                 }
                 else if (aface->v2 == vu->avertex)
                 {
-                    aface = aface->n2;
+                    aface = getAFace(aface->n2);
                 }
                 else
                 {
@@ -2700,26 +3513,26 @@ void SRMesh::startCoarsening(Vertex* vs)
         }
         if (fr_aface && aface != fr_aface)
         {
-            aface = fr_aface->n1;
+            aface = getAFace(fr_aface->n1);
             while (aface)
             {
                 if (aface->tstrip)
                 {
-                    allocator->freeTStrip(aface->tstrip, afaces);
+                    freeTStrip(getTStrip(aface->tstrip));
                     --tstripCount;
                 }
 
                 if (aface->v0 == vu->avertex)
                 {
-                    aface = aface->n2;
+                    aface = getAFace(aface->n2);
                 }
                 else if (aface->v1 == vu->avertex)
                 {
-                    aface = aface->n0;
+                    aface = getAFace(aface->n0);
                 }
                 else if (aface->v2 == vu->avertex)
                 {
-                    aface = aface->n1;
+                    aface = getAFace(aface->n1);
                 }
                 else
                 {
@@ -2734,25 +3547,25 @@ void SRMesh::startCoarsening(Vertex* vs)
         {
             if (fr_aface->tstrip)
             {
-                allocator->freeTStrip(fr_aface->tstrip, afaces);
+                freeTStrip(getTStrip(fr_aface->tstrip));
                 --tstripCount;
             }
 
-            aface = fr_aface->n0;
+            aface = getAFace(fr_aface->n0);
             while (aface && aface != fl_aface)
             {
                 if (aface->tstrip)
                 {
-                    allocator->freeTStrip(aface->tstrip, afaces);
+                    freeTStrip(getTStrip(aface->tstrip));
                     --tstripCount;
                 }
 
                 if (aface->v0 == vt->avertex)
-                    aface = aface->n0;
+                    aface = getAFace(aface->n0);
                 else if (aface->v1 == vt->avertex)
-                    aface = aface->n1;
+                    aface = getAFace(aface->n1);
                 else if (aface->v2 == vt->avertex)
-                    aface = aface->n2;
+                    aface = getAFace(aface->n2);
                 else
                 {
                     assert(0);
@@ -2764,21 +3577,21 @@ void SRMesh::startCoarsening(Vertex* vs)
         if (fl_aface && aface != fl_aface)
         {
             assert(!aface);
-            aface = fl_aface->n2;
+            aface = getAFace(fl_aface->n2);
             while (aface)
             {
                 if (aface->tstrip)
                 {
-                    allocator->freeTStrip(aface->tstrip, afaces);
+                    freeTStrip(getTStrip(aface->tstrip));
                     --tstripCount;
                 }
 
                 if (aface->v0 == vt->avertex)
-                    aface = aface->n2;
+                    aface = getAFace(aface->n2);
                 else if (aface->v1 == vt->avertex)
-                    aface = aface->n0;
+                    aface = getAFace(aface->n0);
                 else if (aface->v2 == vt->avertex)
-                    aface = aface->n1;
+                    aface = getAFace(aface->n1);
                 else
                 {
                     assert(0);
@@ -2788,29 +3601,27 @@ void SRMesh::startCoarsening(Vertex* vs)
         }
     }
 #endif // VDPM_TSTRIP_RESTRIP_ALL
+    ++churnStats.coarsenings;
 }
 
 bool SRMesh::finishCoarsening(AVertex* avertex)
 {
-    Vertex* vt = avertex->vertex;
+    Vertex* vt = getVertex(avertex->vertex);
     VMorph* vmorph;
     Vertex* vu;
 
-    if (vt->parent == (vt + 1)->parent)
-        vu = vt + 1;
-    else
-        vu = vt - 1;
+    vu = getSibling(vt);
 
-    vmorph = vu->avertex->vmorph;
+    vmorph = getAVertex(vu->avertex)->vmorph;
     if (vmorph)
     {
-        assert(vmorph->avertex == vu->avertex);
+        assert(vmorph->avertex == getAVertex(vu->avertex));
 
         if (vmorph->gtime > 0)
             return false;
 
         removeVMorph(vmorph);
-        assert(!vu->avertex->vmorph);
+        assert(!getAVertex(vu->avertex)->vmorph);
     }
 
     vmorph = avertex->vmorph;
@@ -2829,67 +3640,27 @@ void SRMesh::abortCoarsening(AVertex* avertex)
     VMorph* vmorph = avertex->vmorph;
     VGeom* vgRefined = getVGeom(avertex->i);
     VGeom* vgeom = getVMorphVGeom(vmorph->vgIndex);
-    Vertex* v = avertex->vertex;
+    Vertex* v = getVertex(avertex->vertex);
 
     vmorph->coarsening = false;
     vmorph->gtime = gtime - vmorph->gtime;
-    vmorph->vgInc.point = (vgRefined->point - vgeom->point) / vmorph->gtime;
-    vmorph->vgInc.normal = (vgRefined->normal - vgeom->normal) / vmorph->gtime;
-
-    if (hasColor())
-    {
-        float* vgIncColor = geometry.getVGeomColor(&vmorph->vgInc);
-        float* vgRefinedColor = geometry.getVGeomColor(vgRefined);
-        float* vgeomColor = geometry.getVGeomColor(vgeom);
-
-        for (int i = 0; i < 3; ++i)
-            vgIncColor[i] = (vgRefinedColor[i] - vgeomColor[i]) / vmorph->gtime;
-    }
-
-    if (hasTexCoord())
-    {
-        float* vgIncTexCoord = geometry.getVGeomTexCoord(&vmorph->vgInc);
-        float* vgRefinedTexCoord = geometry.getVGeomTexCoord(vgRefined);
-        float* vgeomTexCoord = geometry.getVGeomTexCoord(vgeom);
-
-        for (int i = 0; i < 2; ++i)
-            vgIncTexCoord[i] = (vgRefinedTexCoord[i] - vgeomTexCoord[i]) / vmorph->gtime;
-    }
+    vgeomOps->increment(&vmorph->vgInc, vgRefined, vgeom, vmorph->gtime);
 
-    if (v->parent == (v + 1)->parent)
-        ++v;
-    else
-        --v;
+    v = getSibling(v);
 
-    if (v->avertex && (vmorph = v->avertex->vmorph))
+    if (v->avertex && (vmorph = getAVertex(v->avertex)->vmorph))
     {
-        vgRefined = getVGeom(v->avertex->i);
+        vgRefined = getVGeom(getAVertex(v->avertex)->i);
         vgeom = getVMorphVGeom(vmorph->vgIndex);
         vmorph->coarsening = false;
         vmorph->gtime = gtime - vmorph->gtime;
-        vmorph->vgInc.point = (vgRefined->point - vgeom->point) / vmorph->gtime;
-        vmorph->vgInc.normal = (vgRefined->normal - vgeom->normal) / vmorph->gtime;
-
-        if (hasColor())
-        {
-            float* vgIncColor = geometry.getVGeomColor(&vmorph->vgInc);
-            float* vgRefinedColor = geometry.getVGeomColor(vgRefined);
-            float* vgeomColor = geometry.getVGeomColor(vgeom);
-
-            for (int i = 0; i < 3; ++i)
-                vgIncColor[i] = (vgRefinedColor[i] - vgeomColor[i]) / vmorph->gtime;
-        }
-
-        if (hasTexCoord())
-        {
-            float* vgIncTexCoord = geometry.getVGeomTexCoord(&vmorph->vgInc);
-            float* vgRefinedTexCoord = geometry.getVGeomTexCoord(vgRefined);
-            float* vgeomTexCoord = geometry.getVGeomTexCoord(vgeom);
-
-            for (int i = 0; i < 2; ++i)
-                vgIncTexCoord[i] = (vgRefinedTexCoord[i] - vgeomTexCoord[i]) / vmorph->gtime;
-        }
+        vgeomOps->increment(&vmorph->vgInc, vgRefined, vgeom, vmorph->gtime);
     }
+
+#ifdef VDPM_HYSTERESIS
+    vertexHolds[getVertex(getVertex(avertex->vertex)->parent) - vertices] = refineFrame + cooldown;
+#endif
+    ++churnStats.aborts;
 }
 #endif // VDPM_GEOMORPHS
 
@@ -2897,23 +3668,23 @@ void SRMesh::abortCoarsening(AVertex* avertex)
 
 void SRMesh::assertAVertices()
 {
-    AVertex* avertex = avertices.next;
+    AVertex* avertex = getAVertex(avertices->next);
 
 #ifdef VDPM_AMORTIZATION
     bool amortizeAFaceFound = false;
 #endif
 
-    while (avertex != &averticesEnd)
+    while (avertex != averticesEnd)
     {
         assert(avertex->prev != NULL);
         assert(avertex->next != NULL);
-        assert(avertex->next != (void*)0xCDCDCDCD);
+        assert(getAVertex(avertex->next) != (void*)0xCDCDCDCD);
 
 #ifdef VDPM_AMORTIZATION
         if (avertex == amortizeAvertex)
             amortizeAFaceFound = true;
 #endif
-        avertex = avertex->next;
+        avertex = getAVertex(avertex->next);
     }
 #ifdef VDPM_AMORTIZATION
     assert(amortizeAFaceFound);
@@ -2922,34 +3693,34 @@ void SRMesh::assertAVertices()
 
 void SRMesh::assertAFaces()
 {
-    AFace* aface = afaces.next;
+    AFace* aface = getAFace(afaces->next);
 
-    while (aface != &afacesEnd)
+    while (aface != afacesEnd)
     {
     #ifndef VDPM_TSTRIP_RESTRIP_ALL
         assert(aface->tstrip == NULL);
     #endif
         assert(aface->prev != NULL);
         assert(aface->next != NULL);
-        assert(aface->next != (void*)0xCDCDCDCD);
-        assert(!aface->n0 || aface->n0->prev != NULL);
-        assert(!aface->n1 || aface->n1->prev != NULL);
-        assert(!aface->n2 || aface->n2->prev != NULL);
+        assert(getAFace(aface->next) != (void*)0xCDCDCDCD);
+        assert(!aface->n0 || getAFace(aface->n0)->prev != NULL);
+        assert(!aface->n1 || getAFace(aface->n1)->prev != NULL);
+        assert(!aface->n2 || getAFace(aface->n2)->prev != NULL);
 
-        aface = aface->next;
+        aface = getAFace(aface->next);
     }
 
     TStrip* tstrip = tstrips.next;
     while (tstrip != &tstripsEnd)
     {
         AFace* aface;
-        for (aface = tstrip->afaces; aface->next; aface = aface->next)
+        for (aface = tstrip->afaces; aface->next; aface = getAFace(aface->next))
         {
-            assert(aface->tstrip == tstrip);
-            assert(aface->next != (void*)0xCDCDCDCD);
-            assert(!aface->n0 || aface->n0->prev != NULL);
-            assert(!aface->n1 || aface->n1->prev != NULL);
-            assert(!aface->n2 || aface->n2->prev != NULL);
+            assert(getTStrip(aface->tstrip) == tstrip);
+            assert(getAFace(aface->next) != (void*)0xCDCDCDCD);
+            assert(!aface->n0 || getAFace(aface->n0)->prev != NULL);
+            assert(!aface->n1 || getAFace(aface->n1)->prev != NULL);
+            assert(!aface->n2 || getAFace(aface->n2)->prev != NULL);
         }
         assert(aface->tstrip);
         tstrip = tstrip->next;
@@ -2965,11 +3736,11 @@ void SRMesh::assertAFaceNeighbors(AFace* aface)
     {
         unsigned int count = 0;
 
-        if (aface->n0->n0 == aface)
+        if (getAFace(getAFace(aface->n0)->n0) == aface)
             count++;
-        if (aface->n0->n1 == aface)
+        if (getAFace(getAFace(aface->n0)->n1) == aface)
             count++;
-        if (aface->n0->n2 == aface)
+        if (getAFace(getAFace(aface->n0)->n2) == aface)
             count++;
 
         assert(count == 1);
@@ -2979,11 +3750,11 @@ void SRMesh::assertAFaceNeighbors(AFace* aface)
     {
         unsigned int count = 0;
 
-        if (aface->n1->n0 == aface)
+        if (getAFace(getAFace(aface->n1)->n0) == aface)
             count++;
-        if (aface->n1->n1 == aface)
+        if (getAFace(getAFace(aface->n1)->n1) == aface)
             count++;
-        if (aface->n1->n2 == aface)
+        if (getAFace(getAFace(aface->n1)->n2) == aface)
             count++;
 
         assert(count == 1);
@@ -2993,18 +3764,18 @@ void SRMesh::assertAFaceNeighbors(AFace* aface)
     {
         unsigned int count = 0;
 
-        if (aface->n2->n0 == aface)
+        if (getAFace(getAFace(aface->n2)->n0) == aface)
             count++;
-        if (aface->n2->n1 == aface)
+        if (getAFace(getAFace(aface->n2)->n1) == aface)
             count++;
-        if (aface->n2->n2 == aface)
+        if (getAFace(getAFace(aface->n2)->n2) == aface)
             count++;
 
         assert(count == 1);
     }
 
-    AFace* af = afaces.next;
-    while (af != &afacesEnd)
+    AFace* af = getAFace(afaces->next);
+    while (af != afacesEnd)
     {
         unsigned int count = 0;
 
@@ -3012,16 +3783,16 @@ void SRMesh::assertAFaceNeighbors(AFace* aface)
         assert(!af->n1 || (af->n1 != af->n0 && af->n1 != af->n2));
         assert(!af->n2 || (af->n2 != af->n0 && af->n2 != af->n1));
 
-        if (af->n0 == aface)
+        if (getAFace(af->n0) == aface)
             count++;
-        if (af->n1 == aface)
+        if (getAFace(af->n1) == aface)
             count++;
-        if (af->n2 == aface)
+        if (getAFace(af->n2) == aface)
             count++;
 
         assert(count <= 3);
 
-        af = af->next;
+        af = getAFace(af->next);
     }
 }
 
@@ -3050,20 +3821,189 @@ void SRMesh::assertVMorphs()
 void SRMesh::addAVertex(AVertex* avertex)
 {
     ++avertexCount;
-    avertex->next = avertices.next;
-    avertices.next->prev = avertex;
-    avertex->prev = &avertices;
-    avertices.next = avertex;
+    avertex->next = avertices->next;
+    getAVertex(avertices->next)->prev = ref(avertex);
+    avertex->prev = ref(avertices);
+    avertices->next = ref(avertex);
 }
 
 void SRMesh::addAFace(AFace* aface)
 {
     ++afaceCount;
-    aface->next = afaces.next;
-    afaces.next->prev = aface;
-    aface->prev = &afaces;
-    afaces.next = aface;
+    aface->next = afaces->next;
+    getAFace(afaces->next)->prev = ref(aface);
+    aface->prev = ref(afaces);
+    afaces->next = ref(aface);
+}
+
+AVertex* SRMesh::allocAVertex()
+{
+#ifdef VDPM_INDEX_TOPOLOGY
+    AVertex* avertex = freeAVertices;
+
+    if (avertex)
+    {
+        freeAVertices = getAVertex(avertex->next);
+        return avertex;
+    }
+
+    // a vertex has at most one active vertex, the pool never needs to grow
+    assert(avertexPoolTop < vcount + 2);
+    return &avertexPool[avertexPoolTop++];
+#else
+    return allocator->allocAVertex();
+#endif // VDPM_INDEX_TOPOLOGY
+}
+
+void SRMesh::freeAVertex(AVertex* avertex)
+{
+#ifdef VDPM_INDEX_TOPOLOGY
+    getAVertex(avertex->prev)->next = avertex->next;
+    getAVertex(avertex->next)->prev = avertex->prev;
+
+    avertex->next = ref(freeAVertices);
+    avertex->prev = NULL;
+    freeAVertices = avertex;
+#else
+    allocator->freeAVertex(avertex);
+#endif // VDPM_INDEX_TOPOLOGY
+}
+
+AFace* SRMesh::allocAFace()
+{
+#ifdef VDPM_INDEX_TOPOLOGY
+    AFace* aface = freeAFaces;
+
+    if (aface)
+    {
+        freeAFaces = getAFace(aface->next);
+        return aface;
+    }
+
+    // likewise a face has at most one active face
+    assert(afacePoolTop < fcount + 2);
+    return &afacePool[afacePoolTop++];
+#else
+    return allocator->allocAFace();
+#endif // VDPM_INDEX_TOPOLOGY
+}
+
+void SRMesh::freeAFace(AFace* aface)
+{
+#ifdef VDPM_FACE_BVH
+    if (aface->bvhLeaf)
+    {
+        bvh->remove(aface->bvhLeaf);
+        aface->bvhLeaf = 0;
+    }
+#endif
+
+#ifdef VDPM_INDEX_TOPOLOGY
+    getAFace(aface->prev)->next = aface->next;
+    getAFace(aface->next)->prev = aface->prev;
+
+    aface->next = ref(freeAFaces);
+    aface->prev = NULL;
+    freeAFaces = aface;
+#else
+    allocator->freeAFace(aface);
+#endif // VDPM_INDEX_TOPOLOGY
+}
+
+TStrip* SRMesh::allocTStrip()
+{
+#ifdef VDPM_INDEX_TOPOLOGY
+    TStrip* tstrip = freeTStrips;
+
+    if (tstrip)
+    {
+        freeTStrips = tstrip->next;
+        return tstrip;
+    }
+
+    if (tstripPoolTop == tstripPoolSize)
+    {
+        tstripPoolSize += fcount / 16 + 1;
+        tstripPool = (TStrip**)::realloc(tstripPool, sizeof(TStrip*) * tstripPoolSize);
+    }
+
+    tstrip = new TStrip();
+    tstrip->index = tstripPoolTop + 1;
+    tstripPool[tstripPoolTop++] = tstrip;
+    return tstrip;
+#else
+    return allocator->allocTStrip();
+#endif // VDPM_INDEX_TOPOLOGY
+}
+
+void SRMesh::freeTStrip(TStrip* tstrip)
+{
+    AFace* aface;
+
+    for (aface = tstrip->afaces; aface->next; aface = getAFace(aface->next))
+        aface->tstrip = NULL;
+    aface->tstrip = NULL;
+
+    delete[] tstrip->vgIndices;
+
+    // the faces go back to the unstripped list
+    aface->next = afaces->next;
+    getAFace(afaces->next)->prev = ref(aface);
+    tstrip->afaces->prev = ref(afaces);
+    afaces->next = ref(tstrip->afaces);
+
+#ifdef VDPM_INDEX_TOPOLOGY
+    tstrip->prev->next = tstrip->next;
+    tstrip->next->prev = tstrip->prev;
+
+    tstrip->next = freeTStrips;
+    freeTStrips = tstrip;
+#else
+    allocator->freeTStrip(tstrip);
+#endif // VDPM_INDEX_TOPOLOGY
+}
+
+void SRMesh::initActiveLists()
+{
+    avertices->next = ref(averticesEnd);
+    averticesEnd->prev = ref(avertices);
+    afaces->next = ref(afacesEnd);
+    afacesEnd->prev = ref(afaces);
+
+#ifdef VDPM_AMORTIZATION
+    amortizeAvertex = averticesEnd;
+#endif
+}
+
+#ifdef VDPM_INDEX_TOPOLOGY
+int SRMesh::createTopologyPools(unsigned int vcount, unsigned int fcount)
+{
+    // two more slots for the sentinels
+    avertexPool = new AVertex[vcount + 2]();
+    if (!avertexPool)
+        goto error;
+
+    afacePool = new AFace[fcount + 2]();
+    if (!afacePool)
+        goto error;
+
+    avertices = &avertexPool[0];
+    averticesEnd = &avertexPool[1];
+    afaces = &afacePool[0];
+    afacesEnd = &afacePool[1];
+    initActiveLists();
+
+    avertexPoolTop = afacePoolTop = 2;
+    freeAVertices = NULL;
+    freeAFaces = NULL;
+    return 0;
+
+error:
+    delete[] avertexPool;
+    avertexPool = NULL;
+    return -1;
 }
+#endif // VDPM_INDEX_TOPOLOGY
 
 void SRMesh::addTStrip(TStrip* tstrip)
 {
@@ -3075,18 +4015,15 @@ void SRMesh::addTStrip(TStrip* tstrip)
 
 unsigned int SRMesh::getVGeomIndex(Vertex* vs)
 {
-    div_t result;
+    // vt and vu of vsplit k are loaded at baseVCount + k * 2 and baseVCount + k * 2 + 1,
+    // so every vertex shares its index with its vgeom
+    return (unsigned int)(vs - vertices);
+}
 
-    if (vs->parent)
-    {
-        result = div(vs - &vertices[baseVCount], 2);
-        if (result.rem)
-            return vsplits[result.quot].vu_i;
-        else
-            return vsplits[result.quot].vt_i;
-    }
-    else
-        return vs - vertices;
+inline Vertex* SRMesh::getSibling(Vertex* v)
+{
+    // vt and vu of vsplit k are stored at baseVCount + k * 2
+    return ((v - vertices - baseVCount) & 1) ? v - 1 : v + 1;
 }
 
 inline unsigned int SRMesh::getVertexIndex(AVertex* av, TStrip* tstrip)
@@ -3111,6 +4048,7 @@ VMorph* SRMesh::createVMorph()
 {
     VMorph* vmorph = allocator->allocVMorph();
     vmorph->vgIndex = getFreeVMorphIndex();
+    geometry.setDirty(vmorph->vgIndex);     // written by the caller
     vmorph->next = vmorphs.next;
     vmorphs.next->prev = vmorph;
     vmorph->prev = &vmorphs;
@@ -3135,27 +4073,16 @@ unsigned int SRMesh::getFreeVMorphIndex()
 {
     unsigned int i, size;
 
-#ifndef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-    if (!vmorphVgeoms)
-        vmorphVgeoms = (VGeom*)renderer->mapBuffer(RENDERER_VERTEX_BUFFER, geometry.vbo, geometry.vgeomSize * vcount, geometry.vgeomSize * vmorphSize, RENDERER_WRITE_ONLY);
-#endif // !VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
-
     for (i = 0; i < vmorphSize; ++i)
     {
         if (isVMorphIndexFree(i))
             return vcount + i;
     }
 
-    renderer->flushBuffer(RENDERER_VERTEX_BUFFER, geometry.vbo, geometry.vgeomSize * vcount, vmorphSize);
-    renderer->unmapBuffer(RENDERER_VERTEX_BUFFER, geometry.vbo);
     size = vmorphSize;
     vmorphSize *= 2;
-    geometry.resize(geometry.vgeomCount + vmorphSize);
-#ifdef VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
+    geometry.resize(vcount + vmorphSize);
     vmorphVgeoms = getVGeom(vcount);
-#else
-    vmorphVgeoms = (VGeom*)renderer->mapBuffer(RENDERER_VERTEX_BUFFER, geometry.vbo, geometry.vgeomSize * vcount, vmorphSize, RENDERER_WRITE_ONLY);
-#endif // VDPM_RENDERER_OPENGL_VBO_MAP_VGEOM
 
     for (i = size; i < vmorphSize; ++i)
     {
@@ -3190,151 +4117,31 @@ void SRMesh::addGMorphTStrip(TStrip* tstrip)
     gmorphTstrips.next = tstrip;
 }
 
-#ifdef VDPM_GEOMORPHS_PLUS
-
-void SRMesh::calcVGeomOnLine(const VGeom* vu_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom)
+void SRMesh::selectVGeomKernels()
 {
-    Point vec_lu, vec_lr;
-    float lambda, result;
-
-    vec_lu = vu_vgeom->point - vl_vgeom->point;
-    vec_lr = vr_vgeom->point - vl_vgeom->point;
-    result = dotProduct(vec_lr, vec_lr);
-    lambda = (result) ? dotProduct(vec_lu, vec_lr) / result : 0.0f;
-
-    if (lambda <= 0.0f)
-    {
-        ::memcpy(vgeom, vl_vgeom, geometry.vgeomSize);
-    }
-    else if (lambda >= 1.0f)
+    switch (geometry.vgeomSize / sizeof(float))
     {
-        ::memcpy(vgeom, vr_vgeom, geometry.vgeomSize);
-    }
-    else
-    {
-        vgeom->point = vl_vgeom->point + lambda * vec_lr;
-        vgeom->normal = vl_vgeom->normal + lambda * (vr_vgeom->normal - vl_vgeom->normal);
-
-        if (hasColor())
-        {
-            float* vgeomColor = geometry.getVGeomColor(vgeom);
-            float* vlVgeomColor = geometry.getVGeomColor(vl_vgeom);
-            float* vrVgeomColor = geometry.getVGeomColor(vr_vgeom);
-
-            for (int i = 0; i < 3; ++i)
-                vgeomColor[i] = vlVgeomColor[i] + lambda * (vrVgeomColor[i] - vlVgeomColor[i]);
-        }
-
-        if (hasTexCoord())
-        {
-            float* vgeomTexCoord = geometry.getVGeomTexCoord(vgeom);
-            float* vlVgeomTexCoord = geometry.getVGeomTexCoord(vl_vgeom);
-            float* vrVgeomTexCoord = geometry.getVGeomTexCoord(vr_vgeom);
-
-            for (int i = 0; i < 2; ++i)
-                vgeomTexCoord[i] = vlVgeomTexCoord[i] + lambda * (vrVgeomTexCoord[i] - vlVgeomTexCoord[i]);
-        }
+    case VGEOM_LAYOUT_PN:
+        vgeomOps = &VGeomKernels<VGEOM_LAYOUT_PN>::ops;
+        updateVMorphsFunc = &SRMesh::updateVMorphs<VGEOM_LAYOUT_PN>;
+        break;
+
+    case VGEOM_LAYOUT_PNT:
+        vgeomOps = &VGeomKernels<VGEOM_LAYOUT_PNT>::ops;
+        updateVMorphsFunc = &SRMesh::updateVMorphs<VGEOM_LAYOUT_PNT>;
+        break;
+
+    case VGEOM_LAYOUT_PNC:
+        vgeomOps = &VGeomKernels<VGEOM_LAYOUT_PNC>::ops;
+        updateVMorphsFunc = &SRMesh::updateVMorphs<VGEOM_LAYOUT_PNC>;
+        break;
+
+    default:
+        assert(geometry.vgeomSize == VGeomKernels<VGEOM_LAYOUT_PNCT>::SIZE);
+        vgeomOps = &VGeomKernels<VGEOM_LAYOUT_PNCT>::ops;
+        updateVMorphsFunc = &SRMesh::updateVMorphs<VGEOM_LAYOUT_PNCT>;
+        break;
     }
 }
 
-void SRMesh::calcVGeomOnFace(const VGeom* vu_vgeom, const VGeom* vs_vgeom, const VGeom* vl_vgeom, const VGeom* vr_vgeom, VGeom* vgeom)
-{
-    Point vec_sl, vec_sr, vec_su, faceNormal;
-    float lambda, result, dot00, dot01, dot02, dot11, dot12, invDenom, u, v;
-
-    vec_sl = vl_vgeom->point - vs_vgeom->point;
-    vec_sr = vr_vgeom->point - vs_vgeom->point;
-    faceNormal = crossProduct(vec_sl, vec_sr);
-    result = dotProduct(faceNormal, faceNormal);
-    lambda = (result) ? (dotProduct(faceNormal, vs_vgeom->point) -
-        dotProduct(faceNormal, vu_vgeom->point)) / result : 0.0f;
-    vgeom->point = vu_vgeom->point + lambda * faceNormal;
-    vec_su = vgeom->point - vs_vgeom->point;
-
-    // compute dot products
-    dot00 = dotProduct(vec_sr, vec_sr);
-    dot01 = dotProduct(vec_sr, vec_sl);
-    dot02 = dotProduct(vec_sr, vec_su);
-    dot11 = dotProduct(vec_sl, vec_sl);
-    dot12 = dotProduct(vec_sl, vec_su);
-
-    // compute barycentric coordinates
-    invDenom = 1.0f / (dot00 * dot11 - dot01 * dot01);
-    u = (dot11 * dot02 - dot01 * dot12) * invDenom;
-    v = (dot00 * dot12 - dot01 * dot02) * invDenom;
-
-    if (u >= 0.0f)
-    {
-        if (v >= 0.0f)
-        {
-            if (u + v <= 1.0f)
-            {
-                // inside triangle
-                vgeom->normal = vs_vgeom->normal + u * (vr_vgeom->normal - vs_vgeom->normal) + v * (vl_vgeom->normal - vs_vgeom->normal);
-
-                if (hasColor())
-                {
-                    float* vgeomColor = geometry.getVGeomColor(vgeom);
-                    float* vsVgeomColor = geometry.getVGeomColor(vs_vgeom);
-                    float* vrVgeomColor = geometry.getVGeomColor(vr_vgeom);
-                    float* vlVgeomColor = geometry.getVGeomColor(vl_vgeom);
-
-                    for (int i = 0; i < 3; ++i)
-                        vgeomColor[i] = vsVgeomColor[i] + u * (vrVgeomColor[i] - vsVgeomColor[i]) + v * (vlVgeomColor[i] - vsVgeomColor[i]);
-                }
-
-                if (hasTexCoord())
-                {
-                    float* vgeomTexCoord = geometry.getVGeomTexCoord(vgeom);
-                    float* vsVgeomTexCoord = geometry.getVGeomTexCoord(vs_vgeom);
-                    float* vrVgeomTexCoord = geometry.getVGeomTexCoord(vr_vgeom);
-                    float* vlVgeomTexCoord = geometry.getVGeomTexCoord(vl_vgeom);
-
-                    for (int i = 0; i < 2; ++i)
-                        vgeomTexCoord[i] = vsVgeomTexCoord[i] + u * (vrVgeomTexCoord[i] - vsVgeomTexCoord[i]) + v * (vlVgeomTexCoord[i] - vsVgeomTexCoord[i]);
-                }
-            }
-            else
-            {
-                // outside line vl_vr
-                calcVGeomOnLine(vu_vgeom, vl_vgeom, vr_vgeom, vgeom);
-            }
-        }
-        else
-        {
-            if (u + v <= 1.0f)
-            {
-                // outside line vs_vr
-                calcVGeomOnLine(vu_vgeom, vs_vgeom, vr_vgeom, vgeom);
-            }
-            else
-            {
-                // outside vr
-                ::memcpy(vgeom, vr_vgeom, geometry.vgeomSize);
-            }
-        }
-    }
-    else
-    {
-        if (v >= 0.0f)
-        {
-            if (u + v <= 1.0f)
-            {
-                // outside line vl_vs
-                calcVGeomOnLine(vu_vgeom, vl_vgeom, vs_vgeom, vgeom);
-            }
-            else
-            {
-                // outside vl
-                ::memcpy(vgeom, vl_vgeom, geometry.vgeomSize);
-            }
-        }
-        else
-        {
-            // outside vs
-            ::memcpy(vgeom, vs_vgeom, geometry.vgeomSize);
-        }
-    }
-}
-#endif // VDPM_GEOMORPHS_PLUS
 #endif // VDPM_GEOMORPHS
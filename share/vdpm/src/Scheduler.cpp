@@ -0,0 +1,171 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include "vdpm/Scheduler.h"
+#include "vdpm/SRMesh.h"
+
+using namespace std;
+using namespace vdpm;
+
+Scheduler::Scheduler(unsigned int threadCount) : pending(0), generation(0), quit(false), job(NULL), param(NULL)
+{
+    unsigned int i;
+
+    if (threadCount == 0)
+        threadCount = thread::hardware_concurrency();
+
+    if (threadCount == 0)
+        threadCount = 1;
+
+    for (i = 0; i < threadCount; ++i)
+        workers.push_back(new Worker());
+
+    for (i = 1; i < threadCount; ++i)
+        threads.push_back(thread(&Scheduler::workerMain, this, i));
+}
+
+Scheduler::~Scheduler()
+{
+    unsigned int i;
+
+    {
+        lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wakeCondition.notify_all();
+
+    for (i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    for (i = 0; i < workers.size(); ++i)
+        delete workers[i];
+}
+
+void Scheduler::workerMain(unsigned int id)
+{
+    unsigned int seen = 0;
+
+    for (;;)
+    {
+        {
+            unique_lock<std::mutex> lock(mutex);
+
+            while (!quit && generation == seen)
+                wakeCondition.wait(lock);
+
+            if (quit)
+                return;
+
+            seen = generation;
+        }
+        execute(id);
+    }
+}
+
+bool Scheduler::popJob(unsigned int id, unsigned int& index)
+{
+    unsigned int i, victim;
+
+    // own jobs are taken from the back, stolen ones from the front
+    {
+        lock_guard<std::mutex> lock(workers[id]->mutex);
+
+        if (!workers[id]->jobs.empty())
+        {
+            index = workers[id]->jobs.back();
+            workers[id]->jobs.pop_back();
+            return true;
+        }
+    }
+
+    for (i = 1; i < workers.size(); ++i)
+    {
+        victim = (id + i) % workers.size();
+        lock_guard<std::mutex> lock(workers[victim]->mutex);
+
+        if (!workers[victim]->jobs.empty())
+        {
+            index = workers[victim]->jobs.front();
+            workers[victim]->jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::execute(unsigned int id)
+{
+    unsigned int index;
+
+    while (popJob(id, index))
+    {
+        job(param, index);
+
+        if (pending.fetch_sub(1) == 1)
+        {
+            lock_guard<std::mutex> lock(mutex);
+            doneCondition.notify_all();
+        }
+    }
+}
+
+void Scheduler::run(SchedulerJob job, void* param, unsigned int count)
+{
+    unsigned int i;
+
+    if (count == 0)
+        return;
+
+    this->job = job;
+    this->param = param;
+    pending = count;
+
+    for (i = 0; i < count; ++i)
+    {
+        Worker* worker = workers[i % workers.size()];
+        lock_guard<std::mutex> lock(worker->mutex);
+        worker->jobs.push_back(i);
+    }
+
+    {
+        lock_guard<std::mutex> lock(mutex);
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    execute(0);
+
+    unique_lock<std::mutex> lock(mutex);
+    while (pending > 0)
+        doneCondition.wait(lock);
+}
+
+static void refineJob(void* param, unsigned int index)
+{
+    SRMesh* srmesh = ((SRMesh**)param)[index];
+
+#ifdef VDPM_GEOMORPHS
+    srmesh->updateVMorphs();
+#endif
+    srmesh->adaptRefine();
+    srmesh->updateScene();
+}
+
+void Scheduler::refine(SRMesh** meshes, unsigned int count)
+{
+    run(refineJob, meshes, count);
+}
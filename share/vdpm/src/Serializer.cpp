@@ -19,7 +19,6 @@
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
-#include "vdpm/Allocator.h"
 #include "vdpm/Serializer.h"
 #include "vdpm/SRMesh.h"
 #include "vdpm/StdInStream.h"
@@ -30,6 +29,12 @@ using namespace vdpm;
 #define VDPM_FILE_FORMAT_MAGIC \
         ((long)'v' + ((long)'d' << 8) + ((long)'p' << 16) + ((long)'m' << 24))
 
+#define VDPM_FRONT_FORMAT_MAGIC \
+        ((long)'v' + ((long)'d' << 8) + ((long)'p' << 16) + ((long)'f' << 24))
+
+#define VDPM_STREAM_FORMAT_MAGIC \
+        ((long)'v' + ((long)'d' << 8) + ((long)'p' << 16) + ((long)'s' << 24))
+
 #define VDPM_FILE_FORMAT_SRMESH     0x00000001
 #define VDPM_FILE_FORMAT_TEXNAME    0x00000002
 #define VDPM_FILE_FORMAT_END        0x00000003
@@ -70,10 +75,63 @@ error:
     return -1;
 }
 
+// point, normal, color and texcoord are stored in the order they are laid out in memory
+void Serializer::readVGeom(InStream& is, SRMesh* srmesh, VGeom* vgeom)
+{
+    unsigned int count = srmesh->getVGeomSize() / sizeof(float);
+    float* ptr = &vgeom->point.x;
+
+    for (unsigned int j = 0; j < count; ++j)
+        is.readFloat(ptr[j]);
+}
+
+void Serializer::writeVGeom(OutStream& os, SRMesh* srmesh, VGeom* vgeom)
+{
+    unsigned int count = srmesh->getVGeomSize() / sizeof(float);
+    float* ptr = &vgeom->point.x;
+
+    for (unsigned int j = 0; j < count; ++j)
+        os.writeFloat(ptr[j]);
+}
+
+void Serializer::readBaseFaces(InStream& is, SRMesh* srmesh)
+{
+    AFace* aface;
+    uint32_t index, i;
+
+    for (i = 0; i < srmesh->fcount; ++i)
+        srmesh->faces[i].aface = NULL;
+
+    for (i = 0; i < srmesh->baseFCount; ++i)
+    {
+        aface = srmesh->allocAFace();
+
+        is.readUInt(index);
+        aface->v0 = srmesh->vertices[index].avertex;
+        is.readUInt(index);
+        aface->v1 = srmesh->vertices[index].avertex;
+        is.readUInt(index);
+        aface->v2 = srmesh->vertices[index].avertex;
+
+        srmesh->faces[i].aface = srmesh->ref(aface);
+        aface->tstrip = NULL;
+        srmesh->addAFace(aface);
+    }
+    // update neighbors of afaces
+    for (i = 0; i < srmesh->baseFCount; ++i)
+    {
+        is.readUInt(index);
+        srmesh->getAFace(srmesh->faces[i].aface)->n0 = (index == UINT_MAX) ? NULL : srmesh->faces[index].aface;
+        is.readUInt(index);
+        srmesh->getAFace(srmesh->faces[i].aface)->n1 = (index == UINT_MAX) ? NULL : srmesh->faces[index].aface;
+        is.readUInt(index);
+        srmesh->getAFace(srmesh->faces[i].aface)->n2 = (index == UINT_MAX) ? NULL : srmesh->faces[index].aface;
+    }
+}
+
 int Serializer::readSRMesh(InStream& is, SRMesh* srmesh)
 {
     AVertex* avertex;
-    AFace* aface;
     uint32_t index, vt_i, vu_i, i, flags;
     bool hasColor, hasTexCoord;
     unsigned int vgeomCount;
@@ -96,11 +154,23 @@ int Serializer::readSRMesh(InStream& is, SRMesh* srmesh)
     if (!srmesh->vertices)
         goto error;
 
+#ifdef VDPM_HYSTERESIS
+    // vsplit() and ecol() stamp these whether or not the mesh is ever realized
+    srmesh->vertexHolds = (unsigned int*)::calloc(srmesh->vcount, sizeof(unsigned int));
+    if (!srmesh->vertexHolds)
+        goto error;
+#endif
+
+#ifdef VDPM_INDEX_TOPOLOGY
+    if (srmesh->createTopologyPools(srmesh->vcount, srmesh->baseFCount + srmesh->vsplitCount * 2))
+        goto error;
+#endif
+
     for (i = 0; i < srmesh->vcount; ++i)
     {
         srmesh->vertices[i].avertex = NULL;
         is.readUInt(index);
-        srmesh->vertices[i].parent = (index == UINT_MAX) ? NULL : &srmesh->vertices[index];
+        srmesh->vertices[i].parent = srmesh->ref((index == UINT_MAX) ? NULL : &srmesh->vertices[index]);
         is.readUInt(srmesh->vertices[i].i);
     }
 
@@ -122,84 +192,22 @@ int Serializer::readSRMesh(InStream& is, SRMesh* srmesh)
     {
         VGeom* vgeom = srmesh->geometry.getVGeom(i);
 
-        avertex = Allocator::getInstance().allocAVertex();
-
-        is.readFloat(vgeom->point.x);
-        is.readFloat(vgeom->point.y);
-        is.readFloat(vgeom->point.z);
-        is.readFloat(vgeom->normal.x);
-        is.readFloat(vgeom->normal.y);
-        is.readFloat(vgeom->normal.z);
-
-        if (hasColor)
-        {
-            float* ptr = srmesh->geometry.getVGeomColor(vgeom);
-            for (int j = 0; j < 3; ++j)
-                is.readFloat(*ptr++);
-        }
-        if (hasTexCoord)
-        {
-            float* ptr = srmesh->geometry.getVGeomTexCoord(vgeom);
-            for (int j = 0; j < 2; ++j)
-                is.readFloat(*ptr++);
-        }
+        avertex = srmesh->allocAVertex();
+        readVGeom(is, srmesh, vgeom);
 
         avertex->i = i;
-        srmesh->vertices[i].avertex = avertex;
-        avertex->vertex = &srmesh->vertices[i];
+        srmesh->vertices[i].avertex = srmesh->ref(avertex);
+        avertex->vertex = srmesh->ref(&srmesh->vertices[i]);
         avertex->vmorph = NULL;
         srmesh->addAVertex(avertex);
     }
     for (i = 0; i < srmesh->vsplitCount; ++i)
     {
-        VGeom* vgeom;
-
         vt_i = srmesh->baseVCount + i * 2;
         vu_i = srmesh->baseVCount + i * 2 + 1;
 
-        vgeom = srmesh->geometry.getVGeom(vt_i);
-
-        is.readFloat(vgeom->point.x);
-        is.readFloat(vgeom->point.y);
-        is.readFloat(vgeom->point.z);
-        is.readFloat(vgeom->normal.x);
-        is.readFloat(vgeom->normal.y);
-        is.readFloat(vgeom->normal.z);
-
-        if (hasColor)
-        {
-            float* ptr = srmesh->geometry.getVGeomColor(vgeom);
-            for (int j = 0; j < 3; ++j)
-                is.readFloat(*ptr++);
-        }
-        if (hasTexCoord)
-        {
-            float* ptr = srmesh->geometry.getVGeomTexCoord(vgeom);
-            for (int j = 0; j < 2; ++j)
-                is.readFloat(*ptr++);
-        }
-
-        vgeom = srmesh->geometry.getVGeom(vu_i);
-
-        is.readFloat(vgeom->point.x);
-        is.readFloat(vgeom->point.y);
-        is.readFloat(vgeom->point.z);
-        is.readFloat(vgeom->normal.x);
-        is.readFloat(vgeom->normal.y);
-        is.readFloat(vgeom->normal.z);
-
-        if (hasColor)
-        {
-            float* ptr = srmesh->geometry.getVGeomColor(vgeom);
-            for (int j = 0; j < 3; ++j)
-                is.readFloat(*ptr++);
-        }
-        if (hasTexCoord)
-        {
-            float* ptr = srmesh->geometry.getVGeomTexCoord(vgeom);
-            for (int j = 0; j < 2; ++j)
-                is.readFloat(*ptr++);
-        }
+        readVGeom(is, srmesh, srmesh->geometry.getVGeom(vt_i));
+        readVGeom(is, srmesh, srmesh->geometry.getVGeom(vu_i));
     }
 #ifdef VDPM_GEOMORPHS
     for (i = srmesh->vcount; i < vgeomCount; ++i)
@@ -214,34 +222,7 @@ int Serializer::readSRMesh(InStream& is, SRMesh* srmesh)
     if (!srmesh->faces)
         goto error;
 
-    for (i = 0; i < srmesh->fcount; ++i)
-        srmesh->faces[i].aface = NULL;
-
-    for (i = 0; i < srmesh->baseFCount; ++i)
-    {
-        aface = Allocator::getInstance().allocAFace();
-
-        is.readUInt(index);
-        aface->v0 = srmesh->vertices[index].avertex;
-        is.readUInt(index);
-        aface->v1 = srmesh->vertices[index].avertex;
-        is.readUInt(index);
-        aface->v2 = srmesh->vertices[index].avertex;
-
-        srmesh->faces[i].aface = aface;
-        aface->tstrip = NULL;
-        srmesh->addAFace(aface);
-    }
-    // update neighbors of afaces
-    for (i = 0; i < srmesh->baseFCount; ++i)
-    {
-        is.readUInt(index);
-        srmesh->faces[i].aface->n0 = (index == UINT_MAX) ? NULL : srmesh->faces[index].aface;
-        is.readUInt(index);
-        srmesh->faces[i].aface->n1 = (index == UINT_MAX) ? NULL : srmesh->faces[index].aface;
-        is.readUInt(index);
-        srmesh->faces[i].aface->n2 = (index == UINT_MAX) ? NULL : srmesh->faces[index].aface;
-    }
+    readBaseFaces(is, srmesh);
 
     srmesh->vsplits = new VSplit[srmesh->vsplitCount];
     if (!srmesh->vsplits)
@@ -256,13 +237,13 @@ int Serializer::readSRMesh(InStream& is, SRMesh* srmesh)
         srmesh->vsplits[i].vu_i = vu_i;
 
         is.readUInt(index);
-        srmesh->vsplits[i].fn0 = (index == UINT_MAX) ? NULL : &srmesh->faces[index];
+        srmesh->vsplits[i].fn0 = srmesh->ref((index == UINT_MAX) ? NULL : &srmesh->faces[index]);
         is.readUInt(index);
-        srmesh->vsplits[i].fn1 = (index == UINT_MAX) ? NULL : &srmesh->faces[index];
+        srmesh->vsplits[i].fn1 = srmesh->ref((index == UINT_MAX) ? NULL : &srmesh->faces[index]);
         is.readUInt(index);
-        srmesh->vsplits[i].fn2 = (index == UINT_MAX) ? NULL : &srmesh->faces[index];
+        srmesh->vsplits[i].fn2 = srmesh->ref((index == UINT_MAX) ? NULL : &srmesh->faces[index]);
         is.readUInt(index);
-        srmesh->vsplits[i].fn3 = (index == UINT_MAX) ? NULL : &srmesh->faces[index];
+        srmesh->vsplits[i].fn3 = srmesh->ref((index == UINT_MAX) ? NULL : &srmesh->faces[index]);
 
         is.readFloat(srmesh->vsplits[i].radius);
         is.readFloat(srmesh->vsplits[i].sin2alpha);
@@ -290,8 +271,6 @@ SRMesh* Serializer::readSRMesh(InStream& is)
     if (readSRMesh(is, srmesh))
         goto error;
 
-    srmesh->allocator = &Allocator::getInstance();
-
     return srmesh;
 
 error:
@@ -337,8 +316,6 @@ SRMesh* Serializer::loadSRMesh(InStream& is)
         }
     }
 
-    srmesh->allocator = &Allocator::getInstance();
-
     return srmesh;
 
 error:
@@ -353,137 +330,28 @@ SRMesh* Serializer::loadSRMesh(const char filePath[])
     return srmesh;
 }
 
-int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
+void Serializer::writeBaseFaces(OutStream& os, SRMesh* srmesh)
 {
-    uint32_t index, vt_i, vu_i, i, flags;
+    uint32_t index, i;
     AFace* aface;
 
-    flags = 0;
-
-    if (srmesh->hasColor())
-        flags |= VDPM_HAS_COLOR;
-
-    if (srmesh->hasTexCoord())
-        flags |= VDPM_HAS_TEXCOORD;
-
-    os.writeUInt(flags);
-
-    os.writeFloat(srmesh->boundMin.x);
-    os.writeFloat(srmesh->boundMin.y);
-    os.writeFloat(srmesh->boundMin.z);
-    os.writeFloat(srmesh->boundMax.x);
-    os.writeFloat(srmesh->boundMax.y);
-    os.writeFloat(srmesh->boundMax.z);
-
-    os.writeUInt(srmesh->baseVCount);
-    os.writeUInt(srmesh->baseFCount);
-    os.writeUInt(srmesh->vsplitCount);
-
-    for (i = 0; i < srmesh->vcount; ++i)
-    {
-        if (srmesh->vertices[i].parent == NULL)
-            index = UINT_MAX;
-        else
-            index = srmesh->vertices[i].parent - srmesh->vertices;
-
-        os.writeUInt(index);
-        os.writeUInt(srmesh->vertices[i].i);
-    }
-
-    for (i = 0; i < srmesh->baseVCount; ++i)
-    {
-        VGeom* vgeom = srmesh->geometry.getVGeom(i);
-
-        os.writeFloat(vgeom->point.x);
-        os.writeFloat(vgeom->point.y);
-        os.writeFloat(vgeom->point.z);
-        os.writeFloat(vgeom->normal.x);
-        os.writeFloat(vgeom->normal.y);
-        os.writeFloat(vgeom->normal.z);
-
-        if (srmesh->hasColor())
-        {
-            float* ptr = srmesh->geometry.getVGeomColor(vgeom);
-            for (int j = 0; j < 3; ++j)
-                os.writeFloat(*ptr++);
-        }
-        if (srmesh->hasTexCoord())
-        {
-            float* ptr = srmesh->geometry.getVGeomTexCoord(vgeom);
-            for (int j = 0; j < 2; ++j)
-                os.writeFloat(*ptr++);
-        }
-    }
-
-    for (i = 0; i < srmesh->vsplitCount; ++i)
-    {
-        VGeom* vgeom;
-
-        vt_i = srmesh->baseVCount + i * 2;
-        vu_i = srmesh->baseVCount + i * 2 + 1;
-
-        vgeom = srmesh->geometry.getVGeom(vt_i);
-
-        os.writeFloat(vgeom->point.x);
-        os.writeFloat(vgeom->point.y);
-        os.writeFloat(vgeom->point.z);
-        os.writeFloat(vgeom->normal.x);
-        os.writeFloat(vgeom->normal.y);
-        os.writeFloat(vgeom->normal.z);
-
-        if (srmesh->hasColor())
-        {
-            float* ptr = srmesh->geometry.getVGeomColor(vgeom);
-            for (int j = 0; j < 3; ++j)
-                os.writeFloat(*ptr++);
-        }
-        if (srmesh->hasTexCoord())
-        {
-            float* ptr = srmesh->geometry.getVGeomTexCoord(vgeom);
-            for (int j = 0; j < 2; ++j)
-                os.writeFloat(*ptr++);
-        }
-
-        vgeom = srmesh->geometry.getVGeom(vu_i);
-
-        os.writeFloat(vgeom->point.x);
-        os.writeFloat(vgeom->point.y);
-        os.writeFloat(vgeom->point.z);
-        os.writeFloat(vgeom->normal.x);
-        os.writeFloat(vgeom->normal.y);
-        os.writeFloat(vgeom->normal.z);
-
-        if (srmesh->hasColor())
-        {
-            float* ptr = srmesh->geometry.getVGeomColor(vgeom);
-            for (int j = 0; j < 3; ++j)
-                os.writeFloat(*ptr++);
-        }
-        if (srmesh->hasTexCoord())
-        {
-            float* ptr = srmesh->geometry.getVGeomTexCoord(vgeom);
-            for (int j = 0; j < 2; ++j)
-                os.writeFloat(*ptr++);
-        }
-    }
-
     assert(srmesh->afaceCount == srmesh->baseFCount);
-    aface = srmesh->afacesEnd.prev;
-    while (aface != &srmesh->afaces)
+    aface = srmesh->getAFace(srmesh->afacesEnd->prev);
+    while (aface != srmesh->afaces)
     {
-        index = aface->v0->vertex - srmesh->vertices;
+        index = srmesh->getVertex(srmesh->getAVertex(aface->v0)->vertex) - srmesh->vertices;
         os.writeUInt(index);
-        index = aface->v1->vertex - srmesh->vertices;
+        index = srmesh->getVertex(srmesh->getAVertex(aface->v1)->vertex) - srmesh->vertices;
         os.writeUInt(index);
-        index = aface->v2->vertex - srmesh->vertices;
+        index = srmesh->getVertex(srmesh->getAVertex(aface->v2)->vertex) - srmesh->vertices;
         os.writeUInt(index);
 
-        aface = aface->prev;
+        aface = srmesh->getAFace(aface->prev);
     }
 
     for (i = 0; i < srmesh->baseFCount; ++i)
     {
-        if (srmesh->faces[i].aface->n0 == NULL)
+        if (srmesh->getAFace(srmesh->faces[i].aface)->n0 == NULL)
         {
             index = UINT_MAX;
         }
@@ -493,7 +361,7 @@ int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
 
             for (j = 0; j < srmesh->baseFCount; ++j)
             {
-                if (srmesh->faces[j].aface == srmesh->faces[i].aface->n0)
+                if (srmesh->faces[j].aface == srmesh->getAFace(srmesh->faces[i].aface)->n0)
                 {
                     index = j;
                     break;
@@ -503,7 +371,7 @@ int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
         }
         os.writeUInt(index);
 
-        if (srmesh->faces[i].aface->n1 == NULL)
+        if (srmesh->getAFace(srmesh->faces[i].aface)->n1 == NULL)
         {
             index = UINT_MAX;
         }
@@ -513,7 +381,7 @@ int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
 
             for (j = 0; j < srmesh->baseFCount; ++j)
             {
-                if (srmesh->faces[j].aface == srmesh->faces[i].aface->n1)
+                if (srmesh->faces[j].aface == srmesh->getAFace(srmesh->faces[i].aface)->n1)
                 {
                     index = j;
                     break;
@@ -523,7 +391,7 @@ int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
         }
         os.writeUInt(index);
 
-        if (srmesh->faces[i].aface->n2 == NULL)
+        if (srmesh->getAFace(srmesh->faces[i].aface)->n2 == NULL)
         {
             index = UINT_MAX;
         }
@@ -533,7 +401,7 @@ int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
 
             for (j = 0; j < srmesh->baseFCount; ++j)
             {
-                if (srmesh->faces[j].aface == srmesh->faces[i].aface->n2)
+                if (srmesh->faces[j].aface == srmesh->getAFace(srmesh->faces[i].aface)->n2)
                 {
                     index = j;
                     break;
@@ -543,34 +411,89 @@ int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
         }
         os.writeUInt(index);
     }
+}
+
+int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
+{
+    uint32_t index, vt_i, vu_i, i, flags;
+
+    flags = 0;
+
+    if (srmesh->hasColor())
+        flags |= VDPM_HAS_COLOR;
+
+    if (srmesh->hasTexCoord())
+        flags |= VDPM_HAS_TEXCOORD;
+
+    os.writeUInt(flags);
+
+    os.writeFloat(srmesh->boundMin.x);
+    os.writeFloat(srmesh->boundMin.y);
+    os.writeFloat(srmesh->boundMin.z);
+    os.writeFloat(srmesh->boundMax.x);
+    os.writeFloat(srmesh->boundMax.y);
+    os.writeFloat(srmesh->boundMax.z);
+
+    os.writeUInt(srmesh->baseVCount);
+    os.writeUInt(srmesh->baseFCount);
+    os.writeUInt(srmesh->vsplitCount);
+
+    for (i = 0; i < srmesh->vcount; ++i)
+    {
+        if (srmesh->vertices[i].parent == NULL)
+            index = UINT_MAX;
+        else
+            index = srmesh->getVertex(srmesh->vertices[i].parent) - srmesh->vertices;
+
+        os.writeUInt(index);
+        os.writeUInt(srmesh->vertices[i].i);
+    }
+
+    for (i = 0; i < srmesh->baseVCount; ++i)
+    {
+        VGeom* vgeom = srmesh->geometry.getVGeom(i);
+
+        writeVGeom(os, srmesh, vgeom);
+    }
+
+    for (i = 0; i < srmesh->vsplitCount; ++i)
+    {
+        vt_i = srmesh->baseVCount + i * 2;
+        vu_i = srmesh->baseVCount + i * 2 + 1;
+
+        writeVGeom(os, srmesh, srmesh->geometry.getVGeom(vt_i));
+        writeVGeom(os, srmesh, srmesh->geometry.getVGeom(vu_i));
+    }
+
+    writeBaseFaces(os, srmesh);
 
     for (i = 0; i < srmesh->vsplitCount; ++i)
     {
         if (srmesh->vsplits[i].fn0 == NULL)
             index = UINT_MAX;
         else
-            index = srmesh->vsplits[i].fn0 - srmesh->faces;
+            index = srmesh->getFace(srmesh->vsplits[i].fn0) - srmesh->faces;
 
         os.writeUInt(index);
 
         if (srmesh->vsplits[i].fn1 == NULL)
             index = UINT_MAX;
         else
-            index = srmesh->vsplits[i].fn1 - srmesh->faces;
+            index = srmesh->getFace(srmesh->vsplits[i].fn1) - srmesh->faces;
 
         os.writeUInt(index);
 
         if (srmesh->vsplits[i].fn2 == NULL)
             index = UINT_MAX;
         else
-            index = srmesh->vsplits[i].fn2 - srmesh->faces;
+            index = srmesh->getFace(srmesh->vsplits[i].fn2) - srmesh->faces;
 
         os.writeUInt(index);
 
         if (srmesh->vsplits[i].fn3 == NULL)
             index = UINT_MAX;
         else
-            index = srmesh->vsplits[i].fn3 - srmesh->faces;
+            index = srmesh->getFace(srmesh->vsplits[i].fn3) - srmesh->faces;
 
         os.writeUInt(index);
 
@@ -581,4 +504,299 @@ int Serializer::writeSRMesh(OutStream& os, SRMesh* srmesh)
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+int Serializer::readActiveFront(InStream& is, SRMesh* srmesh)
+{
+    uint32_t magic, count, size, i;
+    uint32_t* front = NULL;
+
+    is.readUInt(magic);
+    if (VDPM_FRONT_FORMAT_MAGIC != magic)
+        goto error;
+
+    // a front only applies to the mesh it was saved from
+    is.readUInt(count);
+    if (count != srmesh->vsplitCount)
+        goto error;
+
+    size = srmesh->getActiveFrontSize();
+    front = new uint32_t[size];
+    if (!front)
+        goto error;
+
+    for (i = 0; i < size; ++i)
+        is.readUInt(front[i]);
+
+    if (srmesh->restoreActiveFront(front))
+        goto error;
+
+    delete[] front;
+    return 0;
+
+error:
+    delete[] front;
+    return -1;
+}
+
+int Serializer::writeActiveFront(OutStream& os, SRMesh* srmesh)
+{
+    uint32_t magic, size, i;
+    uint32_t* front;
+
+    size = srmesh->getActiveFrontSize();
+    front = new uint32_t[size];
+    if (!front)
+        return -1;
+
+    srmesh->saveActiveFront(front);
+
+    magic = VDPM_FRONT_FORMAT_MAGIC;
+    os.writeUInt(magic);
+    os.writeUInt(srmesh->vsplitCount);
+
+    for (i = 0; i < size; ++i)
+        os.writeUInt(front[i]);
+
+    delete[] front;
+    return 0;
+}
+
+#ifdef VDPM_STREAMING
+SRMesh* Serializer::readStreamedSRMesh(InStream& is)
+{
+    SRMesh* srmesh = NULL;
+    AVertex* avertex;
+    uint32_t magic, flags, len, vt_i, i;
+    unsigned int vgeomCount;
+
+    is.readUInt(magic);
+    if (VDPM_STREAM_FORMAT_MAGIC != magic)
+        goto error;
+
+    srmesh = new SRMesh();
+    if (!srmesh)
+        goto error;
+
+    is.readUInt(flags);
+
+    is.readFloat(srmesh->boundMin.x);
+    is.readFloat(srmesh->boundMin.y);
+    is.readFloat(srmesh->boundMin.z);
+    is.readFloat(srmesh->boundMax.x);
+    is.readFloat(srmesh->boundMax.y);
+    is.readFloat(srmesh->boundMax.z);
+
+    is.readUInt(srmesh->baseVCount);
+    is.readUInt(srmesh->baseFCount);
+    is.readUInt(srmesh->vsplitCount);
+
+    srmesh->vcount = srmesh->baseVCount + srmesh->vsplitCount * 2;
+    srmesh->vertices = new Vertex[srmesh->vcount];
+    if (!srmesh->vertices)
+        goto error;
+
+#ifdef VDPM_HYSTERESIS
+    // vsplit() and ecol() stamp these whether or not the mesh is ever realized
+    srmesh->vertexHolds = (unsigned int*)::calloc(srmesh->vcount, sizeof(unsigned int));
+    if (!srmesh->vertexHolds)
+        goto error;
+#endif
+
+#ifdef VDPM_INDEX_TOPOLOGY
+    if (srmesh->createTopologyPools(srmesh->vcount, srmesh->baseFCount + srmesh->vsplitCount * 2))
+        goto error;
+#endif
+
+    // vertices below the base mesh get their parent and vsplit when the records arrive
+    for (i = 0; i < srmesh->vcount; ++i)
+    {
+        srmesh->vertices[i].avertex = NULL;
+        srmesh->vertices[i].parent = NULL;
+        srmesh->vertices[i].i = UINT_MAX;
+    }
+
+    vgeomCount = srmesh->vcount;
+
+#ifdef VDPM_GEOMORPHS
+    srmesh->vmorphSize = srmesh->vcount / 16;
+    if (srmesh->vmorphSize == 0)
+        srmesh->vmorphSize = 32;
+
+    vgeomCount += srmesh->vmorphSize;
+#endif
+
+    if (srmesh->geometry.create(vgeomCount, (flags & VDPM_HAS_COLOR) ? true : false, (flags & VDPM_HAS_TEXCOORD) ? true : false))
+        goto error;
+
+    ::memset(reinterpret_cast<float*>(srmesh->geometry.getVGeom(srmesh->baseVCount)), 0, srmesh->getVGeomSize() * srmesh->vsplitCount * 2);
+
+    for (i = 0; i < srmesh->baseVCount; ++i)
+    {
+        VGeom* vgeom = srmesh->geometry.getVGeom(i);
+
+        avertex = srmesh->allocAVertex();
+        readVGeom(is, srmesh, vgeom);
+
+        avertex->i = i;
+        srmesh->vertices[i].avertex = srmesh->ref(avertex);
+        avertex->vertex = srmesh->ref(&srmesh->vertices[i]);
+        avertex->vmorph = NULL;
+        srmesh->addAVertex(avertex);
+    }
+#ifdef VDPM_GEOMORPHS
+    for (i = srmesh->vcount; i < vgeomCount; ++i)
+    {
+        VGeom* vgeom = srmesh->geometry.getVGeom(i);
+        *(unsigned int*)&vgeom->point.x = UINT_MAX;
+    }
+#endif // VDPM_GEOMORPHS
+
+    srmesh->fcount = srmesh->baseFCount + srmesh->vsplitCount * 2;
+    srmesh->faces = new Face[srmesh->fcount];
+    if (!srmesh->faces)
+        goto error;
+
+    readBaseFaces(is, srmesh);
+
+    srmesh->vsplits = new VSplit[srmesh->vsplitCount];
+    if (!srmesh->vsplits)
+        goto error;
+
+    for (i = 0; i < srmesh->vsplitCount; ++i)
+    {
+        vt_i = srmesh->baseVCount + i * 2;
+
+        srmesh->vsplits[i].vt_i = vt_i;
+        srmesh->vsplits[i].vu_i = vt_i + 1;
+        srmesh->vsplits[i].fn0 = srmesh->vsplits[i].fn1 = NULL;
+        srmesh->vsplits[i].fn2 = srmesh->vsplits[i].fn3 = NULL;
+        srmesh->vsplits[i].radius = srmesh->vsplits[i].sin2alpha = 0.0f;
+        srmesh->vsplits[i].uni_error = srmesh->vsplits[i].dir_error = 0.0f;
+    }
+
+    is.readUInt(len);
+    if (len > 0)
+    {
+        srmesh->texname = new char[len];
+        for (i = 0; i < len; ++i)
+            is.readChar(srmesh->texname[i]);
+    }
+
+    srmesh->streamed = true;
+    return srmesh;
+
+error:
+    delete srmesh;
+    return NULL;
+}
+
+int Serializer::writeStreamedSRMesh(OutStream& os, SRMesh* srmesh)
+{
+    uint32_t magic, flags, len, i;
+
+    // only the base mesh is sent up front
+    if (srmesh->afaceCount != srmesh->baseFCount)
+        return -1;
+
+    magic = VDPM_STREAM_FORMAT_MAGIC;
+    os.writeUInt(magic);
+
+    flags = 0;
+
+    if (srmesh->hasColor())
+        flags |= VDPM_HAS_COLOR;
+
+    if (srmesh->hasTexCoord())
+        flags |= VDPM_HAS_TEXCOORD;
+
+    os.writeUInt(flags);
+
+    os.writeFloat(srmesh->boundMin.x);
+    os.writeFloat(srmesh->boundMin.y);
+    os.writeFloat(srmesh->boundMin.z);
+    os.writeFloat(srmesh->boundMax.x);
+    os.writeFloat(srmesh->boundMax.y);
+    os.writeFloat(srmesh->boundMax.z);
+
+    os.writeUInt(srmesh->baseVCount);
+    os.writeUInt(srmesh->baseFCount);
+    os.writeUInt(srmesh->vsplitCount);
+
+    for (i = 0; i < srmesh->baseVCount; ++i)
+        writeVGeom(os, srmesh, srmesh->geometry.getVGeom(i));
+
+    writeBaseFaces(os, srmesh);
+
+    len = srmesh->texname ? (uint32_t)strlen(srmesh->texname) + 1 : 0;
+    os.writeUInt(len);
+
+    for (i = 0; i < len; ++i)
+        os.writeChar(srmesh->texname[i]);
+
+    return 0;
+}
+
+unsigned int Serializer::getStreamedVSplitSize(SRMesh* srmesh)
+{
+    // indices of the vsplit, vs and fn0..fn3, four floats and the vertices vt and vu
+    return sizeof(uint32_t) * 6 + sizeof(float) * 4 + srmesh->getVGeomSize() * 2;
+}
+
+int Serializer::readStreamedVSplit(InStream& is, SRMesh* srmesh)
+{
+    VGeomAll vt, vu;
+    uint32_t i, vs_i, fn[4];
+    float radius, sin2alpha, uni_error, dir_error;
+
+    is.readUInt(i);
+    is.readUInt(vs_i);
+    is.readUInt(fn[0]);
+    is.readUInt(fn[1]);
+    is.readUInt(fn[2]);
+    is.readUInt(fn[3]);
+
+    is.readFloat(radius);
+    is.readFloat(sin2alpha);
+    is.readFloat(uni_error);
+    is.readFloat(dir_error);
+
+    readVGeom(is, srmesh, &vt);
+    readVGeom(is, srmesh, &vu);
+
+    return srmesh->addStreamedVSplit(i, vs_i, fn, radius, sin2alpha, uni_error, dir_error, &vt, &vu);
+}
+
+int Serializer::writeStreamedVSplit(OutStream& os, SRMesh* srmesh, unsigned int i)
+{
+    VSplit& vsplit = srmesh->vsplits[i];
+    FaceRef fn[4] = { vsplit.fn0, vsplit.fn1, vsplit.fn2, vsplit.fn3 };
+    uint32_t index;
+    int j;
+
+    os.writeUInt(i);
+
+    index = (uint32_t)(srmesh->getVertex(srmesh->vertices[vsplit.vt_i].parent) - srmesh->vertices);
+    os.writeUInt(index);
+
+    for (j = 0; j < 4; ++j)
+    {
+        if (fn[j] == NULL)
+            index = UINT_MAX;
+        else
+            index = (uint32_t)(srmesh->getFace(fn[j]) - srmesh->faces);
+
+        os.writeUInt(index);
+    }
+
+    os.writeFloat(vsplit.radius);
+    os.writeFloat(vsplit.sin2alpha);
+    os.writeFloat(vsplit.uni_error);
+    os.writeFloat(vsplit.dir_error);
+
+    writeVGeom(os, srmesh, srmesh->geometry.getVGeom(vsplit.vt_i));
+    writeVGeom(os, srmesh, srmesh->geometry.getVGeom(vsplit.vu_i));
+
+    return 0;
+}
+#endif // VDPM_STREAMING
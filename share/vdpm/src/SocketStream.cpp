@@ -0,0 +1,329 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <cstdio>
+#include <cstring>
+#include "vdpm/Log.h"
+#include "vdpm/SocketStream.h"
+
+using namespace std;
+using namespace vdpm;
+
+#ifdef _WIN32
+typedef SOCKET NativeSocket;
+typedef int socklen_t;
+#define closeSocket closesocket
+#define SHUTDOWN_SEND SD_SEND
+#define SEND_FLAGS 0
+#else
+typedef int NativeSocket;
+#define INVALID_SOCKET (-1)
+#define closeSocket ::close
+#define SHUTDOWN_SEND SHUT_WR
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL     // report a closed peer as an error rather than SIGPIPE
+#else
+#define SEND_FLAGS 0
+#endif
+#endif // _WIN32
+
+#define SOCKET_RECEIVE_SIZE (64 * 1024)
+
+static bool startup()
+{
+#ifdef _WIN32
+    static bool started = false;
+    WSADATA data;
+
+    if (!started)
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+
+    return started;
+#else
+    return true;
+#endif
+}
+
+SocketStream::SocketStream(SocketHandle socket) : socket(socket), readOffset(0), failed(false)
+{
+    int noDelay = 1;
+
+    // vsplit batches and view updates are small, so do not hold them back
+    setsockopt((NativeSocket)socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+
+SocketStream::~SocketStream()
+{
+    close();
+}
+
+SocketStream* SocketStream::connect(const char host[], unsigned short port)
+{
+    struct addrinfo hints, *result = NULL, *ai;
+    char service[16];
+    SocketHandle s = INVALID_SOCKET;
+
+    if (!startup())
+        goto error;
+
+    ::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    sprintf(service, "%u", port);
+
+    if (getaddrinfo(host, service, &hints, &result))
+    {
+        Log::println("cannot resolve %s", host);
+        goto error;
+    }
+
+    for (ai = result; ai; ai = ai->ai_next)
+    {
+        s = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (s == INVALID_SOCKET)
+            continue;
+
+        if (::connect((NativeSocket)s, ai->ai_addr, (socklen_t)ai->ai_addrlen) == 0)
+            break;
+
+        closeSocket((NativeSocket)s);
+        s = INVALID_SOCKET;
+    }
+    freeaddrinfo(result);
+
+    if (s == INVALID_SOCKET)
+    {
+        Log::println("cannot connect to %s:%u", host, port);
+        goto error;
+    }
+    return new SocketStream(s);
+
+error:
+    return NULL;
+}
+
+SocketHandle SocketStream::listen(unsigned short port, unsigned short* boundPort)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    SocketHandle s = INVALID_SOCKET;
+    int reuse = 1;
+
+    if (!startup())
+        goto error;
+
+    s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET)
+        goto error;
+
+    setsockopt((NativeSocket)s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    ::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (::bind((NativeSocket)s, (struct sockaddr*)&addr, sizeof(addr)) || ::listen((NativeSocket)s, SOMAXCONN))
+    {
+        Log::println("cannot listen on port %u", port);
+        goto error;
+    }
+
+    // port 0 binds any free port
+    if (boundPort)
+    {
+        if (getsockname((NativeSocket)s, (struct sockaddr*)&addr, &len))
+            goto error;
+
+        *boundPort = ntohs(addr.sin_port);
+    }
+    return s;
+
+error:
+    if (s != INVALID_SOCKET)
+        closeSocket((NativeSocket)s);
+
+    return INVALID_SOCKET;
+}
+
+SocketStream* SocketStream::accept(SocketHandle listener)
+{
+    SocketHandle s = ::accept((NativeSocket)listener, NULL, NULL);
+
+    if (s == INVALID_SOCKET)
+        return NULL;
+
+    return new SocketStream(s);
+}
+
+void SocketStream::closeHandle(SocketHandle socket)
+{
+    if (socket != INVALID_SOCKET)
+        closeSocket((NativeSocket)socket);
+}
+
+void SocketStream::close()
+{
+    if (socket != INVALID_SOCKET)
+    {
+        closeSocket((NativeSocket)socket);
+        socket = INVALID_SOCKET;
+    }
+    failed = true;
+}
+
+void SocketStream::shutdown(int timeout)
+{
+    if (socket == INVALID_SOCKET)
+        return;
+
+    flush();
+    ::shutdown((NativeSocket)socket, SHUTDOWN_SEND);
+
+    // closing with unread data resets the connection, which can drop what the peer has not read yet
+    while (fill(timeout) > 0)
+        readOffset = (unsigned int)readBuffer.size();
+
+    close();
+}
+
+int SocketStream::fill(int timeout)
+{
+    struct timeval tv;
+    fd_set fds;
+    unsigned int size;
+    int ret;
+
+    // what the peer sent before a failed write can still be read
+    if (socket == INVALID_SOCKET)
+        return -1;
+
+    FD_ZERO(&fds);
+    FD_SET((NativeSocket)socket, &fds);
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+
+    ret = ::select((int)socket + 1, &fds, NULL, NULL, timeout < 0 ? NULL : &tv);
+    if (ret < 0)
+        goto error;
+
+    if (ret == 0)
+        return 0;
+
+    // drop what has been read before growing the buffer
+    if (readOffset > 0)
+    {
+        readBuffer.erase(readBuffer.begin(), readBuffer.begin() + readOffset);
+        readOffset = 0;
+    }
+
+    size = (unsigned int)readBuffer.size();
+    readBuffer.resize(size + SOCKET_RECEIVE_SIZE);
+    ret = ::recv((NativeSocket)socket, (char*)&readBuffer[size], SOCKET_RECEIVE_SIZE, 0);
+
+    if (ret <= 0)
+    {
+        readBuffer.resize(size);
+        goto error;
+    }
+    readBuffer.resize(size + ret);
+    return ret;
+
+error:
+    failed = true;
+    return -1;
+}
+
+int SocketStream::flush()
+{
+    unsigned int offset = 0;
+    int ret;
+
+    while (!failed && offset < writeBuffer.size())
+    {
+        ret = ::send((NativeSocket)socket, (const char*)&writeBuffer[offset], (int)(writeBuffer.size() - offset), SEND_FLAGS);
+        if (ret <= 0)
+            failed = true;
+        else
+            offset += ret;
+    }
+    writeBuffer.clear();
+
+    return failed ? -1 : 0;
+}
+
+void SocketStream::read(void* data, unsigned int size)
+{
+    while (available() < size)
+    {
+        if (fill(-1) < 0)
+        {
+            ::memset(data, 0, size);
+            return;
+        }
+    }
+    ::memcpy(data, &readBuffer[readOffset], size);
+    readOffset += size;
+}
+
+void SocketStream::write(const void* data, unsigned int size)
+{
+    const uint8_t* ptr = (const uint8_t*)data;
+
+    writeBuffer.insert(writeBuffer.end(), ptr, ptr + size);
+}
+
+void SocketStream::readChar(char& value)
+{
+    read(&value, sizeof(char));
+}
+
+void SocketStream::readUInt(unsigned int& value)
+{
+    read(&value, sizeof(unsigned int));
+}
+
+void SocketStream::readFloat(float& value)
+{
+    read(&value, sizeof(float));
+}
+
+void SocketStream::writeChar(char& value)
+{
+    write(&value, sizeof(char));
+}
+
+void SocketStream::writeUInt(unsigned int& value)
+{
+    write(&value, sizeof(unsigned int));
+}
+
+void SocketStream::writeFloat(float& value)
+{
+    write(&value, sizeof(float));
+}
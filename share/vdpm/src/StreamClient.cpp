@@ -0,0 +1,178 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include "vdpm/Log.h"
+#include "vdpm/Serializer.h"
+#include "vdpm/SRMesh.h"
+#include "vdpm/StreamClient.h"
+#include "vdpm/StreamServer.h"
+#include "vdpm/Viewport.h"
+
+#ifdef VDPM_STREAMING
+
+using namespace std;
+using namespace vdpm;
+
+#define STREAM_NO_TOKEN 0
+
+StreamClient::StreamClient() : stream(NULL), srmesh(NULL), recordSize(0), token(STREAM_NO_TOKEN), complete(false)
+{
+}
+
+StreamClient::~StreamClient()
+{
+    close();
+}
+
+SRMesh* StreamClient::connect(const char host[], unsigned short port)
+{
+    Serializer& serializer = Serializer::getInstance();
+
+    close();
+
+    stream = SocketStream::connect(host, port);
+    if (!stream)
+        goto error;
+
+    // the base mesh is small, so wait for all of it
+    srmesh = serializer.readStreamedSRMesh(*stream);
+    if (!srmesh || stream->isFailed())
+        goto error;
+
+    recordSize = serializer.getStreamedVSplitSize(srmesh);
+    token = STREAM_NO_TOKEN;
+    complete = srmesh->getVSplitCount() == 0;
+    return srmesh;
+
+error:
+    Log::println("cannot receive the base mesh from %s:%u", host, port);
+    delete srmesh;
+    srmesh = NULL;
+    close();
+    return NULL;
+}
+
+void StreamClient::close()
+{
+    delete stream;
+    stream = NULL;
+}
+
+int StreamClient::sendView(Viewport* viewport)
+{
+    Point viewPos = viewport->getViewPosition();
+    unsigned int message = STREAM_VIEW, p, j;
+    float value;
+
+    // nothing is left to steer
+    if (!stream || complete)
+        return 0;
+
+    stream->writeUInt(message);
+    stream->writeFloat(viewPos.x);
+    stream->writeFloat(viewPos.y);
+    stream->writeFloat(viewPos.z);
+
+    for (p = 0; p < 6; ++p)
+    {
+        for (j = 0; j < 4; ++j)
+        {
+            value = viewport->getViewClipPlane(p)[j];
+            stream->writeFloat(value);
+        }
+    }
+    return stream->flush();
+}
+
+int StreamClient::update(unsigned int maxCount)
+{
+    Serializer& serializer = Serializer::getInstance();
+    unsigned int count = 0;
+    int ret = 0;
+
+    if (!stream)
+        return complete ? 0 : -1;
+
+    while (!complete && count < maxCount)
+    {
+        // a message is only read once all of it has arrived
+        if (token == STREAM_NO_TOKEN)
+        {
+            ret = receive(sizeof(uint32_t));
+            if (ret <= 0)
+                break;
+
+            stream->readUInt(token);
+        }
+
+        if (token == STREAM_END)
+        {
+            complete = true;
+            break;
+        }
+
+        if (token != STREAM_VSPLIT)
+        {
+            Log::println("unknown stream message %u", token);
+            goto error;
+        }
+
+        ret = receive(recordSize);
+        if (ret <= 0)
+            break;
+
+        if (serializer.readStreamedVSplit(*stream, srmesh))
+        {
+            Log::println("invalid vsplit record");
+            goto error;
+        }
+
+        token = STREAM_NO_TOKEN;
+        ++count;
+    }
+
+    // the server closes the connection only after the last message
+    if (ret < 0)
+    {
+        Log::println("stream closed before the last vsplit record");
+        goto error;
+    }
+
+    if (complete)
+        close();
+
+    return count;
+
+error:
+    close();
+    return -1;
+}
+
+int StreamClient::receive(unsigned int size)
+{
+    int ret;
+
+    while (stream->available() < size)
+    {
+        ret = stream->fill(0);
+        if (ret <= 0)
+            return ret;
+    }
+    return 1;
+}
+
+#endif // VDPM_STREAMING
@@ -0,0 +1,251 @@
+/* vdpm - View-dependent progressive meshes library
+* Copyright 2015 Jim Tan
+* https://github.com/kctan0805/vdpm
+*
+* vdpm is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+#include <algorithm>
+#include <cfloat>
+#include "vdpm/Log.h"
+#include "vdpm/Serializer.h"
+#include "vdpm/SRMesh.h"
+#include "vdpm/StreamServer.h"
+
+#ifdef VDPM_STREAMING
+
+using namespace std;
+using namespace vdpm;
+
+#define STREAM_BATCH_SIZE       64
+#define STREAM_OUTSIDE_WEIGHT   1e-4f   // records outside the view frustum still arrive, but last
+#define STREAM_LINGER_TIME      10000   // milliseconds
+#define STREAM_VIEW_SIZE        (sizeof(uint32_t) + sizeof(float) * 27)
+
+StreamServer::StreamServer(SRMesh* srmesh) : srmesh(srmesh), listener(INVALID_SOCKET_HANDLE), port(0), batchSize(STREAM_BATCH_SIZE)
+{
+}
+
+StreamServer::~StreamServer()
+{
+    close();
+}
+
+int StreamServer::listen(unsigned short port)
+{
+    if (depCounts.empty() && buildDependencies())
+        return -1;
+
+    listener = SocketStream::listen(port, &this->port);
+    if (listener == INVALID_SOCKET_HANDLE)
+        return -1;
+
+    return 0;
+}
+
+void StreamServer::close()
+{
+    SocketStream::closeHandle(listener);
+    listener = INVALID_SOCKET_HANDLE;
+}
+
+int StreamServer::buildDependencies()
+{
+    unsigned int vsplitCount = srmesh->vsplitCount, deps[5], i, j, n;
+    vector<unsigned int> allDeps(vsplitCount * 5), next;
+
+    // a server sends its mesh as loaded
+    if (srmesh->renderer || srmesh->afaceCount != srmesh->baseFCount)
+    {
+        Log::println("cannot stream a realized or refined mesh");
+        return -1;
+    }
+
+    depCounts.assign(vsplitCount, 0);
+    dependentOffsets.assign(vsplitCount + 1, 0);
+
+    for (i = 0; i < vsplitCount; ++i)
+    {
+        n = srmesh->getVSplitDependencies(i, deps);
+        depCounts[i] = n;
+
+        for (j = 0; j < n; ++j)
+        {
+            allDeps[i * 5 + j] = deps[j];
+            ++dependentOffsets[deps[j] + 1];
+        }
+    }
+
+    for (i = 0; i < vsplitCount; ++i)
+        dependentOffsets[i + 1] += dependentOffsets[i];
+
+    dependents.resize(dependentOffsets[vsplitCount]);
+    next.assign(dependentOffsets.begin(), dependentOffsets.end() - 1);
+
+    for (i = 0; i < vsplitCount; ++i)
+    {
+        for (j = 0; j < depCounts[i]; ++j)
+            dependents[next[allDeps[i * 5 + j]]++] = i;
+    }
+    return 0;
+}
+
+int StreamServer::readView(SocketStream* stream, StreamView& view)
+{
+    unsigned int token, p, j;
+
+    stream->readUInt(token);
+    if (token != STREAM_VIEW)
+        return -1;
+
+    stream->readFloat(view.viewPos.x);
+    stream->readFloat(view.viewPos.y);
+    stream->readFloat(view.viewPos.z);
+
+    for (p = 0; p < 6; ++p)
+    {
+        for (j = 0; j < 4; ++j)
+            stream->readFloat(view.frustum[p][j]);
+    }
+    return 0;
+}
+
+float StreamServer::getPriority(unsigned int i, const StreamView* view)
+{
+    VSplit& vsp = srmesh->vsplits[i];
+    Vertex* vs = srmesh->getVertex(srmesh->vertices[vsp.vt_i].parent);
+    VGeom* vs_geom = srmesh->getVGeom(srmesh->getVGeomIndex(vs));
+    Point v_e;
+    float lv2, ve_n, priority;
+    unsigned int p;
+
+    // coarse to fine until the client reports a view
+    if (!view)
+        return vsp.uni_error;
+
+    // the screen error of SRMesh::screenErrorIllegal() relative to tau
+    v_e = vs_geom->point - view->viewPos;
+    lv2 = dotProduct(v_e, v_e);
+    if (lv2 <= FLT_MIN)
+        return FLT_MAX;
+
+    ve_n = dotProduct(v_e, vs_geom->normal);
+    priority = max(vsp.uni_error / lv2, vsp.dir_error * (lv2 - ve_n * ve_n) / (lv2 * lv2));
+
+    for (p = 0; p < 6; ++p)
+    {
+        float d = view->frustum[p][0] * vs_geom->point.x + view->frustum[p][1] * vs_geom->point.y + view->frustum[p][2] * vs_geom->point.z + view->frustum[p][3];
+        if (d <= -vsp.radius)
+            return priority * STREAM_OUTSIDE_WEIGHT;
+    }
+    return priority;
+}
+
+int StreamServer::serve()
+{
+    Serializer& serializer = Serializer::getInstance();
+    SocketStream* stream = NULL;
+    vector<unsigned int> counts(depCounts);
+    vector<StreamEntry> heap;
+    StreamEntry entry;
+    StreamView view;
+    bool hasView = false, viewChanged;
+    unsigned int token, i, j, n;
+    int ret = -1;
+
+    stream = SocketStream::accept(listener);
+    if (!stream)
+        goto error;
+
+    if (serializer.writeStreamedSRMesh(*stream, srmesh) || stream->flush())
+        goto error;
+
+    for (i = 0; i < counts.size(); ++i)
+    {
+        if (counts[i] == 0)
+        {
+            entry.i = i;
+            entry.priority = getPriority(i, NULL);
+            heap.push_back(entry);
+        }
+    }
+    make_heap(heap.begin(), heap.end());
+
+    while (!heap.empty())
+    {
+        // only the newest view matters
+        viewChanged = false;
+        while (stream->fill(0) > 0)
+            ;
+
+        while (stream->available() >= STREAM_VIEW_SIZE)
+        {
+            if (readView(stream, view))
+                goto error;
+
+            viewChanged = hasView = true;
+        }
+
+        if (stream->isFailed())
+            goto error;
+
+        if (viewChanged)
+        {
+            for (i = 0; i < heap.size(); ++i)
+                heap[i].priority = getPriority(heap[i].i, &view);
+
+            make_heap(heap.begin(), heap.end());
+        }
+
+        for (n = 0; n < batchSize && !heap.empty(); ++n)
+        {
+            pop_heap(heap.begin(), heap.end());
+            i = heap.back().i;
+            heap.pop_back();
+
+            token = STREAM_VSPLIT;
+            stream->writeUInt(token);
+            serializer.writeStreamedVSplit(*stream, srmesh, i);
+
+            // the records waiting only for this one are ready now
+            for (j = dependentOffsets[i]; j < dependentOffsets[i + 1]; ++j)
+            {
+                if (--counts[dependents[j]] == 0)
+                {
+                    entry.i = dependents[j];
+                    entry.priority = getPriority(entry.i, hasView ? &view : NULL);
+                    heap.push_back(entry);
+                    push_heap(heap.begin(), heap.end());
+                }
+            }
+        }
+
+        if (stream->flush())
+            goto error;
+    }
+
+    token = STREAM_END;
+    stream->writeUInt(token);
+    if (stream->flush())
+        goto error;
+
+    // the client closes once it has read the end, and may still send views until then
+    stream->shutdown(STREAM_LINGER_TIME);
+    ret = 0;
+
+error:
+    delete stream;
+    return ret;
+}
+
+#endif // VDPM_STREAMING
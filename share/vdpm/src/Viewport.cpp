@@ -16,13 +16,24 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>
 */
 #include <cassert>
+#include <cfloat>
 #include "vdpm/Viewport.h"
 
 using namespace std;
 using namespace vdpm;
 
+#ifdef VDPM_PREDICT_VIEW_POSITION
+#define PREDICT_SMOOTHING   0.5f    // weight of the newest sample
+#define PREDICT_MAX_FRAMES  4.0     // gaps longer than this many frames restart prediction
+#endif
+
 Viewport::Viewport()
 {
+#ifdef VDPM_PREDICT_VIEW_POSITION
+    maxSpeed = maxAcceleration = maxDistance = FLT_MAX;
+    viewPos = Point(0.0f, 0.0f, 0.0f);
+    resetPrediction();
+#endif
 }
 
 Viewport::~Viewport()
@@ -51,7 +62,89 @@ void Viewport::setViewClipPlane(int plane, float a, float b, float c, float d)
 
 void Viewport::setViewPosition(float x, float y, float z)
 {
+#ifdef VDPM_PREDICT_VIEW_POSITION
+    setViewPosition(x, y, z, lastTime + frameTime);
+#else
     viewPos.x = x;
     viewPos.y = y;
     viewPos.z = z;
+#endif
+}
+
+#ifdef VDPM_PREDICT_VIEW_POSITION
+static void clampLength(Vector& v, float maxLength)
+{
+    float len2 = dotProduct(v, v);
+
+    if (len2 > maxLength * maxLength)
+        v = v * (maxLength / sqrt(len2));
+}
+
+void Viewport::setViewPosition(float x, float y, float z, double time)
+{
+    Point pos(x, y, z);
+    Vector v, a;
+    float dt = (float)(time - lastTime);
+
+    if (samples == 0 || dt > frameTime * PREDICT_MAX_FRAMES)
+    {
+        // first sample or the camera stopped being updated, start over
+        velocity = acceleration = Vector(0.0f, 0.0f, 0.0f);
+        samples = 1;
+    }
+    else if (dt > 0.0f)
+    {
+        v = (pos - viewPos) / dt;
+        clampLength(v, maxSpeed);
+
+        if (samples > 1)
+        {
+            a = (v - velocity) / dt;
+            clampLength(a, maxAcceleration);
+            acceleration = acceleration * (1.0f - PREDICT_SMOOTHING) + a * PREDICT_SMOOTHING;
+            velocity = velocity * (1.0f - PREDICT_SMOOTHING) + v * PREDICT_SMOOTHING;
+            frameTime = frameTime * (1.0f - PREDICT_SMOOTHING) + dt * PREDICT_SMOOTHING;
+        }
+        else
+        {
+            velocity = v;
+            frameTime = dt;
+            samples = 2;
+        }
+    }
+
+    viewPos = pos;
+    lastTime = time;
+}
+
+void Viewport::setPredictionLimits(float maxSpeed, float maxAcceleration, float maxDistance)
+{
+    this->maxSpeed = (maxSpeed > 0.0f) ? maxSpeed : FLT_MAX;
+    this->maxAcceleration = (maxAcceleration > 0.0f) ? maxAcceleration : FLT_MAX;
+    this->maxDistance = (maxDistance > 0.0f) ? maxDistance : FLT_MAX;
+}
+
+void Viewport::resetPrediction()
+{
+    predictViewPos = viewPos;
+    delta_e = velocity = acceleration = Vector(0.0f, 0.0f, 0.0f);
+    lastTime = 0.0;
+    frameTime = 1.0f;
+    samples = 0;
+}
+
+void Viewport::predictViewPosition(unsigned int frames)
+{
+    float t = frames * frameTime;
+    Vector d = velocity * t + acceleration * (0.5f * t * t);
+
+    // do not let deceleration carry the prediction behind the camera
+    if (dotProduct(d, velocity) < 0.0f)
+        d = Vector(0.0f, 0.0f, 0.0f);
+
+    clampLength(d, maxDistance);
+
+    delta_e = (frames > 0) ? d / (float)frames : d;
+    predictViewPos = viewPos + d;
 }
+#endif // VDPM_PREDICT_VIEW_POSITION